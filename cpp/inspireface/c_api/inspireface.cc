@@ -481,6 +481,16 @@ HResult HFGetCudaDeviceId(int32_t *device_id) {
     return HSUCCEED;
 }
 
+HResult HFSetModelSharing(HInt32 enable) {
+    INSPIREFACE_CONTEXT->SetModelSharing(enable != 0);
+    return HSUCCEED;
+}
+
+HResult HFGetModelSharing(HPInt32 enable) {
+    *enable = INSPIREFACE_CONTEXT->GetModelSharing() ? 1 : 0;
+    return HSUCCEED;
+}
+
 HResult HFPrintCudaDeviceInfo() {
 #if defined(ISF_ENABLE_TENSORRT)
     return inspire::PrintCudaDeviceInfo();
@@ -509,6 +519,18 @@ HResult HFCheckCudaDeviceSupport(int32_t *is_support) {
 }
 
 HResult HFFeatureHubDataEnable(HFFeatureHubConfiguration configuration) {
+    HFFeatureHubIndexConfiguration indexConfiguration;
+    indexConfiguration.indexType = HF_SEARCH_INDEX_FLAT;
+    indexConfiguration.hnswM = 16;
+    indexConfiguration.hnswEfConstruction = 200;
+    indexConfiguration.hnswEfSearch = 64;
+    indexConfiguration.vectorStorage = HF_SEARCH_STORAGE_FLOAT32;
+    indexConfiguration.rerankFactor = 4;
+    return HFFeatureHubDataEnableWithIndex(configuration, indexConfiguration);
+}
+
+static inspire::DatabaseConfiguration MakeDatabaseConfiguration(HFFeatureHubConfiguration configuration,
+                                                                HFFeatureHubIndexConfiguration indexConfiguration) {
     inspire::DatabaseConfiguration param;
     if (configuration.primaryKeyMode != HF_PK_AUTO_INCREMENT && configuration.primaryKeyMode != HF_PK_MANUAL_INPUT) {
         param.primary_key_mode = inspire::PrimaryKeyMode::AUTO_INCREMENT;
@@ -531,10 +553,50 @@ HResult HFFeatureHubDataEnable(HFFeatureHubConfiguration configuration) {
     param.enable_persistence = configuration.enablePersistence;
     param.recognition_threshold = configuration.searchThreshold;
     param.search_mode = (inspire::SearchMode)configuration.searchMode;
-    auto ret = INSPIREFACE_FEATURE_HUB->EnableHub(param);
+    if (indexConfiguration.indexType == HF_SEARCH_INDEX_HNSW) {
+        param.search_index.index_type = inspire::SEARCH_INDEX_HNSW;
+    } else {
+        param.search_index.index_type = inspire::SEARCH_INDEX_FLAT;
+    }
+    param.search_index.hnsw_m = indexConfiguration.hnswM;
+    param.search_index.hnsw_ef_construction = indexConfiguration.hnswEfConstruction;
+    param.search_index.hnsw_ef_search = indexConfiguration.hnswEfSearch;
+    if (indexConfiguration.vectorStorage == HF_SEARCH_STORAGE_FLOAT16) {
+        param.search_index.vector_storage = inspire::SEARCH_STORAGE_FLOAT16;
+    } else if (indexConfiguration.vectorStorage == HF_SEARCH_STORAGE_INT8) {
+        param.search_index.vector_storage = inspire::SEARCH_STORAGE_INT8;
+    } else {
+        param.search_index.vector_storage = inspire::SEARCH_STORAGE_FLOAT32;
+    }
+    param.search_index.rerank_factor = indexConfiguration.rerankFactor;
+    return param;
+}
+
+HResult HFFeatureHubDataEnableWithIndex(HFFeatureHubConfiguration configuration, HFFeatureHubIndexConfiguration indexConfiguration) {
+    auto ret = INSPIREFACE_FEATURE_HUB->EnableHub(MakeDatabaseConfiguration(configuration, indexConfiguration));
+    return ret;
+}
+
+HResult HFFeatureHubSetSearchEf(HInt32 ef) {
+    return INSPIREFACE_FEATURE_HUB->SetSearchIndexEf(ef);
+}
+
+HResult HFFeatureHubGetSearchIndexMemoryUsage(HPSize bytes) {
+    if (bytes == nullptr) {
+        return HERR_INVALID_PARAM;
+    }
+    size_t usage = 0;
+    auto ret = INSPIREFACE_FEATURE_HUB->GetSearchIndexMemoryUsage(usage);
+    if (ret == HSUCCEED) {
+        *bytes = static_cast<HSize>(usage);
+    }
     return ret;
 }
 
+HResult HFFeatureHubSaveSearchIndex() {
+    return INSPIREFACE_FEATURE_HUB->SaveSearchIndex();
+}
+
 HResult HFSessionSetTrackPreviewSize(HFSession session, HInt32 previewSize) {
     if (session == nullptr) {
         return HERR_INVALID_CONTEXT_HANDLE;
@@ -616,6 +678,39 @@ HResult HFSessionSetTrackModeDetectInterval(HFSession session, HInt32 num) {
     return ctx->impl.SetTrackModeDetectInterval(num);
 }
 
+HResult HFSessionSetTrackModeAdaptiveDetect(HFSession session, HInt32 maxInterval) {
+    if (session == nullptr) {
+        return HERR_INVALID_CONTEXT_HANDLE;
+    }
+    HF_FaceAlgorithmSession *ctx = (HF_FaceAlgorithmSession *)session;
+    if (ctx == nullptr) {
+        return HERR_INVALID_CONTEXT_HANDLE;
+    }
+    return ctx->impl.SetTrackModeAdaptiveDetect(maxInterval);
+}
+
+HResult HFSessionSetTrackModeTiledDetect(HFSession session, HInt32 tileSize, HInt32 motionOnly) {
+    if (session == nullptr) {
+        return HERR_INVALID_CONTEXT_HANDLE;
+    }
+    HF_FaceAlgorithmSession *ctx = (HF_FaceAlgorithmSession *)session;
+    if (ctx == nullptr) {
+        return HERR_INVALID_CONTEXT_HANDLE;
+    }
+    return ctx->impl.SetTrackModeTiledDetect(tileSize, motionOnly);
+}
+
+HResult HFSessionSetTrackNumThreads(HFSession session, HInt32 num) {
+    if (session == nullptr) {
+        return HERR_INVALID_CONTEXT_HANDLE;
+    }
+    HF_FaceAlgorithmSession *ctx = (HF_FaceAlgorithmSession *)session;
+    if (ctx == nullptr) {
+        return HERR_INVALID_CONTEXT_HANDLE;
+    }
+    return ctx->impl.SetTrackNumThreads(num);
+}
+
 HResult HFExecuteFaceTrack(HFSession session, HFImageStream streamHandle, PHFMultipleFaceData results) {
     if (session == nullptr) {
         return HERR_INVALID_CONTEXT_HANDLE;
@@ -904,6 +999,15 @@ HResult HFFeatureHubInsertFeature(HFFaceFeatureIdentity featureIdentity, HPFaceI
     return ret;
 }
 
+HResult HFFeatureHubBatchInsertFeatures(HPFloat features, HInt32 num, HPFaceId customIds, HPFaceId allocIds) {
+    if (features == nullptr || num < 0) {
+        return HERR_INVALID_PARAM;
+    }
+    HInt32 ret = INSPIREFACE_FEATURE_HUB->FaceFeatureBatchInsert(features, num, customIds, allocIds);
+
+    return ret;
+}
+
 HResult HFFeatureHubFaceSearch(HFFaceFeature searchFeature, HPFloat confidence, PHFFaceFeatureIdentity mostSimilar) {
     if (searchFeature.data == nullptr) {
         return HERR_INVALID_FACE_FEATURE;
@@ -927,6 +1031,43 @@ HResult HFFeatureHubFaceSearch(HFFaceFeature searchFeature, HPFloat confidence,
     return ret;
 }
 
+HResult HFFeatureHubFaceSearchWithBuffer(HFFaceFeature searchFeature, HPFloat confidence, PHFFaceFeatureIdentity mostSimilar) {
+    if (searchFeature.data == nullptr) {
+        return HERR_INVALID_FACE_FEATURE;
+    }
+    if (confidence == nullptr || mostSimilar == nullptr) {
+        return HERR_INVALID_PARAM;
+    }
+    HInt32 featureLength;
+    HFGetFeatureLength(&featureLength);
+    if (searchFeature.size != featureLength) {
+        return HERR_INVALID_FACE_FEATURE;
+    }
+    inspire::FaceSearchTopKBuffer buffer = {0};
+    int64_t id = -1;
+    float similarity = -1.0f;
+    buffer.ids = &id;
+    buffer.confidences = &similarity;
+    if (mostSimilar->feature != nullptr) {
+        if (mostSimilar->feature->data == nullptr || mostSimilar->feature->size < featureLength) {
+            return HERR_INVALID_FACE_FEATURE;
+        }
+        buffer.features = mostSimilar->feature->data;
+    }
+    *confidence = -1.0f;
+    mostSimilar->id = -1;
+    HInt32 ret = INSPIREFACE_FEATURE_HUB->SearchFaceFeatureTopK(searchFeature.data, 1, buffer);
+    if (ret == HSUCCEED && buffer.size > 0) {
+        mostSimilar->id = id;
+        *confidence = similarity;
+        if (mostSimilar->feature != nullptr) {
+            mostSimilar->feature->size = featureLength;
+        }
+    }
+
+    return ret;
+}
+
 HResult HFFeatureHubFaceSearchTopK(HFFaceFeature searchFeature, HInt32 topK, PHFSearchTopKResults results) {
     if (searchFeature.data == nullptr) {
         return HERR_INVALID_FACE_FEATURE;
@@ -946,6 +1087,116 @@ HResult HFFeatureHubFaceSearchTopK(HFFaceFeature searchFeature, HInt32 topK, PHF
     return ret;
 }
 
+HResult HFFeatureHubFaceSearchTopKBatch(PHFFaceFeature searchFeatures, HInt32 num, HInt32 topK, PHFSearchTopKResults results) {
+    if (searchFeatures == nullptr || results == nullptr || num < 0) {
+        return HERR_INVALID_PARAM;
+    }
+    HInt32 featureLength;
+    HFGetFeatureLength(&featureLength);
+    // Pack the queries into one contiguous matrix for the batched scan
+    std::vector<float> queries(static_cast<size_t>(num) * featureLength);
+    for (HInt32 i = 0; i < num; ++i) {
+        if (searchFeatures[i].data == nullptr || searchFeatures[i].size != featureLength) {
+            return HERR_INVALID_FACE_FEATURE;
+        }
+        std::memcpy(queries.data() + static_cast<size_t>(i) * featureLength, searchFeatures[i].data, featureLength * sizeof(float));
+    }
+    std::vector<std::vector<inspire::FaceSearchResult>> searched;
+    HInt32 ret = INSPIREFACE_FEATURE_HUB->SearchFaceFeatureTopKBatch(queries.data(), num, searched, topK);
+    if (ret != HSUCCEED) {
+        return ret;
+    }
+    // The arrays returned belong to the calling thread, a search on another thread cannot overwrite them
+    thread_local std::vector<HFloat> confidence;
+    thread_local std::vector<HFaceId> ids;
+    confidence.clear();
+    ids.clear();
+    for (const auto &queryResults : searched) {
+        for (const auto &result : queryResults) {
+            confidence.push_back(result.similarity);
+            ids.push_back(result.id);
+        }
+    }
+    size_t offset = 0;
+    for (HInt32 i = 0; i < num; ++i) {
+        results[i].size = searched[i].size();
+        results[i].confidence = confidence.data() + offset;
+        results[i].ids = ids.data() + offset;
+        offset += searched[i].size();
+    }
+
+    return HSUCCEED;
+}
+
+HResult HFFeatureHubFaceSearchTopKWithBuffer(HFFaceFeature searchFeature, HInt32 topK, PHFSearchTopKResults results) {
+    if (searchFeature.data == nullptr) {
+        return HERR_INVALID_FACE_FEATURE;
+    }
+    if (results == nullptr || topK < 0) {
+        return HERR_INVALID_PARAM;
+    }
+    HInt32 featureLength;
+    HFGetFeatureLength(&featureLength);
+    if (searchFeature.size != featureLength) {
+        return HERR_INVALID_FACE_FEATURE;
+    }
+    inspire::FaceSearchTopKBuffer buffer = {0};
+    buffer.ids = results->ids;
+    buffer.confidences = results->confidence;
+    HInt32 ret = INSPIREFACE_FEATURE_HUB->SearchFaceFeatureTopK(searchFeature.data, topK, buffer);
+    results->size = ret == HSUCCEED ? static_cast<HInt32>(buffer.size) : 0;
+
+    return ret;
+}
+
+HResult HFFeatureHubFaceSearchTopKBatchWithBuffer(PHFFaceFeature searchFeatures, HInt32 num, HInt32 topK, PHFSearchTopKResults results) {
+    if (searchFeatures == nullptr || results == nullptr || num < 0 || topK < 0) {
+        return HERR_INVALID_PARAM;
+    }
+    HInt32 featureLength;
+    HFGetFeatureLength(&featureLength);
+    std::vector<float> queries(static_cast<size_t>(num) * featureLength);
+    std::vector<inspire::FaceSearchTopKBuffer> buffers(num);
+    for (HInt32 i = 0; i < num; ++i) {
+        if (searchFeatures[i].data == nullptr || searchFeatures[i].size != featureLength) {
+            return HERR_INVALID_FACE_FEATURE;
+        }
+        std::memcpy(queries.data() + static_cast<size_t>(i) * featureLength, searchFeatures[i].data, featureLength * sizeof(float));
+        buffers[i].ids = results[i].ids;
+        buffers[i].confidences = results[i].confidence;
+        buffers[i].features = nullptr;
+        buffers[i].size = 0;
+    }
+    HInt32 ret = INSPIREFACE_FEATURE_HUB->SearchFaceFeatureTopKBatch(queries.data(), num, topK, buffers.data());
+    for (HInt32 i = 0; i < num; ++i) {
+        results[i].size = ret == HSUCCEED ? static_cast<HInt32>(buffers[i].size) : 0;
+    }
+
+    return ret;
+}
+
+HResult HFFeatureHubFaceSearchTopKFiltered(HFFaceFeature searchFeature, HInt32 topK, HFSearchFilter filter, PHFSearchTopKResults results) {
+    if (searchFeature.data == nullptr) {
+        return HERR_INVALID_FACE_FEATURE;
+    }
+    if (results == nullptr || topK < 0) {
+        return HERR_INVALID_PARAM;
+    }
+    HInt32 featureLength;
+    HFGetFeatureLength(&featureLength);
+    if (searchFeature.size != featureLength) {
+        return HERR_INVALID_FACE_FEATURE;
+    }
+    inspire::FaceSearchTopKBuffer buffer = {0};
+    buffer.ids = results->ids;
+    buffer.confidences = results->confidence;
+    inspire::FaceSearchFilter searchFilter = {filter.allOf, filter.anyOf, filter.noneOf};
+    HInt32 ret = INSPIREFACE_FEATURE_HUB->SearchFaceFeatureTopK(searchFeature.data, topK, searchFilter, buffer);
+    results->size = ret == HSUCCEED ? static_cast<HInt32>(buffer.size) : 0;
+
+    return ret;
+}
+
 HResult HFFeatureHubFaceRemove(HFaceId id) {
     auto ret = INSPIREFACE_FEATURE_HUB->FaceFeatureRemove(id);
     return ret;
@@ -980,6 +1231,20 @@ HResult HFFeatureHubGetFaceIdentity(HFaceId id, PHFFaceFeatureIdentity identity)
     return ret;
 }
 
+HResult HFFeatureHubSetFaceTags(HFaceId id, HUInt64 tags) {
+    return INSPIREFACE_FEATURE_HUB->FaceFeatureSetTags(id, tags);
+}
+
+HResult HFFeatureHubGetFaceTags(HFaceId id, HPUInt64 tags) {
+    if (tags == nullptr) {
+        return HERR_INVALID_PARAM;
+    }
+    uint64_t value = 0;
+    HInt32 ret = INSPIREFACE_FEATURE_HUB->GetFaceFeatureTags(id, value);
+    *tags = ret == HSUCCEED ? value : 0;
+    return ret;
+}
+
 HResult HFMultipleFacePipelineProcess(HFSession session, HFImageStream streamHandle, PHFMultipleFaceData faces, HFSessionCustomParameter parameter) {
     if (session == nullptr) {
         return HERR_INVALID_CONTEXT_HANDLE;
@@ -1206,11 +1471,449 @@ HResult HFGetFaceAttributeResult(HFSession session, PHFFaceAttributeResult resul
     return HSUCCEED;
 }
 
+// Points a HFStreamFrameResult at the faces of source, copying the fields the C structs keep in separate arrays
+static void FillStreamFrameResult(const inspire::FaceStreamResult &source, HF_StreamResultBuffer &buffer, PHFStreamFrameResult result) {
+    const auto num = source.faces.size();
+    buffer.tokens.resize(num);
+    buffer.rects.resize(num);
+    buffer.trackIds.resize(num);
+    for (auto &angles : buffer.angles) {
+        angles.resize(num);
+    }
+    for (size_t i = 0; i < num; ++i) {
+        const auto &face = source.faces[i];
+        buffer.tokens[i].size = sizeof(inspire::FaceTrackWrap);
+        buffer.tokens[i].data = (HPVoid)&face;
+        buffer.rects[i] = {face.rect.x, face.rect.y, face.rect.width, face.rect.height};
+        buffer.trackIds[i] = face.trackId;
+        buffer.angles[0][i] = face.face3DAngle.roll;
+        buffer.angles[1][i] = face.face3DAngle.yaw;
+        buffer.angles[2][i] = face.face3DAngle.pitch;
+    }
+    for (auto &eyes : buffer.eyes) {
+        eyes.assign(num, -1.0f);
+    }
+    for (size_t i = 0; i < source.interactionState.size(); ++i) {
+        buffer.eyes[0][i] = source.interactionState[i].left_eye_status_confidence;
+        buffer.eyes[1][i] = source.interactionState[i].right_eye_status_confidence;
+    }
+    for (auto &actions : buffer.actions) {
+        actions.assign(num, -1);
+    }
+    for (size_t i = 0; i < source.interactionAction.size(); ++i) {
+        buffer.actions[0][i] = source.interactionAction[i].normal;
+        buffer.actions[1][i] = source.interactionAction[i].shake;
+        buffer.actions[2][i] = source.interactionAction[i].jawOpen;
+        buffer.actions[3][i] = source.interactionAction[i].headRaise;
+        buffer.actions[4][i] = source.interactionAction[i].blink;
+    }
+    for (auto &attributes : buffer.attributes) {
+        attributes.assign(num, -1);
+    }
+    for (size_t i = 0; i < source.attributeResult.size(); ++i) {
+        buffer.attributes[0][i] = source.attributeResult[i].race;
+        buffer.attributes[1][i] = source.attributeResult[i].gender;
+        buffer.attributes[2][i] = source.attributeResult[i].ageBracket;
+    }
+    buffer.features.resize(source.embeddings.size());
+    for (size_t i = 0; i < source.embeddings.size(); ++i) {
+        buffer.features[i].size = source.embeddings[i].embedding.size();
+        buffer.features[i].data = (HPFloat)source.embeddings[i].embedding.data();
+    }
+
+    result->frameId = source.frameId;
+    result->streamId = source.streamId;
+    result->status = source.status;
+    result->latencyMs = source.latencyMs;
+    result->faces.detectedNum = num;
+    result->faces.rects = buffer.rects.data();
+    result->faces.trackIds = buffer.trackIds.data();
+    result->faces.detConfidence = (HFloat *)source.detConfidence.data();
+    result->faces.angles.roll = buffer.angles[0].data();
+    result->faces.angles.yaw = buffer.angles[1].data();
+    result->faces.angles.pitch = buffer.angles[2].data();
+    result->faces.tokens = buffer.tokens.data();
+    result->quality.num = source.qualityConfidence.size();
+    result->quality.confidence = (HPFloat)source.qualityConfidence.data();
+    result->rgbLiveness.num = source.rgbLivenessConfidence.size();
+    result->rgbLiveness.confidence = (HPFloat)source.rgbLivenessConfidence.data();
+    result->mask.num = source.maskConfidence.size();
+    result->mask.confidence = (HPFloat)source.maskConfidence.data();
+    result->attribute.num = num;
+    result->attribute.race = buffer.attributes[0].data();
+    result->attribute.gender = buffer.attributes[1].data();
+    result->attribute.ageBracket = buffer.attributes[2].data();
+    result->interactionState.num = num;
+    result->interactionState.leftEyeStatusConfidence = buffer.eyes[0].data();
+    result->interactionState.rightEyeStatusConfidence = buffer.eyes[1].data();
+    result->interactionActions.num = num;
+    result->interactionActions.normal = buffer.actions[0].data();
+    result->interactionActions.shake = buffer.actions[1].data();
+    result->interactionActions.jawOpen = buffer.actions[2].data();
+    result->interactionActions.headRaise = buffer.actions[3].data();
+    result->interactionActions.blink = buffer.actions[4].data();
+    result->featureNum = buffer.features.size();
+    result->features = buffer.features.data();
+}
+
+// Rotation and format of an image pushed to a stream session or a stream server
+static bool ConvertStreamImageData(PHFImageData data, inspirecv::ROTATION_MODE &rotation, inspirecv::DATA_FORMAT &format) {
+    rotation = inspirecv::ROTATION_0;
+    switch (data->rotation) {
+        case HF_CAMERA_ROTATION_90:
+            rotation = inspirecv::ROTATION_90;
+            break;
+        case HF_CAMERA_ROTATION_180:
+            rotation = inspirecv::ROTATION_180;
+            break;
+        case HF_CAMERA_ROTATION_270:
+            rotation = inspirecv::ROTATION_270;
+            break;
+        default:
+            break;
+    }
+    switch (data->format) {
+        case HF_STREAM_RGB:
+            format = inspirecv::RGB;
+            break;
+        case HF_STREAM_BGR:
+            format = inspirecv::BGR;
+            break;
+        case HF_STREAM_RGBA:
+            format = inspirecv::RGBA;
+            break;
+        case HF_STREAM_BGRA:
+            format = inspirecv::BGRA;
+            break;
+        case HF_STREAM_YUV_NV12:
+            format = inspirecv::NV12;
+            break;
+        case HF_STREAM_YUV_NV21:
+            format = inspirecv::NV21;
+            break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+HResult HFCreateInspireFaceStreamSession(HFSessionCustomParameter parameter, HFDetectMode detectMode, HInt32 maxDetectFaceNum,
+                                         HInt32 detectPixelLevel, HInt32 trackByDetectModeFPS, HInt32 queueCapacity, HFStreamSession *handle) {
+    if (handle == nullptr) {
+        return HERR_INVALID_PARAM;
+    }
+    inspire::ContextCustomParameter param;
+    param.enable_mask_detect = parameter.enable_mask_detect;
+    param.enable_liveness = parameter.enable_liveness;
+    param.enable_face_quality = parameter.enable_face_quality;
+    param.enable_interaction_liveness = parameter.enable_interaction_liveness;
+    param.enable_ir_liveness = parameter.enable_ir_liveness;
+    param.enable_recognition = parameter.enable_recognition;
+    param.enable_face_attribute = parameter.enable_face_attribute;
+    param.enable_detect_mode_landmark = parameter.enable_detect_mode_landmark;
+    inspire::DetectModuleMode detMode = inspire::DETECT_MODE_ALWAYS_DETECT;
+    if (detectMode == HF_DETECT_MODE_LIGHT_TRACK) {
+        detMode = inspire::DETECT_MODE_LIGHT_TRACK;
+    } else if (detectMode == HF_DETECT_MODE_TRACK_BY_DETECTION) {
+        detMode = inspire::DETECT_MODE_TRACK_BY_DETECT;
+    }
+
+    HF_FaceAlgorithmStreamSession *ctx = new HF_FaceAlgorithmStreamSession();
+    auto ret = ctx->impl.Configuration(detMode, maxDetectFaceNum, param, detectPixelLevel, trackByDetectModeFPS, queueCapacity);
+    if (ret != HSUCCEED) {
+        delete ctx;
+        *handle = nullptr;
+    } else {
+        *handle = ctx;
+    }
+
+    return ret;
+}
+
+HResult HFReleaseInspireFaceStreamSession(HFStreamSession handle) {
+    if (handle == nullptr) {
+        return HERR_INVALID_CONTEXT_HANDLE;
+    }
+    delete (HF_FaceAlgorithmStreamSession *)handle;
+    return HSUCCEED;
+}
+
+HResult HFStreamSessionSetResultCallback(HFStreamSession session, HFStreamResultCallback callback, HPVoid userData) {
+    if (session == nullptr) {
+        return HERR_INVALID_CONTEXT_HANDLE;
+    }
+    HF_FaceAlgorithmStreamSession *ctx = (HF_FaceAlgorithmStreamSession *)session;
+    if (callback == nullptr) {
+        ctx->impl.SetResultCallback(nullptr);
+        return HSUCCEED;
+    }
+    // The callback runs on the pipeline thread only, one set of arrays is enough
+    auto buffer = std::make_shared<HF_StreamResultBuffer>();
+    ctx->impl.SetResultCallback([callback, userData, buffer](const inspire::FaceStreamResult &source) {
+        HFStreamFrameResult result;
+        FillStreamFrameResult(source, *buffer, &result);
+        callback(&result, userData);
+    });
+    return HSUCCEED;
+}
+
+HResult HFStreamSessionPushFrame(HFStreamSession session, PHFImageData data, HInt32 block, HPUInt64 frameId) {
+    if (session == nullptr) {
+        return HERR_INVALID_CONTEXT_HANDLE;
+    }
+    if (data == nullptr) {
+        return HERR_INVALID_IMAGE_STREAM_PARAM;
+    }
+    HF_FaceAlgorithmStreamSession *ctx = (HF_FaceAlgorithmStreamSession *)session;
+    inspirecv::ROTATION_MODE rotation;
+    inspirecv::DATA_FORMAT format;
+    if (!ConvertStreamImageData(data, rotation, format)) {
+        return HERR_INVALID_IMAGE_STREAM_PARAM;
+    }
+    uint64_t id = 0;
+    auto ret = ctx->impl.PushFrame(data->data, data->height, data->width, format, rotation, block != 0, &id);
+    if (ret == HSUCCEED && frameId != nullptr) {
+        *frameId = id;
+    }
+
+    return ret;
+}
+
+HResult HFStreamSessionPollResult(HFStreamSession session, HInt32 timeoutMs, PHFStreamFrameResult result) {
+    if (session == nullptr) {
+        return HERR_INVALID_CONTEXT_HANDLE;
+    }
+    if (result == nullptr) {
+        return HERR_INVALID_PARAM;
+    }
+    HF_FaceAlgorithmStreamSession *ctx = (HF_FaceAlgorithmStreamSession *)session;
+    auto ret = ctx->impl.PollResult(ctx->polled.result, timeoutMs);
+    if (ret != HSUCCEED) {
+        return ret;
+    }
+    FillStreamFrameResult(ctx->polled.result, ctx->polled, result);
+
+    return HSUCCEED;
+}
+
+HResult HFStreamSessionFlush(HFStreamSession session) {
+    if (session == nullptr) {
+        return HERR_INVALID_CONTEXT_HANDLE;
+    }
+    HF_FaceAlgorithmStreamSession *ctx = (HF_FaceAlgorithmStreamSession *)session;
+    return ctx->impl.Flush();
+}
+
+HResult HFCreateInspireFaceStreamServer(HFSessionCustomParameter parameter, HFDetectMode detectMode, HInt32 maxDetectFaceNum, HInt32 detectPixelLevel,
+                                        HInt32 trackByDetectModeFPS, HInt32 numWorkers, HInt32 maxBatchStreams, HInt32 queueCapacity,
+                                        HFStreamServer *handle) {
+    if (handle == nullptr) {
+        return HERR_INVALID_PARAM;
+    }
+    inspire::ContextCustomParameter param;
+    param.enable_mask_detect = parameter.enable_mask_detect;
+    param.enable_liveness = parameter.enable_liveness;
+    param.enable_face_quality = parameter.enable_face_quality;
+    param.enable_interaction_liveness = parameter.enable_interaction_liveness;
+    param.enable_ir_liveness = parameter.enable_ir_liveness;
+    param.enable_recognition = parameter.enable_recognition;
+    param.enable_face_attribute = parameter.enable_face_attribute;
+    param.enable_detect_mode_landmark = parameter.enable_detect_mode_landmark;
+    inspire::DetectModuleMode detMode = inspire::DETECT_MODE_ALWAYS_DETECT;
+    if (detectMode == HF_DETECT_MODE_LIGHT_TRACK) {
+        detMode = inspire::DETECT_MODE_LIGHT_TRACK;
+    } else if (detectMode == HF_DETECT_MODE_TRACK_BY_DETECTION) {
+        detMode = inspire::DETECT_MODE_TRACK_BY_DETECT;
+    }
+
+    HF_FaceAlgorithmStreamServer *ctx = new HF_FaceAlgorithmStreamServer();
+    auto ret = ctx->impl.Configuration(detMode, maxDetectFaceNum, param, detectPixelLevel, trackByDetectModeFPS, numWorkers, maxBatchStreams,
+                                       queueCapacity);
+    if (ret != HSUCCEED) {
+        delete ctx;
+        *handle = nullptr;
+    } else {
+        *handle = ctx;
+    }
+
+    return ret;
+}
+
+HResult HFReleaseInspireFaceStreamServer(HFStreamServer handle) {
+    if (handle == nullptr) {
+        return HERR_INVALID_CONTEXT_HANDLE;
+    }
+    delete (HF_FaceAlgorithmStreamServer *)handle;
+    return HSUCCEED;
+}
+
+HResult HFStreamServerOpenStream(HFStreamServer server, HPInt32 streamId) {
+    if (server == nullptr) {
+        return HERR_INVALID_CONTEXT_HANDLE;
+    }
+    if (streamId == nullptr) {
+        return HERR_INVALID_PARAM;
+    }
+    HF_FaceAlgorithmStreamServer *ctx = (HF_FaceAlgorithmStreamServer *)server;
+    int32_t id = 0;
+    auto ret = ctx->impl.OpenStream(id);
+    if (ret == HSUCCEED) {
+        *streamId = id;
+    }
+
+    return ret;
+}
+
+HResult HFStreamServerCloseStream(HFStreamServer server, HInt32 streamId) {
+    if (server == nullptr) {
+        return HERR_INVALID_CONTEXT_HANDLE;
+    }
+    HF_FaceAlgorithmStreamServer *ctx = (HF_FaceAlgorithmStreamServer *)server;
+    return ctx->impl.CloseStream(streamId);
+}
+
+HResult HFStreamServerSetResultCallback(HFStreamServer server, HFStreamResultCallback callback, HPVoid userData) {
+    if (server == nullptr) {
+        return HERR_INVALID_CONTEXT_HANDLE;
+    }
+    HF_FaceAlgorithmStreamServer *ctx = (HF_FaceAlgorithmStreamServer *)server;
+    if (callback == nullptr) {
+        ctx->impl.SetResultCallback(nullptr);
+        return HSUCCEED;
+    }
+    ctx->impl.SetResultCallback([callback, userData](const inspire::FaceStreamResult &source) {
+        // Several workers may deliver at once, each call gets its own arrays
+        HF_StreamResultBuffer buffer;
+        HFStreamFrameResult result;
+        FillStreamFrameResult(source, buffer, &result);
+        callback(&result, userData);
+    });
+    return HSUCCEED;
+}
+
+HResult HFStreamServerPushFrame(HFStreamServer server, HInt32 streamId, PHFImageData data, HInt32 block, HPUInt64 frameId) {
+    if (server == nullptr) {
+        return HERR_INVALID_CONTEXT_HANDLE;
+    }
+    if (data == nullptr) {
+        return HERR_INVALID_IMAGE_STREAM_PARAM;
+    }
+    HF_FaceAlgorithmStreamServer *ctx = (HF_FaceAlgorithmStreamServer *)server;
+    inspirecv::ROTATION_MODE rotation;
+    inspirecv::DATA_FORMAT format;
+    if (!ConvertStreamImageData(data, rotation, format)) {
+        return HERR_INVALID_IMAGE_STREAM_PARAM;
+    }
+    uint64_t id = 0;
+    auto ret = ctx->impl.PushFrame(streamId, data->data, data->height, data->width, format, rotation, block != 0, &id);
+    if (ret == HSUCCEED && frameId != nullptr) {
+        *frameId = id;
+    }
+
+    return ret;
+}
+
+HResult HFStreamServerPollResult(HFStreamServer server, HInt32 timeoutMs, PHFStreamFrameResult result) {
+    if (server == nullptr) {
+        return HERR_INVALID_CONTEXT_HANDLE;
+    }
+    if (result == nullptr) {
+        return HERR_INVALID_PARAM;
+    }
+    HF_FaceAlgorithmStreamServer *ctx = (HF_FaceAlgorithmStreamServer *)server;
+    auto ret = ctx->impl.PollResult(ctx->polled.result, timeoutMs);
+    if (ret != HSUCCEED) {
+        return ret;
+    }
+    FillStreamFrameResult(ctx->polled.result, ctx->polled, result);
+
+    return HSUCCEED;
+}
+
+HResult HFStreamServerFlush(HFStreamServer server) {
+    if (server == nullptr) {
+        return HERR_INVALID_CONTEXT_HANDLE;
+    }
+    HF_FaceAlgorithmStreamServer *ctx = (HF_FaceAlgorithmStreamServer *)server;
+    return ctx->impl.Flush();
+}
+
 HResult HFFeatureHubGetFaceCount(HInt32 *count) {
     *count = INSPIREFACE_FEATURE_HUB->GetFaceFeatureCount();
     return HSUCCEED;
 }
 
+HResult HFFeatureHubCreateGallery(HString name, HFFeatureHubConfiguration configuration, HFFeatureHubIndexConfiguration indexConfiguration,
+                                  HInt32 numShards) {
+    if (name == nullptr) {
+        return HERR_INVALID_PARAM;
+    }
+    inspire::DatabaseConfiguration param = MakeDatabaseConfiguration(configuration, indexConfiguration);
+    param.search_index.shards = numShards;
+    return INSPIREFACE_FEATURE_HUB->CreateGallery(name, param);
+}
+
+HResult HFFeatureHubDropGallery(HString name) {
+    if (name == nullptr) {
+        return HERR_INVALID_PARAM;
+    }
+    return INSPIREFACE_FEATURE_HUB->DropGallery(name);
+}
+
+HResult HFFeatureHubGalleryInsertFeature(HString name, HFFaceFeatureIdentity featureIdentity, HPFaceId allocId) {
+    if (name == nullptr || allocId == nullptr) {
+        return HERR_INVALID_PARAM;
+    }
+    HInt32 featureLength;
+    HFGetFeatureLength(&featureLength);
+    if (featureIdentity.feature == nullptr || featureIdentity.feature->data == nullptr || featureIdentity.feature->size != featureLength) {
+        return HERR_INVALID_FACE_FEATURE;
+    }
+    return INSPIREFACE_FEATURE_HUB->GalleryFeatureInsert(name, featureIdentity.feature->data, featureIdentity.id, *allocId);
+}
+
+HResult HFFeatureHubGalleryBatchInsertFeatures(HString name, HPFloat features, HInt32 num, HPFaceId customIds, HPFaceId allocIds) {
+    if (name == nullptr || features == nullptr || num < 0) {
+        return HERR_INVALID_PARAM;
+    }
+    return INSPIREFACE_FEATURE_HUB->GalleryFeatureBatchInsert(name, features, num, customIds, allocIds);
+}
+
+HResult HFFeatureHubGalleryRemove(HString name, HFaceId id) {
+    if (name == nullptr) {
+        return HERR_INVALID_PARAM;
+    }
+    return INSPIREFACE_FEATURE_HUB->GalleryFeatureRemove(name, id);
+}
+
+HResult HFFeatureHubGalleryFaceSearchTopK(HString name, HFFaceFeature searchFeature, HInt32 topK, PHFSearchTopKResults results) {
+    if (searchFeature.data == nullptr) {
+        return HERR_INVALID_FACE_FEATURE;
+    }
+    if (name == nullptr || results == nullptr || topK < 0) {
+        return HERR_INVALID_PARAM;
+    }
+    HInt32 featureLength;
+    HFGetFeatureLength(&featureLength);
+    if (searchFeature.size != featureLength) {
+        return HERR_INVALID_FACE_FEATURE;
+    }
+    inspire::FaceSearchTopKBuffer buffer = {0};
+    buffer.ids = results->ids;
+    buffer.confidences = results->confidence;
+    HInt32 ret = INSPIREFACE_FEATURE_HUB->GallerySearchFaceFeatureTopK(name, searchFeature.data, topK, buffer);
+    results->size = ret == HSUCCEED ? static_cast<HInt32>(buffer.size) : 0;
+
+    return ret;
+}
+
+HResult HFFeatureHubGalleryGetFaceCount(HString name, HPInt32 count) {
+    if (name == nullptr || count == nullptr) {
+        return HERR_INVALID_PARAM;
+    }
+    return INSPIREFACE_FEATURE_HUB->GetGalleryFaceFeatureCount(name, *count);
+}
+
 HResult HFFeatureHubViewDBTable() {
     INSPIREFACE_FEATURE_HUB->ViewDBTable();
     return HSUCCEED;
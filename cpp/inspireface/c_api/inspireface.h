@@ -348,6 +348,23 @@ HYPER_CAPI_EXPORT extern HResult HFSetCudaDeviceId(int32_t device_id);
  * */
 HYPER_CAPI_EXPORT extern HResult HFGetCudaDeviceId(int32_t *device_id);
 
+/**
+ * @brief Set whether the sessions share one loaded copy of each model, must be called before HFCreateInspireFaceSession.
+ * Disabled by default. Sharing saves the memory of the models in every session, but the inferences of a shared
+ * model run one at a time, so sessions used from several threads, the tracking threads and the stream server
+ * workers take turns on it. Only the MNN engine shares models, the others ignore it.
+ * @param enable 1 to share the models, 0 to load a copy per session.
+ * @return HResult indicating the success or failure of the operation.
+ * */
+HYPER_CAPI_EXPORT extern HResult HFSetModelSharing(HInt32 enable);
+
+/**
+ * @brief Get whether the sessions share the loaded models.
+ * @param enable Pointer to the result, 1 when the models are shared.
+ * @return HResult indicating the success or failure of the operation.
+ * */
+HYPER_CAPI_EXPORT extern HResult HFGetModelSharing(HPInt32 enable);
+
 /**
  * @brief Print the CUDA device information.
  * @return HResult indicating the success or failure of the operation.
@@ -537,6 +554,45 @@ HYPER_CAPI_EXPORT extern HResult HFSessionSetTrackModeNumSmoothCacheFrame(HFSess
  */
 HYPER_CAPI_EXPORT extern HResult HFSessionSetTrackModeDetectInterval(HFSession session, HInt32 num);
 
+/**
+ * @brief Set the adaptive detection of the track mode in the session. disabled by default
+ *
+ * Instead of every detect interval frames, the light track mode then runs the detector when the scene
+ * changed since the last detection, when a track got weak or was lost, and at least every maxInterval
+ * frames. A track that stays weak is detected again at most every detect interval frames.
+ *
+ * @param session Handle to the session.
+ * @param maxInterval The maximum number of frames between two detections, 0 goes back to the detect interval.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFSessionSetTrackModeAdaptiveDetect(HFSession session, HInt32 maxInterval);
+
+/**
+ * @brief Set the tiled detection of the track mode in the session. disabled by default
+ *
+ * On the detected frames larger than tileSize, the whole frame is still detected at the preview size,
+ * and the frame is also cut into overlapping tiles of tileSize pixels detected at full resolution, so
+ * faces too small for the preview are found.
+ *
+ * @param session Handle to the session.
+ * @param tileSize The side of the tiles in frame pixels, 0 detects on the preview only.
+ * @param motionOnly Non-zero to detect only the tiles that changed since they were last detected.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFSessionSetTrackModeTiledDetect(HFSession session, HInt32 tileSize, HInt32 motionOnly);
+
+/**
+ * @brief Set the number of threads tracking the faces of a frame in the session. default value is 1
+ *
+ * Each extra thread loads its own copy of the landmark, refine and pose networks. The order of the
+ * faces and their track ids are the same for any number of threads.
+ *
+ * @param session Handle to the session.
+ * @param num The number of threads, 1 tracks on the calling thread only.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFSessionSetTrackNumThreads(HFSession session, HInt32 num);
+
 /**
  * @brief Run face tracking in the session.
  *
@@ -687,6 +743,44 @@ typedef enum HFPKMode {
     HF_PK_MANUAL_INPUT,        ///< Manual input mode for primary key.
 } HFPKMode;
 
+/**
+ * @brief Index used to serve the searches of the feature hub.
+ */
+typedef enum HFSearchIndexType {
+    HF_SEARCH_INDEX_FLAT = 0,  ///< Exact search, every stored feature is compared with the query.
+    HF_SEARCH_INDEX_HNSW,      ///< Approximate HNSW graph search, much faster on large galleries.
+} HFSearchIndexType;
+
+/**
+ * @brief Precision of the features scanned in memory by the flat index.
+ *
+ * Reduced precision copies cut the bandwidth of the scan, the best candidates are then re-ranked
+ * with a full precision copy of the features kept next to them in memory, the database is not read
+ * during a search. The index is larger than the float32 one, an in-memory feature hub stores the
+ * features only in the index so that it still takes less memory than a float32 one in total.
+ */
+typedef enum HFSearchVectorStorage {
+    HF_SEARCH_STORAGE_FLOAT32 = 0,  ///< Features are scanned as stored.
+    HF_SEARCH_STORAGE_FLOAT16,      ///< Half precision copy, 2 bytes per element.
+    HF_SEARCH_STORAGE_INT8,         ///< Int8 copy with one scale per feature, 1 byte per element.
+} HFSearchVectorStorage;
+
+/**
+ * @brief Struct for search index configuration.
+ *
+ * With persistence enabled, the search index is saved next to the database file when the feature
+ * hub is disabled and restored on the next enable instead of being rebuilt: the HNSW graph is loaded
+ * back, the flat index maps its snapshot read-only and searches it in place.
+ */
+typedef struct HFFeatureHubIndexConfiguration {
+    HFSearchIndexType indexType;  ///< Index used to serve searches
+    HInt32 hnswM;                 ///< HNSW: max links per node (default 16)
+    HInt32 hnswEfConstruction;    ///< HNSW: candidate list size when inserting (default 200)
+    HInt32 hnswEfSearch;          ///< HNSW: candidate list size when searching (default 64)
+    HFSearchVectorStorage vectorStorage;  ///< Flat: precision of the in-memory copy (default float32)
+    HInt32 rerankFactor;                  ///< Flat: candidates re-ranked at full precision per requested result (default 4)
+} HFFeatureHubIndexConfiguration;
+
 /**
  * @brief Struct for database configuration.
  *
@@ -712,6 +806,45 @@ typedef struct HFFeatureHubConfiguration {
  */
 HYPER_CAPI_EXPORT extern HResult HFFeatureHubDataEnable(HFFeatureHubConfiguration configuration);
 
+/**
+ * @brief Enable the feature hub with an explicit search index.
+ * @details Same as HFFeatureHubDataEnable, HFFeatureHubDataEnable uses the flat index. The default
+ * database of the hub always keeps a single shard, a sharded index is created with HFFeatureHubCreateGallery.
+ *
+ * @param configuration FeatureHub configuration details.
+ * @param indexConfiguration Search index selection and tuning.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFFeatureHubDataEnableWithIndex(HFFeatureHubConfiguration configuration,
+                                                                 HFFeatureHubIndexConfiguration indexConfiguration);
+
+/**
+ * @brief Set the candidate list size of HNSW searches at runtime.
+ * @details Larger values raise recall at the cost of latency, it has no effect on the flat index.
+ *
+ * @param ef Candidate list size, must be positive.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFFeatureHubSetSearchEf(HInt32 ef);
+
+/**
+ * @brief Get the approximate memory held by the in-memory search index.
+ *
+ * @param bytes Pointer to the memory in bytes, the database storage is not included.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFFeatureHubGetSearchIndexMemoryUsage(HPSize bytes);
+
+/**
+ * @brief Save the search index next to the persistent database without disabling the feature hub.
+ * @details Other processes enabling the same database then restore the index instead of rebuilding it,
+ * the snapshot of a flat index is mapped and its pages are shared between those processes.
+ * Only available with persistence enabled.
+ *
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFFeatureHubSaveSearchIndex();
+
 /**
  * @brief Disable the global FeatureHub feature, and you can enable it again if needed.
  * @return HResult indicating the success or failure of the operation.
@@ -738,6 +871,16 @@ typedef struct HFSearchTopKResults {
     HPFaceId ids;        ///< Searched face ids
 } HFSearchTopKResults, *PHFSearchTopKResults;
 
+/**
+ * Tag predicate of filtered searches, each face feature carries 64 tag bits set with HFFeatureHubSetFaceTags.
+ * A feature matches when it has every bit of allOf, at least one bit of anyOf (unless anyOf is 0) and no bit of noneOf.
+ * */
+typedef struct HFSearchFilter {
+    HUInt64 allOf;   ///< Bits that must all be set
+    HUInt64 anyOf;   ///< Bits of which at least one must be set, ignored when 0
+    HUInt64 noneOf;  ///< Bits that must all be clear
+} HFSearchFilter, *PHFSearchFilter;
+
 /**
  * @brief Set the face recognition search threshold.
  *
@@ -830,27 +973,114 @@ HYPER_CAPI_EXPORT extern HResult HFGetFeatureLength(HPInt32 num);
  */
 HYPER_CAPI_EXPORT extern HResult HFFeatureHubInsertFeature(HFFaceFeatureIdentity featureIdentity, HPFaceId allocId);
 
+/**
+ * @brief Bulk import of face features stored back to back in one buffer.
+ *
+ * All features are inserted in a single transaction, which is much faster than one HFFeatureHubInsertFeature
+ * call per feature when enrolling a large gallery. Either every feature is inserted or none of them is.
+ *
+ * @param features Contiguous buffer of num x feature length elements.
+ * @param num Number of face features in features.
+ * @param customIds Array of num custom ids, required when the primary key mode is HF_PK_MANUAL_INPUT and ignored otherwise.
+ * @param allocIds Optional array of num elements receiving the ids of the inserted features, may be NULL.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFFeatureHubBatchInsertFeatures(HPFloat features, HInt32 num, HPFaceId customIds, HPFaceId allocIds);
+
 /**
  * @brief Search for the most similar face feature in the features group.
  *
  * @param searchFeature The face feature to be searched.
  * @param confidence Pointer to a floating-point value where the confidence level of the match will
  * be stored.
- * @param mostSimilar Pointer to the most similar face feature identity found.
+ * @param mostSimilar Pointer to the most similar face feature identity found, its feature points into an internal cache
+ * that is overwritten by the next search, use HFFeatureHubFaceSearchWithBuffer to search from several threads.
  * @return HResult indicating the success or failure of the operation.
  */
 HYPER_CAPI_EXPORT extern HResult HFFeatureHubFaceSearch(HFFaceFeature searchFeature, HPFloat confidence, PHFFaceFeatureIdentity mostSimilar);
 
+/**
+ * @brief Search for the most similar face feature, the result is written to caller-owned memory.
+ *
+ * No internal cache is involved, so any number of threads can search at the same time.
+ *
+ * @param searchFeature The face feature to be searched.
+ * @param confidence Pointer to a floating-point value where the confidence level of the match will be stored.
+ * @param mostSimilar Receives the id of the match, -1 if none. If its feature is not null, the matched feature is copied
+ * to feature->data, which must have room for feature->size elements, at least the feature length.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFFeatureHubFaceSearchWithBuffer(HFFaceFeature searchFeature, HPFloat confidence, PHFFaceFeatureIdentity mostSimilar);
+
 /**
  * @brief Search for the most similar k facial features in the feature group
  *
  * @param searchFeature The face feature to be searched.
  * @param confidence topK Maximum number of searches
- * @param PHFSearchTopKResults Output search result
+ * @param PHFSearchTopKResults Output search result, the arrays point into an internal cache that is overwritten by the next search
  * @return HResult indicating the success or failure of the operation.
  */
 HYPER_CAPI_EXPORT extern HResult HFFeatureHubFaceSearchTopK(HFFaceFeature searchFeature, HInt32 topK, PHFSearchTopKResults results);
 
+/**
+ * @brief Search for the most similar k facial features, the results are written to caller-owned arrays.
+ *
+ * No internal cache is involved, so any number of threads can search at the same time.
+ *
+ * @param searchFeature The face feature to be searched.
+ * @param topK Maximum number of results.
+ * @param results The caller sets confidence and ids to arrays of at least topK elements, size receives the number of results.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFFeatureHubFaceSearchTopKWithBuffer(HFFaceFeature searchFeature, HInt32 topK, PHFSearchTopKResults results);
+
+/**
+ * @brief Search for the most similar k facial features of several face features in one pass.
+ *
+ * All queries are scored together in a single pass over the feature group, which is faster than
+ * calling HFFeatureHubFaceSearchTopK once per face. The result arrays point into a cache of the calling
+ * thread and stay valid until the next call of this function on the same thread, searches on other
+ * threads do not overwrite them.
+ *
+ * @param searchFeatures Array of face features to be searched, each of feature length elements.
+ * @param num Number of face features in searchFeatures.
+ * @param topK Maximum number of results per face feature.
+ * @param results Array of num results filled in the order of searchFeatures.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFFeatureHubFaceSearchTopKBatch(PHFFaceFeature searchFeatures, HInt32 num, HInt32 topK, PHFSearchTopKResults results);
+
+/**
+ * @brief Batched top k search whose results are written to caller-owned arrays.
+ *
+ * Same single pass as HFFeatureHubFaceSearchTopKBatch without the internal cache, so any number of threads
+ * can search at the same time.
+ *
+ * @param searchFeatures Array of face features to be searched, each of feature length elements.
+ * @param num Number of face features in searchFeatures.
+ * @param topK Maximum number of results per face feature.
+ * @param results Array of num results, the caller sets the confidence and ids of each to arrays of at least topK elements.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFFeatureHubFaceSearchTopKBatchWithBuffer(PHFFaceFeature searchFeatures, HInt32 num, HInt32 topK,
+                                                                           PHFSearchTopKResults results);
+
+/**
+ * @brief Search for the most similar k facial features among those whose tags match a filter.
+ *
+ * The tags are tested while the features are scanned, features that do not match are never scored,
+ * so narrowing a search to a subset of the group (a site, a watch list...) also makes it faster.
+ * The results are written to caller-owned arrays as in HFFeatureHubFaceSearchTopKWithBuffer.
+ *
+ * @param searchFeature The face feature to be searched.
+ * @param topK Maximum number of results.
+ * @param filter Tag predicate of the features to consider.
+ * @param results The caller sets confidence and ids to arrays of at least topK elements, size receives the number of results.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFFeatureHubFaceSearchTopKFiltered(HFFaceFeature searchFeature, HInt32 topK, HFSearchFilter filter,
+                                                                    PHFSearchTopKResults results);
+
 /**
  * @brief Remove a face feature from the features group based on custom ID.
  *
@@ -876,6 +1106,27 @@ HYPER_CAPI_EXPORT extern HResult HFFeatureHubFaceUpdate(HFFaceFeatureIdentity fe
  */
 HYPER_CAPI_EXPORT extern HResult HFFeatureHubGetFaceIdentity(HFaceId customId, PHFFaceFeatureIdentity identity);
 
+/**
+ * @brief Set the 64 tag bits of a face feature, used by HFFeatureHubFaceSearchTopKFiltered.
+ *
+ * Features are inserted without tags. The tags are stored in the database next to the feature,
+ * kept when the feature is updated and removed with it.
+ *
+ * @param id The ID of the feature.
+ * @param tags The new tag bits, 0 clears them.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFFeatureHubSetFaceTags(HFaceId id, HUInt64 tags);
+
+/**
+ * @brief Get the tag bits of a face feature.
+ *
+ * @param id The ID of the feature.
+ * @param tags Pointer receiving the tag bits.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFFeatureHubGetFaceTags(HFaceId id, HPUInt64 tags);
+
 /**
  * @brief Get the count of face features in the features group.
  *
@@ -906,6 +1157,85 @@ typedef struct HFFeatureHubExistingIds {
  */
 HYPER_CAPI_EXPORT extern HResult HFFeatureHubGetExistingIds(PHFFeatureHubExistingIds ids);
 
+/**
+ * @brief Create a named gallery, a feature database managed next to the default one of the feature hub.
+ * @details Each gallery has its own primary key mode, threshold and search index. A gallery split into
+ * several shards is searched on all of them in parallel and the results are merged, which lowers the
+ * latency of large galleries on multi-core devices. The feature hub has to be enabled and disabling it
+ * drops every gallery. A persistent gallery whose path is a folder is stored in a file named after it.
+ *
+ * @param name Unique name of the gallery, made of letters, digits, '_' and '-', other names are rejected
+ * with HERR_INVALID_PARAM.
+ * @param configuration Database settings of the gallery, the search mode is ignored.
+ * @param indexConfiguration Search index selection and tuning, applied to every shard.
+ * @param numShards Number of shards, 1 keeps a single index.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFFeatureHubCreateGallery(HString name, HFFeatureHubConfiguration configuration,
+                                                           HFFeatureHubIndexConfiguration indexConfiguration, HInt32 numShards);
+
+/**
+ * @brief Drop a named gallery, a persistent database file is kept.
+ *
+ * @param name Name of the gallery.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFFeatureHubDropGallery(HString name);
+
+/**
+ * @brief Insert a face feature into a named gallery, see HFFeatureHubInsertFeature.
+ *
+ * @param name Name of the gallery.
+ * @param featureIdentity The face feature and its custom id, the id is ignored in auto-increment mode.
+ * @param allocId Pointer receiving the id of the inserted feature.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFFeatureHubGalleryInsertFeature(HString name, HFFaceFeatureIdentity featureIdentity, HPFaceId allocId);
+
+/**
+ * @brief Bulk import of face features into a named gallery, see HFFeatureHubBatchInsertFeatures.
+ *
+ * @param name Name of the gallery.
+ * @param features Contiguous buffer of num x feature length elements.
+ * @param num Number of face features in features.
+ * @param customIds Array of num custom ids, required when the primary key mode is HF_PK_MANUAL_INPUT and ignored otherwise.
+ * @param allocIds Optional array of num elements receiving the ids of the inserted features, may be NULL.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFFeatureHubGalleryBatchInsertFeatures(HString name, HPFloat features, HInt32 num, HPFaceId customIds,
+                                                                        HPFaceId allocIds);
+
+/**
+ * @brief Remove a face feature from a named gallery.
+ *
+ * @param name Name of the gallery.
+ * @param id The id of the feature to remove.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFFeatureHubGalleryRemove(HString name, HFaceId id);
+
+/**
+ * @brief Search a named gallery for the most similar k facial features into caller-owned arrays.
+ * @details Same as HFFeatureHubFaceSearchTopKWithBuffer, the threshold of the gallery is used.
+ *
+ * @param name Name of the gallery.
+ * @param searchFeature The face feature to be searched.
+ * @param topK Maximum number of results.
+ * @param results The caller sets confidence and ids to arrays of at least topK elements, size receives the number of results.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFFeatureHubGalleryFaceSearchTopK(HString name, HFFaceFeature searchFeature, HInt32 topK,
+                                                                   PHFSearchTopKResults results);
+
+/**
+ * @brief Get the count of face features in a named gallery.
+ *
+ * @param name Name of the gallery.
+ * @param count Pointer to an integer where the count of features will be stored.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFFeatureHubGalleryGetFaceCount(HString name, HPInt32 count);
+
 /************************************************************************
  * Face Pipeline
  ************************************************************************/
@@ -1098,6 +1428,209 @@ typedef struct HFFaceAttributeResult {
  */
 HYPER_CAPI_EXPORT extern HResult HFGetFaceAttributeResult(HFSession session, PHFFaceAttributeResult results);
 
+/************************************************************************
+ * Stream Session
+ ************************************************************************/
+
+/**
+ * @brief Struct holding the results of one frame of a stream session.
+ *
+ * Every array holds faces.detectedNum entries, results of disabled functions are -1. featureNum is
+ * faces.detectedNum when recognition is enabled, otherwise 0.
+ */
+typedef struct HFStreamFrameResult {
+    HUInt64 frameId;                               ///< Id returned when the frame was pushed.
+    HInt32 streamId;                               ///< Stream of a stream server, 0 for a stream session.
+    HResult status;                                ///< HSUCCEED, or the error of the first stage that failed.
+    HFloat latencyMs;                              ///< Milliseconds from push to delivery.
+    HFMultipleFaceData faces;                      ///< Detected and tracked faces.
+    HFFaceQualityConfidence quality;               ///< Face quality confidence.
+    HFRGBLivenessConfidence rgbLiveness;           ///< RGB liveness confidence.
+    HFFaceMaskConfidence mask;                     ///< Mask confidence.
+    HFFaceAttributeResult attribute;               ///< Race, gender and age bracket.
+    HFFaceInteractionState interactionState;       ///< Eye status.
+    HFFaceInteractionsActions interactionActions;  ///< Interaction actions.
+    HInt32 featureNum;                             ///< Number of features.
+    PHFFaceFeature features;                       ///< Normalized face feature of each face.
+} HFStreamFrameResult, *PHFStreamFrameResult;
+
+/**
+ * @brief Callback receiving the results of a stream session, called on its pipeline thread.
+ *
+ * The result and the arrays it points to are only valid during the call.
+ */
+typedef void (*HFStreamResultCallback)(PHFStreamFrameResult result, HPVoid userData);
+
+/**
+ * @brief Create a stream session, which runs detection and tracking on one thread and the face
+ * pipeline on another, so consecutive frames of a video overlap.
+ *
+ * Interaction liveness runs with tracking. Liveness, mask, attribute and recognition run in the
+ * pipeline stage, which loads its own copy of the models.
+ *
+ * @param parameter Functions run on every frame.
+ * @param detectMode Detection mode to be used.
+ * @param maxDetectFaceNum Maximum number of faces to detect.
+ * @param detectPixelLevel Input resolution level of the detector, -1 for the default.
+ * @param trackByDetectModeFPS Frame rate of the stream in MODE_TRACK_BY_DETECTION, -1 for 30fps.
+ * @param queueCapacity Number of frames each queue between the stages can hold.
+ * @param handle Pointer to the stream session handle that will be returned.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFCreateInspireFaceStreamSession(HFSessionCustomParameter parameter, HFDetectMode detectMode,
+                                                                  HInt32 maxDetectFaceNum, HInt32 detectPixelLevel, HInt32 trackByDetectModeFPS,
+                                                                  HInt32 queueCapacity, HFStreamSession *handle);
+
+/**
+ * @brief Release the stream session, frames not processed yet are dropped.
+ *
+ * @param handle Handle to the stream session to be released.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFReleaseInspireFaceStreamSession(HFStreamSession handle);
+
+/**
+ * @brief Set the callback receiving the results, pass NULL to poll them with HFStreamSessionPollResult.
+ *
+ * @param session Handle to the stream session.
+ * @param callback The result callback.
+ * @param userData Pointer passed to the callback.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFStreamSessionSetResultCallback(HFStreamSession session, HFStreamResultCallback callback, HPVoid userData);
+
+/**
+ * @brief Copy a frame into the input queue of the stream session.
+ *
+ * @param session Handle to the stream session.
+ * @param data The image data, it may be reused as soon as the function returns.
+ * @param block 1 waits for room in the queue, 0 returns HERR_SESS_STREAM_QUEUE_FULL when it is full.
+ * @param frameId Receives the id of the frame, may be NULL.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFStreamSessionPushFrame(HFStreamSession session, PHFImageData data, HInt32 block, HPUInt64 frameId);
+
+/**
+ * @brief Take the oldest result when no result callback is set.
+ *
+ * The arrays of the result stay valid until the next poll or the release of the session.
+ *
+ * @param session Handle to the stream session.
+ * @param timeoutMs Milliseconds to wait for a result, 0 returns at once.
+ * @param result Pointer to the structure where the result will be stored.
+ * @return HSUCCEED, HERR_SESS_STREAM_TIMEOUT, or HERR_SESS_STREAM_STOPPED.
+ */
+HYPER_CAPI_EXPORT extern HResult HFStreamSessionPollResult(HFStreamSession session, HInt32 timeoutMs, PHFStreamFrameResult result);
+
+/**
+ * @brief Wait until every pushed frame reached the callback or the result queue.
+ *
+ * Without a callback only queueCapacity results fit in the result queue, poll them from another
+ * thread when more frames are in flight.
+ *
+ * @param session Handle to the stream session.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFStreamSessionFlush(HFStreamSession session);
+
+/************************************************************************
+ * Stream Server
+ ************************************************************************/
+
+/**
+ * @brief Create a stream server, which serves many video streams with one set of models per worker thread.
+ *
+ * Every stream opened on the server keeps its own tracker state. A worker serves up to maxBatchStreams
+ * streams in one round, one frame each, and runs RGB liveness and recognition of all their faces as one
+ * batch. Streams are served in turn, so a busy stream cannot starve the others.
+ *
+ * @param parameter Functions run on every frame.
+ * @param detectMode Detection mode of every stream.
+ * @param maxDetectFaceNum Maximum number of faces to detect in a frame.
+ * @param detectPixelLevel Input resolution level of the detector, -1 for the default.
+ * @param trackByDetectModeFPS Frame rate of the streams in MODE_TRACK_BY_DETECTION, -1 for 30fps.
+ * @param numWorkers Number of worker threads, each loads one set of models.
+ * @param maxBatchStreams Maximum number of streams a worker serves in one round.
+ * @param queueCapacity Number of frames the queue of each stream and the result queue can hold.
+ * @param handle Pointer to the stream server handle that will be returned.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFCreateInspireFaceStreamServer(HFSessionCustomParameter parameter, HFDetectMode detectMode,
+                                                                 HInt32 maxDetectFaceNum, HInt32 detectPixelLevel, HInt32 trackByDetectModeFPS,
+                                                                 HInt32 numWorkers, HInt32 maxBatchStreams, HInt32 queueCapacity,
+                                                                 HFStreamServer *handle);
+
+/**
+ * @brief Release the stream server and its streams, frames not processed yet are dropped.
+ *
+ * @param handle Handle to the stream server to be released.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFReleaseInspireFaceStreamServer(HFStreamServer handle);
+
+/**
+ * @brief Open a stream on the stream server.
+ *
+ * @param server Handle to the stream server.
+ * @param streamId Receives the id of the stream.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFStreamServerOpenStream(HFStreamServer server, HPInt32 streamId);
+
+/**
+ * @brief Close a stream of the stream server, its queued frames are dropped.
+ *
+ * @param server Handle to the stream server.
+ * @param streamId Id of the stream.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFStreamServerCloseStream(HFStreamServer server, HInt32 streamId);
+
+/**
+ * @brief Set the callback receiving the results, pass NULL to poll them with HFStreamServerPollResult.
+ *
+ * The callback is called on the worker threads, possibly several at a time.
+ *
+ * @param server Handle to the stream server.
+ * @param callback The result callback.
+ * @param userData Pointer passed to the callback.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFStreamServerSetResultCallback(HFStreamServer server, HFStreamResultCallback callback, HPVoid userData);
+
+/**
+ * @brief Copy a frame into the queue of a stream.
+ *
+ * @param server Handle to the stream server.
+ * @param streamId Id of the stream.
+ * @param data The image data, it may be reused as soon as the function returns.
+ * @param block 1 waits for room in the queue, 0 returns HERR_SESS_STREAM_QUEUE_FULL when it is full.
+ * @param frameId Receives the id of the frame within its stream, may be NULL.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFStreamServerPushFrame(HFStreamServer server, HInt32 streamId, PHFImageData data, HInt32 block,
+                                                         HPUInt64 frameId);
+
+/**
+ * @brief Take the oldest result of any stream when no result callback is set.
+ *
+ * The arrays of the result stay valid until the next poll or the release of the server, poll from one thread.
+ *
+ * @param server Handle to the stream server.
+ * @param timeoutMs Milliseconds to wait for a result, 0 returns at once.
+ * @param result Pointer to the structure where the result will be stored.
+ * @return HSUCCEED, HERR_SESS_STREAM_TIMEOUT, or HERR_SESS_STREAM_STOPPED.
+ */
+HYPER_CAPI_EXPORT extern HResult HFStreamServerPollResult(HFStreamServer server, HInt32 timeoutMs, PHFStreamFrameResult result);
+
+/**
+ * @brief Wait until every pushed frame reached the callback or the result queue.
+ *
+ * @param server Handle to the stream server.
+ * @return HResult indicating the success or failure of the operation.
+ */
+HYPER_CAPI_EXPORT extern HResult HFStreamServerFlush(HFStreamServer server);
+
 /************************************************************************
  * System Function
  ************************************************************************/
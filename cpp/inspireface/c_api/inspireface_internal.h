@@ -6,7 +6,11 @@
 #ifndef INSPIREFACE_INTERNAL_H
 #define INSPIREFACE_INTERNAL_H
 
+#include <vector>
+#include "inspireface.h"
 #include "engine/face_session.h"
+#include "engine/face_stream_session.h"
+#include "engine/face_stream_server.h"
 
 typedef struct HF_FaceAlgorithmSession {
     inspire::FaceSession impl;  ///< Implementation of the face context.
@@ -20,4 +24,26 @@ typedef struct HF_ImageBitmap {
     inspirecv::Image impl;  ///< Implementation of the image bitmap.
 } HF_ImageBitmap;           ///< Handle for managing image bitmap.
 
+typedef struct HF_StreamResultBuffer {
+    inspire::FaceStreamResult result;      ///< Result of the last poll.
+    std::vector<HFFaceBasicToken> tokens;  ///< Tokens of the faces.
+    std::vector<HFaceRect> rects;          ///< Face rectangles.
+    std::vector<HInt32> trackIds;          ///< Track ids.
+    std::vector<HFloat> angles[3];         ///< Roll, yaw and pitch.
+    std::vector<HFloat> eyes[2];           ///< Left and right eye status.
+    std::vector<HInt32> actions[5];        ///< Normal, shake, jaw open, head raise and blink.
+    std::vector<HInt32> attributes[3];     ///< Race, gender and age bracket.
+    std::vector<HFFaceFeature> features;   ///< Feature of each face.
+} HF_StreamResultBuffer;                   ///< Arrays behind the pointers of a stream result.
+
+typedef struct HF_FaceAlgorithmStreamSession {
+    inspire::FaceStreamSession impl;  ///< Implementation of the stream session.
+    HF_StreamResultBuffer polled;     ///< Arrays of the last polled result.
+} HF_FaceAlgorithmStreamSession;      ///< Handle for managing stream session.
+
+typedef struct HF_FaceAlgorithmStreamServer {
+    inspire::FaceStreamServer impl;  ///< Implementation of the stream server.
+    HF_StreamResultBuffer polled;    ///< Arrays of the last polled result.
+} HF_FaceAlgorithmStreamServer;      ///< Handle for managing stream server.
+
 #endif  // INSPIREFACE_INTERNAL_H
@@ -12,6 +12,8 @@ typedef void*               HPVoid;                           ///< Pointer to Vo
 typedef void*               HFImageStream;                   ///< Handle for image.
 typedef void*               HFSession;                       ///< Handle for context.
 typedef void*               HFImageBitmap;                   ///< Handle for image bitmap.
+typedef void*               HFStreamSession;                 ///< Handle for stream session.
+typedef void*               HFStreamServer;                  ///< Handle for stream server.
 typedef long                HLong;                            ///< Long integer.
 typedef float               HFloat;                          ///< Single-precision floating point.
 typedef float*              HPFloat;                         ///< Pointer to Single-precision floating point.
@@ -21,6 +23,8 @@ typedef unsigned char*      HPUInt8;                          ///< Pointer to un
 typedef signed int			HInt32;                           ///< Signed 32-bit integer.
 typedef signed int			HOption;                          ///< Signed 32-bit integer option.
 typedef signed int*			HPInt32;                          ///< Pointer to signed 32-bit integer.
+typedef uint64_t            HUInt64;                          ///< Unsigned 64-bit integer.
+typedef uint64_t*           HPUInt64;                         ///< Pointer to unsigned 64-bit integer.
 typedef int64_t             HFaceId;                          ///< Face ID type for non-Windows platforms
 typedef int64_t*            HPFaceId;                         ///< Pointer to Face ID type for non-Windows platforms
 typedef long                HResult;                          ///< Result code.
@@ -91,9 +91,9 @@ inline FaceTrackWrap INSPIRE_API FaceObjectInternalToHyperFaceData(const FaceObj
     data.face3DAngle.roll = obj.high_result.roll;
     data.face3DAngle.yaw = obj.high_result.yaw;
     // Density Landmark
-    if (!obj.landmark_smooth_aux_.empty()) {
+    if (!obj.landmark_smooth_aux_.Empty()) {
         data.densityLandmarkEnable = 1;
-        const auto& lmk = obj.landmark_smooth_aux_.back();
+        const auto& lmk = obj.landmark_;
         for (size_t i = 0; i < FaceLandmarkAdapt::NUM_OF_LANDMARK; i++) {
             data.densityLandmark[i].x = lmk[i].GetX();
             data.densityLandmark[i].y = lmk[i].GetY();
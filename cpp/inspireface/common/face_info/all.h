@@ -9,5 +9,6 @@
 #include "face_object_internal.h"
 #include "face_action_data.h"
 #include "face_process.h"
+#include "landmark_history.h"
 
 #endif  // INSPIRE_FACE_FO_ALL_H
@@ -8,6 +8,7 @@
 #include "data_type.h"
 #include "face_process.h"
 #include "face_action_data.h"
+#include "landmark_history.h"
 #include "track_module/quality/face_pose_quality_adapt.h"
 
 namespace inspire {
@@ -29,6 +30,39 @@ public:
         num_of_dense_landmark_ = num_landmark;
     }
 
+    /**
+     * @brief Turns a retired face into a newly detected one, keeping the buffers it already allocated.
+     */
+    void Reset(int instance_id, const inspirecv::Rect2i &bbox, int num_landmark = 106) {
+        face_id_ = instance_id;
+        landmark_.assign(num_landmark, inspirecv::Point2f());
+        landmark_smooth_aux_.Clear();
+        bbox_ = bbox;
+        detect_bbox_ = bbox;
+        tracking_state_ = ISF_DETECT;
+        confidence_ = 1.0;
+        tracking_count_ = 0;
+        align_mse_ = 0.0f;
+        is_standard_ = false;
+        pose_euler_angle_.assign(3, 0.0f);
+        keyPointFive.assign(5, inspirecv::Point2f());
+        high_result.pitch = 0.0f;
+        high_result.yaw = 0.0f;
+        high_result.roll = 0.0f;
+        high_result.lmk.clear();
+        high_result.lmk_quality.clear();
+        faceProcess = FaceProcess();
+        left_eye_status_.clear();
+        right_eye_status_.clear();
+        if (face_action_.use_count() == 1) {
+            face_action_->Reset();
+        } else {
+            // A copy handed out earlier still reads the predictor
+            face_action_ = std::make_shared<FaceActionPredictor>(10);
+        }
+        num_of_dense_landmark_ = num_landmark;
+    }
+
     void SetLandmark(const std::vector<inspirecv::Point2f> &lmk, bool update_rect = true, bool update_matrix = true, float h = 0.06f, int n = 5,
                      int num_of_lmk = 106 * 2) {
         // if (lmk.size() != landmark_.size()) {
@@ -164,42 +198,18 @@ public:
         return sqrt((x0 - x1) * (x0 - x1) + (y0 - y1) * (y0 - y1));
     }
 
-    void DynamicSmoothParamUpdate(std::vector<inspirecv::Point2f> &landmarks, std::vector<std::vector<inspirecv::Point2f>> &landmarks_lastNframes,
-                                  int lm_length, float h = 0.06f, int n = 5) {
-        std::vector<inspirecv::Point2f> landmarks_temp;
-        landmarks_temp.assign(landmarks.begin(), landmarks.end());
-        if (landmarks_lastNframes.size() == n) {
-            for (int i = 0; i < lm_length / 2; i++) {
-                float sum_d = 1;
-                float max_d = 0;
-                for (int j = 0; j < n; j++) {
-                    float d = L2norm(landmarks_temp[i].GetX(), landmarks_temp[i].GetY(), landmarks_lastNframes[j][i].GetX(),
-                                     landmarks_lastNframes[j][i].GetY());
-                    if (d > max_d)
-                        max_d = d;
-                }
-                for (int j = 0; j < n; j++) {
-                    float d = exp(-max_d * (n - j) * h);
-                    sum_d += d;
-                    landmarks[i].SetX(landmarks[i].GetX() + d * landmarks_lastNframes[j][i].GetX());
-                    landmarks[i].SetY(landmarks[i].GetY() + d * landmarks_lastNframes[j][i].GetY());
-                }
-                landmarks[i].SetX(landmarks[i].GetX() / sum_d);
-                landmarks[i].SetY(landmarks[i].GetY() / sum_d);
-            }
-        }
-        std::vector<inspirecv::Point2f> landmarks_frame;
-        for (int i = 0; i < lm_length / 2; i++) {
-            landmarks_frame.push_back(inspirecv::Point2f(landmarks[i].GetX(), landmarks[i].GetY()));
+    void DynamicSmoothParamUpdate(std::vector<inspirecv::Point2f> &landmarks, LandmarkHistory &landmarks_lastNframes, int lm_length, float h = 0.06f,
+                                  int n = 5) {
+        const size_t num_points = lm_length / 2;
+        if (landmarks_lastNframes.Capacity() != n || landmarks_lastNframes.NumPoints() != num_points) {
+            landmarks_lastNframes.Reset(n, num_points);
         }
-        landmarks_lastNframes.push_back(landmarks_frame);
-        if (landmarks_lastNframes.size() > n)
-            landmarks_lastNframes.erase(landmarks_lastNframes.begin());
+        landmarks_lastNframes.SmoothAndPush(landmarks, h);
     }
 
 public:
     std::vector<inspirecv::Point2f> landmark_;
-    std::vector<std::vector<inspirecv::Point2f>> landmark_smooth_aux_;
+    LandmarkHistory landmark_smooth_aux_;  ///< Smoothed landmarks of the last frames, the latest equals landmark_
     inspirecv::Rect2i bbox_;
     inspirecv::Vec3f euler_angle_;
     std::vector<float> pose_euler_angle_;
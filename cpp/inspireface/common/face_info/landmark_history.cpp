@@ -0,0 +1,196 @@
+/**
+ * Created by Jingyu Yan
+ * @date 2024-10-01
+ */
+
+#include "landmark_history.h"
+#include <algorithm>
+#include <cmath>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#define ISF_SMOOTH_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define ISF_SMOOTH_NEON
+#endif
+
+namespace inspire {
+
+namespace {
+
+// Polynomial of exp on [-ln2 / 2, ln2 / 2] and the split of ln2, as in the Cephes expf
+const float kLog2e = 1.44269504088896341f;
+const float kLn2Hi = 0.693359375f;
+const float kLn2Lo = -2.12194440e-4f;
+const float kExpP0 = 1.9875691500e-4f;
+const float kExpP1 = 1.3981999507e-3f;
+const float kExpP2 = 8.3334519073e-3f;
+const float kExpP3 = 4.1665795894e-2f;
+const float kExpP4 = 1.6666665459e-1f;
+const float kExpP5 = 5.0000001201e-1f;
+// Below this exp underflows, the weights are zero anyway
+const float kExpMin = -87.0f;
+
+#if defined(ISF_SMOOTH_SSE2)
+
+// exp of four values, within a couple of ulps of std::exp
+inline __m128 Exp4(__m128 x) {
+    x = _mm_max_ps(x, _mm_set1_ps(kExpMin));
+    // n = floor(x / ln2 + 0.5), x = x - n * ln2
+    __m128 fx = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(kLog2e)), _mm_set1_ps(0.5f));
+    __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+    fx = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, fx), _mm_set1_ps(1.0f)));
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(kLn2Hi)));
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(kLn2Lo)));
+    __m128 y = _mm_set1_ps(kExpP0);
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kExpP1));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kExpP2));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kExpP3));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kExpP4));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kExpP5));
+    y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, _mm_mul_ps(x, x)), x), _mm_set1_ps(1.0f));
+    // 2^n built in the exponent bits
+    __m128i n = _mm_add_epi32(_mm_cvttps_epi32(fx), _mm_set1_epi32(127));
+    return _mm_mul_ps(y, _mm_castsi128_ps(_mm_slli_epi32(n, 23)));
+}
+
+#elif defined(ISF_SMOOTH_NEON)
+
+// exp of four values, within a couple of ulps of std::exp
+inline float32x4_t Exp4(float32x4_t x) {
+    x = vmaxq_f32(x, vdupq_n_f32(kExpMin));
+    float32x4_t fx = vmlaq_f32(vdupq_n_f32(0.5f), x, vdupq_n_f32(kLog2e));
+    float32x4_t truncated = vcvtq_f32_s32(vcvtq_s32_f32(fx));
+    uint32x4_t above = vcgtq_f32(truncated, fx);
+    fx = vsubq_f32(truncated, vreinterpretq_f32_u32(vandq_u32(above, vreinterpretq_u32_f32(vdupq_n_f32(1.0f)))));
+    x = vmlsq_f32(x, fx, vdupq_n_f32(kLn2Hi));
+    x = vmlsq_f32(x, fx, vdupq_n_f32(kLn2Lo));
+    float32x4_t y = vdupq_n_f32(kExpP0);
+    y = vmlaq_f32(vdupq_n_f32(kExpP1), y, x);
+    y = vmlaq_f32(vdupq_n_f32(kExpP2), y, x);
+    y = vmlaq_f32(vdupq_n_f32(kExpP3), y, x);
+    y = vmlaq_f32(vdupq_n_f32(kExpP4), y, x);
+    y = vmlaq_f32(vdupq_n_f32(kExpP5), y, x);
+    y = vaddq_f32(vmlaq_f32(x, y, vmulq_f32(x, x)), vdupq_n_f32(1.0f));
+    int32x4_t n = vaddq_s32(vcvtq_s32_f32(fx), vdupq_n_s32(127));
+    return vmulq_f32(y, vreinterpretq_f32_s32(vshlq_n_s32(n, 23)));
+}
+
+#endif
+
+}  // namespace
+
+void LandmarkHistory::SmoothAndPush(std::vector<inspirecv::Point2f> &landmarks, float h) {
+    if (capacity_ == 0) {
+        return;
+    }
+    float *cx = current_xs_.data();
+    float *cy = current_ys_.data();
+    for (size_t i = 0; i < num_points_; ++i) {
+        cx[i] = landmarks[i].GetX();
+        cy[i] = landmarks[i].GetY();
+    }
+
+    if (size_ == capacity_) {
+        // The weight of the frame of age k is exp(-max_d * h)^k, a single exp per point
+        const size_t n = capacity_;
+        // Rows of the kept frames, oldest first
+        const float **rows_x = frame_rows_.data();
+        const float **rows_y = frame_rows_.data() + n;
+        for (size_t j = 0; j < n; ++j) {
+            rows_x[j] = X(j);
+            rows_y[j] = Y(j);
+        }
+        size_t i = 0;
+#if defined(ISF_SMOOTH_SSE2)
+        for (; i + 4 <= num_points_; i += 4) {
+            const __m128 x = _mm_loadu_ps(cx + i);
+            const __m128 y = _mm_loadu_ps(cy + i);
+            __m128 max_d2 = _mm_setzero_ps();
+            for (size_t j = 0; j < n; ++j) {
+                const __m128 dx = _mm_sub_ps(x, _mm_loadu_ps(rows_x[j] + i));
+                const __m128 dy = _mm_sub_ps(y, _mm_loadu_ps(rows_y[j] + i));
+                max_d2 = _mm_max_ps(max_d2, _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+            }
+            const __m128 decay = Exp4(_mm_mul_ps(_mm_sqrt_ps(max_d2), _mm_set1_ps(-h)));
+            __m128 weight = decay;
+            __m128 sum_w = _mm_set1_ps(1.0f);
+            __m128 sum_x = x;
+            __m128 sum_y = y;
+            for (size_t j = n; j-- > 0;) {
+                sum_w = _mm_add_ps(sum_w, weight);
+                sum_x = _mm_add_ps(sum_x, _mm_mul_ps(weight, _mm_loadu_ps(rows_x[j] + i)));
+                sum_y = _mm_add_ps(sum_y, _mm_mul_ps(weight, _mm_loadu_ps(rows_y[j] + i)));
+                weight = _mm_mul_ps(weight, decay);
+            }
+            _mm_storeu_ps(cx + i, _mm_div_ps(sum_x, sum_w));
+            _mm_storeu_ps(cy + i, _mm_div_ps(sum_y, sum_w));
+        }
+#elif defined(ISF_SMOOTH_NEON)
+        for (; i + 4 <= num_points_; i += 4) {
+            const float32x4_t x = vld1q_f32(cx + i);
+            const float32x4_t y = vld1q_f32(cy + i);
+            float32x4_t max_d2 = vdupq_n_f32(0.0f);
+            for (size_t j = 0; j < n; ++j) {
+                const float32x4_t dx = vsubq_f32(x, vld1q_f32(rows_x[j] + i));
+                const float32x4_t dy = vsubq_f32(y, vld1q_f32(rows_y[j] + i));
+                max_d2 = vmaxq_f32(max_d2, vmlaq_f32(vmulq_f32(dx, dx), dy, dy));
+            }
+            // No vector square root on armv7, it is taken lane by lane
+            float d2[4];
+            vst1q_f32(d2, max_d2);
+            for (int k = 0; k < 4; ++k) {
+                d2[k] = std::sqrt(d2[k]);
+            }
+            const float32x4_t decay = Exp4(vmulq_n_f32(vld1q_f32(d2), -h));
+            float32x4_t weight = decay;
+            float32x4_t sum_w = vdupq_n_f32(1.0f);
+            float32x4_t sum_x = x;
+            float32x4_t sum_y = y;
+            for (size_t j = n; j-- > 0;) {
+                sum_w = vaddq_f32(sum_w, weight);
+                sum_x = vmlaq_f32(sum_x, weight, vld1q_f32(rows_x[j] + i));
+                sum_y = vmlaq_f32(sum_y, weight, vld1q_f32(rows_y[j] + i));
+                weight = vmulq_f32(weight, decay);
+            }
+            float w[4], sx[4], sy[4];
+            vst1q_f32(w, sum_w);
+            vst1q_f32(sx, sum_x);
+            vst1q_f32(sy, sum_y);
+            for (int k = 0; k < 4; ++k) {
+                cx[i + k] = sx[k] / w[k];
+                cy[i + k] = sy[k] / w[k];
+            }
+        }
+#endif
+        for (; i < num_points_; ++i) {
+            float max_d2 = 0.0f;
+            for (size_t j = 0; j < n; ++j) {
+                const float dx = cx[i] - rows_x[j][i];
+                const float dy = cy[i] - rows_y[j][i];
+                max_d2 = (std::max)(max_d2, dx * dx + dy * dy);
+            }
+            const float decay = std::exp(-std::sqrt(max_d2) * h);
+            float weight = decay;
+            float sum_w = 1.0f;
+            float sum_x = cx[i];
+            float sum_y = cy[i];
+            for (size_t j = n; j-- > 0;) {
+                sum_w += weight;
+                sum_x += weight * rows_x[j][i];
+                sum_y += weight * rows_y[j][i];
+                weight *= decay;
+            }
+            cx[i] = sum_x / sum_w;
+            cy[i] = sum_y / sum_w;
+        }
+        for (size_t k = 0; k < num_points_; ++k) {
+            landmarks[k].SetX(cx[k]);
+            landmarks[k].SetY(cy[k]);
+        }
+    }
+
+    Push(landmarks);
+}
+
+}  // namespace inspire
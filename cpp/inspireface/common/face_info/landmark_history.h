@@ -0,0 +1,130 @@
+/**
+ * Created by Jingyu Yan
+ * @date 2024-10-01
+ */
+#pragma once
+#ifndef INSPIRE_FACE_LANDMARK_HISTORY_H
+#define INSPIRE_FACE_LANDMARK_HISTORY_H
+
+#include <vector>
+#include <inspirecv/inspirecv.h>
+#include "data_type.h"
+
+namespace inspire {
+
+/**
+ * @class LandmarkHistory
+ * @brief Landmarks of the last frames of a track, kept in a fixed-capacity ring buffer.
+ *
+ * The x and y coordinates are stored in separate arrays, one row of num_points per frame, so the
+ * smoothing loops read contiguous floats. Once sized, pushing a frame overwrites the oldest one and
+ * never allocates.
+ */
+class INSPIRE_API LandmarkHistory {
+public:
+    /**
+     * @brief Empties the history and sizes it, the buffers only grow.
+     * @param capacity Number of frames kept.
+     * @param num_points Number of landmarks per frame.
+     */
+    void Reset(size_t capacity, size_t num_points) {
+        capacity_ = capacity;
+        num_points_ = num_points;
+        if (xs_.size() < capacity * num_points) {
+            xs_.resize(capacity * num_points);
+            ys_.resize(capacity * num_points);
+        }
+        frame_rows_.resize(capacity * 2);
+        if (current_xs_.size() < num_points) {
+            current_xs_.resize(num_points);
+            current_ys_.resize(num_points);
+        }
+        Clear();
+    }
+
+    /**
+     * @brief Empties the history and keeps its size.
+     */
+    void Clear() {
+        head_ = 0;
+        size_ = 0;
+    }
+
+    /**
+     * @brief Appends the first num_points landmarks as the latest frame, the oldest frame is dropped when full.
+     */
+    void Push(const std::vector<inspirecv::Point2f> &points) {
+        if (capacity_ == 0) {
+            return;
+        }
+        size_t slot;
+        if (size_ < capacity_) {
+            slot = (head_ + size_) % capacity_;
+            size_++;
+        } else {
+            slot = head_;
+            head_ = (head_ + 1) % capacity_;
+        }
+        float *xs = &xs_[slot * num_points_];
+        float *ys = &ys_[slot * num_points_];
+        for (size_t i = 0; i < num_points_; ++i) {
+            xs[i] = points[i].GetX();
+            ys[i] = points[i].GetY();
+        }
+    }
+
+    /**
+     * @brief Smooths the first num_points landmarks against the kept frames once the history is full, then pushes them.
+     * @details A point moves towards its past positions with the weights exp(-max_d * h * age), max_d being
+     * its largest distance to them, so a still point is averaged over the frames and a moving one follows
+     * the latest. The points are processed four at a time with SSE2 or NEON when available.
+     * @param landmarks Landmarks of the current frame, smoothed in place.
+     * @param h Smoothing ratio, a larger one follows the motion faster.
+     */
+    void SmoothAndPush(std::vector<inspirecv::Point2f> &landmarks, float h);
+
+    /**
+     * @brief X coordinates of a frame, 0 being the oldest.
+     */
+    const float *X(size_t frame) const {
+        return &xs_[((head_ + frame) % capacity_) * num_points_];
+    }
+
+    /**
+     * @brief Y coordinates of a frame, 0 being the oldest.
+     */
+    const float *Y(size_t frame) const {
+        return &ys_[((head_ + frame) % capacity_) * num_points_];
+    }
+
+    size_t Size() const {
+        return size_;
+    }
+
+    size_t Capacity() const {
+        return capacity_;
+    }
+
+    size_t NumPoints() const {
+        return num_points_;
+    }
+
+    bool Empty() const {
+        return size_ == 0;
+    }
+
+private:
+    std::vector<float> xs_;  ///< X coordinates, one row of num_points per slot
+    std::vector<float> ys_;  ///< Y coordinates, one row of num_points per slot
+    std::vector<float> current_xs_;  ///< X coordinates of the frame being smoothed
+    std::vector<float> current_ys_;  ///< Y coordinates of the frame being smoothed
+    std::vector<const float *> frame_rows_;  ///< X then Y rows of the kept frames, filled while smoothing
+    size_t capacity_ = 0;
+    size_t num_points_ = 0;
+    size_t head_ = 0;  ///< Slot of the oldest frame
+    size_t size_ = 0;  ///< Number of frames kept
+};
+
+}  // namespace inspire
+
+#endif  // INSPIRE_FACE_LANDMARK_HISTORY_H
@@ -48,6 +48,37 @@ int32_t FaceSession::Configuration(DetectModuleMode detect_mode, int32_t max_det
     return HSUCCEED;
 }
 
+int32_t FaceSession::ConfigurationSharedModels(DetectModuleMode detect_mode, int32_t max_detect_face, CustomPipelineParameter param,
+                                               const FaceSession& models, int32_t detect_level_px, int32_t track_by_detect_mode_fps) {
+    m_detect_mode_ = detect_mode;
+    m_max_detect_face_ = max_detect_face;
+    m_parameter_ = param;
+    if (m_parameter_.enable_interaction_liveness) {
+        m_parameter_.enable_detect_mode_landmark = true;
+    }
+
+    // Only the tracker state is created, the networks come from the models session
+    m_face_track_ = std::make_shared<FaceTrackModule>(m_detect_mode_, m_max_detect_face_, 20, 192, detect_level_px, track_by_detect_mode_fps,
+                                                      m_parameter_.enable_detect_mode_landmark);
+    m_face_track_cost_ = std::make_shared<inspire::SpendTimer>("FaceTrack");
+
+    return ShareModels(models);
+}
+
+int32_t FaceSession::ShareModels(const FaceSession& models) {
+    if (models.m_face_track_ == nullptr || models.m_face_recognition_ == nullptr || models.m_face_pipeline_ == nullptr) {
+        return HERR_SESS_FUNCTION_UNUSABLE;
+    }
+    if (m_face_track_ == nullptr) {
+        return HERR_SESS_TRACKER_FAILURE;
+    }
+    m_face_track_->ShareNetworks(*models.m_face_track_);
+    m_face_recognition_ = models.m_face_recognition_;
+    m_face_pipeline_ = models.m_face_pipeline_;
+
+    return HSUCCEED;
+}
+
 int32_t FaceSession::FaceDetectAndTrack(inspirecv::FrameProcess& process) {
     std::lock_guard<std::mutex> lock(m_mtx_);
     if (m_enable_track_cost_spend_) {
@@ -153,11 +184,14 @@ int32_t FaceSession::FacesProcess(inspirecv::FrameProcess& process, const std::v
     m_action_blink_results_cache_.resize(faces.size(), -1);
     m_action_raise_head_results_cache_.resize(faces.size(), -1);
     m_action_shake_results_cache_.resize(faces.size(), -1);
+    // The upright frame, the alignments and the aligned crops are derived once for every option and face
+    auto& frame_cache = m_pipeline_frame_cache_;
+    frame_cache.Reset(process, faces.size());
     for (int i = 0; i < faces.size(); ++i) {
         const auto& face = faces[i];
         // RGB Liveness Detect
         if (param.enable_liveness) {
-            auto ret = m_face_pipeline_->Process(process, face, PROCESS_RGB_LIVENESS);
+            auto ret = m_face_pipeline_->Process(frame_cache, i, face, PROCESS_RGB_LIVENESS);
             if (ret != HSUCCEED) {
                 return ret;
             }
@@ -165,7 +199,7 @@ int32_t FaceSession::FacesProcess(inspirecv::FrameProcess& process, const std::v
         }
         // Mask detection
         if (param.enable_mask_detect) {
-            auto ret = m_face_pipeline_->Process(process, face, PROCESS_MASK);
+            auto ret = m_face_pipeline_->Process(frame_cache, i, face, PROCESS_MASK);
             if (ret != HSUCCEED) {
                 return ret;
             }
@@ -173,7 +207,7 @@ int32_t FaceSession::FacesProcess(inspirecv::FrameProcess& process, const std::v
         }
         // Face attribute prediction
         if (param.enable_face_attribute) {
-            auto ret = m_face_pipeline_->Process(process, face, PROCESS_ATTRIBUTE);
+            auto ret = m_face_pipeline_->Process(frame_cache, i, face, PROCESS_ATTRIBUTE);
             if (ret != HSUCCEED) {
                 return ret;
             }
@@ -184,7 +218,7 @@ int32_t FaceSession::FacesProcess(inspirecv::FrameProcess& process, const std::v
 
         // Face interaction
         if (param.enable_interaction_liveness) {
-            auto ret = m_face_pipeline_->Process(process, face, PROCESS_INTERACTION);
+            auto ret = m_face_pipeline_->Process(frame_cache, i, face, PROCESS_INTERACTION);
             if (ret != HSUCCEED) {
                 return ret;
             }
@@ -427,6 +461,20 @@ int32_t FaceSession::SetTrackModeDetectInterval(int value) {
     return HSUCCEED;
 }
 
+int32_t FaceSession::SetTrackModeAdaptiveDetect(int value) {
+    m_face_track_->SetTrackModeAdaptiveDetect(value);
+    return HSUCCEED;
+}
+
+int32_t FaceSession::SetTrackModeTiledDetect(int tile_size, int motion_only) {
+    m_face_track_->SetTrackModeTiledDetect(tile_size, motion_only != 0);
+    return HSUCCEED;
+}
+
+int32_t FaceSession::SetTrackNumThreads(int value) {
+    return m_face_track_->SetTrackNumThreads(value);
+}
+
 int32_t FaceSession::SetEnableTrackCostSpend(int value) {
     m_enable_track_cost_spend_ = value;
     m_face_track_cost_->Reset();
@@ -46,6 +46,28 @@ public:
     int32_t Configuration(DetectModuleMode detect_mode, int32_t max_detect_face, CustomPipelineParameter param, int32_t detect_level_px = -1,
                           int32_t track_by_detect_mode_fps = -1);
 
+    /**
+     * @brief Configures a session that owns only its tracker state and runs on the models of another session.
+     * @param detect_mode The detection mode to be used (image or video).
+     * @param max_detect_face The maximum number of faces to detect.
+     * @param param Custom parameters for the face pipeline, the models session must have loaded their models.
+     * @param models Configured session whose models are used, see ShareModels.
+     * @param detect_level_px The input size of the detector, the one of the models session.
+     * @param track_by_detect_mode_fps The frame rate in track by detection mode.
+     * @return int32_t Returns 0 on success, non-zero for any error.
+     */
+    int32_t ConfigurationSharedModels(DetectModuleMode detect_mode, int32_t max_detect_face, CustomPipelineParameter param, const FaceSession& models,
+                                      int32_t detect_level_px = -1, int32_t track_by_detect_mode_fps = -1);
+
+    /**
+     * @brief Runs the following calls on the models of another session, the tracker state and the caches stay.
+     *
+     * The models are not copied, the caller keeps the two sessions from running at the same time.
+     * @param models Configured session whose models are used.
+     * @return int32_t Returns 0 on success, non-zero for any error.
+     */
+    int32_t ShareModels(const FaceSession& models);
+
     /**
      * @brief Performs face detection and tracking on a given image stream.
      * @param image The camera stream to process for face detection and tracking.
@@ -326,6 +348,28 @@ public:
      * */
     int32_t SetTrackModeDetectInterval(int value);
 
+    /**
+     * @brief Set the adaptive detection of the track mode
+     * @param value Maximum number of frames between two detections, 0 or less detects at the fixed interval
+     * @return int32_t Status code of the operation.
+     * */
+    int32_t SetTrackModeAdaptiveDetect(int value);
+
+    /**
+     * @brief Set the tiled detection of the track mode
+     * @param tile_size Side of the tiles in frame pixels, 0 or less detects on the preview only
+     * @param motion_only Non-zero to detect only the tiles that changed since they were last detected
+     * @return int32_t Status code of the operation.
+     * */
+    int32_t SetTrackModeTiledDetect(int tile_size, int motion_only);
+
+    /**
+     * @brief Set the number of threads tracking the faces of a frame
+     * @param value The number of threads, 1 tracks on the calling thread only
+     * @return int32_t Status code of the operation.
+     * */
+    int32_t SetTrackNumThreads(int value);
+
     /**
      * @brief Set the enable cost spend
      * @param value The enable cost spend value
@@ -354,6 +398,7 @@ private:
     std::vector<ByteArray> m_detect_cache_;                            ///< Cache for storing serialized detected face data
     std::vector<FaceBasicData> m_face_basic_data_cache_;               ///< Cache for basic face data extracted from detection
     std::vector<FaceRect> m_face_rects_cache_;                         ///< Cache for face rectangle data from detection
+    PipelineFrameCache m_pipeline_frame_cache_;                       ///< Images and transforms derived from the frame of FacesProcess
     std::vector<int32_t> m_track_id_cache_;                            ///< Cache for tracking IDs of detected faces
     std::vector<float> m_det_confidence_cache_;                        ///< Cache for face detection confidence of detected faces
     std::vector<float> m_roll_results_cache_;                          ///< Cache for storing roll results from face pose estimation
@@ -0,0 +1,410 @@
+/**
+ * Created by Jingyu Yan
+ * @date 2024-10-01
+ */
+
+#include "face_stream_server.h"
+#include <algorithm>
+#include "herror.h"
+
+namespace inspire {
+
+FaceStreamServer::FaceStreamServer()
+: m_detect_mode_(DETECT_MODE_ALWAYS_DETECT),
+  m_max_detect_face_(1),
+  m_detect_level_px_(-1),
+  m_track_by_detect_mode_fps_(-1),
+  m_track_preview_size_(-1),
+  m_detect_interval_(-1),
+  m_settings_version_(0),
+  m_max_batch_streams_(1),
+  m_queue_capacity_(1),
+  m_stop_(false),
+  m_next_stream_id_(0),
+  m_pending_frames_(0) {}
+
+FaceStreamServer::~FaceStreamServer() {
+    Stop();
+}
+
+int32_t FaceStreamServer::Configuration(DetectModuleMode detect_mode, int32_t max_detect_face, CustomPipelineParameter param, int32_t detect_level_px,
+                                        int32_t track_by_detect_mode_fps, int32_t num_workers, int32_t max_batch_streams, int32_t queue_capacity) {
+    if (!m_worker_models_.empty()) {
+        return HERR_SESS_FUNCTION_UNUSABLE;
+    }
+    m_parameter_ = param;
+    m_detect_mode_ = detect_mode;
+    m_max_detect_face_ = max_detect_face;
+    m_detect_level_px_ = detect_level_px;
+    m_track_by_detect_mode_fps_ = track_by_detect_mode_fps;
+    m_max_batch_streams_ = max_batch_streams > 0 ? max_batch_streams : 1;
+    m_queue_capacity_ = queue_capacity > 0 ? queue_capacity : 1;
+
+    // The streams only hold tracker state, these are the only models loaded
+    std::vector<std::unique_ptr<FaceSession>> models(num_workers > 0 ? num_workers : 1);
+    for (auto& worker : models) {
+        worker = std::make_unique<FaceSession>();
+        auto ret = worker->Configuration(detect_mode, max_detect_face, param, detect_level_px, track_by_detect_mode_fps);
+        if (ret != HSUCCEED) {
+            return ret;
+        }
+    }
+    m_worker_models_ = std::move(models);
+
+    m_result_queue_ = std::make_unique<parallel::BoundedQueue<FaceStreamResult>>(m_queue_capacity_);
+    m_stop_ = false;
+    for (size_t i = 0; i < m_worker_models_.size(); ++i) {
+        m_workers_.emplace_back(&FaceStreamServer::WorkerLoop, this, i);
+    }
+
+    return HSUCCEED;
+}
+
+void FaceStreamServer::SetTrackPreviewSize(int32_t preview_size) {
+    // A worker may be tracking with the session of an open stream, it applies the change before the next frame
+    std::lock_guard<std::mutex> lock(m_mtx_);
+    m_track_preview_size_ = preview_size;
+    ++m_settings_version_;
+}
+
+void FaceStreamServer::SetTrackModeDetectInterval(int32_t detect_interval) {
+    std::lock_guard<std::mutex> lock(m_mtx_);
+    m_detect_interval_ = detect_interval;
+    ++m_settings_version_;
+}
+
+void FaceStreamServer::ApplyTrackSettings(FaceSession& session, int32_t track_preview_size, int32_t detect_interval) {
+    if (track_preview_size > 0) {
+        session.SetTrackPreviewSize(track_preview_size);
+    }
+    if (detect_interval > 0) {
+        session.SetTrackModeDetectInterval(detect_interval);
+    }
+}
+
+int32_t FaceStreamServer::OpenStream(int32_t& stream_id) {
+    if (m_worker_models_.empty() || m_stop_) {
+        return HERR_SESS_STREAM_STOPPED;
+    }
+    auto stream = std::make_shared<Stream>();
+    stream->session = std::make_unique<FaceSession>();
+    auto ret = stream->session->ConfigurationSharedModels(m_detect_mode_, m_max_detect_face_, m_parameter_, *m_worker_models_[0],
+                                                          m_detect_level_px_, m_track_by_detect_mode_fps_);
+    if (ret != HSUCCEED) {
+        return ret;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mtx_);
+    ApplyTrackSettings(*stream->session, m_track_preview_size_, m_detect_interval_);
+    stream->settings_version = m_settings_version_;
+    stream->id = m_next_stream_id_++;
+    m_streams_[stream->id] = stream;
+    stream_id = stream->id;
+
+    return HSUCCEED;
+}
+
+int32_t FaceStreamServer::CloseStream(int32_t stream_id) {
+    std::deque<FramePtr> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mtx_);
+        auto it = m_streams_.find(stream_id);
+        if (it == m_streams_.end()) {
+            return HERR_INVALID_PARAM;
+        }
+        // A worker serving the stream keeps it alive, the ready list skips it from now on
+        it->second->closed = true;
+        dropped.swap(it->second->frames);
+        m_streams_.erase(it);
+    }
+    m_room_cv_.notify_all();
+    for (auto& frame : dropped) {
+        m_frame_pool_.Recycle(std::move(frame));
+        FinishFrame();
+    }
+
+    return HSUCCEED;
+}
+
+void FaceStreamServer::SetResultCallback(ResultCallback callback) {
+    std::lock_guard<std::mutex> lock(m_callback_mtx_);
+    m_callback_ = std::move(callback);
+}
+
+int32_t FaceStreamServer::PushFrame(int32_t stream_id, const uint8_t* data, int32_t height, int32_t width, inspirecv::DATA_FORMAT data_format,
+                                    inspirecv::ROTATION_MODE rotation_mode, bool block, uint64_t* frame_id) {
+    const auto pushed = std::chrono::steady_clock::now();
+    if (m_result_queue_ == nullptr || m_stop_) {
+        return HERR_SESS_STREAM_STOPPED;
+    }
+
+    auto frame = m_frame_pool_.Acquire();
+    auto ret = frame->Assign(data, height, width, data_format, rotation_mode);
+    if (ret != HSUCCEED) {
+        m_frame_pool_.Recycle(std::move(frame));
+        return ret;
+    }
+    frame->pushed = pushed;
+
+    std::unique_lock<std::mutex> lock(m_mtx_);
+    auto it = m_streams_.find(stream_id);
+    if (it == m_streams_.end()) {
+        m_frame_pool_.Recycle(std::move(frame));
+        return HERR_INVALID_PARAM;
+    }
+    auto stream = it->second;
+    if (block) {
+        m_room_cv_.wait(lock, [&] { return m_stop_ || stream->closed || stream->frames.size() < m_queue_capacity_; });
+    }
+    if (m_stop_ || stream->closed || stream->frames.size() >= m_queue_capacity_) {
+        m_frame_pool_.Recycle(std::move(frame));
+        if (m_stop_) {
+            return HERR_SESS_STREAM_STOPPED;
+        }
+        return stream->closed ? HERR_INVALID_PARAM : HERR_SESS_STREAM_QUEUE_FULL;
+    }
+    frame->result.frameId = stream->next_frame_id;
+    frame->result.streamId = stream->id;
+    if (frame_id != nullptr) {
+        *frame_id = stream->next_frame_id;
+    }
+    ++stream->next_frame_id;
+    {
+        std::lock_guard<std::mutex> flush_lock(m_flush_mtx_);
+        ++m_pending_frames_;
+    }
+    stream->frames.push_back(std::move(frame));
+    if (!stream->scheduled) {
+        stream->scheduled = true;
+        m_ready_.push_back(stream);
+        m_ready_cv_.notify_one();
+    }
+
+    return HSUCCEED;
+}
+
+int32_t FaceStreamServer::PollResult(FaceStreamResult& result, int64_t timeout_ms) {
+    if (m_result_queue_ == nullptr) {
+        return HERR_SESS_STREAM_STOPPED;
+    }
+    if (m_result_queue_->Pop(result, timeout_ms)) {
+        return HSUCCEED;
+    }
+    return m_stop_ ? HERR_SESS_STREAM_STOPPED : HERR_SESS_STREAM_TIMEOUT;
+}
+
+int32_t FaceStreamServer::Flush() {
+    std::unique_lock<std::mutex> lock(m_flush_mtx_);
+    m_flush_cv_.wait(lock, [this] { return m_pending_frames_ == 0; });
+    return m_stop_ ? HERR_SESS_STREAM_STOPPED : HSUCCEED;
+}
+
+void FaceStreamServer::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mtx_);
+        m_stop_ = true;
+    }
+    m_ready_cv_.notify_all();
+    m_room_cv_.notify_all();
+    // Wakes a worker blocked on a full result queue that nobody reads
+    if (m_result_queue_ != nullptr) {
+        m_result_queue_->Close();
+    }
+    for (auto& worker : m_workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    m_workers_.clear();
+
+    std::deque<FramePtr> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mtx_);
+        for (auto& stream : m_streams_) {
+            for (auto& frame : stream.second->frames) {
+                dropped.push_back(std::move(frame));
+            }
+            stream.second->frames.clear();
+            stream.second->scheduled = false;
+        }
+        m_ready_.clear();
+    }
+    for (auto& frame : dropped) {
+        m_frame_pool_.Recycle(std::move(frame));
+        FinishFrame();
+    }
+}
+
+uint64_t FaceStreamServer::GetPendingFrameCount() const {
+    std::lock_guard<std::mutex> lock(m_flush_mtx_);
+    return m_pending_frames_;
+}
+
+int32_t FaceStreamServer::GetStreamCount() const {
+    std::lock_guard<std::mutex> lock(m_mtx_);
+    return m_streams_.size();
+}
+
+void FaceStreamServer::WorkerLoop(size_t worker) {
+    const size_t num_workers = m_worker_models_.size();
+    std::vector<Job> jobs;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mtx_);
+            m_ready_cv_.wait(lock, [this] { return m_stop_ || !m_ready_.empty(); });
+            if (m_stop_) {
+                return;
+            }
+            // Leave a share of the ready streams to the other workers
+            const size_t share = (m_ready_.size() + num_workers - 1) / num_workers;
+            const size_t count = std::min(m_max_batch_streams_, share);
+            while (!m_ready_.empty() && jobs.size() < count) {
+                auto stream = std::move(m_ready_.front());
+                m_ready_.pop_front();
+                if (stream->closed || stream->frames.empty()) {
+                    stream->scheduled = false;
+                    continue;
+                }
+                Job job;
+                job.frame = std::move(stream->frames.front());
+                stream->frames.pop_front();
+                if (stream->settings_version != m_settings_version_) {
+                    job.apply_settings = true;
+                    job.track_preview_size = m_track_preview_size_;
+                    job.detect_interval = m_detect_interval_;
+                    stream->settings_version = m_settings_version_;
+                }
+                job.stream = std::move(stream);
+                jobs.push_back(std::move(job));
+            }
+        }
+        m_room_cv_.notify_all();
+
+        if (!jobs.empty()) {
+            ProcessJobs(*m_worker_models_[worker], jobs);
+        }
+
+        // The streams go back to the end of the list, behind every stream that waited meanwhile
+        bool requeued = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mtx_);
+            for (auto& job : jobs) {
+                if (!m_stop_ && !job.stream->closed && !job.stream->frames.empty()) {
+                    m_ready_.push_back(std::move(job.stream));
+                    requeued = true;
+                } else {
+                    job.stream->scheduled = false;
+                }
+            }
+        }
+        if (requeued) {
+            m_ready_cv_.notify_all();
+        }
+        jobs.clear();
+    }
+}
+
+void FaceStreamServer::ProcessJobs(FaceSession& models, std::vector<Job>& jobs) {
+    CustomPipelineParameter pipeline = m_parameter_;
+    // Batched over every stream of the round below
+    pipeline.enable_liveness = false;
+
+    std::vector<inspirecv::FrameProcess> processes(jobs.size());
+    std::vector<inspirecv::FrameProcess*> batch_frames;
+    std::vector<std::vector<FaceTrackWrap>> batch_faces;
+    std::vector<FaceStreamResult*> batch_results;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        auto& session = *jobs[i].stream->session;
+        auto& result = jobs[i].frame->result;
+        processes[i] = jobs[i].frame->Process();
+        // Only the worker serving the stream touches its session
+        if (jobs[i].apply_settings) {
+            ApplyTrackSettings(session, jobs[i].track_preview_size, jobs[i].detect_interval);
+        }
+        auto ret = session.ShareModels(models);
+        if (ret != HSUCCEED) {
+            result.status = ret;
+            continue;
+        }
+        TrackStreamFrame(session, m_parameter_, processes[i], result);
+        if (result.faces.empty()) {
+            continue;
+        }
+        PipelineStreamFrame(models, pipeline, processes[i], result);
+        batch_frames.push_back(&processes[i]);
+        batch_faces.push_back(result.faces);
+        batch_results.push_back(&result);
+    }
+
+    if (m_parameter_.enable_liveness && !batch_frames.empty()) {
+        std::vector<float> confidences;
+        auto ret = models.PipelineModule()->ProcessRGBLiveness(batch_frames, batch_faces, confidences);
+        size_t offset = 0;
+        for (auto result : batch_results) {
+            const size_t num = result->faces.size();
+            if (ret != HSUCCEED || offset + num > confidences.size()) {
+                if (result->status == HSUCCEED) {
+                    result->status = ret != HSUCCEED ? ret : HERR_SESS_PIPELINE_FAILURE;
+                }
+                continue;
+            }
+            result->rgbLivenessConfidence.assign(confidences.begin() + offset, confidences.begin() + offset + num);
+            offset += num;
+        }
+    }
+
+    if (m_parameter_.enable_recognition && !batch_frames.empty()) {
+        std::vector<Embedded> embeddings;
+        std::vector<float> norms;
+        auto ret = models.FaceRecognitionModule()->FaceExtract(batch_frames, batch_faces, embeddings, norms, true);
+        size_t offset = 0;
+        for (auto result : batch_results) {
+            const size_t num = result->faces.size();
+            result->embeddings.resize(num);
+            if (ret != HSUCCEED) {
+                if (result->status == HSUCCEED) {
+                    result->status = ret;
+                }
+                continue;
+            }
+            for (size_t i = 0; i < num; ++i) {
+                auto& embedding = result->embeddings[i];
+                embedding.isNormal = 1;
+                embedding.norm = norms[offset + i];
+                embedding.embedding = std::move(embeddings[offset + i]);
+            }
+            offset += num;
+        }
+    }
+
+    for (auto& job : jobs) {
+        Deliver(std::move(job.frame));
+    }
+}
+
+void FaceStreamServer::Deliver(FramePtr frame) {
+    auto& result = frame->result;
+    result.latencyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame->pushed).count();
+    ResultCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(m_callback_mtx_);
+        callback = m_callback_;
+    }
+    if (callback) {
+        callback(result);
+    } else {
+        // Fails only once stopped, the result is dropped then
+        m_result_queue_->Push(std::move(result));
+    }
+    m_frame_pool_.Recycle(std::move(frame));
+    FinishFrame();
+}
+
+void FaceStreamServer::FinishFrame() {
+    std::lock_guard<std::mutex> lock(m_flush_mtx_);
+    if (--m_pending_frames_ == 0) {
+        m_flush_cv_.notify_all();
+    }
+}
+
+}  // namespace inspire
@@ -0,0 +1,215 @@
+/**
+ * Created by Jingyu Yan
+ * @date 2024-10-01
+ */
+#pragma once
+#ifndef INSPIRE_FACE_STREAM_SERVER_H
+#define INSPIRE_FACE_STREAM_SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "face_session.h"
+#include "face_warpper.h"
+#include "stream_frame.h"
+#include "middleware/thread/bounded_queue.h"
+
+namespace inspire {
+
+/**
+ * @class FaceStreamServer
+ * @brief Serves many video streams with one set of models per worker thread.
+ *
+ * Each stream owns only its tracker state, a FaceSession configured with ConfigurationSharedModels,
+ * and a bounded queue of copied frames. A stream with queued frames waits in a FIFO ready list; a
+ * worker takes up to max_batch_streams streams from its front, tracks one frame of each on its own
+ * models, runs RGB liveness and recognition of all their faces as one batch, and puts the streams
+ * that still have frames back at the end of the list. Every stream thus gets one frame per round
+ * whatever the frame rate of the others, and the frames of a stream are processed one at a time,
+ * in push order. Results are delivered to the result callback if one is set, otherwise to a bounded
+ * queue read with PollResult.
+ */
+class INSPIRE_API FaceStreamServer {
+public:
+    using ResultCallback = std::function<void(const FaceStreamResult&)>;
+
+    FaceStreamServer();
+
+    /**
+     * @brief Stops the server, see Stop.
+     */
+    ~FaceStreamServer();
+
+    FaceStreamServer(const FaceStreamServer&) = delete;
+    FaceStreamServer& operator=(const FaceStreamServer&) = delete;
+
+    /**
+     * @brief Loads one set of models per worker and starts the workers.
+     * @param detect_mode The detection mode of every stream.
+     * @param max_detect_face The maximum number of faces to detect in a frame.
+     * @param param Functions run on every frame.
+     * @param detect_level_px The input size of the detector.
+     * @param track_by_detect_mode_fps The frame rate in track by detection mode.
+     * @param num_workers Number of worker threads, each loads its own models.
+     * @param max_batch_streams Maximum number of streams a worker serves in one round.
+     * @param queue_capacity Number of frames the queue of each stream and the result queue can hold.
+     * @return int32_t Returns 0 on success, non-zero for any error.
+     */
+    int32_t Configuration(DetectModuleMode detect_mode, int32_t max_detect_face, CustomPipelineParameter param, int32_t detect_level_px = -1,
+                          int32_t track_by_detect_mode_fps = -1, int32_t num_workers = 1, int32_t max_batch_streams = 8, int32_t queue_capacity = 4);
+
+    /**
+     * @brief Sets the track preview size of every stream, the open ones use it from their next frame.
+     */
+    void SetTrackPreviewSize(int32_t preview_size);
+
+    /**
+     * @brief Sets the detect interval of every stream, the open ones use it from their next frame.
+     */
+    void SetTrackModeDetectInterval(int32_t detect_interval);
+
+    /**
+     * @brief Opens a stream with a fresh tracker state.
+     * @param stream_id Receives the id of the stream.
+     * @return int32_t Returns 0 on success, non-zero for any error.
+     */
+    int32_t OpenStream(int32_t& stream_id);
+
+    /**
+     * @brief Closes a stream, its queued frames are dropped and a frame being processed is still delivered.
+     * @param stream_id Id of the stream.
+     * @return int32_t HSUCCEED, or HERR_INVALID_PARAM for an unknown stream.
+     */
+    int32_t CloseStream(int32_t stream_id);
+
+    /**
+     * @brief Sets the function receiving the results, called on the worker threads. Pass nullptr to poll.
+     */
+    void SetResultCallback(ResultCallback callback);
+
+    /**
+     * @brief Copies a frame into the queue of a stream.
+     * @param stream_id Id of the stream.
+     * @param data Pointer to the image data.
+     * @param height Height of the image.
+     * @param width Width of the image.
+     * @param data_format Data format of the image.
+     * @param rotation_mode Rotation of the image.
+     * @param block Wait for room in the queue if true, otherwise fail with HERR_SESS_STREAM_QUEUE_FULL.
+     * @param frame_id Receives the id of the frame within its stream, may be nullptr.
+     * @return int32_t Returns 0 on success, non-zero for any error.
+     */
+    int32_t PushFrame(int32_t stream_id, const uint8_t* data, int32_t height, int32_t width, inspirecv::DATA_FORMAT data_format,
+                      inspirecv::ROTATION_MODE rotation_mode, bool block = true, uint64_t* frame_id = nullptr);
+
+    /**
+     * @brief Takes the oldest result of any stream when no result callback is set.
+     * @param result Receives the result.
+     * @param timeout_ms Milliseconds to wait for a result, 0 returns at once.
+     * @return int32_t HSUCCEED, HERR_SESS_STREAM_TIMEOUT, or HERR_SESS_STREAM_STOPPED once stopped and empty.
+     */
+    int32_t PollResult(FaceStreamResult& result, int64_t timeout_ms);
+
+    /**
+     * @brief Waits until every pushed frame reached the callback or the result queue.
+     */
+    int32_t Flush();
+
+    /**
+     * @brief Stops the workers. Frames not processed yet are dropped, queued results can still be polled.
+     */
+    void Stop();
+
+    /**
+     * @brief Number of frames pushed and not delivered yet.
+     */
+    uint64_t GetPendingFrameCount() const;
+
+    /**
+     * @brief Number of open streams.
+     */
+    int32_t GetStreamCount() const;
+
+private:
+    using FramePtr = std::unique_ptr<StreamFrame>;
+
+    /**
+     * @brief Tracker state and queued frames of a stream.
+     */
+    struct Stream {
+        int32_t id;
+        std::unique_ptr<FaceSession> session;  ///< Tracker state, bound to the models of the worker serving it
+        std::deque<FramePtr> frames;           ///< Frames waiting, at most queue_capacity
+        uint64_t next_frame_id = 0;
+        uint64_t settings_version = 0;  ///< Version of the track settings applied to the session
+        bool scheduled = false;         ///< In the ready list or served by a worker
+        bool closed = false;
+    };
+
+    using StreamPtr = std::shared_ptr<Stream>;
+
+    /**
+     * @brief A frame taken from a stream by a worker.
+     */
+    struct Job {
+        StreamPtr stream;
+        FramePtr frame;
+        bool apply_settings = false;  ///< The track settings changed since the session last got them
+        int32_t track_preview_size = -1;
+        int32_t detect_interval = -1;
+    };
+
+    void WorkerLoop(size_t worker);
+
+    void ProcessJobs(FaceSession& models, std::vector<Job>& jobs);
+
+    void Deliver(FramePtr frame);
+
+    static void ApplyTrackSettings(FaceSession& session, int32_t track_preview_size, int32_t detect_interval);
+
+    void FinishFrame();
+
+private:
+    CustomPipelineParameter m_parameter_;  ///< Functions run on every frame
+    DetectModuleMode m_detect_mode_;
+    int32_t m_max_detect_face_;
+    int32_t m_detect_level_px_;
+    int32_t m_track_by_detect_mode_fps_;
+    int32_t m_track_preview_size_;
+    int32_t m_detect_interval_;
+    uint64_t m_settings_version_;  ///< Bumped by the track setters, the streams catch up before their next frame
+    size_t m_max_batch_streams_;
+    size_t m_queue_capacity_;
+
+    std::vector<std::unique_ptr<FaceSession>> m_worker_models_;  ///< Models of each worker
+    std::vector<std::thread> m_workers_;
+    std::atomic<bool> m_stop_;
+
+    mutable std::mutex m_mtx_;              ///< Guards the streams and the ready list
+    std::condition_variable m_ready_cv_;    ///< Signalled when a stream becomes ready or on stop
+    std::condition_variable m_room_cv_;     ///< Signalled when a frame leaves the queue of a stream
+    std::unordered_map<int32_t, StreamPtr> m_streams_;
+    std::deque<StreamPtr> m_ready_;         ///< Streams with frames waiting for a worker, served in order
+    int32_t m_next_stream_id_;
+
+    std::unique_ptr<parallel::BoundedQueue<FaceStreamResult>> m_result_queue_;  ///< Results waiting to be polled
+
+    std::mutex m_callback_mtx_;
+    ResultCallback m_callback_;
+
+    mutable std::mutex m_flush_mtx_;
+    std::condition_variable m_flush_cv_;
+    uint64_t m_pending_frames_;  ///< Frames pushed and not delivered yet
+
+    StreamFramePool m_frame_pool_;  ///< Frames whose buffers can be reused
+};
+
+}  // namespace inspire
+
+#endif  // INSPIRE_FACE_STREAM_SERVER_H
@@ -0,0 +1,221 @@
+/**
+ * Created by Jingyu Yan
+ * @date 2024-10-01
+ */
+
+#include "face_stream_session.h"
+#include "herror.h"
+
+namespace inspire {
+
+FaceStreamSession::FaceStreamSession() : m_stop_(false), m_next_frame_id_(0), m_pending_frames_(0) {}
+
+FaceStreamSession::~FaceStreamSession() {
+    Stop();
+}
+
+int32_t FaceStreamSession::Configuration(DetectModuleMode detect_mode, int32_t max_detect_face, CustomPipelineParameter param,
+                                         int32_t detect_level_px, int32_t track_by_detect_mode_fps, int32_t queue_capacity) {
+    if (m_track_thread_.joinable()) {
+        return HERR_SESS_FUNCTION_UNUSABLE;
+    }
+    // Interaction liveness filters the eye status with the tracker state, so it stays in the track stage
+    m_track_parameter_ = param;
+    m_track_parameter_.enable_recognition = false;
+    m_track_parameter_.enable_liveness = false;
+    m_track_parameter_.enable_mask_detect = false;
+    m_track_parameter_.enable_face_attribute = false;
+    m_pipeline_parameter_ = param;
+    m_pipeline_parameter_.enable_interaction_liveness = false;
+
+    m_track_session_ = std::make_unique<FaceSession>();
+    auto ret = m_track_session_->Configuration(detect_mode, max_detect_face, m_track_parameter_, detect_level_px, track_by_detect_mode_fps);
+    if (ret != HSUCCEED) {
+        return ret;
+    }
+    m_pipeline_session_ = std::make_unique<FaceSession>();
+    ret = m_pipeline_session_->Configuration(DETECT_MODE_ALWAYS_DETECT, max_detect_face, m_pipeline_parameter_, detect_level_px);
+    if (ret != HSUCCEED) {
+        return ret;
+    }
+
+    const size_t capacity = queue_capacity > 0 ? queue_capacity : 1;
+    m_input_queue_ = std::make_unique<parallel::BoundedQueue<FramePtr>>(capacity);
+    m_staged_queue_ = std::make_unique<parallel::BoundedQueue<FramePtr>>(capacity);
+    m_result_queue_ = std::make_unique<parallel::BoundedQueue<FaceStreamResult>>(capacity);
+    m_stop_ = false;
+    m_track_thread_ = std::thread(&FaceStreamSession::TrackLoop, this);
+    m_pipeline_thread_ = std::thread(&FaceStreamSession::PipelineLoop, this);
+
+    return HSUCCEED;
+}
+
+FaceSession& FaceStreamSession::TrackSession() {
+    return *m_track_session_;
+}
+
+void FaceStreamSession::SetResultCallback(ResultCallback callback) {
+    std::lock_guard<std::mutex> lock(m_callback_mtx_);
+    m_callback_ = std::move(callback);
+}
+
+int32_t FaceStreamSession::PushFrame(const uint8_t* data, int32_t height, int32_t width, inspirecv::DATA_FORMAT data_format,
+                                     inspirecv::ROTATION_MODE rotation_mode, bool block, uint64_t* frame_id) {
+    const auto pushed = std::chrono::steady_clock::now();
+    if (m_input_queue_ == nullptr || m_stop_) {
+        return HERR_SESS_STREAM_STOPPED;
+    }
+
+    auto frame = m_frame_pool_.Acquire();
+    auto ret = frame->Assign(data, height, width, data_format, rotation_mode);
+    if (ret != HSUCCEED) {
+        m_frame_pool_.Recycle(std::move(frame));
+        return ret;
+    }
+    frame->pushed = pushed;
+
+    std::lock_guard<std::mutex> lock(m_push_mtx_);
+    frame->result.frameId = m_next_frame_id_;
+    frame->result.streamId = 0;
+    {
+        std::lock_guard<std::mutex> flush_lock(m_flush_mtx_);
+        ++m_pending_frames_;
+    }
+    const bool queued = block ? m_input_queue_->Push(std::move(frame)) : m_input_queue_->TryPush(std::move(frame));
+    if (!queued) {
+        // A failed push leaves the frame with us
+        m_frame_pool_.Recycle(std::move(frame));
+        FinishFrame();
+        return m_stop_ ? HERR_SESS_STREAM_STOPPED : HERR_SESS_STREAM_QUEUE_FULL;
+    }
+    if (frame_id != nullptr) {
+        *frame_id = m_next_frame_id_;
+    }
+    ++m_next_frame_id_;
+
+    return HSUCCEED;
+}
+
+int32_t FaceStreamSession::PollResult(FaceStreamResult& result, int64_t timeout_ms) {
+    if (m_result_queue_ == nullptr) {
+        return HERR_SESS_STREAM_STOPPED;
+    }
+    if (m_result_queue_->Pop(result, timeout_ms)) {
+        return HSUCCEED;
+    }
+    return m_stop_ ? HERR_SESS_STREAM_STOPPED : HERR_SESS_STREAM_TIMEOUT;
+}
+
+int32_t FaceStreamSession::Flush() {
+    std::unique_lock<std::mutex> lock(m_flush_mtx_);
+    m_flush_cv_.wait(lock, [this] { return m_pending_frames_ == 0; });
+    return m_stop_ ? HERR_SESS_STREAM_STOPPED : HSUCCEED;
+}
+
+void FaceStreamSession::Stop() {
+    m_stop_ = true;
+    // Closing every queue first wakes a stage blocked on a full queue that nobody reads
+    if (m_input_queue_ != nullptr) {
+        m_input_queue_->Close();
+        m_staged_queue_->Close();
+        m_result_queue_->Close();
+    }
+    if (m_track_thread_.joinable()) {
+        m_track_thread_.join();
+    }
+    if (m_pipeline_thread_.joinable()) {
+        m_pipeline_thread_.join();
+    }
+}
+
+uint64_t FaceStreamSession::GetPendingFrameCount() const {
+    std::lock_guard<std::mutex> lock(m_flush_mtx_);
+    return m_pending_frames_;
+}
+
+void FaceStreamSession::TrackLoop() {
+    FramePtr frame;
+    while (m_input_queue_->Pop(frame)) {
+        if (!m_stop_) {
+            TrackFrame(*frame);
+            if (m_staged_queue_->Push(std::move(frame))) {
+                continue;
+            }
+        }
+        m_frame_pool_.Recycle(std::move(frame));
+        FinishFrame();
+    }
+}
+
+void FaceStreamSession::PipelineLoop() {
+    FramePtr frame;
+    while (m_staged_queue_->Pop(frame)) {
+        if (m_stop_) {
+            m_frame_pool_.Recycle(std::move(frame));
+            FinishFrame();
+            continue;
+        }
+        PipelineFrame(*frame);
+        Deliver(std::move(frame));
+    }
+}
+
+void FaceStreamSession::TrackFrame(StreamFrame& frame) {
+    auto process = frame.Process();
+    TrackStreamFrame(*m_track_session_, m_track_parameter_, process, frame.result);
+}
+
+void FaceStreamSession::PipelineFrame(StreamFrame& frame) {
+    auto& result = frame.result;
+    if (result.faces.empty()) {
+        return;
+    }
+    auto process = frame.Process();
+    PipelineStreamFrame(*m_pipeline_session_, m_pipeline_parameter_, process, result);
+
+    if (!m_pipeline_parameter_.enable_recognition) {
+        return;
+    }
+    result.embeddings.resize(result.faces.size());
+    for (size_t i = 0; i < result.faces.size(); ++i) {
+        auto face = result.faces[i];
+        auto ret = m_pipeline_session_->FaceFeatureExtract(process, face, true);
+        if (ret != HSUCCEED) {
+            if (result.status == HSUCCEED) {
+                result.status = ret;
+            }
+            continue;
+        }
+        auto& embedding = result.embeddings[i];
+        embedding.isNormal = 1;
+        embedding.norm = m_pipeline_session_->GetFaceFeatureNormCache();
+        embedding.embedding = m_pipeline_session_->GetFaceFeatureCache();
+    }
+}
+
+void FaceStreamSession::Deliver(FramePtr frame) {
+    auto& result = frame->result;
+    result.latencyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame->pushed).count();
+    ResultCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(m_callback_mtx_);
+        callback = m_callback_;
+    }
+    if (callback) {
+        callback(result);
+    } else {
+        // Fails only once stopped, the result is dropped then
+        m_result_queue_->Push(std::move(result));
+    }
+    m_frame_pool_.Recycle(std::move(frame));
+    FinishFrame();
+}
+
+void FaceStreamSession::FinishFrame() {
+    std::lock_guard<std::mutex> lock(m_flush_mtx_);
+    if (--m_pending_frames_ == 0) {
+        m_flush_cv_.notify_all();
+    }
+}
+
+}  // namespace inspire
@@ -0,0 +1,155 @@
+/**
+ * Created by Jingyu Yan
+ * @date 2024-10-01
+ */
+#pragma once
+#ifndef INSPIRE_FACE_STREAM_SESSION_H
+#define INSPIRE_FACE_STREAM_SESSION_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "face_session.h"
+#include "face_warpper.h"
+#include "stream_frame.h"
+#include "middleware/thread/bounded_queue.h"
+
+namespace inspire {
+
+/**
+ * @class FaceStreamSession
+ * @brief Runs detection, tracking and the face pipeline of a video stream as a two stage pipeline.
+ *
+ * Pushed frames are copied into a bounded queue. The track stage detects and tracks them in push
+ * order on its own thread and also runs interaction liveness, which needs the tracker state. The
+ * pipeline stage runs liveness, mask, attribute and recognition on a second thread with its own
+ * FaceSession, so frame N+1 is tracked while frame N is in the pipeline. Results are delivered in
+ * push order, to the result callback if one is set, otherwise to a bounded queue read with PollResult.
+ */
+class INSPIRE_API FaceStreamSession {
+public:
+    using ResultCallback = std::function<void(const FaceStreamResult&)>;
+
+    FaceStreamSession();
+
+    /**
+     * @brief Stops the stream session, see Stop.
+     */
+    ~FaceStreamSession();
+
+    FaceStreamSession(const FaceStreamSession&) = delete;
+    FaceStreamSession& operator=(const FaceStreamSession&) = delete;
+
+    /**
+     * @brief Creates the sessions of both stages and starts their threads.
+     * @param detect_mode The detection mode to be used (image or video).
+     * @param max_detect_face The maximum number of faces to detect.
+     * @param param Functions run on every frame.
+     * @param detect_level_px The input size of the detector.
+     * @param track_by_detect_mode_fps The frame rate in track by detection mode.
+     * @param queue_capacity Number of frames each queue between the stages can hold.
+     * @return int32_t Returns 0 on success, non-zero for any error.
+     */
+    int32_t Configuration(DetectModuleMode detect_mode, int32_t max_detect_face, CustomPipelineParameter param, int32_t detect_level_px = -1,
+                          int32_t track_by_detect_mode_fps = -1, int32_t queue_capacity = 4);
+
+    /**
+     * @brief Session of the track stage, its tracking parameters may be changed before the first push.
+     */
+    FaceSession& TrackSession();
+
+    /**
+     * @brief Sets the function receiving the results, called on the pipeline thread. Pass nullptr to poll.
+     */
+    void SetResultCallback(ResultCallback callback);
+
+    /**
+     * @brief Copies a frame into the input queue.
+     * @param data Pointer to the image data.
+     * @param height Height of the image.
+     * @param width Width of the image.
+     * @param data_format Data format of the image.
+     * @param rotation_mode Rotation of the image.
+     * @param block Wait for room in the queue if true, otherwise fail with HERR_SESS_STREAM_QUEUE_FULL.
+     * @param frame_id Receives the id of the frame, may be nullptr.
+     * @return int32_t Returns 0 on success, non-zero for any error.
+     */
+    int32_t PushFrame(const uint8_t* data, int32_t height, int32_t width, inspirecv::DATA_FORMAT data_format,
+                      inspirecv::ROTATION_MODE rotation_mode, bool block = true, uint64_t* frame_id = nullptr);
+
+    /**
+     * @brief Takes the oldest result when no result callback is set.
+     * @param result Receives the result.
+     * @param timeout_ms Milliseconds to wait for a result, 0 returns at once.
+     * @return int32_t HSUCCEED, HERR_SESS_STREAM_TIMEOUT, or HERR_SESS_STREAM_STOPPED once stopped and empty.
+     */
+    int32_t PollResult(FaceStreamResult& result, int64_t timeout_ms);
+
+    /**
+     * @brief Waits until every pushed frame reached the callback or the result queue.
+     *
+     * Without a callback only queue_capacity results fit in the result queue, poll them from another
+     * thread when more frames are in flight.
+     */
+    int32_t Flush();
+
+    /**
+     * @brief Stops both stages. Frames not processed yet are dropped, queued results can still be polled.
+     */
+    void Stop();
+
+    /**
+     * @brief Number of frames pushed and not delivered yet.
+     */
+    uint64_t GetPendingFrameCount() const;
+
+private:
+    using FramePtr = std::unique_ptr<StreamFrame>;
+
+    void TrackLoop();
+
+    void PipelineLoop();
+
+    void TrackFrame(StreamFrame& frame);
+
+    void PipelineFrame(StreamFrame& frame);
+
+    void Deliver(FramePtr frame);
+
+    void FinishFrame();
+
+private:
+    CustomPipelineParameter m_track_parameter_;        ///< Functions run by the track stage
+    CustomPipelineParameter m_pipeline_parameter_;     ///< Functions run by the pipeline stage
+    std::unique_ptr<FaceSession> m_track_session_;     ///< Session of the track stage
+    std::unique_ptr<FaceSession> m_pipeline_session_;  ///< Session of the pipeline stage
+
+    std::unique_ptr<parallel::BoundedQueue<FramePtr>> m_input_queue_;           ///< Pushed frames
+    std::unique_ptr<parallel::BoundedQueue<FramePtr>> m_staged_queue_;          ///< Tracked frames
+    std::unique_ptr<parallel::BoundedQueue<FaceStreamResult>> m_result_queue_;  ///< Results waiting to be polled
+
+    std::thread m_track_thread_;
+    std::thread m_pipeline_thread_;
+    std::atomic<bool> m_stop_;
+
+    std::mutex m_callback_mtx_;
+    ResultCallback m_callback_;
+
+    std::mutex m_push_mtx_;  ///< Keeps frame ids in queue order
+    uint64_t m_next_frame_id_;
+
+    mutable std::mutex m_flush_mtx_;
+    std::condition_variable m_flush_cv_;
+    uint64_t m_pending_frames_;  ///< Frames pushed and not delivered yet
+
+    StreamFramePool m_frame_pool_;  ///< Frames whose buffers can be reused
+};
+
+}  // namespace inspire
+
+#endif  // INSPIRE_FACE_STREAM_SESSION_H
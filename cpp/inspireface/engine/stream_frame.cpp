@@ -0,0 +1,141 @@
+/**
+ * Created by Jingyu Yan
+ * @date 2024-10-01
+ */
+
+#include "stream_frame.h"
+#include "herror.h"
+
+namespace inspire {
+
+namespace {
+
+size_t FrameBufferSize(int32_t height, int32_t width, inspirecv::DATA_FORMAT data_format) {
+    const size_t pixels = static_cast<size_t>(height) * static_cast<size_t>(width);
+    switch (data_format) {
+        case inspirecv::NV21:
+        case inspirecv::NV12:
+            return pixels * 3 / 2;
+        case inspirecv::RGB:
+        case inspirecv::BGR:
+            return pixels * 3;
+        case inspirecv::RGBA:
+        case inspirecv::BGRA:
+            return pixels * 4;
+    }
+    return 0;
+}
+
+}  // namespace
+
+int32_t StreamFrame::Assign(const uint8_t* data, int32_t height, int32_t width, inspirecv::DATA_FORMAT data_format,
+                            inspirecv::ROTATION_MODE rotation_mode) {
+    if (data == nullptr || height <= 0 || width <= 0) {
+        return HERR_INVALID_IMAGE_STREAM_PARAM;
+    }
+    const size_t size = FrameBufferSize(height, width, data_format);
+    if (size == 0) {
+        return HERR_INVALID_IMAGE_STREAM_PARAM;
+    }
+    buffer.assign(data, data + size);
+    this->height = height;
+    this->width = width;
+    format = data_format;
+    rotation = rotation_mode;
+    return HSUCCEED;
+}
+
+inspirecv::FrameProcess StreamFrame::Process() {
+    return inspirecv::FrameProcess::Create(buffer.data(), height, width, format, rotation);
+}
+
+std::unique_ptr<StreamFrame> StreamFramePool::Acquire() {
+    std::lock_guard<std::mutex> lock(m_mtx_);
+    if (m_free_frames_.empty()) {
+        return std::make_unique<StreamFrame>();
+    }
+    auto frame = std::move(m_free_frames_.back());
+    m_free_frames_.pop_back();
+    return frame;
+}
+
+void StreamFramePool::Recycle(std::unique_ptr<StreamFrame> frame) {
+    std::lock_guard<std::mutex> lock(m_mtx_);
+    m_free_frames_.push_back(std::move(frame));
+}
+
+void TrackStreamFrame(FaceSession& session, const CustomPipelineParameter& param, inspirecv::FrameProcess& process, FaceStreamResult& result) {
+    result.status = HSUCCEED;
+    result.latencyMs = 0.0;
+    result.faces.clear();
+    result.detConfidence.clear();
+    result.qualityConfidence.clear();
+    result.rgbLivenessConfidence.clear();
+    result.maskConfidence.clear();
+    result.attributeResult.clear();
+    result.interactionState.clear();
+    result.interactionAction.clear();
+    result.embeddings.clear();
+
+    auto ret = session.FaceDetectAndTrack(process);
+    if (ret != HSUCCEED) {
+        result.status = ret;
+        return;
+    }
+    const auto& detect_cache = session.GetDetectCache();
+    result.faces.resize(detect_cache.size());
+    for (size_t i = 0; i < detect_cache.size(); ++i) {
+        RunDeserializeHyperFaceData(detect_cache[i], result.faces[i]);
+    }
+    result.detConfidence = session.GetDetConfidenceCache();
+    result.qualityConfidence = session.GetFaceQualityScoresResultsCache();
+    if (result.faces.empty()) {
+        return;
+    }
+
+    // Disabled functions still size the caches, their results are -1
+    CustomPipelineParameter interaction;
+    interaction.enable_interaction_liveness = param.enable_interaction_liveness;
+    ret = session.FacesProcess(process, result.faces, interaction);
+    if (ret != HSUCCEED) {
+        result.status = ret;
+    }
+    const auto& left_eyes = session.GetFaceInteractionLeftEyeStatusCache();
+    const auto& right_eyes = session.GetFaceInteractionRightEyeStatusCache();
+    result.interactionState.resize(result.faces.size());
+    result.interactionAction.resize(result.faces.size());
+    for (size_t i = 0; i < result.faces.size(); ++i) {
+        result.interactionState[i].left_eye_status_confidence = left_eyes[i];
+        result.interactionState[i].right_eye_status_confidence = right_eyes[i];
+        auto& action = result.interactionAction[i];
+        action.normal = session.GetFaceNormalAactionsResultCache()[i];
+        action.shake = session.GetFaceShakeAactionsResultCache()[i];
+        action.jawOpen = session.GetFaceJawOpenAactionsResultCache()[i];
+        action.headRaise = session.GetFaceRaiseHeadAactionsResultCache()[i];
+        action.blink = session.GetFaceBlinkAactionsResultCache()[i];
+    }
+}
+
+void PipelineStreamFrame(FaceSession& session, const CustomPipelineParameter& param, inspirecv::FrameProcess& process, FaceStreamResult& result) {
+    if (result.faces.empty()) {
+        return;
+    }
+    CustomPipelineParameter pipeline;
+    pipeline.enable_liveness = param.enable_liveness;
+    pipeline.enable_mask_detect = param.enable_mask_detect;
+    pipeline.enable_face_attribute = param.enable_face_attribute;
+    auto ret = session.FacesProcess(process, result.faces, pipeline);
+    if (ret != HSUCCEED && result.status == HSUCCEED) {
+        result.status = ret;
+    }
+    result.rgbLivenessConfidence = session.GetRgbLivenessResultsCache();
+    result.maskConfidence = session.GetMaskResultsCache();
+    result.attributeResult.resize(result.faces.size());
+    for (size_t i = 0; i < result.faces.size(); ++i) {
+        result.attributeResult[i].race = session.GetFaceRaceResultsCache()[i];
+        result.attributeResult[i].gender = session.GetFaceGenderResultsCache()[i];
+        result.attributeResult[i].ageBracket = session.GetFaceAgeBracketResultsCache()[i];
+    }
+}
+
+}  // namespace inspire
@@ -0,0 +1,78 @@
+/**
+ * Created by Jingyu Yan
+ * @date 2024-10-01
+ */
+#pragma once
+#ifndef INSPIRE_FACE_STREAM_FRAME_H
+#define INSPIRE_FACE_STREAM_FRAME_H
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "face_session.h"
+#include "face_warpper.h"
+
+namespace inspire {
+
+/**
+ * @brief A copied frame and its results on their way through a stream session or a stream server.
+ */
+struct StreamFrame {
+    std::vector<uint8_t> buffer;
+    int32_t height;
+    int32_t width;
+    inspirecv::DATA_FORMAT format;
+    inspirecv::ROTATION_MODE rotation;
+    std::chrono::steady_clock::time_point pushed;
+    FaceStreamResult result;
+
+    /**
+     * @brief Copies the image, FrameProcess only keeps the pointer and the caller may reuse its buffer.
+     * @return int32_t HSUCCEED, or HERR_INVALID_IMAGE_STREAM_PARAM for an invalid image.
+     */
+    int32_t Assign(const uint8_t* data, int32_t height, int32_t width, inspirecv::DATA_FORMAT data_format, inspirecv::ROTATION_MODE rotation_mode);
+
+    /**
+     * @brief Processor reading the copied image.
+     */
+    inspirecv::FrameProcess Process();
+};
+
+/**
+ * @brief Free list of frames, so that their buffers are reused instead of reallocated for every push.
+ */
+class StreamFramePool {
+public:
+    std::unique_ptr<StreamFrame> Acquire();
+
+    void Recycle(std::unique_ptr<StreamFrame> frame);
+
+private:
+    std::mutex m_mtx_;
+    std::vector<std::unique_ptr<StreamFrame>> m_free_frames_;
+};
+
+/**
+ * @brief Detects and tracks a frame, then runs the functions of param that need the tracker state.
+ *
+ * The result is cleared first, the pipeline results stay empty until PipelineStreamFrame.
+ * @param session Session holding the tracker state of the stream.
+ * @param param Functions run with the tracker state, only interaction liveness is read.
+ * @param process Processor of the frame.
+ * @param result Receives the faces, their confidences and the interaction results.
+ */
+void TrackStreamFrame(FaceSession& session, const CustomPipelineParameter& param, inspirecv::FrameProcess& process, FaceStreamResult& result);
+
+/**
+ * @brief Runs liveness, mask and attribute of param on the faces of a tracked frame.
+ * @param session Session whose pipeline models are used.
+ * @param param Functions to run.
+ * @param process Processor of the frame.
+ * @param result Tracked frame, receives the confidences.
+ */
+void PipelineStreamFrame(FaceSession& session, const CustomPipelineParameter& param, inspirecv::FrameProcess& process, FaceStreamResult& result);
+
+}  // namespace inspire
+
+#endif  // INSPIRE_FACE_STREAM_FRAME_H
@@ -1,13 +1,29 @@
 #include "embedding_db.h"
 #include "sqlite-vec.h"
 #include "isf_check.h"
+#include "feature_hub/simd.h"
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
 #if defined(__ANDROID__)
 #include <android/log.h>
 #endif
 
 namespace inspire {
 
+namespace {
+
+// Shared by the sharded indexes of every database, the searching thread takes part in each search
+parallel::ThreadPool &ShardSearchPool() {
+    static parallel::ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+}  // namespace
+
 std::unique_ptr<EmbeddingDB> EmbeddingDB::instance_ = nullptr;
 std::mutex EmbeddingDB::instanceMutex_;
 
@@ -17,69 +33,358 @@ EmbeddingDB &EmbeddingDB::GetInstance() {
     return *instance_;
 }
 
-void EmbeddingDB::Init(const std::string &dbPath, size_t vectorDim, IdMode idMode) {
+void EmbeddingDB::Init(const std::string &dbPath, size_t vectorDim, IdMode idMode, const IndexOptions &indexOptions) {
     std::lock_guard<std::mutex> lock(instanceMutex_);
     INSPIREFACE_CHECK_MSG(!instance_, "EmbeddingDB already initialized");
-    instance_.reset(new EmbeddingDB(dbPath, vectorDim, "cosine", idMode));
+    instance_.reset(new EmbeddingDB(dbPath, vectorDim, "cosine", idMode, indexOptions));
 }
 
-EmbeddingDB::EmbeddingDB(const std::string &dbPath, size_t vectorDim, const std::string &distanceMetric, IdMode idMode)
-: vectorDim_(vectorDim), tableName_("vec_items"), idMode_(idMode) {
+std::unique_ptr<EmbeddingDB> EmbeddingDB::Create(const std::string &dbPath, size_t vectorDim, IdMode idMode, const IndexOptions &indexOptions) {
+    return std::unique_ptr<EmbeddingDB>(new EmbeddingDB(dbPath, vectorDim, "cosine", idMode, indexOptions));
+}
+
+EmbeddingDB::EmbeddingDB(const std::string &dbPath, size_t vectorDim, const std::string &distanceMetric, IdMode idMode, const IndexOptions &indexOptions)
+: vectorDim_(vectorDim),
+  tableName_("vec_items"),
+  tagsTableName_("vec_tags"),
+  idMode_(idMode),
+  indexType_(indexOptions.type),
+  storage_(VectorStorage::FLOAT32),
+  shardCount_(std::max<size_t>(indexOptions.shards, 1)) {
+    if (indexType_ == IndexType::HNSW && indexOptions.storage != VectorStorage::FLOAT32) {
+        INSPIRE_LOGW("Reduced precision storage is only supported by the flat index, the HNSW index keeps float vectors");
+    } else if (indexType_ == IndexType::FLAT) {
+        // The quantized index re-ranks against its own float copy, searches never read the table
+        storage_ = indexOptions.storage;
+    }
+    auto makeIndex = [&]() -> IndexPtr {
+        if (indexType_ == IndexType::HNSW) {
+            return IndexPtr(new HnswIndex(vectorDim, indexOptions.hnsw));
+        } else if (storage_ != VectorStorage::FLOAT32) {
+            return IndexPtr(new QuantizedFlatIndex(vectorDim, storage_, indexOptions.rerank_factor));
+        }
+        return IndexPtr(new FlatIndex(vectorDim));
+    };
+    IndexPtr index;
+    if (shardCount_ > 1) {
+        std::vector<IndexPtr> shards;
+        for (size_t shard = 0; shard < shardCount_; ++shard) {
+            shards.push_back(makeIndex());
+        }
+        index.reset(new ShardedIndex(std::move(shards), &ShardSearchPool()));
+    } else {
+        index = makeIndex();
+    }
+    // The index of a persistent database is kept next to it so it does not have to be rebuilt: the HNSW
+    // graph is loaded back and the flat rows are mapped in place. Both paths are tracked whatever the
+    // index type so that writes invalidate the file of the other type too. Each shard has its own file
+    if (dbPath != ":memory:" && !dbPath.empty()) {
+        indexPath_ = dbPath + ".hnsw";
+        snapshotPath_ = dbPath + ".snap";
+    }
+    // A table that goes away with the connection is never read back, an in-memory quantized database
+    // keeps its float vectors next to the codes in the index and the table only allocates the ids
+    vectorsInTable_ = !indexPath_.empty() || storage_ == VectorStorage::FLOAT32;
+
     int rc = sqlite3_auto_extension((void (*)())sqlite3_vec_init);
     CheckSQLiteError(rc, nullptr);
 
-    // Open database
-    rc = sqlite3_open(dbPath.c_str(), &db_);
+    // Open database, searches read through the same connection as the writer so it has to be serialized
+    rc = sqlite3_open_v2(dbPath.c_str(), &db_, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX, nullptr);
     CheckSQLiteError(rc, db_);
 
     // Create vector table
-    std::string createTableSQL = "CREATE VIRTUAL TABLE IF NOT EXISTS " + tableName_ + " USING vec0(embedding float[" + std::to_string(vectorDim_) +
-                                 "] distance_metric=" + distanceMetric + ")";
-
-    ExecuteSQL(createTableSQL);
+    if (vectorsInTable_) {
+        ExecuteSQL("CREATE VIRTUAL TABLE IF NOT EXISTS " + tableName_ + " USING vec0(embedding float[" + std::to_string(vectorDim_) +
+                   "] distance_metric=" + distanceMetric + ")");
+    } else {
+        // Ids are never reused, like the rowids of vec0
+        ExecuteSQL("CREATE TABLE IF NOT EXISTS " + tableName_ + " (id INTEGER PRIMARY KEY AUTOINCREMENT)");
+    }
+    // Untagged vectors have no row, databases created before tags existed get an empty table
+    ExecuteSQL("CREATE TABLE IF NOT EXISTS " + tagsTableName_ + " (id INTEGER PRIMARY KEY, tags INTEGER NOT NULL)");
+    ConfigureConnection(!indexPath_.empty());
+    PrepareStatements();
+    if (!LoadPersistedIndex(*index)) {
+        LoadIndexFromTable(*index);
+        // A rebuilt index is saved at shutdown, the files left next to the database are stale
+        MarkIndexDirty();
+    }
+    // The saved index files do not carry the tags
+    LoadTagsFromTable(*index);
+    index_ = std::move(index);
     initialized_ = true;
 }
 
+void EmbeddingDB::ConfigureConnection(bool persistent) {
+    if (persistent) {
+        // Commits become sequential appends to the log instead of rewrites of the database pages,
+        // a power loss can drop the last commits but never corrupts the file
+        ExecuteSQL("PRAGMA journal_mode=WAL");
+        ExecuteSQL("PRAGMA synchronous=NORMAL");
+    }
+    ExecuteSQL("PRAGMA temp_store=MEMORY");
+    ExecuteSQL("PRAGMA cache_size=-32768");
+}
+
+void EmbeddingDB::PrepareStatements() {
+    if (!vectorsInTable_) {
+        // Updates only touch the index
+        if (idMode_ == IdMode::AUTO_INCREMENT) {
+            insertStmt_ = PrepareStatement("INSERT INTO " + tableName_ + " DEFAULT VALUES");
+        } else {
+            insertStmt_ = PrepareStatement("INSERT INTO " + tableName_ + "(rowid) VALUES (?)");
+        }
+    } else {
+        if (idMode_ == IdMode::AUTO_INCREMENT) {
+            insertStmt_ = PrepareStatement("INSERT INTO " + tableName_ + "(embedding) VALUES (?)");
+        } else {
+            insertStmt_ = PrepareStatement("INSERT INTO " + tableName_ + "(rowid, embedding) VALUES (?, ?)");
+        }
+        updateStmt_ = PrepareStatement("UPDATE " + tableName_ + " SET embedding = ? WHERE rowid = ?");
+    }
+    deleteStmt_ = PrepareStatement("DELETE FROM " + tableName_ + " WHERE rowid = ?");
+    setTagsStmt_ = PrepareStatement("INSERT OR REPLACE INTO " + tagsTableName_ + "(id, tags) VALUES (?, ?)");
+    deleteTagsStmt_ = PrepareStatement("DELETE FROM " + tagsTableName_ + " WHERE id = ?");
+}
+
+void EmbeddingDB::FinalizeStatements() {
+    for (auto stmt : {insertStmt_, updateStmt_, deleteStmt_, setTagsStmt_, deleteTagsStmt_}) {
+        sqlite3_finalize(stmt);
+    }
+    insertStmt_ = updateStmt_ = deleteStmt_ = setTagsStmt_ = deleteTagsStmt_ = nullptr;
+}
+
+sqlite3_stmt *EmbeddingDB::PrepareStatement(const std::string &sql) const {
+    sqlite3_stmt *stmt = nullptr;
+    int rc = sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr);
+    CheckSQLiteError(rc, db_);
+    return stmt;
+}
+
+bool EmbeddingDB::LoadPersistedIndex(VectorIndex &index) {
+    if (indexPath_.empty()) {
+        return false;
+    }
+    uint32_t version = ReadUserVersion();
+    for (size_t shard = 0; shard < shardCount_; ++shard) {
+        uint32_t tag = 0;
+        VectorIndex &target = IndexShard(index, shard);
+        std::string path = ShardFilePath(PersistedIndexPath(), shard);
+        bool loaded = false;
+        if (indexType_ == IndexType::HNSW) {
+            loaded = static_cast<HnswIndex &>(target).Load(path, &tag);
+        } else if (storage_ == VectorStorage::FLOAT32) {
+            loaded = static_cast<FlatIndex &>(target).Map(path, &tag);
+        } else {
+            loaded = static_cast<QuantizedFlatIndex &>(target).Map(path, &tag);
+        }
+        if (!loaded) {
+            index.Clear();
+            return false;
+        }
+        // The database header carries the tag of the index saved with it, a recreated or
+        // replaced database does not match and the index is rebuilt from the table
+        if (tag == 0 || tag != version) {
+            INSPIRE_LOGW("Index file %s does not match the database, rebuilding it", path.c_str());
+            index.Clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+const std::string &EmbeddingDB::PersistedIndexPath() const {
+    return indexType_ == IndexType::HNSW ? indexPath_ : snapshotPath_;
+}
+
+std::string EmbeddingDB::ShardFilePath(const std::string &path, size_t shard) const {
+    return shardCount_ > 1 ? path + "." + std::to_string(shard) : path;
+}
+
+VectorIndex &EmbeddingDB::IndexShard(VectorIndex &index, size_t shard) const {
+    return shardCount_ > 1 ? static_cast<ShardedIndex &>(index).Shard(shard) : index;
+}
+
+const VectorIndex &EmbeddingDB::IndexShard(const VectorIndex &index, size_t shard) const {
+    return shardCount_ > 1 ? static_cast<const ShardedIndex &>(index).Shard(shard) : index;
+}
+
+uint32_t EmbeddingDB::ReadUserVersion() {
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db_, "PRAGMA user_version", -1, &stmt, nullptr);
+    CheckSQLiteError(rc, db_);
+    uint32_t version = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        version = static_cast<uint32_t>(sqlite3_column_int64(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+    return version;
+}
+
+bool EmbeddingDB::SavePersistedIndex() {
+    std::random_device rd;
+    uint32_t tag = 0;
+    while (tag == 0) {
+        tag = rd();
+    }
+    // Searches can go on while the files are written, writers are held by writeMutex_ or gone
+    std::shared_lock<std::shared_timed_mutex> lock(indexMutex_);
+    for (size_t shard = 0; shard < shardCount_; ++shard) {
+        std::string path = ShardFilePath(PersistedIndexPath(), shard);
+        const VectorIndex &source = IndexShard(*index_, shard);
+        bool saved = false;
+        if (indexType_ == IndexType::HNSW) {
+            saved = static_cast<const HnswIndex &>(source).Save(path, tag);
+        } else if (storage_ == VectorStorage::FLOAT32) {
+            saved = static_cast<const FlatIndex &>(source).Save(path, tag);
+        } else {
+            saved = static_cast<const QuantizedFlatIndex &>(source).Save(path, tag);
+        }
+        if (!saved) {
+            INSPIRE_LOGW("Failed to save the index to %s", path.c_str());
+            return false;
+        }
+    }
+    ExecuteSQL("PRAGMA user_version = " + std::to_string(static_cast<int32_t>(tag)));
+    indexDirty_ = false;
+    return true;
+}
+
+bool EmbeddingDB::SaveIndex() {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    if (indexPath_.empty()) {
+        INSPIRE_LOGW("Only the index of a persistent database can be saved");
+        return false;
+    }
+    if (!indexDirty_) {
+        return true;
+    }
+    return SavePersistedIndex();
+}
+
+void EmbeddingDB::MarkIndexDirty() {
+    if (indexDirty_) {
+        return;
+    }
+    // Drop the saved index on the first change, a crash before the next save then triggers a rebuild.
+    // The tag is cleared as well since a file that is still mapped cannot be removed on every platform
+    if (!indexPath_.empty()) {
+        for (size_t shard = 0; shard < shardCount_; ++shard) {
+            std::remove(ShardFilePath(indexPath_, shard).c_str());
+            std::remove(ShardFilePath(snapshotPath_, shard).c_str());
+            std::remove(QuantizedFlatIndex::VectorsPath(ShardFilePath(snapshotPath_, shard)).c_str());
+        }
+        ExecuteSQL("PRAGMA user_version = 0");
+    }
+    indexDirty_ = true;
+}
+
+void EmbeddingDB::SetSearchEf(size_t ef) {
+    if (indexType_ != IndexType::HNSW) {
+        INSPIRE_LOGW("The search ef only applies to the HNSW index");
+        return;
+    }
+    std::lock_guard<std::shared_timed_mutex> lock(indexMutex_);
+    for (size_t shard = 0; shard < shardCount_; ++shard) {
+        static_cast<HnswIndex &>(IndexShard(*index_, shard)).SetEfSearch(ef);
+    }
+}
+
+void EmbeddingDB::LoadIndexFromTable(VectorIndex &index) {
+    index.Clear();
+    if (!vectorsInTable_) {
+        return;
+    }
+    sqlite3_stmt *stmt;
+    std::string sql = "SELECT rowid, embedding FROM " + tableName_;
+
+    int rc = sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr);
+    CheckSQLiteError(rc, db_);
+
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        int64_t id = sqlite3_column_int64(stmt, 0);
+        const float *blob_data = static_cast<const float *>(sqlite3_column_blob(stmt, 1));
+        size_t blob_size = sqlite3_column_bytes(stmt, 1) / sizeof(float);
+        if (blob_size != vectorDim_) {
+            INSPIRE_LOGW("Skip vector %lld with unexpected dimension %zu", (long long)id, blob_size);
+            continue;
+        }
+        index.Add(id, blob_data);
+    }
+
+    sqlite3_finalize(stmt);
+    CheckSQLiteError(rc == SQLITE_DONE ? SQLITE_OK : rc, db_);
+}
+
+void EmbeddingDB::LoadTagsFromTable(VectorIndex &index) {
+    sqlite3_stmt *stmt = PrepareStatement("SELECT id, tags FROM " + tagsTableName_);
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        index.SetTags(sqlite3_column_int64(stmt, 0), static_cast<uint64_t>(sqlite3_column_int64(stmt, 1)));
+    }
+    sqlite3_finalize(stmt);
+    CheckSQLiteError(rc == SQLITE_DONE ? SQLITE_OK : rc, db_);
+}
+
+bool EmbeddingDB::WriteTagsToTable(int64_t id, uint64_t tags) {
+    // The bits are stored as a signed integer, SQLite has no unsigned 64-bit type
+    sqlite3_stmt *stmt = tags != 0 ? setTagsStmt_ : deleteTagsStmt_;
+    sqlite3_bind_int64(stmt, 1, id);
+    if (tags != 0) {
+        sqlite3_bind_int64(stmt, 2, static_cast<int64_t>(tags));
+    }
+    int rc = StepStatement(stmt);
+    if (rc != SQLITE_DONE) {
+        INSPIRE_LOGE("Failed to write the tags of vector %lld: %s", (long long)id, sqlite3_errmsg(db_));
+        return false;
+    }
+    return true;
+}
+
 EmbeddingDB::~EmbeddingDB() {
+    if (indexDirty_ && !indexPath_.empty()) {
+        SavePersistedIndex();
+    }
     if (db_) {
+        FinalizeStatements();
         sqlite3_close(db_);
     }
 }
 
 bool EmbeddingDB::InsertVector(const std::vector<float> &vector, int64_t &allocId) {
-    std::lock_guard<std::mutex> lock(dbMutex_);
     return InsertVector(0, vector, allocId);  // In auto-increment mode, the passed ID is ignored
 }
 
 bool EmbeddingDB::InsertVector(int64_t id, const std::vector<float> &vector, int64_t &allocId) {
     CheckVectorDimension(vector);
-
-    sqlite3_stmt *stmt;
-    std::string sql;
-
-    if (idMode_ == IdMode::AUTO_INCREMENT) {
-        sql = "INSERT INTO " + tableName_ + "(embedding) VALUES (?)";
-    } else {
-        sql = "INSERT INTO " + tableName_ + "(rowid, embedding) VALUES (?, ?)";
-    }
-
-    int rc = sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr);
-    // CheckSQLiteError(rc, db_);
-    if (rc != SQLITE_OK) {
-        INSPIRE_LOGE("Failed to prepare statement: %s", sqlite3_errmsg(db_));
-        sqlite3_finalize(stmt);
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    if (!InsertVectorInternal(id, vector.data(), allocId)) {
         return false;
     }
+    {
+        std::lock_guard<std::shared_timed_mutex> indexLock(indexMutex_);
+        index_->Add(allocId, vector.data());
+    }
+    MarkIndexDirty();
+    return true;
+}
 
-    if (idMode_ == IdMode::AUTO_INCREMENT) {
-        sqlite3_bind_blob(stmt, 1, vector.data(), vector.size() * sizeof(float), SQLITE_STATIC);
+bool EmbeddingDB::InsertVectorInternal(int64_t id, const float *vector, int64_t &allocId) {
+    // The vector is bound in place, the statement is reset before the caller's buffer can go away
+    int bytes = static_cast<int>(vectorDim_ * sizeof(float));
+    if (!vectorsInTable_) {
+        if (idMode_ == IdMode::MANUAL) {
+            sqlite3_bind_int64(insertStmt_, 1, id);
+        }
+    } else if (idMode_ == IdMode::AUTO_INCREMENT) {
+        sqlite3_bind_blob(insertStmt_, 1, vector, bytes, SQLITE_STATIC);
     } else {
-        sqlite3_bind_int64(stmt, 1, id);
-        sqlite3_bind_blob(stmt, 2, vector.data(), vector.size() * sizeof(float), SQLITE_STATIC);
+        sqlite3_bind_int64(insertStmt_, 1, id);
+        sqlite3_bind_blob(insertStmt_, 2, vector, bytes, SQLITE_STATIC);
     }
 
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    int rc = StepStatement(insertStmt_);
     if (rc != SQLITE_DONE) {
         INSPIRE_LOGE("Failed to insert vector: %s", sqlite3_errmsg(db_));
         return false;
@@ -91,60 +396,121 @@ bool EmbeddingDB::InsertVector(int64_t id, const std::vector<float> &vector, int
 }
 
 std::vector<float> EmbeddingDB::GetVector(int64_t id) const {
-    std::lock_guard<std::mutex> lock(dbMutex_);
-
-    sqlite3_stmt *stmt;
-    std::string sql = "SELECT embedding FROM " + tableName_ + " WHERE rowid = ?";
+    std::vector<float> result;
+    std::shared_lock<std::shared_timed_mutex> lock(indexMutex_);
+    if (!index_->Get(id, result)) {
+        return {};
+    }
+    return result;
+}
 
-    int rc = sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr);
-    CheckSQLiteError(rc, db_);
+int EmbeddingDB::StepStatement(sqlite3_stmt *stmt) {
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    return rc;
+}
 
-    sqlite3_bind_int64(stmt, 1, id);
+bool EmbeddingDB::BatchInsertVectors(const float *vectors, size_t count, const int64_t *ids, int64_t *allocIds, const uint64_t *tags) {
+    if (count == 0) {
+        return true;
+    }
+    INSPIREFACE_CHECK_MSG(vectors != nullptr, "Vector buffer is null");
+    if (idMode_ == IdMode::MANUAL && ids == nullptr) {
+        INSPIRE_LOGE("Ids are required in manual id mode");
+        return false;
+    }
+    std::vector<int64_t> insertedIds(count);
 
-    rc = sqlite3_step(stmt);
-    if (rc != SQLITE_ROW) {
-        sqlite3_finalize(stmt);
-        // throw std::runtime_error("Vector with id " + std::to_string(id) + " not found");
-        return {};
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    ExecuteSQL("BEGIN");
+    for (size_t i = 0; i < count; ++i) {
+        int64_t id = ids != nullptr ? ids[i] : 0;
+        if (!InsertVectorInternal(id, vectors + i * vectorDim_, insertedIds[i]) || (tags != nullptr && !WriteTagsToTable(insertedIds[i], tags[i]))) {
+            ExecuteSQL("ROLLBACK");
+            return false;
+        }
     }
+    ExecuteSQL("COMMIT");
 
-    const float *blob_data = static_cast<const float *>(sqlite3_column_blob(stmt, 0));
-    size_t blob_size = sqlite3_column_bytes(stmt, 0) / sizeof(float);
-    std::vector<float> result(blob_data, blob_data + blob_size);
+    {
+        std::lock_guard<std::shared_timed_mutex> indexLock(indexMutex_);
+        // Only a batch at least as large as the gallery reserves, small batches keep the geometric growth
+        if (count >= index_->Size()) {
+            index_->Reserve(index_->Size() + count);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            index_->Add(insertedIds[i], vectors + i * vectorDim_);
+            if (tags != nullptr) {
+                index_->SetTags(insertedIds[i], tags[i]);
+            }
+        }
+    }
+    MarkIndexDirty();
 
-    sqlite3_finalize(stmt);
-    return result;
+    if (allocIds != nullptr) {
+        std::copy(insertedIds.begin(), insertedIds.end(), allocIds);
+    }
+    return true;
 }
 
 std::vector<int64_t> EmbeddingDB::BatchInsertVectors(const std::vector<VectorData> &vectors) {
+    for (const auto &data : vectors) {
+        CheckVectorDimension(data.vector);
+    }
+    std::lock_guard<std::mutex> lock(writeMutex_);
     ExecuteSQL("BEGIN");
     std::vector<int64_t> insertedIds;
     insertedIds.reserve(vectors.size());
 
     for (const auto &data : vectors) {
         int64_t id = 0;
-        bool ret = InsertVector(data.id, data.vector, id);
+        bool ret = InsertVectorInternal(data.id, data.vector.data(), id);
         INSPIREFACE_CHECK_MSG(ret, "Failed to insert vector");
         insertedIds.push_back(id);
     }
     ExecuteSQL("COMMIT");
 
+    // The whole batch is added under one exclusive lock, searches are held once instead of once per vector
+    {
+        std::lock_guard<std::shared_timed_mutex> indexLock(indexMutex_);
+        for (size_t i = 0; i < vectors.size(); ++i) {
+            index_->Add(insertedIds[i], vectors[i].vector.data());
+        }
+    }
+    if (!vectors.empty()) {
+        MarkIndexDirty();
+    }
+
     return insertedIds;
 }
 
 std::vector<int64_t> EmbeddingDB::BatchInsertVectors(const std::vector<std::vector<float>> &vectors) {
+    for (const auto &vector : vectors) {
+        CheckVectorDimension(vector);
+    }
+    std::lock_guard<std::mutex> lock(writeMutex_);
     ExecuteSQL("BEGIN");
     std::vector<int64_t> insertedIds;
     insertedIds.reserve(vectors.size());
 
     for (const auto &vector : vectors) {
         int64_t id = 0;
-        bool ret = InsertVector(0, vector, id);
+        bool ret = InsertVectorInternal(0, vector.data(), id);
         INSPIREFACE_CHECK_MSG(ret, "Failed to insert vector");
         insertedIds.push_back(id);
     }
     ExecuteSQL("COMMIT");
 
+    {
+        std::lock_guard<std::shared_timed_mutex> indexLock(indexMutex_);
+        for (size_t i = 0; i < vectors.size(); ++i) {
+            index_->Add(insertedIds[i], vectors[i].data());
+        }
+    }
+    if (!vectors.empty()) {
+        MarkIndexDirty();
+    }
+
     return insertedIds;
 }
 
@@ -153,113 +519,171 @@ int64_t EmbeddingDB::GetLastInsertRowId() const {
 }
 
 void EmbeddingDB::UpdateVector(int64_t id, const std::vector<float> &newVector) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
     CheckVectorDimension(newVector);
 
-    sqlite3_stmt *stmt;
-    std::string sql = "UPDATE " + tableName_ + " SET embedding = ? WHERE rowid = ?";
-
-    int rc = sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr);
-    CheckSQLiteError(rc, db_);
-
-    sqlite3_bind_blob(stmt, 1, newVector.data(), newVector.size() * sizeof(float), SQLITE_STATIC);
-    sqlite3_bind_int64(stmt, 2, id);
-
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    INSPIREFACE_CHECK_MSG(rc == SQLITE_DONE, "Failed to update vector");
-    if (sqlite3_changes(db_) == 0) {
-        INSPIRE_LOGF("Vector with id %ld not found", id);
+    if (!vectorsInTable_) {
+        // Only writers change the index and they are serialized, the lookup needs no index lock
+        if (!index_->Contains(id)) {
+            INSPIRE_LOGF("Vector with id %ld not found", id);
+            return;
+        }
+    } else {
+        sqlite3_bind_blob(updateStmt_, 1, newVector.data(), newVector.size() * sizeof(float), SQLITE_STATIC);
+        sqlite3_bind_int64(updateStmt_, 2, id);
+
+        int rc = StepStatement(updateStmt_);
+        INSPIREFACE_CHECK_MSG(rc == SQLITE_DONE, "Failed to update vector");
+        if (sqlite3_changes(db_) == 0) {
+            INSPIRE_LOGF("Vector with id %ld not found", id);
+            return;
+        }
     }
+    {
+        std::lock_guard<std::shared_timed_mutex> indexLock(indexMutex_);
+        index_->Update(id, newVector.data());
+    }
+    MarkIndexDirty();
 }
 
 void EmbeddingDB::DeleteVector(int64_t id) {
-    sqlite3_stmt *stmt;
-    std::string sql = "DELETE FROM " + tableName_ + " WHERE rowid = ?";
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    sqlite3_bind_int64(deleteStmt_, 1, id);
 
-    int rc = sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr);
-    CheckSQLiteError(rc, db_);
+    int rc = StepStatement(deleteStmt_);
+    CheckSQLiteError(rc == SQLITE_DONE ? SQLITE_OK : rc, db_);
+    WriteTagsToTable(id, 0);
+    bool removed = false;
+    {
+        std::lock_guard<std::shared_timed_mutex> indexLock(indexMutex_);
+        removed = index_->Remove(id);
+    }
+    if (removed) {
+        MarkIndexDirty();
+    }
+}
 
-    sqlite3_bind_int64(stmt, 1, id);
+bool EmbeddingDB::SetVectorTags(int64_t id, uint64_t tags) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    // Only writers change the index and they are serialized, the lookup needs no index lock
+    if (!index_->Contains(id) || !WriteTagsToTable(id, tags)) {
+        return false;
+    }
+    // Tags are not part of the saved index files, the index does not become dirty
+    std::lock_guard<std::shared_timed_mutex> indexLock(indexMutex_);
+    index_->SetTags(id, tags);
+    return true;
+}
 
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    CheckSQLiteError(rc == SQLITE_DONE ? SQLITE_OK : rc, db_);
+bool EmbeddingDB::GetVectorTags(int64_t id, uint64_t &tags) const {
+    std::shared_lock<std::shared_timed_mutex> lock(indexMutex_);
+    return index_->GetTags(id, tags);
 }
 
 std::vector<FaceSearchResult> EmbeddingDB::SearchSimilarVectors(const std::vector<float> &queryVector, size_t top_k, float keep_similar_threshold,
                                                                 bool return_feature) {
-    std::lock_guard<std::mutex> lock(dbMutex_);
     CheckVectorDimension(queryVector);
 
-    sqlite3_stmt *stmt;
-    std::string sql;
-    if (return_feature) {
-        sql =
-          "SELECT rowid, embedding, 1.0 - distance as similarity "
-          "FROM " +
-          tableName_ +
-          " "
-          "WHERE embedding MATCH ? "
-          "ORDER BY distance "
-          "LIMIT ?";
+    std::shared_lock<std::shared_timed_mutex> lock(indexMutex_);
+    // Hits are already sorted and filtered by the threshold
+    std::vector<IndexSearchHit> hits;
+    SearchIndex(*index_, queryVector.data(), top_k, keep_similar_threshold, hits);
+    return MakeSearchResults(*index_, hits, return_feature);
+}
+
+void EmbeddingDB::SearchIndex(const VectorIndex &index, const float *query, size_t top_k, float threshold, std::vector<IndexSearchHit> &hits,
+                              const TagFilter *filter) const {
+    if (filter != nullptr) {
+        index.SearchFiltered(query, top_k, threshold, *filter, hits);
     } else {
-        sql =
-          "SELECT rowid, 1.0 - distance as similarity "
-          "FROM " +
-          tableName_ +
-          " "
-          "WHERE embedding MATCH ? "
-          "ORDER BY distance "
-          "LIMIT ?";
+        index.Search(query, top_k, threshold, hits);
     }
+}
 
-    int rc = sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr);
-    CheckSQLiteError(rc, db_);
+std::vector<std::vector<FaceSearchResult>> EmbeddingDB::BatchSearchSimilarVectors(const float *queries, size_t num_queries, size_t top_k,
+                                                                                   float keep_similar_threshold, bool return_feature) {
+    INSPIREFACE_CHECK_MSG(queries != nullptr || num_queries == 0, "Query matrix is null");
 
-    sqlite3_bind_blob(stmt, 1, queryVector.data(), queryVector.size() * sizeof(float), SQLITE_STATIC);
-    sqlite3_bind_int64(stmt, 2, top_k);
+    std::shared_lock<std::shared_timed_mutex> lock(indexMutex_);
+    std::vector<std::vector<IndexSearchHit>> hits;
+    index_->SearchBatch(queries, num_queries, top_k, keep_similar_threshold, hits);
 
-    std::vector<FaceSearchResult> results;
-    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
-        FaceSearchResult result;
-        result.id = sqlite3_column_int64(stmt, 0);
-        if (return_feature) {
-            const float *blob_data = static_cast<const float *>(sqlite3_column_blob(stmt, 1));
-            size_t blob_size = sqlite3_column_bytes(stmt, 1) / sizeof(float);
-            result.feature.assign(blob_data, blob_data + blob_size);
-            result.similarity = sqlite3_column_double(stmt, 2);
-        } else {
-            result.similarity = sqlite3_column_double(stmt, 1);
-        }
-        results.push_back(result);
+    std::vector<std::vector<FaceSearchResult>> results;
+    results.reserve(hits.size());
+    for (const auto &query_hits : hits) {
+        results.push_back(MakeSearchResults(*index_, query_hits, return_feature));
     }
+    return results;
+}
 
-    sqlite3_finalize(stmt);
-    CheckSQLiteError(rc == SQLITE_DONE ? SQLITE_OK : rc, db_);
+void EmbeddingDB::SearchSimilarVectors(const float *query, size_t top_k, float keep_similar_threshold, FaceSearchTopKBuffer &result) const {
+    INSPIREFACE_CHECK_MSG(query != nullptr, "Query vector is null");
 
-    // Filter results whose similarity is below the threshold
-    results.erase(std::remove_if(results.begin(), results.end(),
-                                 [keep_similar_threshold](const FaceSearchResult &result) { return result.similarity < keep_similar_threshold; }),
-                  results.end());
+    // Reused by the next search of this thread, nothing is allocated once it has grown
+    thread_local std::vector<IndexSearchHit> hits;
+    std::shared_lock<std::shared_timed_mutex> lock(indexMutex_);
+    SearchIndex(*index_, query, top_k, keep_similar_threshold, hits);
+    WriteSearchResults(*index_, hits, result);
+}
 
-    return results;
+void EmbeddingDB::SearchSimilarVectors(const float *query, size_t top_k, float keep_similar_threshold, const TagFilter &filter,
+                                       FaceSearchTopKBuffer &result) const {
+    INSPIREFACE_CHECK_MSG(query != nullptr, "Query vector is null");
+
+    thread_local std::vector<IndexSearchHit> hits;
+    std::shared_lock<std::shared_timed_mutex> lock(indexMutex_);
+    SearchIndex(*index_, query, top_k, keep_similar_threshold, hits, &filter);
+    WriteSearchResults(*index_, hits, result);
 }
 
-int64_t EmbeddingDB::GetVectorCount() const {
-    std::lock_guard<std::mutex> lock(dbMutex_);
-    sqlite3_stmt *stmt;
-    std::string sql = "SELECT COUNT(*) FROM " + tableName_;
+void EmbeddingDB::BatchSearchSimilarVectors(const float *queries, size_t num_queries, size_t top_k, float keep_similar_threshold,
+                                            FaceSearchTopKBuffer *results) const {
+    INSPIREFACE_CHECK_MSG((queries != nullptr && results != nullptr) || num_queries == 0, "Query matrix or result buffers are null");
 
-    int rc = sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr);
-    CheckSQLiteError(rc, db_);
+    thread_local std::vector<std::vector<IndexSearchHit>> hits;
+    std::shared_lock<std::shared_timed_mutex> lock(indexMutex_);
+    index_->SearchBatch(queries, num_queries, top_k, keep_similar_threshold, hits);
+    for (size_t q = 0; q < num_queries; ++q) {
+        WriteSearchResults(*index_, hits[q], results[q]);
+    }
+}
 
-    rc = sqlite3_step(stmt);
-    CheckSQLiteError(rc == SQLITE_ROW ? SQLITE_OK : rc, db_);
+void EmbeddingDB::WriteSearchResults(const VectorIndex &index, const std::vector<IndexSearchHit> &hits, FaceSearchTopKBuffer &result) const {
+    for (size_t i = 0; i < hits.size(); ++i) {
+        result.ids[i] = hits[i].id;
+        result.confidences[i] = hits[i].similarity;
+        if (result.features != nullptr) {
+            std::memcpy(result.features + i * vectorDim_, index.Row(hits[i].row), vectorDim_ * sizeof(float));
+        }
+    }
+    result.size = hits.size();
+}
 
-    int64_t count = sqlite3_column_int64(stmt, 0);
-    sqlite3_finalize(stmt);
+std::vector<FaceSearchResult> EmbeddingDB::MakeSearchResults(const VectorIndex &index, const std::vector<IndexSearchHit> &hits,
+                                                             bool return_feature) const {
+    std::vector<FaceSearchResult> results;
+    results.reserve(hits.size());
+    for (const auto &hit : hits) {
+        FaceSearchResult result;
+        result.id = hit.id;
+        result.similarity = hit.similarity;
+        if (return_feature) {
+            const float *row = index.Row(hit.row);
+            result.feature.assign(row, row + vectorDim_);
+        }
+        results.push_back(std::move(result));
+    }
+    return results;
+}
 
-    return count;
+size_t EmbeddingDB::GetIndexMemoryUsage() const {
+    std::shared_lock<std::shared_timed_mutex> lock(indexMutex_);
+    return index_->MemoryUsage();
+}
+
+int64_t EmbeddingDB::GetVectorCount() const {
+    std::shared_lock<std::shared_timed_mutex> lock(indexMutex_);
+    return static_cast<int64_t>(index_->Size());
 }
 
 void EmbeddingDB::CheckVectorDimension(const std::vector<float> &vector) const {
@@ -268,7 +692,6 @@ void EmbeddingDB::CheckVectorDimension(const std::vector<float> &vector) const {
 }
 
 void EmbeddingDB::ExecuteSQL(const std::string &sql) {
-    std::lock_guard<std::mutex> lock(dbMutex_);
     char *errMsg = nullptr;
     int rc = sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &errMsg);
 
@@ -291,9 +714,9 @@ void EmbeddingDB::ShowTable() {
         INSPIRE_LOGE("EmbeddingDB is not initialized");
         return;
     }
-    std::lock_guard<std::mutex> lock(dbMutex_);
     sqlite3_stmt *stmt;
-    std::string sql = "SELECT rowid, embedding FROM " + tableName_;
+    // The vectors are read from the index, the table of an in-memory quantized database only has the ids
+    std::string sql = "SELECT rowid FROM " + tableName_;
 
     int rc = sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr);
     CheckSQLiteError(rc, db_);
@@ -311,8 +734,9 @@ void EmbeddingDB::ShowTable() {
 
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         int64_t id = sqlite3_column_int64(stmt, 0);
-        const float *vector_data = static_cast<const float *>(sqlite3_column_blob(stmt, 1));
-        size_t vector_size = std::min(size_t(5), sqlite3_column_bytes(stmt, 1) / sizeof(float));
+        std::vector<float> vector = GetVector(id);
+        const float *vector_data = vector.data();
+        size_t vector_size = std::min(size_t(5), vector.size());
 
         std::string vector_str;
         for (size_t i = 0; i < vector_size; ++i) {
@@ -337,9 +761,9 @@ std::vector<int64_t> EmbeddingDB::GetAllIds() {
         INSPIRE_LOGE("EmbeddingDB is not initialized");
         return {};
     }
-    std::lock_guard<std::mutex> lock(dbMutex_);
     std::vector<int64_t> ids;
 
+    // Read from the table, callers rely on its insertion order which the index does not keep
     sqlite3_stmt *stmt;
     std::string sql = "SELECT rowid FROM " + tableName_;
 
@@ -19,7 +19,12 @@
 #include <memory>
 #include <stdexcept>
 #include <mutex>
+#include <shared_mutex>
 #include "data_type.h"
+#include "flat_index.h"
+#include "hnsw_index.h"
+#include "quantized_index.h"
+#include "sharded_index.h"
 
 #define EMBEDDING_DB inspire::EmbeddingDB
 
@@ -37,12 +42,31 @@ enum class IdMode {
     MANUAL,              // Manually specify ID
 };
 
+// Index used to serve searches
+enum class IndexType {
+    FLAT = 0,  // Exact brute-force scan
+    HNSW,      // Approximate graph search, saved next to persistent databases
+};
+
+struct IndexOptions {
+    IndexType type = IndexType::FLAT;
+    HnswParameters hnsw;                            // Only used by IndexType::HNSW
+    VectorStorage storage = VectorStorage::FLOAT32;  // Precision scanned in memory, only used by IndexType::FLAT
+    size_t rerank_factor = 4;                       // Reduced precision: candidates re-ranked per requested result
+    size_t shards = 1;                              // Indexes the gallery is split over, searched in parallel
+};
+
 class EmbeddingDB {
 public:
     ~EmbeddingDB();
 
     static EmbeddingDB &GetInstance();
-    static void Init(const std::string &dbPath = ":memory:", size_t vectorDim = 512, IdMode idMode = IdMode::AUTO_INCREMENT);
+    static void Init(const std::string &dbPath = ":memory:", size_t vectorDim = 512, IdMode idMode = IdMode::AUTO_INCREMENT,
+                     const IndexOptions &indexOptions = IndexOptions());
+
+    // Standalone database next to the singleton, each named gallery of the feature hub owns one
+    static std::unique_ptr<EmbeddingDB> Create(const std::string &dbPath, size_t vectorDim, IdMode idMode,
+                                               const IndexOptions &indexOptions = IndexOptions());
 
     // Delete copy and move operations
     EmbeddingDB(const EmbeddingDB &) = delete;
@@ -58,18 +82,70 @@ public:
     std::vector<int64_t> BatchInsertVectors(const std::vector<VectorData> &vectors);
     std::vector<int64_t> BatchInsertVectors(const std::vector<std::vector<float>> &vectors);  // For auto-increment mode
 
+    // Bulk import of count contiguous vectors (count x vectorDim, row-major) in one transaction,
+    // ids may be null in auto-increment mode and allocIds receives count ids when not null.
+    // tags optionally gives the tag bits of every vector. Nothing is inserted if any row fails
+    bool BatchInsertVectors(const float *vectors, size_t count, const int64_t *ids, int64_t *allocIds, const uint64_t *tags = nullptr);
+
     // Update vector
     void UpdateVector(int64_t id, const std::vector<float> &newVector);
 
     // Delete vector
     void DeleteVector(int64_t id);
 
+    // Set the 64 tag bits of a stored vector, filtered searches test them. Vectors are inserted
+    // without tags and keep them across updates. Returns false if the id does not exist
+    bool SetVectorTags(int64_t id, uint64_t tags);
+
+    bool GetVectorTags(int64_t id, uint64_t &tags) const;
+
     std::vector<FaceSearchResult> SearchSimilarVectors(const std::vector<float> &queryVector, size_t top_k = 3, float keep_similar_threshold = 0.5f,
                                                        bool return_feature = false);
 
+    // Search several queries (num_queries x vectorDim, row-major) in one pass over the index
+    std::vector<std::vector<FaceSearchResult>> BatchSearchSimilarVectors(const float *queries, size_t num_queries, size_t top_k = 3,
+                                                                         float keep_similar_threshold = 0.5f, bool return_feature = false);
+
+    // Search into caller-owned buffers of top_k elements, no result state is shared between calls
+    void SearchSimilarVectors(const float *query, size_t top_k, float keep_similar_threshold, FaceSearchTopKBuffer &result) const;
+
+    // Search restricted to the vectors whose tags match filter, the filter is applied during the scan
+    void SearchSimilarVectors(const float *query, size_t top_k, float keep_similar_threshold, const TagFilter &filter,
+                              FaceSearchTopKBuffer &result) const;
+
+    // Batched search into one caller-owned buffer per query
+    void BatchSearchSimilarVectors(const float *queries, size_t num_queries, size_t top_k, float keep_similar_threshold,
+                                   FaceSearchTopKBuffer *results) const;
+
     // Get vector count
     int64_t GetVectorCount() const;
 
+    size_t GetVectorDim() const {
+        return vectorDim_;
+    }
+
+    IndexType GetIndexType() const {
+        return indexType_;
+    }
+
+    // Set the candidate list size of HNSW searches, ignored by the flat index
+    void SetSearchEf(size_t ef);
+
+    VectorStorage GetVectorStorage() const {
+        return storage_;
+    }
+
+    size_t GetShardCount() const {
+        return shardCount_;
+    }
+
+    // Approximate memory held by the in-memory index, SQLite storage is not included
+    size_t GetIndexMemoryUsage() const;
+
+    // Save the index of a persistent database now instead of at shutdown, so that other
+    // processes opening the database load or map it instead of rebuilding it
+    bool SaveIndex();
+
     // Get current ID mode
     IdMode GetIdMode() const {
         return idMode_;
@@ -96,16 +172,51 @@ public:
 private:
     // Constructor: add ID mode parameter
     explicit EmbeddingDB(const std::string &dbPath = ":memory:", size_t vectorDim = 4, const std::string &distanceMetric = "cosine",
-                         IdMode idMode = IdMode::AUTO_INCREMENT);
+                         IdMode idMode = IdMode::AUTO_INCREMENT, const IndexOptions &indexOptions = IndexOptions());
 
 private:
     sqlite3 *db_;
     size_t vectorDim_;
     std::string tableName_;
+    std::string tagsTableName_;  // Tags of the vectors that have any, keyed by vector id
     IdMode idMode_;
     bool initialized_ = false;
 
+    // In-memory index used for every query, SQLite only journals the vectors. A single copy is kept,
+    // searches share indexMutex_ and a writer takes it exclusively only while it updates the index
+    typedef std::unique_ptr<VectorIndex> IndexPtr;
+    IndexType indexType_;
+    IndexPtr index_;
+    mutable std::shared_timed_mutex indexMutex_;
+    std::string indexPath_;           // Where the HNSW graph is saved, empty for in-memory databases
+    std::string snapshotPath_;        // Where the flat rows are saved, empty for in-memory databases
+    bool indexDirty_ = false;         // The saved index no longer matches the table
+    VectorStorage storage_;           // Precision of the vectors scanned by index_
+    bool vectorsInTable_ = true;      // The table stores the vectors, otherwise only their ids
+    size_t shardCount_;               // Shards of index_, a single shard is not wrapped in a ShardedIndex
+
     // Helper functions
+    bool InsertVectorInternal(int64_t id, const float *vector, int64_t &allocId);
+    void ConfigureConnection(bool persistent);
+    void PrepareStatements();
+    void FinalizeStatements();
+    sqlite3_stmt *PrepareStatement(const std::string &sql) const;
+    static int StepStatement(sqlite3_stmt *stmt);
+    void LoadIndexFromTable(VectorIndex &index);
+    void LoadTagsFromTable(VectorIndex &index);
+    bool WriteTagsToTable(int64_t id, uint64_t tags);
+    bool LoadPersistedIndex(VectorIndex &index);
+    bool SavePersistedIndex();
+    const std::string &PersistedIndexPath() const;
+    std::string ShardFilePath(const std::string &path, size_t shard) const;
+    VectorIndex &IndexShard(VectorIndex &index, size_t shard) const;
+    const VectorIndex &IndexShard(const VectorIndex &index, size_t shard) const;
+    uint32_t ReadUserVersion();
+    void MarkIndexDirty();
+    void SearchIndex(const VectorIndex &index, const float *query, size_t top_k, float threshold, std::vector<IndexSearchHit> &hits,
+                     const TagFilter *filter = nullptr) const;
+    std::vector<FaceSearchResult> MakeSearchResults(const VectorIndex &index, const std::vector<IndexSearchHit> &hits, bool return_feature) const;
+    void WriteSearchResults(const VectorIndex &index, const std::vector<IndexSearchHit> &hits, FaceSearchTopKBuffer &result) const;
     void CheckVectorDimension(const std::vector<float> &vector) const;
     void ExecuteSQL(const std::string &sql);
     static void CheckSQLiteError(int rc, sqlite3 *db);
@@ -116,8 +227,16 @@ private:
     static std::unique_ptr<EmbeddingDB> instance_;
     static std::mutex instanceMutex_;
 
-    // Database operation mutex
-    mutable std::mutex dbMutex_;
+    // Serializes writers so that the table and the index see changes in the same order,
+    // searches do not take it and the connection is opened in serialized mode
+    std::mutex writeMutex_;
+
+    // Statements prepared once per connection, the writer ones are only used under writeMutex_
+    sqlite3_stmt *insertStmt_ = nullptr;
+    sqlite3_stmt *updateStmt_ = nullptr;
+    sqlite3_stmt *deleteStmt_ = nullptr;
+    sqlite3_stmt *setTagsStmt_ = nullptr;
+    sqlite3_stmt *deleteTagsStmt_ = nullptr;
 };
 
 }  // namespace inspire
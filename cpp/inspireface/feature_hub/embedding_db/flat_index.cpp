@@ -0,0 +1,302 @@
+#include "flat_index.h"
+#include "top_k_collector.h"
+#include "feature_hub/simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace inspire {
+
+namespace {
+
+// Rows scored per kernel call, keeps the score block resident in L1
+const size_t kSearchBlockRows = 1024;
+
+// Bytes of matrix kept hot in cache while a batch of queries is scored against it
+const size_t kBatchTileBytes = 256 * 1024;
+
+}  // namespace
+
+FlatIndex::FlatIndex(size_t dim) : dim_(dim), stride_((dim + 15) / 16 * 16) {}
+
+void FlatIndex::WriteRow(size_t row, const float *vector) {
+    float *dst = data_.data() + row * stride_;
+    std::memcpy(dst, vector, dim_ * sizeof(float));
+    std::fill(dst + dim_, dst + stride_, 0.0f);
+    float norm = std::sqrt(simd_dot(vector, vector, static_cast<long>(dim_)));
+    inv_norms_[row] = norm > 0.0f ? 1.0f / norm : 0.0f;
+}
+
+bool FlatIndex::Add(int64_t id, const float *vector) {
+    if (Contains(id)) {
+        return false;
+    }
+    Detach();
+    size_t row = ids_.size();
+    data_.resize((row + 1) * stride_);
+    inv_norms_.resize(row + 1);
+    ids_.push_back(id);
+    if (!tags_.empty()) {
+        tags_.push_back(0);
+    }
+    id_to_row_[id] = row;
+    WriteRow(row, vector);
+    return true;
+}
+
+bool FlatIndex::Update(int64_t id, const float *vector) {
+    if (!Contains(id)) {
+        return false;
+    }
+    Detach();
+    auto it = id_to_row_.find(id);
+    if (it == id_to_row_.end()) {
+        return false;
+    }
+    WriteRow(it->second, vector);
+    return true;
+}
+
+bool FlatIndex::Remove(int64_t id) {
+    if (!Contains(id)) {
+        return false;
+    }
+    Detach();
+    auto it = id_to_row_.find(id);
+    if (it == id_to_row_.end()) {
+        return false;
+    }
+    size_t row = it->second;
+    size_t last = ids_.size() - 1;
+    if (row != last) {
+        // Swap the last row into the hole so the matrix stays dense
+        std::memcpy(data_.data() + row * stride_, data_.data() + last * stride_, stride_ * sizeof(float));
+        inv_norms_[row] = inv_norms_[last];
+        ids_[row] = ids_[last];
+        if (!tags_.empty()) {
+            tags_[row] = tags_[last];
+        }
+        id_to_row_[ids_[row]] = row;
+    }
+    id_to_row_.erase(it);
+    ids_.pop_back();
+    if (!tags_.empty()) {
+        tags_.pop_back();
+    }
+    inv_norms_.pop_back();
+    data_.resize(last * stride_);
+    return true;
+}
+
+bool FlatIndex::Get(int64_t id, std::vector<float> &out) const {
+    size_t row = 0;
+    if (!FindRow(id, row)) {
+        return false;
+    }
+    const float *data = Row(row);
+    out.assign(data, data + dim_);
+    return true;
+}
+
+bool FlatIndex::Contains(int64_t id) const {
+    size_t row = 0;
+    return FindRow(id, row);
+}
+
+bool FlatIndex::SetTags(int64_t id, uint64_t tags) {
+    size_t row = 0;
+    if (!FindRow(id, row)) {
+        return false;
+    }
+    if (tags_.empty()) {
+        if (tags == 0) {
+            return true;
+        }
+        tags_.assign(Size(), 0);
+    }
+    tags_[row] = tags;
+    return true;
+}
+
+bool FlatIndex::GetTags(int64_t id, uint64_t &tags) const {
+    size_t row = 0;
+    if (!FindRow(id, row)) {
+        return false;
+    }
+    tags = tags_.empty() ? 0 : tags_[row];
+    return true;
+}
+
+bool FlatIndex::FindRow(int64_t id, size_t &row) const {
+    if (snapshot_) {
+        return snapshot_->FindRow(id, row);
+    }
+    auto it = id_to_row_.find(id);
+    if (it == id_to_row_.end()) {
+        return false;
+    }
+    row = it->second;
+    return true;
+}
+
+std::vector<int64_t> FlatIndex::Ids() const {
+    return std::vector<int64_t>(RowIds(), RowIds() + Size());
+}
+
+void FlatIndex::Search(const float *query, size_t top_k, float threshold, std::vector<IndexSearchHit> &hits) const {
+    SearchRows(query, top_k, threshold, nullptr, hits);
+}
+
+void FlatIndex::SearchFiltered(const float *query, size_t top_k, float threshold, const TagFilter &filter,
+                               std::vector<IndexSearchHit> &hits) const {
+    SearchRows(query, top_k, threshold, &filter, hits);
+}
+
+void FlatIndex::SearchRows(const float *query, size_t top_k, float threshold, const TagFilter *filter, std::vector<IndexSearchHit> &hits) const {
+    hits.clear();
+    if (filter != nullptr && tags_.empty()) {
+        // No vector has tags yet, the filter selects all of them or none
+        if (!filter->Matches(0)) {
+            return;
+        }
+        filter = nullptr;
+    }
+    if (top_k == 0 || Size() == 0) {
+        return;
+    }
+    float query_norm = std::sqrt(simd_dot(query, query, static_cast<long>(dim_)));
+    if (query_norm <= 0.0f) {
+        return;
+    }
+    float query_inv_norm = 1.0f / query_norm;
+
+    // Zero-padded copy of the query so the kernel can run over the full row stride
+    thread_local AlignedFloatBuffer padded_query;
+    thread_local std::vector<float> scores;
+    padded_query.assign(stride_, 0.0f);
+    std::memcpy(padded_query.data(), query, dim_ * sizeof(float));
+    scores.resize(kSearchBlockRows);
+
+    TopKCollector collector(top_k, threshold, &hits);
+    const size_t total = Size();
+    for (size_t begin = 0; begin < total; begin += kSearchBlockRows) {
+        size_t count = std::min(kSearchBlockRows, total - begin);
+        if (filter == nullptr) {
+            simd_dot_rows(padded_query.data(), Row(begin), count, stride_, stride_, scores.data());
+        } else if (!ScoreMatchingRows(tags_.data() + begin, count, *filter, scores.data(), [&](size_t first, size_t n, float *out) {
+                       simd_dot_rows(padded_query.data(), Row(begin + first), n, stride_, stride_, out);
+                   })) {
+            continue;
+        }
+        collector.Collect(scores.data(), count, begin, query_inv_norm, InvNorms(), RowIds());
+    }
+    collector.Finish();
+}
+
+void FlatIndex::SearchBatch(const float *queries, size_t num_queries, size_t top_k, float threshold,
+                            std::vector<std::vector<IndexSearchHit>> &hits) const {
+    hits.assign(num_queries, std::vector<IndexSearchHit>());
+    if (top_k == 0 || Size() == 0 || num_queries == 0) {
+        return;
+    }
+
+    thread_local AlignedFloatBuffer padded_queries;
+    thread_local std::vector<float> query_inv_norms;
+    thread_local std::vector<float> scores;
+    padded_queries.assign(num_queries * stride_, 0.0f);
+    query_inv_norms.assign(num_queries, 0.0f);
+
+    std::vector<TopKCollector> collectors;
+    collectors.reserve(num_queries);
+    for (size_t q = 0; q < num_queries; ++q) {
+        const float *query = queries + q * dim_;
+        std::memcpy(padded_queries.data() + q * stride_, query, dim_ * sizeof(float));
+        float query_norm = std::sqrt(simd_dot(query, query, static_cast<long>(dim_)));
+        // Zero queries keep a zero inverse norm and are skipped
+        query_inv_norms[q] = query_norm > 0.0f ? 1.0f / query_norm : 0.0f;
+        collectors.emplace_back(top_k, threshold, &hits[q]);
+    }
+
+    const size_t tile_rows = std::max<size_t>(16, kBatchTileBytes / (stride_ * sizeof(float)));
+    scores.resize(tile_rows);
+    const size_t total = Size();
+    for (size_t begin = 0; begin < total; begin += tile_rows) {
+        size_t count = std::min(tile_rows, total - begin);
+        const float *tile = Row(begin);
+        for (size_t q = 0; q < num_queries; ++q) {
+            if (query_inv_norms[q] == 0.0f) {
+                continue;
+            }
+            simd_dot_rows(padded_queries.data() + q * stride_, tile, count, stride_, stride_, scores.data());
+            collectors[q].Collect(scores.data(), count, begin, query_inv_norms[q], InvNorms(), RowIds());
+        }
+    }
+    for (auto &collector : collectors) {
+        collector.Finish();
+    }
+}
+
+void FlatIndex::Reserve(size_t rows) {
+    Detach();
+    data_.reserve(rows * stride_);
+    inv_norms_.reserve(rows);
+    ids_.reserve(rows);
+    if (!tags_.empty()) {
+        tags_.reserve(rows);
+    }
+    id_to_row_.reserve(rows);
+}
+
+void FlatIndex::Clear() {
+    snapshot_.reset();
+    AlignedFloatBuffer().swap(data_);
+    std::vector<float>().swap(inv_norms_);
+    std::vector<int64_t>().swap(ids_);
+    std::vector<uint64_t>().swap(tags_);
+    id_to_row_.clear();
+}
+
+size_t FlatIndex::MemoryUsage() const {
+    return data_.capacity() * sizeof(float) + inv_norms_.capacity() * sizeof(float) + ids_.capacity() * sizeof(int64_t) +
+           tags_.capacity() * sizeof(uint64_t) + HashMapMemoryUsage(id_to_row_);
+}
+
+GallerySnapshot::Layout FlatIndex::SnapshotLayout() const {
+    return {VectorStorage::FLOAT32, dim_, stride_, stride_ * sizeof(float)};
+}
+
+bool FlatIndex::Save(const std::string &path, uint32_t tag) const {
+    return GallerySnapshot::Save(path, tag, SnapshotLayout(), Size(), RowIds(), InvNorms(), Matrix());
+}
+
+bool FlatIndex::Map(const std::string &path, uint32_t *tag) {
+    auto snapshot = GallerySnapshot::Map(path);
+    if (!snapshot || !(snapshot->GetLayout() == SnapshotLayout())) {
+        return false;
+    }
+    Clear();
+    snapshot_ = snapshot;
+    if (tag != nullptr) {
+        *tag = snapshot_->Tag();
+    }
+    return true;
+}
+
+void FlatIndex::Detach() {
+    if (!snapshot_) {
+        return;
+    }
+    const size_t count = snapshot_->Count();
+    const float *matrix = Matrix();
+    data_.assign(matrix, matrix + count * stride_);
+    inv_norms_.assign(InvNorms(), InvNorms() + count);
+    ids_.assign(RowIds(), RowIds() + count);
+    id_to_row_.clear();
+    id_to_row_.reserve(count);
+    for (size_t row = 0; row < count; ++row) {
+        id_to_row_[ids_[row]] = row;
+    }
+    snapshot_.reset();
+}
+
+}  // namespace inspire
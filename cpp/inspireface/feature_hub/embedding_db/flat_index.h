@@ -0,0 +1,132 @@
+#ifndef INSPIRE_FLAT_INDEX_H
+#define INSPIRE_FLAT_INDEX_H
+
+#include <string>
+#include <unordered_map>
+#include "vector_index.h"
+#include "gallery_snapshot.h"
+
+namespace inspire {
+
+/**
+ * @class FlatIndex
+ * @brief Brute-force cosine similarity index over a contiguous float matrix.
+ *
+ * Rows are padded to a multiple of 16 floats (64 bytes) and stored back to back, so a search
+ * is a single streaming pass of the SIMD dot-product kernel followed by a partial sort.
+ * Vectors are kept as inserted; the inverse norm of each row is cached to produce cosine scores.
+ * The rows can also be served from a mapped GallerySnapshot, they are copied to the heap on the first modification.
+ */
+class FlatIndex : public VectorIndex {
+public:
+    explicit FlatIndex(size_t dim);
+
+    bool Add(int64_t id, const float *vector) override;
+
+    /**
+     * @brief Replaces the vector in place, the row of the id does not change.
+     */
+    bool Update(int64_t id, const float *vector) override;
+
+    /**
+     * @brief Removes the vector stored under id, the last row is moved into the freed slot.
+     */
+    bool Remove(int64_t id) override;
+
+    bool Get(int64_t id, std::vector<float> &out) const override;
+
+    bool Contains(int64_t id) const override;
+
+    bool SetTags(int64_t id, uint64_t tags) override;
+
+    bool GetTags(int64_t id, uint64_t &tags) const override;
+
+    void Search(const float *query, size_t top_k, float threshold, std::vector<IndexSearchHit> &hits) const override;
+
+    void SearchFiltered(const float *query, size_t top_k, float threshold, const TagFilter &filter,
+                        std::vector<IndexSearchHit> &hits) const override;
+
+    /**
+     * @brief Runs several queries in one pass over the matrix.
+     * @details The matrix is walked in tiles small enough to stay in cache while every query
+     * is scored against them, so the gallery is streamed from memory once instead of once per query.
+     */
+    void SearchBatch(const float *queries, size_t num_queries, size_t top_k, float threshold,
+                     std::vector<std::vector<IndexSearchHit>> &hits) const override;
+
+    void Reserve(size_t rows) override;
+
+    void Clear() override;
+
+    size_t Size() const override {
+        return snapshot_ ? snapshot_->Count() : ids_.size();
+    }
+
+    size_t Dim() const override {
+        return dim_;
+    }
+
+    size_t Stride() const {
+        return stride_;
+    }
+
+    const float *Row(size_t row) const override {
+        return Matrix() + row * stride_;
+    }
+
+    std::vector<int64_t> Ids() const override;
+
+    /**
+     * @brief Heap memory only, the pages of a mapped snapshot are not counted.
+     */
+    size_t MemoryUsage() const override;
+
+    /**
+     * @brief Writes the rows to a snapshot file that Map() can serve without loading it.
+     */
+    bool Save(const std::string &path, uint32_t tag) const;
+
+    /**
+     * @brief Replaces the content with the snapshot at path, fails if it was saved with another dimension.
+     * @param tag Receives the tag the snapshot was saved with.
+     */
+    bool Map(const std::string &path, uint32_t *tag);
+
+private:
+    void WriteRow(size_t row, const float *vector);
+
+    void SearchRows(const float *query, size_t top_k, float threshold, const TagFilter *filter, std::vector<IndexSearchHit> &hits) const;
+
+    // Copies a mapped snapshot to the heap before a modification
+    void Detach();
+
+    bool FindRow(int64_t id, size_t &row) const;
+
+    const float *Matrix() const {
+        return snapshot_ ? reinterpret_cast<const float *>(snapshot_->Matrix()) : data_.data();
+    }
+
+    const float *InvNorms() const {
+        return snapshot_ ? snapshot_->Factors() : inv_norms_.data();
+    }
+
+    const int64_t *RowIds() const {
+        return snapshot_ ? snapshot_->Ids() : ids_.data();
+    }
+
+    GallerySnapshot::Layout SnapshotLayout() const;
+
+private:
+    size_t dim_;
+    size_t stride_;
+    AlignedFloatBuffer data_;
+    std::vector<float> inv_norms_;
+    std::vector<int64_t> ids_;
+    std::unordered_map<int64_t, size_t> id_to_row_;
+    std::vector<uint64_t> tags_;                       ///< Tags of every row once one is set, empty while no row has tags
+    std::shared_ptr<const GallerySnapshot> snapshot_;  ///< Rows served in place of the heap buffers when set
+};
+
+}  // namespace inspire
+
+#endif  // INSPIRE_FLAT_INDEX_H
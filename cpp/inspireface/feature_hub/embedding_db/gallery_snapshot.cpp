@@ -0,0 +1,228 @@
+#include "gallery_snapshot.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace inspire {
+
+namespace {
+
+const char kSnapshotMagic[8] = {'I', 'S', 'F', 'G', 'A', 'L', 'L', '\0'};
+const uint32_t kSnapshotVersion = 1;
+
+// Every section starts on a cache line so the matrix rows keep the alignment of the in-memory index
+const uint64_t kSectionAlignment = 64;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t tag;
+    uint32_t storage;
+    uint32_t reserved;
+    uint64_t dim;
+    uint64_t stride;
+    uint64_t row_bytes;
+    uint64_t count;
+    uint64_t ids_offset;
+    uint64_t lookup_offset;
+    uint64_t factors_offset;
+    uint64_t matrix_offset;
+    uint64_t file_size;
+};
+
+inline uint64_t AlignSection(uint64_t offset) {
+    return (offset + kSectionAlignment - 1) / kSectionAlignment * kSectionAlignment;
+}
+
+inline size_t ElementSize(VectorStorage storage) {
+    return storage == VectorStorage::FLOAT32 ? sizeof(float) : storage == VectorStorage::FLOAT16 ? sizeof(uint16_t) : sizeof(int8_t);
+}
+
+// Fills the section offsets of a snapshot of count rows
+void ComputeOffsets(uint64_t count, uint64_t row_bytes, SnapshotHeader &header) {
+    header.ids_offset = AlignSection(sizeof(SnapshotHeader));
+    header.lookup_offset = AlignSection(header.ids_offset + count * sizeof(int64_t));
+    header.factors_offset = AlignSection(header.lookup_offset + count * 2 * sizeof(int64_t));
+    header.matrix_offset = AlignSection(header.factors_offset + count * sizeof(float));
+    header.file_size = header.matrix_offset + count * row_bytes;
+}
+
+bool WriteSection(std::ofstream &out, uint64_t offset, const void *data, size_t bytes) {
+    static const char zeros[kSectionAlignment] = {0};
+    uint64_t position = static_cast<uint64_t>(out.tellp());
+    if (position > offset) {
+        return false;
+    }
+    out.write(zeros, static_cast<std::streamsize>(offset - position));
+    out.write(static_cast<const char *>(data), static_cast<std::streamsize>(bytes));
+    return static_cast<bool>(out);
+}
+
+bool ValidateHeader(const SnapshotHeader &header, uint64_t file_size) {
+    if (std::memcmp(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 || header.version != kSnapshotVersion ||
+        header.storage > static_cast<uint32_t>(VectorStorage::INT8) || header.file_size != file_size) {
+        return false;
+    }
+    size_t element_size = ElementSize(static_cast<VectorStorage>(header.storage));
+    if (header.dim == 0 || header.stride < header.dim || header.row_bytes != header.stride * element_size ||
+        header.row_bytes % kSectionAlignment != 0) {
+        return false;
+    }
+    // Bound the count by the file size first so the offsets below cannot overflow
+    if (header.count > file_size / header.row_bytes) {
+        return false;
+    }
+    SnapshotHeader expected = header;
+    ComputeOffsets(header.count, header.row_bytes, expected);
+    return expected.ids_offset == header.ids_offset && expected.lookup_offset == header.lookup_offset &&
+           expected.factors_offset == header.factors_offset && expected.matrix_offset == header.matrix_offset &&
+           expected.file_size == header.file_size;
+}
+
+}  // namespace
+
+GallerySnapshot::~GallerySnapshot() {
+#if defined(_WIN32)
+    if (mapping_ != nullptr) {
+        UnmapViewOfFile(mapping_);
+    }
+    if (map_handle_ != nullptr) {
+        CloseHandle(map_handle_);
+    }
+    if (file_handle_ != nullptr) {
+        CloseHandle(file_handle_);
+    }
+#else
+    if (mapping_ != nullptr) {
+        munmap(mapping_, mapping_size_);
+    }
+#endif
+}
+
+bool GallerySnapshot::Save(const std::string &path, uint32_t tag, const Layout &layout, size_t count, const int64_t *ids, const float *factors,
+                           const void *matrix) {
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+    header.version = kSnapshotVersion;
+    header.tag = tag;
+    header.storage = static_cast<uint32_t>(layout.storage);
+    header.dim = layout.dim;
+    header.stride = layout.stride;
+    header.row_bytes = layout.row_bytes;
+    header.count = count;
+    ComputeOffsets(count, layout.row_bytes, header);
+
+    std::vector<LookupEntry> lookup(count);
+    for (size_t row = 0; row < count; ++row) {
+        lookup[row].id = ids[row];
+        lookup[row].row = row;
+    }
+    std::sort(lookup.begin(), lookup.end(), [](const LookupEntry &a, const LookupEntry &b) { return a.id < b.id; });
+
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        bool written = WriteSection(out, header.ids_offset, ids, count * sizeof(int64_t)) &&
+                       WriteSection(out, header.lookup_offset, lookup.data(), count * sizeof(LookupEntry)) &&
+                       WriteSection(out, header.factors_offset, factors, count * sizeof(float)) &&
+                       WriteSection(out, header.matrix_offset, matrix, count * layout.row_bytes);
+        out.close();
+        if (!written || !out) {
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+    }
+    // The previous file may still be mapped, renaming leaves its pages untouched
+    std::remove(path.c_str());
+    return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+std::shared_ptr<const GallerySnapshot> GallerySnapshot::Map(const std::string &path) {
+    std::shared_ptr<GallerySnapshot> snapshot(new GallerySnapshot());
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    snapshot->file_handle_ = file;
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < static_cast<LONGLONG>(sizeof(SnapshotHeader))) {
+        return nullptr;
+    }
+    snapshot->map_handle_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (snapshot->map_handle_ == nullptr) {
+        return nullptr;
+    }
+    snapshot->mapping_ = MapViewOfFile(snapshot->map_handle_, FILE_MAP_READ, 0, 0, 0);
+    if (snapshot->mapping_ == nullptr) {
+        return nullptr;
+    }
+    snapshot->mapping_size_ = static_cast<size_t>(file_size.QuadPart);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(SnapshotHeader))) {
+        close(fd);
+        return nullptr;
+    }
+    // Shared read-only pages, every process mapping the file uses the same page cache
+    void *mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+    snapshot->mapping_ = mapping;
+    snapshot->mapping_size_ = static_cast<size_t>(st.st_size);
+#endif
+
+    const uint8_t *base = static_cast<const uint8_t *>(snapshot->mapping_);
+    SnapshotHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (!ValidateHeader(header, snapshot->mapping_size_)) {
+        return nullptr;
+    }
+    snapshot->tag_ = header.tag;
+    snapshot->layout_.storage = static_cast<VectorStorage>(header.storage);
+    snapshot->layout_.dim = static_cast<size_t>(header.dim);
+    snapshot->layout_.stride = static_cast<size_t>(header.stride);
+    snapshot->layout_.row_bytes = static_cast<size_t>(header.row_bytes);
+    snapshot->count_ = static_cast<size_t>(header.count);
+    snapshot->ids_ = reinterpret_cast<const int64_t *>(base + header.ids_offset);
+    snapshot->lookup_ = reinterpret_cast<const LookupEntry *>(base + header.lookup_offset);
+    snapshot->factors_ = reinterpret_cast<const float *>(base + header.factors_offset);
+    snapshot->matrix_ = base + header.matrix_offset;
+    return snapshot;
+}
+
+bool GallerySnapshot::FindRow(int64_t id, size_t &row) const {
+    const LookupEntry *end = lookup_ + count_;
+    const LookupEntry *it = std::lower_bound(lookup_, end, id, [](const LookupEntry &entry, int64_t value) { return entry.id < value; });
+    if (it == end || it->id != id || it->row >= count_) {
+        return false;
+    }
+    row = static_cast<size_t>(it->row);
+    return true;
+}
+
+}  // namespace inspire
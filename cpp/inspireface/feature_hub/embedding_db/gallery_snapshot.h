@@ -0,0 +1,106 @@
+#ifndef INSPIRE_GALLERY_SNAPSHOT_H
+#define INSPIRE_GALLERY_SNAPSHOT_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "quantized_index.h"
+
+namespace inspire {
+
+/**
+ * @class GallerySnapshot
+ * @brief Read-only memory mapping of a flat gallery saved to disk.
+ *
+ * The file holds a header, the id of every row, the ids sorted with their rows for lookups,
+ * one float factor per row (inverse norm or dequantization scale) and the padded matrix in the
+ * layout of the index that saved it, every section starting on a 64-byte boundary. The mapping
+ * is searched in place, nothing is deserialized and the pages are shared by every process that
+ * maps the same file. The format uses the native byte order.
+ */
+class GallerySnapshot {
+public:
+    /** @brief Shape of the rows stored in a snapshot. */
+    struct Layout {
+        VectorStorage storage;  ///< Element type of the matrix
+        size_t dim;             ///< Elements per vector
+        size_t stride;          ///< Elements per padded row
+        size_t row_bytes;       ///< Bytes per padded row
+
+        bool operator==(const Layout &other) const {
+            return storage == other.storage && dim == other.dim && stride == other.stride && row_bytes == other.row_bytes;
+        }
+    };
+
+    ~GallerySnapshot();
+
+    GallerySnapshot(const GallerySnapshot &) = delete;
+    GallerySnapshot &operator=(const GallerySnapshot &) = delete;
+
+    /**
+     * @brief Writes count rows to path, through a temporary file so that a mapped snapshot is never modified.
+     * @param tag Value stored in the header, used by the owner to match the snapshot with its database.
+     */
+    static bool Save(const std::string &path, uint32_t tag, const Layout &layout, size_t count, const int64_t *ids, const float *factors,
+                     const void *matrix);
+
+    /**
+     * @brief Maps the snapshot at path, returns null if it is missing or malformed.
+     */
+    static std::shared_ptr<const GallerySnapshot> Map(const std::string &path);
+
+    uint32_t Tag() const {
+        return tag_;
+    }
+
+    const Layout &GetLayout() const {
+        return layout_;
+    }
+
+    size_t Count() const {
+        return count_;
+    }
+
+    const int64_t *Ids() const {
+        return ids_;
+    }
+
+    const float *Factors() const {
+        return factors_;
+    }
+
+    const uint8_t *Matrix() const {
+        return matrix_;
+    }
+
+    /**
+     * @brief Binary search of the sorted ids.
+     */
+    bool FindRow(int64_t id, size_t &row) const;
+
+private:
+    struct LookupEntry {
+        int64_t id;
+        uint64_t row;
+    };
+
+    GallerySnapshot() = default;
+
+    void *mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+#if defined(_WIN32)
+    void *file_handle_ = nullptr;
+    void *map_handle_ = nullptr;
+#endif
+    uint32_t tag_ = 0;
+    Layout layout_ = {VectorStorage::FLOAT32, 0, 0, 0};
+    size_t count_ = 0;
+    const int64_t *ids_ = nullptr;
+    const LookupEntry *lookup_ = nullptr;
+    const float *factors_ = nullptr;
+    const uint8_t *matrix_ = nullptr;
+};
+
+}  // namespace inspire
+
+#endif  // INSPIRE_GALLERY_SNAPSHOT_H
@@ -0,0 +1,667 @@
+#include "hnsw_index.h"
+#include "top_k_collector.h"
+#include "feature_hub/simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <queue>
+
+namespace inspire {
+
+namespace {
+
+const char kHnswMagic[8] = {'I', 'S', 'F', 'H', 'N', 'S', 'W', '\0'};
+const uint32_t kHnswVersion = 1;
+// Levels above this are never drawn for realistic m, anything larger in a file means corruption
+const int kMaxLevel = 32;
+// Deleted nodes tolerated before the graph is rebuilt
+const size_t kMinCompactDeleted = 1024;
+// Filtered searches matching at most this many live nodes score them exhaustively
+const size_t kFilteredExactScanNodes = 4096;
+// Upper bound of the factor applied to ef_search by filtered graph searches
+const size_t kMaxFilteredEfScale = 16;
+
+// Visit marks of one search, reused across searches of the same thread
+class VisitedList {
+public:
+    void Reset(size_t nodes) {
+        if (marks_.size() < nodes) {
+            marks_.resize(nodes, 0);
+        }
+        if (++tag_ == 0) {
+            std::fill(marks_.begin(), marks_.end(), 0);
+            tag_ = 1;
+        }
+    }
+
+    bool Visit(uint32_t node) {
+        if (marks_[node] == tag_) {
+            return false;
+        }
+        marks_[node] = tag_;
+        return true;
+    }
+
+private:
+    std::vector<uint32_t> marks_;
+    uint32_t tag_ = 0;
+};
+
+struct CloserFirst {
+    template <typename T>
+    bool operator()(const T &a, const T &b) const {
+        return a.similarity < b.similarity;
+    }
+};
+
+struct FartherFirst {
+    template <typename T>
+    bool operator()(const T &a, const T &b) const {
+        return a.similarity > b.similarity;
+    }
+};
+
+template <typename T>
+void WritePod(std::ofstream &out, const T &value) {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+bool ReadPod(std::ifstream &in, T &value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+}  // namespace
+
+HnswIndex::HnswIndex(size_t dim, const HnswParameters &params)
+: dim_(dim),
+  stride_((dim + 15) / 16 * 16),
+  params_(params),
+  max_links0_(0),
+  level_mult_(0.0),
+  entry_point_(-1),
+  max_level_(-1),
+  deleted_count_(0),
+  rng_(100) {
+    params_.m = std::max<size_t>(params_.m, 2);
+    params_.ef_construction = std::max(params_.ef_construction, params_.m);
+    params_.ef_search = std::max<size_t>(params_.ef_search, 1);
+    max_links0_ = params_.m * 2;
+    level_mult_ = 1.0 / std::log(static_cast<double>(params_.m));
+}
+
+int HnswIndex::RandomLevel() {
+    std::uniform_real_distribution<double> distribution(0.0, 1.0);
+    double r = std::max(distribution(rng_), std::numeric_limits<double>::min());
+    return std::min(static_cast<int>(-std::log(r) * level_mult_), kMaxLevel);
+}
+
+HnswIndex::NodeId *HnswIndex::Links(NodeId node, int level) {
+    if (level == 0) {
+        return links0_.data() + node * (max_links0_ + 1);
+    }
+    return upper_links_[node].data() + (level - 1) * (params_.m + 1);
+}
+
+const HnswIndex::NodeId *HnswIndex::Links(NodeId node, int level) const {
+    if (level == 0) {
+        return links0_.data() + node * (max_links0_ + 1);
+    }
+    return upper_links_[node].data() + (level - 1) * (params_.m + 1);
+}
+
+void HnswIndex::NormalizeQuery(const float *vector, float *out) const {
+    float norm = std::sqrt(simd_dot(vector, vector, static_cast<long>(dim_)));
+    float inv_norm = norm > 0.0f ? 1.0f / norm : 0.0f;
+    for (size_t i = 0; i < dim_; ++i) {
+        out[i] = vector[i] * inv_norm;
+    }
+    std::fill(out + dim_, out + stride_, 0.0f);
+}
+
+float HnswIndex::QuerySimilarity(const float *query, NodeId node) const {
+    const float *row = Row(node);
+    float score;
+    simd_dot_gather(query, &row, 1, stride_, &score);
+    return score * inv_norms_[node];
+}
+
+float HnswIndex::NodeSimilarity(NodeId a, NodeId b) const {
+    const float *row = Row(b);
+    float score;
+    simd_dot_gather(Row(a), &row, 1, stride_, &score);
+    return score * inv_norms_[a] * inv_norms_[b];
+}
+
+HnswIndex::NodeId HnswIndex::AppendNode(int64_t id, const float *vector, int level) {
+    NodeId node = static_cast<NodeId>(node_ids_.size());
+    data_.resize((node + 1) * stride_);
+    float *dst = data_.data() + node * stride_;
+    std::memcpy(dst, vector, dim_ * sizeof(float));
+    std::fill(dst + dim_, dst + stride_, 0.0f);
+    float norm = std::sqrt(simd_dot(vector, vector, static_cast<long>(dim_)));
+    inv_norms_.push_back(norm > 0.0f ? 1.0f / norm : 0.0f);
+    node_ids_.push_back(id);
+    deleted_.push_back(0);
+    tags_.push_back(0);
+    levels_.push_back(level);
+    links0_.resize((node + 1) * (max_links0_ + 1), 0);
+    upper_links_.emplace_back(level * (params_.m + 1), 0);
+    return node;
+}
+
+bool HnswIndex::Add(int64_t id, const float *vector) {
+    if (Contains(id)) {
+        return false;
+    }
+    NodeId node = AppendNode(id, vector, RandomLevel());
+    id_to_node_[id] = node;
+    LinkNode(node);
+    return true;
+}
+
+void HnswIndex::LinkNode(NodeId node) {
+    int level = levels_[node];
+    if (entry_point_ < 0) {
+        entry_point_ = node;
+        max_level_ = level;
+        return;
+    }
+
+    thread_local AlignedFloatBuffer query;
+    query.resize(stride_);
+    NormalizeQuery(Row(node), query.data());
+
+    NodeId current = static_cast<NodeId>(entry_point_);
+    for (int l = max_level_; l > level; --l) {
+        current = GreedyClosest(query.data(), current, l);
+    }
+
+    std::vector<Candidate> candidates;
+    for (int l = std::min(level, max_level_); l >= 0; --l) {
+        // Deleted nodes still take part in construction so the graph stays connected through them
+        SearchLayer(query.data(), current, params_.ef_construction, l, false, nullptr, candidates);
+        current = candidates.front().node;
+        SelectNeighbors(candidates, params_.m);
+
+        NodeId *links = Links(node, l);
+        links[0] = static_cast<NodeId>(candidates.size());
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            links[i + 1] = candidates[i].node;
+        }
+        for (const auto &candidate : candidates) {
+            AddLink(candidate.node, node, l);
+        }
+    }
+
+    if (level > max_level_) {
+        entry_point_ = node;
+        max_level_ = level;
+    }
+}
+
+void HnswIndex::AddLink(NodeId node, NodeId neighbor, int level) {
+    NodeId *links = Links(node, level);
+    size_t max_links = level == 0 ? max_links0_ : params_.m;
+    size_t count = links[0];
+    if (count < max_links) {
+        links[count + 1] = neighbor;
+        links[0] = static_cast<NodeId>(count + 1);
+        return;
+    }
+
+    // The list is full, keep the most diverse subset of the old links plus the new one
+    std::vector<Candidate> candidates;
+    candidates.reserve(count + 1);
+    candidates.push_back({NodeSimilarity(node, neighbor), neighbor});
+    for (size_t i = 0; i < count; ++i) {
+        candidates.push_back({NodeSimilarity(node, links[i + 1]), links[i + 1]});
+    }
+    std::sort(candidates.begin(), candidates.end(), FartherFirst());
+    SelectNeighbors(candidates, max_links);
+    links[0] = static_cast<NodeId>(candidates.size());
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        links[i + 1] = candidates[i].node;
+    }
+}
+
+void HnswIndex::SelectNeighbors(std::vector<Candidate> &candidates, size_t max_links) const {
+    // Heuristic of the HNSW paper: a candidate is kept only if it is closer to the base node
+    // than to every neighbour already kept, which spreads the links over different directions
+    std::vector<Candidate> selected;
+    selected.reserve(max_links);
+    for (const auto &candidate : candidates) {
+        if (selected.size() >= max_links) {
+            break;
+        }
+        bool keep = true;
+        for (const auto &kept : selected) {
+            if (NodeSimilarity(candidate.node, kept.node) > candidate.similarity) {
+                keep = false;
+                break;
+            }
+        }
+        if (keep) {
+            selected.push_back(candidate);
+        }
+    }
+    candidates.swap(selected);
+}
+
+HnswIndex::NodeId HnswIndex::GreedyClosest(const float *query, NodeId entry, int level) const {
+    NodeId current = entry;
+    float best = QuerySimilarity(query, current);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        const NodeId *links = Links(current, level);
+        for (NodeId i = 1; i <= links[0]; ++i) {
+            float similarity = QuerySimilarity(query, links[i]);
+            if (similarity > best) {
+                best = similarity;
+                current = links[i];
+                changed = true;
+            }
+        }
+    }
+    return current;
+}
+
+void HnswIndex::SearchLayer(const float *query, NodeId entry, size_t ef, int level, bool skip_deleted, const TagFilter *filter,
+                            std::vector<Candidate> &result) const {
+    // Nodes that are skipped are still expanded, only the result list is restricted
+    auto reportable = [&](NodeId node) { return (!skip_deleted || !deleted_[node]) && (filter == nullptr || filter->Matches(tags_[node])); };
+    thread_local VisitedList visited;
+    visited.Reset(node_ids_.size());
+
+    std::priority_queue<Candidate, std::vector<Candidate>, CloserFirst> frontier;
+    std::priority_queue<Candidate, std::vector<Candidate>, FartherFirst> top;
+
+    float entry_similarity = QuerySimilarity(query, entry);
+    visited.Visit(entry);
+    frontier.push({entry_similarity, entry});
+    if (reportable(entry)) {
+        top.push({entry_similarity, entry});
+    }
+    float lower_bound = top.empty() ? -std::numeric_limits<float>::max() : top.top().similarity;
+
+    thread_local std::vector<const float *> rows;
+    thread_local std::vector<NodeId> nodes;
+    thread_local std::vector<float> scores;
+    rows.resize(max_links0_);
+    nodes.resize(max_links0_);
+    scores.resize(max_links0_);
+    while (!frontier.empty()) {
+        Candidate current = frontier.top();
+        if (current.similarity < lower_bound && top.size() >= ef) {
+            break;
+        }
+        frontier.pop();
+
+        // Score all unvisited neighbours with one gather call
+        const NodeId *links = Links(current.node, level);
+        size_t count = 0;
+        for (NodeId i = 1; i <= links[0]; ++i) {
+            NodeId neighbor = links[i];
+            if (visited.Visit(neighbor)) {
+                rows[count] = Row(neighbor);
+                nodes[count] = neighbor;
+                ++count;
+            }
+        }
+        simd_dot_gather(query, rows.data(), count, stride_, scores.data());
+
+        for (size_t i = 0; i < count; ++i) {
+            float similarity = scores[i] * inv_norms_[nodes[i]];
+            if (top.size() < ef || similarity > lower_bound) {
+                frontier.push({similarity, nodes[i]});
+                if (reportable(nodes[i])) {
+                    top.push({similarity, nodes[i]});
+                    if (top.size() > ef) {
+                        top.pop();
+                    }
+                }
+                if (!top.empty()) {
+                    lower_bound = top.top().similarity;
+                }
+            }
+        }
+    }
+
+    result.resize(top.size());
+    for (size_t i = result.size(); i > 0; --i) {
+        result[i - 1] = top.top();
+        top.pop();
+    }
+}
+
+void HnswIndex::Search(const float *query, size_t top_k, float threshold, std::vector<IndexSearchHit> &hits) const {
+    SearchGraph(query, top_k, std::max(params_.ef_search, top_k), threshold, nullptr, hits);
+}
+
+void HnswIndex::SearchFiltered(const float *query, size_t top_k, float threshold, const TagFilter &filter,
+                               std::vector<IndexSearchHit> &hits) const {
+    size_t matching = 0;
+    NodeId scanned = 0;
+    for (; scanned < node_ids_.size() && matching <= kFilteredExactScanNodes; ++scanned) {
+        if (!deleted_[scanned] && filter.Matches(tags_[scanned])) {
+            ++matching;
+        }
+    }
+    if (matching <= kFilteredExactScanNodes) {
+        ScanMatching(query, top_k, threshold, filter, hits);
+        return;
+    }
+    // Only a fraction of the visited nodes can be reported, the candidate list grows with the
+    // inverse of the selectivity estimated on the nodes counted above
+    size_t scale = std::min((scanned + matching - 1) / matching, kMaxFilteredEfScale);
+    SearchGraph(query, top_k, std::max(params_.ef_search, top_k) * scale, threshold, &filter, hits);
+}
+
+void HnswIndex::ScanMatching(const float *query, size_t top_k, float threshold, const TagFilter &filter,
+                             std::vector<IndexSearchHit> &hits) const {
+    hits.clear();
+    if (top_k == 0) {
+        return;
+    }
+    thread_local AlignedFloatBuffer normalized;
+    normalized.resize(stride_);
+    NormalizeQuery(query, normalized.data());
+
+    // Matching rows are scored in gather batches of the layer 0 link capacity
+    thread_local std::vector<const float *> rows;
+    thread_local std::vector<NodeId> nodes;
+    thread_local std::vector<float> scores;
+    rows.resize(max_links0_);
+    nodes.resize(max_links0_);
+    scores.resize(max_links0_);
+    size_t count = 0;
+    auto flush = [&]() {
+        simd_dot_gather(normalized.data(), rows.data(), count, stride_, scores.data());
+        for (size_t i = 0; i < count; ++i) {
+            float similarity = scores[i] * inv_norms_[nodes[i]];
+            if (similarity >= threshold) {
+                hits.push_back({node_ids_[nodes[i]], similarity, nodes[i]});
+            }
+        }
+        count = 0;
+    };
+    for (NodeId node = 0; node < node_ids_.size(); ++node) {
+        if (deleted_[node] || !filter.Matches(tags_[node])) {
+            continue;
+        }
+        rows[count] = Row(node);
+        nodes[count] = node;
+        if (++count == max_links0_) {
+            flush();
+        }
+    }
+    flush();
+    size_t keep = std::min(top_k, hits.size());
+    std::partial_sort(hits.begin(), hits.begin() + keep, hits.end(), HitGreater);
+    hits.resize(keep);
+}
+
+void HnswIndex::SearchGraph(const float *query, size_t top_k, size_t ef, float threshold, const TagFilter *filter,
+                            std::vector<IndexSearchHit> &hits) const {
+    hits.clear();
+    if (top_k == 0 || id_to_node_.empty()) {
+        return;
+    }
+
+    thread_local AlignedFloatBuffer normalized;
+    normalized.resize(stride_);
+    NormalizeQuery(query, normalized.data());
+
+    NodeId current = static_cast<NodeId>(entry_point_);
+    for (int l = max_level_; l > 0; --l) {
+        current = GreedyClosest(normalized.data(), current, l);
+    }
+
+    thread_local std::vector<Candidate> candidates;
+    SearchLayer(normalized.data(), current, ef, 0, true, filter, candidates);
+
+    for (const auto &candidate : candidates) {
+        if (hits.size() >= top_k || candidate.similarity < threshold) {
+            break;
+        }
+        hits.push_back({node_ids_[candidate.node], candidate.similarity, candidate.node});
+    }
+}
+
+bool HnswIndex::Update(int64_t id, const float *vector) {
+    uint64_t tags = 0;
+    if (!GetTags(id, tags) || !Remove(id)) {
+        return false;
+    }
+    return Add(id, vector) && SetTags(id, tags);
+}
+
+bool HnswIndex::SetTags(int64_t id, uint64_t tags) {
+    auto it = id_to_node_.find(id);
+    if (it == id_to_node_.end()) {
+        return false;
+    }
+    tags_[it->second] = tags;
+    return true;
+}
+
+bool HnswIndex::GetTags(int64_t id, uint64_t &tags) const {
+    auto it = id_to_node_.find(id);
+    if (it == id_to_node_.end()) {
+        return false;
+    }
+    tags = tags_[it->second];
+    return true;
+}
+
+bool HnswIndex::Remove(int64_t id) {
+    auto it = id_to_node_.find(id);
+    if (it == id_to_node_.end()) {
+        return false;
+    }
+    deleted_[it->second] = 1;
+    ++deleted_count_;
+    id_to_node_.erase(it);
+    if (deleted_count_ >= kMinCompactDeleted && deleted_count_ > id_to_node_.size()) {
+        Compact();
+    }
+    return true;
+}
+
+void HnswIndex::Compact() {
+    std::vector<int64_t> ids;
+    std::vector<uint64_t> tags;
+    AlignedFloatBuffer vectors;
+    ids.reserve(id_to_node_.size());
+    tags.reserve(id_to_node_.size());
+    vectors.reserve(id_to_node_.size() * stride_);
+    for (NodeId node = 0; node < node_ids_.size(); ++node) {
+        if (!deleted_[node]) {
+            ids.push_back(node_ids_[node]);
+            tags.push_back(tags_[node]);
+            vectors.insert(vectors.end(), Row(node), Row(node) + stride_);
+        }
+    }
+    Clear();
+    Reserve(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        Add(ids[i], vectors.data() + i * stride_);
+        tags_[id_to_node_[ids[i]]] = tags[i];
+    }
+}
+
+bool HnswIndex::Get(int64_t id, std::vector<float> &out) const {
+    auto it = id_to_node_.find(id);
+    if (it == id_to_node_.end()) {
+        return false;
+    }
+    const float *row = Row(it->second);
+    out.assign(row, row + dim_);
+    return true;
+}
+
+std::vector<int64_t> HnswIndex::Ids() const {
+    std::vector<int64_t> ids;
+    ids.reserve(id_to_node_.size());
+    for (NodeId node = 0; node < node_ids_.size(); ++node) {
+        if (!deleted_[node]) {
+            ids.push_back(node_ids_[node]);
+        }
+    }
+    return ids;
+}
+
+size_t HnswIndex::MemoryUsage() const {
+    size_t bytes = data_.capacity() * sizeof(float) + inv_norms_.capacity() * sizeof(float) + node_ids_.capacity() * sizeof(int64_t) +
+                   deleted_.capacity() + tags_.capacity() * sizeof(uint64_t) + levels_.capacity() * sizeof(int) +
+                   links0_.capacity() * sizeof(NodeId) + upper_links_.capacity() * sizeof(std::vector<NodeId>) + HashMapMemoryUsage(id_to_node_);
+    for (const auto &links : upper_links_) {
+        bytes += links.capacity() * sizeof(NodeId);
+    }
+    return bytes;
+}
+
+void HnswIndex::SetEfSearch(size_t ef) {
+    params_.ef_search = std::max<size_t>(ef, 1);
+}
+
+void HnswIndex::Reserve(size_t rows) {
+    data_.reserve(rows * stride_);
+    inv_norms_.reserve(rows);
+    node_ids_.reserve(rows);
+    deleted_.reserve(rows);
+    tags_.reserve(rows);
+    levels_.reserve(rows);
+    links0_.reserve(rows * (max_links0_ + 1));
+    upper_links_.reserve(rows);
+    id_to_node_.reserve(rows);
+}
+
+void HnswIndex::Clear() {
+    AlignedFloatBuffer().swap(data_);
+    std::vector<float>().swap(inv_norms_);
+    std::vector<int64_t>().swap(node_ids_);
+    std::vector<uint8_t>().swap(deleted_);
+    std::vector<uint64_t>().swap(tags_);
+    std::vector<int>().swap(levels_);
+    std::vector<NodeId>().swap(links0_);
+    std::vector<std::vector<NodeId>>().swap(upper_links_);
+    id_to_node_.clear();
+    entry_point_ = -1;
+    max_level_ = -1;
+    deleted_count_ = 0;
+}
+
+bool HnswIndex::Save(const std::string &path, uint32_t tag) const {
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        out.write(kHnswMagic, sizeof(kHnswMagic));
+        WritePod(out, kHnswVersion);
+        WritePod(out, tag);
+        WritePod(out, static_cast<uint64_t>(dim_));
+        WritePod(out, static_cast<uint64_t>(params_.m));
+        WritePod(out, static_cast<uint64_t>(node_ids_.size()));
+        WritePod(out, entry_point_);
+        WritePod(out, static_cast<int32_t>(max_level_));
+        for (NodeId node = 0; node < node_ids_.size(); ++node) {
+            WritePod(out, node_ids_[node]);
+            WritePod(out, deleted_[node]);
+            WritePod(out, static_cast<int32_t>(levels_[node]));
+            out.write(reinterpret_cast<const char *>(Row(node)), dim_ * sizeof(float));
+            out.write(reinterpret_cast<const char *>(Links(node, 0)), (max_links0_ + 1) * sizeof(NodeId));
+            out.write(reinterpret_cast<const char *>(upper_links_[node].data()), upper_links_[node].size() * sizeof(NodeId));
+        }
+        if (!out) {
+            out.close();
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+    }
+    // Rename does not overwrite on every platform
+    std::remove(path.c_str());
+    return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+bool HnswIndex::Load(const std::string &path, uint32_t *tag) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    char magic[sizeof(kHnswMagic)];
+    uint32_t version = 0, file_tag = 0;
+    uint64_t dim = 0, m = 0, count = 0;
+    int64_t entry_point = -1;
+    int32_t max_level = -1;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, kHnswMagic, sizeof(magic)) != 0 || !ReadPod(in, version) || version != kHnswVersion ||
+        !ReadPod(in, file_tag) || !ReadPod(in, dim) || !ReadPod(in, m) || !ReadPod(in, count) || !ReadPod(in, entry_point) || !ReadPod(in, max_level)) {
+        return false;
+    }
+    if (dim != dim_ || m != params_.m || count > std::numeric_limits<NodeId>::max() || entry_point >= static_cast<int64_t>(count) ||
+        max_level > kMaxLevel || (count > 0) != (entry_point >= 0)) {
+        return false;
+    }
+
+    Clear();
+    Reserve(count);
+    std::vector<float> vector(dim_);
+    std::vector<NodeId> links(max_links0_ + 1);
+    bool valid = true;
+    for (uint64_t i = 0; i < count && valid; ++i) {
+        int64_t id;
+        uint8_t deleted;
+        int32_t level;
+        if (!ReadPod(in, id) || !ReadPod(in, deleted) || !ReadPod(in, level) || level < 0 || level > max_level ||
+            !in.read(reinterpret_cast<char *>(vector.data()), dim_ * sizeof(float))) {
+            valid = false;
+            break;
+        }
+        NodeId node = AppendNode(id, vector.data(), level);
+        in.read(reinterpret_cast<char *>(Links(node, 0)), (max_links0_ + 1) * sizeof(NodeId));
+        in.read(reinterpret_cast<char *>(upper_links_[node].data()), upper_links_[node].size() * sizeof(NodeId));
+        if (!in) {
+            valid = false;
+            break;
+        }
+        if (deleted) {
+            deleted_[node] = 1;
+            ++deleted_count_;
+        } else if (!id_to_node_.emplace(id, node).second) {
+            valid = false;
+        }
+    }
+    // The search descends from max_level through the links of the entry point, it must have every layer
+    valid = valid && (count == 0 || levels_[entry_point] == max_level);
+
+    // Every link must point at an existing node and respect the per-layer limit
+    for (NodeId node = 0; node < node_ids_.size() && valid; ++node) {
+        for (int l = 0; l <= levels_[node] && valid; ++l) {
+            const NodeId *node_links = Links(node, l);
+            size_t max_links = l == 0 ? max_links0_ : params_.m;
+            valid = node_links[0] <= max_links;
+            for (NodeId i = 1; valid && i <= node_links[0]; ++i) {
+                valid = node_links[i] < count;
+            }
+        }
+    }
+    if (!valid) {
+        Clear();
+        return false;
+    }
+
+    entry_point_ = entry_point;
+    max_level_ = max_level;
+    if (tag != nullptr) {
+        *tag = file_tag;
+    }
+    return true;
+}
+
+}  // namespace inspire
@@ -0,0 +1,156 @@
+#ifndef INSPIRE_HNSW_INDEX_H
+#define INSPIRE_HNSW_INDEX_H
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include "vector_index.h"
+
+namespace inspire {
+
+/** @brief Build and search parameters of the HNSW graph. */
+struct HnswParameters {
+    size_t m = 16;                ///< Max links per node on upper layers, layer 0 keeps 2 * m
+    size_t ef_construction = 200; ///< Candidate list size used while linking a new node
+    size_t ef_search = 64;        ///< Candidate list size used by queries, raised to top_k when smaller
+};
+
+/**
+ * @class HnswIndex
+ * @brief Approximate cosine similarity index based on a Hierarchical Navigable Small World graph.
+ *
+ * Searches visit O(log n) nodes instead of the whole gallery, at the price of an approximate result
+ * whose recall is controlled by ef_search. Removed vectors are only marked as deleted so the graph
+ * stays navigable; the graph is rebuilt from the live vectors once deleted nodes outnumber them.
+ * The node index is reported as the hit row and stays valid until the next modification.
+ */
+class HnswIndex : public VectorIndex {
+public:
+    explicit HnswIndex(size_t dim, const HnswParameters &params = HnswParameters());
+
+    bool Add(int64_t id, const float *vector) override;
+
+    /**
+     * @brief Replaces the vector stored under id, the node is deleted and a new one is linked.
+     */
+    bool Update(int64_t id, const float *vector) override;
+
+    bool Remove(int64_t id) override;
+
+    bool Get(int64_t id, std::vector<float> &out) const override;
+
+    bool Contains(int64_t id) const override {
+        return id_to_node_.find(id) != id_to_node_.end();
+    }
+
+    bool SetTags(int64_t id, uint64_t tags) override;
+
+    bool GetTags(int64_t id, uint64_t &tags) const override;
+
+    void Search(const float *query, size_t top_k, float threshold, std::vector<IndexSearchHit> &hits) const override;
+
+    /**
+     * @brief Graph search that only reports matching nodes, non-matching nodes are still traversed.
+     * @details When few live nodes match, the graph would have to be walked far to find them, so those
+     * are scored exhaustively instead and the result is exact.
+     */
+    void SearchFiltered(const float *query, size_t top_k, float threshold, const TagFilter &filter,
+                        std::vector<IndexSearchHit> &hits) const override;
+
+    void Reserve(size_t rows) override;
+
+    void Clear() override;
+
+    size_t Size() const override {
+        return id_to_node_.size();
+    }
+
+    size_t Dim() const override {
+        return dim_;
+    }
+
+    const float *Row(size_t row) const override {
+        return data_.data() + row * stride_;
+    }
+
+    std::vector<int64_t> Ids() const override;
+
+    size_t MemoryUsage() const override;
+
+    void SetEfSearch(size_t ef);
+
+    size_t GetEfSearch() const {
+        return params_.ef_search;
+    }
+
+    /**
+     * @brief Number of deleted nodes still kept in the graph.
+     */
+    size_t DeletedCount() const {
+        return deleted_count_;
+    }
+
+    /**
+     * @brief Writes the graph and the vectors to path, the file is replaced atomically.
+     * @param tag Opaque value stored in the header, used by the owner to match the file with its data source.
+     */
+    bool Save(const std::string &path, uint32_t tag = 0) const;
+
+    /**
+     * @brief Replaces the content of the index with the graph stored at path.
+     * @param tag Receives the tag given to Save, may be null.
+     * @return false if the file is missing, corrupted, or was built with another dim or m.
+     */
+    bool Load(const std::string &path, uint32_t *tag = nullptr);
+
+private:
+    typedef uint32_t NodeId;
+
+    struct Candidate {
+        float similarity;
+        NodeId node;
+    };
+
+    NodeId AppendNode(int64_t id, const float *vector, int level);
+    void LinkNode(NodeId node);
+    void AddLink(NodeId node, NodeId neighbor, int level);
+    void SelectNeighbors(std::vector<Candidate> &candidates, size_t max_links) const;
+    void SearchLayer(const float *query, NodeId entry, size_t ef, int level, bool skip_deleted, const TagFilter *filter,
+                     std::vector<Candidate> &result) const;
+    void SearchGraph(const float *query, size_t top_k, size_t ef, float threshold, const TagFilter *filter, std::vector<IndexSearchHit> &hits) const;
+    void ScanMatching(const float *query, size_t top_k, float threshold, const TagFilter &filter, std::vector<IndexSearchHit> &hits) const;
+    NodeId GreedyClosest(const float *query, NodeId entry, int level) const;
+    float QuerySimilarity(const float *query, NodeId node) const;
+    float NodeSimilarity(NodeId a, NodeId b) const;
+    void NormalizeQuery(const float *vector, float *out) const;
+    NodeId *Links(NodeId node, int level);
+    const NodeId *Links(NodeId node, int level) const;
+    int RandomLevel();
+    void Compact();
+
+private:
+    size_t dim_;
+    size_t stride_;
+    HnswParameters params_;
+    size_t max_links0_;
+    double level_mult_;
+
+    AlignedFloatBuffer data_;                     ///< Raw vectors, one padded row per node
+    std::vector<float> inv_norms_;                ///< Inverse L2 norm of every node
+    std::vector<int64_t> node_ids_;               ///< Database id of every node
+    std::vector<uint8_t> deleted_;                ///< Tombstones of removed nodes
+    std::vector<uint64_t> tags_;                  ///< Tag bits of every node
+    std::vector<int> levels_;                     ///< Top layer of every node
+    std::vector<NodeId> links0_;                  ///< Layer 0 links, max_links0_ + 1 slots per node, slot 0 is the count
+    std::vector<std::vector<NodeId>> upper_links_;///< Layers 1..level, m + 1 slots per layer
+    std::unordered_map<int64_t, NodeId> id_to_node_;
+
+    int64_t entry_point_;
+    int max_level_;
+    size_t deleted_count_;
+    std::mt19937 rng_;
+};
+
+}  // namespace inspire
+
+#endif  // INSPIRE_HNSW_INDEX_H
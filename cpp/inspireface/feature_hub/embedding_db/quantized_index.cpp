@@ -0,0 +1,438 @@
+#include "quantized_index.h"
+#include "gallery_snapshot.h"
+#include "top_k_collector.h"
+#include "feature_hub/simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace inspire {
+
+namespace {
+
+// Rows scored per kernel call, keeps the score block resident in L1
+const size_t kSearchBlockRows = 1024;
+
+// Largest magnitude of a quantized element, -128 is left out so that |q| fits in int8
+const float kInt8Max = 127.0f;
+
+// Reduced precision scores can underestimate a similarity by a few thousandths, candidates are
+// collected below the requested threshold by this margin so that they still get re-ranked
+const float kRerankMargin = 0.02f;
+
+// Candidates re-ranked at least, whatever the requested top_k
+const size_t kMinRerankCandidates = 16;
+
+inline size_t ElementSize(VectorStorage storage) {
+    return storage == VectorStorage::INT8 ? sizeof(int8_t) : sizeof(uint16_t);
+}
+
+// Normalizes vector into out and returns false for a zero vector
+bool Normalize(const float *vector, size_t dim, float *out) {
+    float norm = std::sqrt(simd_dot(vector, vector, static_cast<long>(dim)));
+    if (norm <= 0.0f) {
+        return false;
+    }
+    float inv_norm = 1.0f / norm;
+    for (size_t i = 0; i < dim; ++i) {
+        out[i] = vector[i] * inv_norm;
+    }
+    return true;
+}
+
+// Symmetric int8 quantization of a normalized vector, returns the dequantization scale
+float QuantizeInt8(const float *vector, size_t dim, int8_t *out) {
+    float max_abs = 0.0f;
+    for (size_t i = 0; i < dim; ++i) {
+        max_abs = std::max(max_abs, std::fabs(vector[i]));
+    }
+    if (max_abs <= 0.0f) {
+        std::fill(out, out + dim, static_cast<int8_t>(0));
+        return 0.0f;
+    }
+    float inv_scale = kInt8Max / max_abs;
+    for (size_t i = 0; i < dim; ++i) {
+        float value = std::max(-kInt8Max, std::min(kInt8Max, std::round(vector[i] * inv_scale)));
+        out[i] = static_cast<int8_t>(value);
+    }
+    return max_abs / kInt8Max;
+}
+
+}  // namespace
+
+QuantizedFlatIndex::QuantizedFlatIndex(size_t dim, VectorStorage storage, size_t rerank_factor)
+: dim_(dim),
+  storage_(storage == VectorStorage::FLOAT16 ? VectorStorage::FLOAT16 : VectorStorage::INT8),
+  rerank_factor_(std::max<size_t>(rerank_factor, 1)),
+  vector_stride_((dim + 15) / 16 * 16) {
+    // Pad every row to whole cache lines so the kernels never need a tail loop
+    size_t elements_per_line = 64 / ElementSize(storage_);
+    stride_ = (dim + elements_per_line - 1) / elements_per_line * elements_per_line;
+    row_bytes_ = stride_ * ElementSize(storage_);
+}
+
+void QuantizedFlatIndex::WriteRow(size_t row, const float *vector) {
+    float *full = vectors_.data() + row * vector_stride_;
+    std::memcpy(full, vector, dim_ * sizeof(float));
+    std::fill(full + dim_, full + vector_stride_, 0.0f);
+    float norm = std::sqrt(simd_dot(vector, vector, static_cast<long>(dim_)));
+    inv_norms_[row] = norm > 0.0f ? 1.0f / norm : 0.0f;
+
+    uint8_t *dst = codes_.data() + row * row_bytes_;
+    std::memset(dst, 0, row_bytes_);
+    thread_local std::vector<float> normalized;
+    normalized.resize(dim_);
+    if (!Normalize(vector, dim_, normalized.data())) {
+        scales_[row] = 0.0f;
+        return;
+    }
+    if (storage_ == VectorStorage::INT8) {
+        scales_[row] = QuantizeInt8(normalized.data(), dim_, reinterpret_cast<int8_t *>(dst));
+    } else {
+        uint16_t *halves = reinterpret_cast<uint16_t *>(dst);
+        for (size_t i = 0; i < dim_; ++i) {
+            halves[i] = simd_float_to_half(normalized[i]);
+        }
+        scales_[row] = 1.0f;
+    }
+}
+
+bool QuantizedFlatIndex::Add(int64_t id, const float *vector) {
+    if (Contains(id)) {
+        return false;
+    }
+    Detach();
+    size_t row = ids_.size();
+    codes_.resize((row + 1) * row_bytes_);
+    scales_.resize(row + 1);
+    vectors_.resize((row + 1) * vector_stride_);
+    inv_norms_.resize(row + 1);
+    ids_.push_back(id);
+    if (!tags_.empty()) {
+        tags_.push_back(0);
+    }
+    id_to_row_[id] = row;
+    WriteRow(row, vector);
+    return true;
+}
+
+bool QuantizedFlatIndex::Update(int64_t id, const float *vector) {
+    if (!Contains(id)) {
+        return false;
+    }
+    Detach();
+    auto it = id_to_row_.find(id);
+    if (it == id_to_row_.end()) {
+        return false;
+    }
+    WriteRow(it->second, vector);
+    return true;
+}
+
+bool QuantizedFlatIndex::Remove(int64_t id) {
+    if (!Contains(id)) {
+        return false;
+    }
+    Detach();
+    auto it = id_to_row_.find(id);
+    if (it == id_to_row_.end()) {
+        return false;
+    }
+    size_t row = it->second;
+    size_t last = ids_.size() - 1;
+    if (row != last) {
+        std::memcpy(codes_.data() + row * row_bytes_, codes_.data() + last * row_bytes_, row_bytes_);
+        scales_[row] = scales_[last];
+        std::memcpy(vectors_.data() + row * vector_stride_, vectors_.data() + last * vector_stride_, vector_stride_ * sizeof(float));
+        inv_norms_[row] = inv_norms_[last];
+        ids_[row] = ids_[last];
+        if (!tags_.empty()) {
+            tags_[row] = tags_[last];
+        }
+        id_to_row_[ids_[row]] = row;
+    }
+    id_to_row_.erase(it);
+    ids_.pop_back();
+    if (!tags_.empty()) {
+        tags_.pop_back();
+    }
+    scales_.pop_back();
+    codes_.resize(last * row_bytes_);
+    inv_norms_.pop_back();
+    vectors_.resize(last * vector_stride_);
+    return true;
+}
+
+bool QuantizedFlatIndex::Get(int64_t id, std::vector<float> &out) const {
+    size_t row = 0;
+    if (!FindRow(id, row)) {
+        return false;
+    }
+    const float *vector = Row(row);
+    out.assign(vector, vector + dim_);
+    return true;
+}
+
+void QuantizedFlatIndex::Search(const float *query, size_t top_k, float threshold, std::vector<IndexSearchHit> &hits) const {
+    SearchRows(query, top_k, threshold, nullptr, hits);
+}
+
+void QuantizedFlatIndex::SearchFiltered(const float *query, size_t top_k, float threshold, const TagFilter &filter,
+                                        std::vector<IndexSearchHit> &hits) const {
+    SearchRows(query, top_k, threshold, &filter, hits);
+}
+
+void QuantizedFlatIndex::SearchRows(const float *query, size_t top_k, float threshold, const TagFilter *filter,
+                                    std::vector<IndexSearchHit> &hits) const {
+    hits.clear();
+    if (top_k == 0) {
+        return;
+    }
+    // First pass over the reduced precision matrix, then exact scores for the short list
+    size_t candidates = std::max(top_k * rerank_factor_, top_k + kMinRerankCandidates);
+    ScanRows(query, candidates, threshold - kRerankMargin, filter, hits);
+    RerankRows(query, top_k, threshold, hits);
+}
+
+void QuantizedFlatIndex::RerankRows(const float *query, size_t top_k, float threshold, std::vector<IndexSearchHit> &hits) const {
+    if (hits.empty()) {
+        return;
+    }
+    float query_norm = std::sqrt(simd_dot(query, query, static_cast<long>(dim_)));
+    if (query_norm <= 0.0f) {
+        hits.clear();
+        return;
+    }
+    float inv_query_norm = 1.0f / query_norm;
+    const float *inv_norms = InvNorms();
+    size_t kept = 0;
+    for (const auto &hit : hits) {
+        float similarity = simd_dot(query, Row(hit.row), static_cast<long>(dim_)) * inv_norms[hit.row] * inv_query_norm;
+        if (inv_norms[hit.row] > 0.0f && similarity >= threshold) {
+            hits[kept] = hit;
+            hits[kept].similarity = similarity;
+            ++kept;
+        }
+    }
+    hits.resize(kept);
+
+    size_t keep = std::min(top_k, hits.size());
+    std::partial_sort(hits.begin(), hits.begin() + keep, hits.end(), HitGreater);
+    hits.resize(keep);
+}
+
+void QuantizedFlatIndex::ScanRows(const float *query, size_t top_k, float threshold, const TagFilter *filter,
+                                  std::vector<IndexSearchHit> &hits) const {
+    hits.clear();
+    if (filter != nullptr && tags_.empty()) {
+        // No vector has tags yet, the filter selects all of them or none
+        if (!filter->Matches(0)) {
+            return;
+        }
+        filter = nullptr;
+    }
+    if (top_k == 0 || Size() == 0) {
+        return;
+    }
+    // The query is normalized and padded once, then encoded like the rows
+    thread_local AlignedFloatBuffer padded_query;
+    thread_local std::vector<float> scores;
+    padded_query.assign(stride_, 0.0f);
+    if (!Normalize(query, dim_, padded_query.data())) {
+        return;
+    }
+    scores.resize(kSearchBlockRows);
+
+    TopKCollector collector(top_k, threshold, &hits);
+    const size_t total = Size();
+    if (storage_ == VectorStorage::INT8) {
+        thread_local std::vector<int8_t, AlignedAllocator<int8_t, 64>> quantized_query;
+        thread_local std::vector<int32_t> int_scores;
+        quantized_query.assign(stride_, 0);
+        int_scores.resize(kSearchBlockRows);
+        float query_scale = QuantizeInt8(padded_query.data(), dim_, quantized_query.data());
+        const int8_t *matrix = reinterpret_cast<const int8_t *>(Codes());
+        for (size_t begin = 0; begin < total; begin += kSearchBlockRows) {
+            size_t count = std::min(kSearchBlockRows, total - begin);
+            auto score_rows = [&](size_t first, size_t n, float *out) {
+                simd_dot_rows_s8(quantized_query.data(), matrix + (begin + first) * stride_, n, stride_, stride_, int_scores.data());
+                for (size_t j = 0; j < n; ++j) {
+                    out[j] = static_cast<float>(int_scores[j]);
+                }
+            };
+            if (filter == nullptr) {
+                score_rows(0, count, scores.data());
+            } else if (!ScoreMatchingRows(tags_.data() + begin, count, *filter, scores.data(), score_rows)) {
+                continue;
+            }
+            collector.Collect(scores.data(), count, begin, query_scale, Scales(), RowIds());
+        }
+    } else {
+        const uint16_t *matrix = reinterpret_cast<const uint16_t *>(Codes());
+        for (size_t begin = 0; begin < total; begin += kSearchBlockRows) {
+            size_t count = std::min(kSearchBlockRows, total - begin);
+            if (filter == nullptr) {
+                simd_dot_rows_f16(padded_query.data(), matrix + begin * stride_, count, stride_, stride_, scores.data());
+            } else if (!ScoreMatchingRows(tags_.data() + begin, count, *filter, scores.data(), [&](size_t first, size_t n, float *out) {
+                           simd_dot_rows_f16(padded_query.data(), matrix + (begin + first) * stride_, n, stride_, stride_, out);
+                       })) {
+                continue;
+            }
+            collector.Collect(scores.data(), count, begin, 1.0f, Scales(), RowIds());
+        }
+    }
+    collector.Finish();
+}
+
+void QuantizedFlatIndex::Reserve(size_t rows) {
+    Detach();
+    codes_.reserve(rows * row_bytes_);
+    scales_.reserve(rows);
+    vectors_.reserve(rows * vector_stride_);
+    inv_norms_.reserve(rows);
+    ids_.reserve(rows);
+    if (!tags_.empty()) {
+        tags_.reserve(rows);
+    }
+    id_to_row_.reserve(rows);
+}
+
+void QuantizedFlatIndex::Clear() {
+    snapshot_.reset();
+    vectors_snapshot_.reset();
+    AlignedByteBuffer().swap(codes_);
+    std::vector<float>().swap(scales_);
+    AlignedFloatBuffer().swap(vectors_);
+    std::vector<float>().swap(inv_norms_);
+    std::vector<int64_t>().swap(ids_);
+    std::vector<uint64_t>().swap(tags_);
+    id_to_row_.clear();
+}
+
+size_t QuantizedFlatIndex::MemoryUsage() const {
+    return codes_.capacity() + scales_.capacity() * sizeof(float) + vectors_.capacity() * sizeof(float) + inv_norms_.capacity() * sizeof(float) +
+           ids_.capacity() * sizeof(int64_t) + tags_.capacity() * sizeof(uint64_t) + HashMapMemoryUsage(id_to_row_);
+}
+
+bool QuantizedFlatIndex::Contains(int64_t id) const {
+    size_t row = 0;
+    return FindRow(id, row);
+}
+
+size_t QuantizedFlatIndex::Size() const {
+    return snapshot_ ? snapshot_->Count() : ids_.size();
+}
+
+std::vector<int64_t> QuantizedFlatIndex::Ids() const {
+    return std::vector<int64_t>(RowIds(), RowIds() + Size());
+}
+
+bool QuantizedFlatIndex::SetTags(int64_t id, uint64_t tags) {
+    size_t row = 0;
+    if (!FindRow(id, row)) {
+        return false;
+    }
+    if (tags_.empty()) {
+        if (tags == 0) {
+            return true;
+        }
+        tags_.assign(Size(), 0);
+    }
+    tags_[row] = tags;
+    return true;
+}
+
+bool QuantizedFlatIndex::GetTags(int64_t id, uint64_t &tags) const {
+    size_t row = 0;
+    if (!FindRow(id, row)) {
+        return false;
+    }
+    tags = tags_.empty() ? 0 : tags_[row];
+    return true;
+}
+
+bool QuantizedFlatIndex::FindRow(int64_t id, size_t &row) const {
+    if (snapshot_) {
+        return snapshot_->FindRow(id, row);
+    }
+    auto it = id_to_row_.find(id);
+    if (it == id_to_row_.end()) {
+        return false;
+    }
+    row = it->second;
+    return true;
+}
+
+const uint8_t *QuantizedFlatIndex::Codes() const {
+    return snapshot_ ? snapshot_->Matrix() : codes_.data();
+}
+
+const float *QuantizedFlatIndex::Scales() const {
+    return snapshot_ ? snapshot_->Factors() : scales_.data();
+}
+
+const int64_t *QuantizedFlatIndex::RowIds() const {
+    return snapshot_ ? snapshot_->Ids() : ids_.data();
+}
+
+const float *QuantizedFlatIndex::Vectors() const {
+    return vectors_snapshot_ ? reinterpret_cast<const float *>(vectors_snapshot_->Matrix()) : vectors_.data();
+}
+
+const float *QuantizedFlatIndex::InvNorms() const {
+    return vectors_snapshot_ ? vectors_snapshot_->Factors() : inv_norms_.data();
+}
+
+std::string QuantizedFlatIndex::VectorsPath(const std::string &path) {
+    return path + ".f32";
+}
+
+bool QuantizedFlatIndex::Save(const std::string &path, uint32_t tag) const {
+    GallerySnapshot::Layout layout = {storage_, dim_, stride_, row_bytes_};
+    GallerySnapshot::Layout vectors_layout = {VectorStorage::FLOAT32, dim_, vector_stride_, vector_stride_ * sizeof(float)};
+    return GallerySnapshot::Save(VectorsPath(path), tag, vectors_layout, Size(), RowIds(), InvNorms(), Vectors()) &&
+           GallerySnapshot::Save(path, tag, layout, Size(), RowIds(), Scales(), Codes());
+}
+
+bool QuantizedFlatIndex::Map(const std::string &path, uint32_t *tag) {
+    auto snapshot = GallerySnapshot::Map(path);
+    GallerySnapshot::Layout layout = {storage_, dim_, stride_, row_bytes_};
+    if (!snapshot || !(snapshot->GetLayout() == layout)) {
+        return false;
+    }
+    // Both files come from the same Save(), the vectors are read through the rows of the codes
+    auto vectors_snapshot = GallerySnapshot::Map(VectorsPath(path));
+    GallerySnapshot::Layout vectors_layout = {VectorStorage::FLOAT32, dim_, vector_stride_, vector_stride_ * sizeof(float)};
+    if (!vectors_snapshot || !(vectors_snapshot->GetLayout() == vectors_layout) || vectors_snapshot->Count() != snapshot->Count() ||
+        vectors_snapshot->Tag() != snapshot->Tag()) {
+        return false;
+    }
+    Clear();
+    snapshot_ = snapshot;
+    vectors_snapshot_ = vectors_snapshot;
+    if (tag != nullptr) {
+        *tag = snapshot_->Tag();
+    }
+    return true;
+}
+
+void QuantizedFlatIndex::Detach() {
+    if (!snapshot_) {
+        return;
+    }
+    const size_t count = snapshot_->Count();
+    codes_.assign(Codes(), Codes() + count * row_bytes_);
+    scales_.assign(Scales(), Scales() + count);
+    vectors_.assign(Vectors(), Vectors() + count * vector_stride_);
+    inv_norms_.assign(InvNorms(), InvNorms() + count);
+    ids_.assign(RowIds(), RowIds() + count);
+    id_to_row_.clear();
+    id_to_row_.reserve(count);
+    for (size_t row = 0; row < count; ++row) {
+        id_to_row_[ids_[row]] = row;
+    }
+    snapshot_.reset();
+    vectors_snapshot_.reset();
+}
+
+}  // namespace inspire
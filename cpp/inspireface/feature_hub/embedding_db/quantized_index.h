@@ -0,0 +1,151 @@
+#ifndef INSPIRE_QUANTIZED_INDEX_H
+#define INSPIRE_QUANTIZED_INDEX_H
+
+#include <string>
+#include <unordered_map>
+#include "vector_index.h"
+
+namespace inspire {
+
+/** @brief Precision of the vectors kept in memory by the brute-force index. */
+enum class VectorStorage {
+    FLOAT32 = 0,  ///< Vectors kept as inserted
+    FLOAT16,      ///< Normalized vectors in IEEE 754 half precision, 2 bytes per element
+    INT8,         ///< Normalized vectors in int8 with one scale per vector, 1 byte per element
+};
+
+class GallerySnapshot;
+
+/**
+ * @class QuantizedFlatIndex
+ * @brief Brute-force cosine similarity index over a reduced precision copy of the vectors.
+ *
+ * Vectors are normalized on insertion and stored either as fp16 or as int8 with a per-vector
+ * scale, which cuts the bandwidth of the scan by 2x or 4x and lets the int8 scan run on integer
+ * dot-product instructions. The vectors are also kept as inserted in a contiguous float matrix:
+ * a search over-fetches candidates from the codes and re-ranks them against that matrix, so the
+ * reported similarities are exact and Row() returns the inserted vectors. Like FlatIndex, the rows
+ * can be served from mapped GallerySnapshots until the first modification.
+ */
+class QuantizedFlatIndex : public VectorIndex {
+public:
+    /**
+     * @param storage VectorStorage::FLOAT16 or VectorStorage::INT8.
+     * @param rerank_factor Candidates re-ranked at full precision per requested result.
+     */
+    QuantizedFlatIndex(size_t dim, VectorStorage storage, size_t rerank_factor = 4);
+
+    bool Add(int64_t id, const float *vector) override;
+
+    bool Update(int64_t id, const float *vector) override;
+
+    /**
+     * @brief Removes the vector stored under id, the last row is moved into the freed slot.
+     */
+    bool Remove(int64_t id) override;
+
+    bool Get(int64_t id, std::vector<float> &out) const override;
+
+    bool Contains(int64_t id) const override;
+
+    bool SetTags(int64_t id, uint64_t tags) override;
+
+    bool GetTags(int64_t id, uint64_t &tags) const override;
+
+    /**
+     * @brief Scans the codes for candidates, then keeps the top_k by their exact similarity.
+     */
+    void Search(const float *query, size_t top_k, float threshold, std::vector<IndexSearchHit> &hits) const override;
+
+    void SearchFiltered(const float *query, size_t top_k, float threshold, const TagFilter &filter,
+                        std::vector<IndexSearchHit> &hits) const override;
+
+    void Reserve(size_t rows) override;
+
+    void Clear() override;
+
+    size_t Size() const override;
+
+    size_t Dim() const override {
+        return dim_;
+    }
+
+    const float *Row(size_t row) const override {
+        return Vectors() + row * vector_stride_;
+    }
+
+    std::vector<int64_t> Ids() const override;
+
+    /**
+     * @brief Heap memory only, the pages of a mapped snapshot are not counted.
+     */
+    size_t MemoryUsage() const override;
+
+    VectorStorage Storage() const {
+        return storage_;
+    }
+
+    /**
+     * @brief Writes the quantized rows to a snapshot file that Map() can serve without loading it.
+     * @details The full precision vectors go to a second snapshot at VectorsPath(path).
+     */
+    bool Save(const std::string &path, uint32_t tag) const;
+
+    /**
+     * @brief Replaces the content with the snapshots at path, fails if they were saved with another dimension or storage.
+     * @param tag Receives the tag the snapshots were saved with.
+     */
+    bool Map(const std::string &path, uint32_t *tag);
+
+    /**
+     * @brief Path of the snapshot holding the full precision vectors of the snapshot at path.
+     */
+    static std::string VectorsPath(const std::string &path);
+
+private:
+    void WriteRow(size_t row, const float *vector);
+
+    void SearchRows(const float *query, size_t top_k, float threshold, const TagFilter *filter, std::vector<IndexSearchHit> &hits) const;
+
+    void ScanRows(const float *query, size_t top_k, float threshold, const TagFilter *filter, std::vector<IndexSearchHit> &hits) const;
+
+    void RerankRows(const float *query, size_t top_k, float threshold, std::vector<IndexSearchHit> &hits) const;
+
+    // Copies a mapped snapshot to the heap before a modification
+    void Detach();
+
+    bool FindRow(int64_t id, size_t &row) const;
+
+    const uint8_t *Codes() const;
+
+    const float *Scales() const;
+
+    const int64_t *RowIds() const;
+
+    const float *Vectors() const;
+
+    const float *InvNorms() const;
+
+private:
+    typedef std::vector<uint8_t, AlignedAllocator<uint8_t, 64>> AlignedByteBuffer;
+
+    size_t dim_;
+    VectorStorage storage_;
+    size_t stride_;         ///< Elements per padded row
+    size_t row_bytes_;      ///< Bytes per padded row, a multiple of 64
+    size_t rerank_factor_;  ///< Candidates re-ranked per requested result
+    size_t vector_stride_;  ///< Floats per padded row of vectors_
+    AlignedByteBuffer codes_;
+    std::vector<float> scales_;     ///< Dequantization scale of every row, 0 for zero vectors
+    AlignedFloatBuffer vectors_;    ///< Vectors as inserted, in the rows of the codes
+    std::vector<float> inv_norms_;  ///< Inverse norm of every row of vectors_, 0 for zero vectors
+    std::vector<int64_t> ids_;
+    std::unordered_map<int64_t, size_t> id_to_row_;
+    std::vector<uint64_t> tags_;                               ///< Tags of every row once one is set, empty while no row has tags
+    std::shared_ptr<const GallerySnapshot> snapshot_;          ///< Rows served in place of the heap buffers when set
+    std::shared_ptr<const GallerySnapshot> vectors_snapshot_;  ///< Vectors served in place of vectors_, set with snapshot_
+};
+
+}  // namespace inspire
+
+#endif  // INSPIRE_QUANTIZED_INDEX_H
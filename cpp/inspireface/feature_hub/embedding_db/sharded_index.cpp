@@ -0,0 +1,124 @@
+#include "sharded_index.h"
+#include "top_k_collector.h"
+#include "isf_check.h"
+#include <algorithm>
+
+namespace inspire {
+
+ShardedIndex::ShardedIndex(std::vector<std::unique_ptr<VectorIndex>> shards, parallel::ThreadPool *pool) : shards_(std::move(shards)), pool_(pool) {
+    INSPIREFACE_CHECK_MSG(!shards_.empty(), "A sharded index needs at least one shard");
+}
+
+bool ShardedIndex::Add(int64_t id, const float *vector) {
+    return shards_[ShardOf(id)]->Add(id, vector);
+}
+
+bool ShardedIndex::Update(int64_t id, const float *vector) {
+    return shards_[ShardOf(id)]->Update(id, vector);
+}
+
+bool ShardedIndex::Remove(int64_t id) {
+    return shards_[ShardOf(id)]->Remove(id);
+}
+
+bool ShardedIndex::Get(int64_t id, std::vector<float> &out) const {
+    return shards_[ShardOf(id)]->Get(id, out);
+}
+
+bool ShardedIndex::Contains(int64_t id) const {
+    return shards_[ShardOf(id)]->Contains(id);
+}
+
+bool ShardedIndex::SetTags(int64_t id, uint64_t tags) {
+    return shards_[ShardOf(id)]->SetTags(id, tags);
+}
+
+bool ShardedIndex::GetTags(int64_t id, uint64_t &tags) const {
+    return shards_[ShardOf(id)]->GetTags(id, tags);
+}
+
+void ShardedIndex::Search(const float *query, size_t top_k, float threshold, std::vector<IndexSearchHit> &hits) const {
+    // Filled by the pool threads, they must write to the buffers of the calling thread
+    thread_local std::vector<std::vector<IndexSearchHit>> shard_hits_buffer;
+    auto &shard_hits = shard_hits_buffer;
+    shard_hits.resize(shards_.size());
+    pool_->ParallelFor(shards_.size(), [&](size_t shard) { shards_[shard]->Search(query, top_k, threshold, shard_hits[shard]); });
+    MergeHits(shard_hits, top_k, hits);
+}
+
+void ShardedIndex::SearchFiltered(const float *query, size_t top_k, float threshold, const TagFilter &filter,
+                                  std::vector<IndexSearchHit> &hits) const {
+    thread_local std::vector<std::vector<IndexSearchHit>> shard_hits_buffer;
+    auto &shard_hits = shard_hits_buffer;
+    shard_hits.resize(shards_.size());
+    pool_->ParallelFor(shards_.size(), [&](size_t shard) { shards_[shard]->SearchFiltered(query, top_k, threshold, filter, shard_hits[shard]); });
+    MergeHits(shard_hits, top_k, hits);
+}
+
+void ShardedIndex::SearchBatch(const float *queries, size_t num_queries, size_t top_k, float threshold,
+                               std::vector<std::vector<IndexSearchHit>> &hits) const {
+    std::vector<std::vector<std::vector<IndexSearchHit>>> shard_hits(shards_.size());
+    pool_->ParallelFor(shards_.size(),
+                       [&](size_t shard) { shards_[shard]->SearchBatch(queries, num_queries, top_k, threshold, shard_hits[shard]); });
+    hits.resize(num_queries);
+    std::vector<std::vector<IndexSearchHit>> query_hits(shards_.size());
+    for (size_t q = 0; q < num_queries; ++q) {
+        for (size_t shard = 0; shard < shards_.size(); ++shard) {
+            query_hits[shard].swap(shard_hits[shard][q]);
+        }
+        MergeHits(query_hits, top_k, hits[q]);
+    }
+}
+
+void ShardedIndex::MergeHits(const std::vector<std::vector<IndexSearchHit>> &shard_hits, size_t top_k, std::vector<IndexSearchHit> &hits) const {
+    hits.clear();
+    for (size_t shard = 0; shard < shard_hits.size(); ++shard) {
+        for (const auto &hit : shard_hits[shard]) {
+            hits.push_back({hit.id, hit.similarity, hit.row * shards_.size() + shard});
+        }
+    }
+    size_t keep = std::min(top_k, hits.size());
+    std::partial_sort(hits.begin(), hits.begin() + keep, hits.end(), HitGreater);
+    hits.resize(keep);
+}
+
+void ShardedIndex::Reserve(size_t rows) {
+    size_t per_shard = (rows + shards_.size() - 1) / shards_.size();
+    for (auto &shard : shards_) {
+        shard->Reserve(std::max(per_shard, shard->Size()));
+    }
+}
+
+void ShardedIndex::Clear() {
+    for (auto &shard : shards_) {
+        shard->Clear();
+    }
+}
+
+size_t ShardedIndex::Size() const {
+    size_t size = 0;
+    for (const auto &shard : shards_) {
+        size += shard->Size();
+    }
+    return size;
+}
+
+std::vector<int64_t> ShardedIndex::Ids() const {
+    std::vector<int64_t> ids;
+    ids.reserve(Size());
+    for (const auto &shard : shards_) {
+        auto shard_ids = shard->Ids();
+        ids.insert(ids.end(), shard_ids.begin(), shard_ids.end());
+    }
+    return ids;
+}
+
+size_t ShardedIndex::MemoryUsage() const {
+    size_t usage = shards_.capacity() * sizeof(std::unique_ptr<VectorIndex>);
+    for (const auto &shard : shards_) {
+        usage += shard->MemoryUsage();
+    }
+    return usage;
+}
+
+}  // namespace inspire
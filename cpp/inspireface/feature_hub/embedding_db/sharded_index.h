@@ -0,0 +1,97 @@
+#ifndef INSPIRE_SHARDED_INDEX_H
+#define INSPIRE_SHARDED_INDEX_H
+
+#include "vector_index.h"
+#include "middleware/thread/thread_pool.h"
+
+namespace inspire {
+
+/**
+ * @class ShardedIndex
+ * @brief Splits a gallery over several indexes of the same kind and searches them in parallel.
+ *
+ * Every id lives in the shard id % shard count. A search runs on all shards at once through the
+ * thread pool and their hits are merged into one top-k list. The row of a merged hit encodes its
+ * shard (row * shard count + shard), Row() decodes it so callers see a single index.
+ */
+class ShardedIndex : public VectorIndex {
+public:
+    /**
+     * @param shards At least one empty index, all of the same dimension.
+     * @param pool Runs the per-shard searches, it must outlive the index and its clones.
+     */
+    ShardedIndex(std::vector<std::unique_ptr<VectorIndex>> shards, parallel::ThreadPool *pool);
+
+    bool Add(int64_t id, const float *vector) override;
+
+    bool Update(int64_t id, const float *vector) override;
+
+    bool Remove(int64_t id) override;
+
+    bool Get(int64_t id, std::vector<float> &out) const override;
+
+    bool Contains(int64_t id) const override;
+
+    bool SetTags(int64_t id, uint64_t tags) override;
+
+    bool GetTags(int64_t id, uint64_t &tags) const override;
+
+    void Search(const float *query, size_t top_k, float threshold, std::vector<IndexSearchHit> &hits) const override;
+
+    void SearchFiltered(const float *query, size_t top_k, float threshold, const TagFilter &filter,
+                        std::vector<IndexSearchHit> &hits) const override;
+
+    /**
+     * @brief Each shard runs the whole batch with its own SearchBatch, then the hits are merged per query.
+     */
+    void SearchBatch(const float *queries, size_t num_queries, size_t top_k, float threshold,
+                     std::vector<std::vector<IndexSearchHit>> &hits) const override;
+
+    /**
+     * @brief Spreads rows evenly over the shards.
+     */
+    void Reserve(size_t rows) override;
+
+    void Clear() override;
+
+    size_t Size() const override;
+
+    size_t Dim() const override {
+        return shards_.front()->Dim();
+    }
+
+    const float *Row(size_t row) const override {
+        return shards_[row % shards_.size()]->Row(row / shards_.size());
+    }
+
+    std::vector<int64_t> Ids() const override;
+
+    size_t MemoryUsage() const override;
+
+    size_t ShardCount() const {
+        return shards_.size();
+    }
+
+    VectorIndex &Shard(size_t shard) {
+        return *shards_[shard];
+    }
+
+    const VectorIndex &Shard(size_t shard) const {
+        return *shards_[shard];
+    }
+
+    size_t ShardOf(int64_t id) const {
+        return static_cast<size_t>(static_cast<uint64_t>(id) % shards_.size());
+    }
+
+private:
+    // Merges the sorted hits of every shard into the top_k best, encoding the shard in the rows
+    void MergeHits(const std::vector<std::vector<IndexSearchHit>> &shard_hits, size_t top_k, std::vector<IndexSearchHit> &hits) const;
+
+    std::vector<std::unique_ptr<VectorIndex>> shards_;
+    parallel::ThreadPool *pool_;
+};
+
+}  // namespace inspire
+
+#endif  // INSPIRE_SHARDED_INDEX_H
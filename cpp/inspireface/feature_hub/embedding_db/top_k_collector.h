@@ -0,0 +1,93 @@
+#ifndef INSPIRE_TOP_K_COLLECTOR_H
+#define INSPIRE_TOP_K_COLLECTOR_H
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include "vector_index.h"
+
+namespace inspire {
+
+inline bool HitGreater(const IndexSearchHit &a, const IndexSearchHit &b) {
+    return a.similarity > b.similarity;
+}
+
+/**
+ * @class TopKCollector
+ * @brief Collects the scored rows of one query for the brute-force indexes and keeps the candidate list bounded.
+ */
+class TopKCollector {
+public:
+    TopKCollector(size_t top_k, float threshold, std::vector<IndexSearchHit> *hits)
+    : top_k_(top_k), prune_limit_(std::max<size_t>(top_k * 4, 256)), bar_(threshold), hits_(hits) {}
+
+    /**
+     * @brief Adds a block of raw scores, the similarity of a row is score * row_scales[row] * query_scale.
+     * @param begin Row of the first score in the block.
+     */
+    void Collect(const float *scores, size_t count, size_t begin, float query_scale, const float *row_scales, const int64_t *ids) {
+        for (size_t j = 0; j < count; ++j) {
+            float similarity = scores[j] * row_scales[begin + j] * query_scale;
+            if (similarity >= bar_) {
+                hits_->push_back({ids[begin + j], similarity, begin + j});
+            }
+        }
+        if (hits_->size() >= prune_limit_) {
+            // Keep only the current top_k and raise the bar to the k-th score
+            std::nth_element(hits_->begin(), hits_->begin() + (top_k_ - 1), hits_->end(), HitGreater);
+            hits_->resize(top_k_);
+            bar_ = std::max(bar_, (*hits_)[top_k_ - 1].similarity);
+        }
+    }
+
+    /**
+     * @brief Sorts the hits by descending similarity and keeps the top_k.
+     */
+    void Finish() {
+        size_t keep = std::min(top_k_, hits_->size());
+        std::partial_sort(hits_->begin(), hits_->begin() + keep, hits_->end(), HitGreater);
+        hits_->resize(keep);
+    }
+
+private:
+    size_t top_k_;
+    size_t prune_limit_;
+    float bar_;
+    std::vector<IndexSearchHit> *hits_;
+};
+
+/**
+ * @brief Scores the rows of a block whose tags match filter, for the filtered brute-force scans.
+ * @details Consecutive matching rows are scored with a single call so that clustered tags keep the
+ * streaming kernels, the other rows get a score of -infinity and are dropped by the collector.
+ * @param tags Tags of the count rows of the block.
+ * @param score_rows Callable (first, n, out) writing the scores of the n rows starting at block offset first to out.
+ * @return false when no row of the block matches and scores were not touched.
+ */
+template <typename ScoreRows>
+inline bool ScoreMatchingRows(const uint64_t *tags, size_t count, const TagFilter &filter, float *scores, ScoreRows &&score_rows) {
+    size_t first = 0;
+    while (first < count && !filter.Matches(tags[first])) {
+        ++first;
+    }
+    if (first == count) {
+        return false;
+    }
+    std::fill(scores, scores + first, -std::numeric_limits<float>::infinity());
+    while (first < count) {
+        size_t end = first + 1;
+        while (end < count && filter.Matches(tags[end])) {
+            ++end;
+        }
+        score_rows(first, end - first, scores + first);
+        first = end;
+        while (first < count && !filter.Matches(tags[first])) {
+            scores[first++] = -std::numeric_limits<float>::infinity();
+        }
+    }
+    return true;
+}
+
+}  // namespace inspire
+
+#endif  // INSPIRE_TOP_K_COLLECTOR_H
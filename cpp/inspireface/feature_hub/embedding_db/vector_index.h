@@ -0,0 +1,205 @@
+#ifndef INSPIRE_VECTOR_INDEX_H
+#define INSPIRE_VECTOR_INDEX_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace inspire {
+
+/**
+ * @brief Minimal allocator that returns memory aligned to Alignment bytes,
+ * so that every row of the index starts on a cache line.
+ */
+template <typename T, size_t Alignment = 64>
+class AlignedAllocator {
+public:
+    typedef T value_type;
+
+    template <typename U>
+    struct rebind {
+        typedef AlignedAllocator<U, Alignment> other;
+    };
+
+    AlignedAllocator() noexcept = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {}
+
+    T *allocate(size_t n) {
+        if (n == 0) {
+            return nullptr;
+        }
+        void *ptr = nullptr;
+#if defined(_WIN32)
+        ptr = _aligned_malloc(n * sizeof(T), Alignment);
+#else
+        if (posix_memalign(&ptr, Alignment, n * sizeof(T)) != 0) {
+            ptr = nullptr;
+        }
+#endif
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>(ptr);
+    }
+
+    void deallocate(T *ptr, size_t) noexcept {
+#if defined(_WIN32)
+        _aligned_free(ptr);
+#else
+        free(ptr);
+#endif
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment> &) const noexcept {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment> &) const noexcept {
+        return false;
+    }
+};
+
+/** @brief Float buffer whose data pointer is 64-byte aligned. */
+typedef std::vector<float, AlignedAllocator<float, 64>> AlignedFloatBuffer;
+
+/** @brief A single search hit returned by the vector indexes. */
+struct IndexSearchHit {
+    int64_t id;        ///< Id of the stored vector
+    float similarity;  ///< Cosine similarity to the query
+    size_t row;        ///< Row of the vector inside the index
+};
+
+/**
+ * @brief Predicate on the 64 tag bits stored with every vector.
+ * @details A vector matches when it has every bit of all_of, at least one bit of any_of unless any_of
+ * is 0, and no bit of none_of. The default filter matches every vector.
+ */
+struct TagFilter {
+    uint64_t all_of = 0;
+    uint64_t any_of = 0;
+    uint64_t none_of = 0;
+
+    bool Matches(uint64_t tags) const {
+        return (tags & all_of) == all_of && (any_of == 0 || (tags & any_of) != 0) && (tags & none_of) == 0;
+    }
+};
+
+/**
+ * @class VectorIndex
+ * @brief Interface shared by the in-memory indexes that serve EmbeddingDB searches.
+ *
+ * Vectors are addressed by their database id; the row reported in a search hit can be passed to Row()
+ * to read the stored vector back without another lookup.
+ * Const methods may run concurrently with each other, modifications need exclusive access and the owner is
+ * responsible for the locking.
+ */
+class VectorIndex {
+public:
+    virtual ~VectorIndex() = default;
+
+    /**
+     * @brief Adds a vector, fails if the id already exists.
+     */
+    virtual bool Add(int64_t id, const float *vector) = 0;
+
+    /**
+     * @brief Replaces the vector stored under id, fails if the id does not exist.
+     */
+    virtual bool Update(int64_t id, const float *vector) = 0;
+
+    /**
+     * @brief Removes the vector stored under id.
+     */
+    virtual bool Remove(int64_t id) = 0;
+
+    /**
+     * @brief Copies the vector stored under id into out.
+     */
+    virtual bool Get(int64_t id, std::vector<float> &out) const = 0;
+
+    virtual bool Contains(int64_t id) const = 0;
+
+    /**
+     * @brief Sets the tag bits of the vector stored under id, vectors are added without tags.
+     * @details Tags are kept next to the rows so that filtered searches test them during the scan.
+     * Update() keeps the tags of the vector.
+     */
+    virtual bool SetTags(int64_t id, uint64_t tags) = 0;
+
+    virtual bool GetTags(int64_t id, uint64_t &tags) const = 0;
+
+    /**
+     * @brief Finds the top_k most similar vectors whose similarity is not below threshold.
+     * @param query Query vector of dim elements, it does not need to be normalized.
+     * @param top_k Maximum number of hits.
+     * @param threshold Minimum cosine similarity kept.
+     * @param hits Output hits, sorted by descending similarity.
+     */
+    virtual void Search(const float *query, size_t top_k, float threshold, std::vector<IndexSearchHit> &hits) const = 0;
+
+    /**
+     * @brief Same as Search, restricted to the vectors whose tags match filter.
+     * @details The filter is applied while scanning, vectors that do not match are never scored.
+     */
+    virtual void SearchFiltered(const float *query, size_t top_k, float threshold, const TagFilter &filter,
+                                std::vector<IndexSearchHit> &hits) const = 0;
+
+    /**
+     * @brief Runs several queries, the default implementation searches them one by one.
+     * @param queries Row-major query matrix of num_queries x dim elements.
+     * @param num_queries Number of queries.
+     * @param top_k Maximum number of hits per query.
+     * @param threshold Minimum cosine similarity kept.
+     * @param hits Output hits, one sorted list per query.
+     */
+    virtual void SearchBatch(const float *queries, size_t num_queries, size_t top_k, float threshold,
+                             std::vector<std::vector<IndexSearchHit>> &hits) const {
+        hits.resize(num_queries);
+        for (size_t q = 0; q < num_queries; ++q) {
+            Search(queries + q * Dim(), top_k, threshold, hits[q]);
+        }
+    }
+
+    /**
+     * @brief Pre-allocates storage for rows vectors.
+     */
+    virtual void Reserve(size_t rows) = 0;
+
+    virtual void Clear() = 0;
+
+    /**
+     * @brief Number of live vectors.
+     */
+    virtual size_t Size() const = 0;
+
+    virtual size_t Dim() const = 0;
+
+    /**
+     * @brief Stored vector of the row reported by a search hit.
+     */
+    virtual const float *Row(size_t row) const = 0;
+
+    /**
+     * @brief Ids of all live vectors, in no particular order.
+     */
+    virtual std::vector<int64_t> Ids() const = 0;
+
+    /**
+     * @brief Approximate heap memory held by the index, in bytes.
+     */
+    virtual size_t MemoryUsage() const = 0;
+};
+
+/** @brief Approximate heap memory of a node based hash map, used by the MemoryUsage implementations. */
+template <typename Map>
+inline size_t HashMapMemoryUsage(const Map &map) {
+    return map.bucket_count() * sizeof(void *) + map.size() * (sizeof(typename Map::value_type) + 2 * sizeof(void *));
+}
+
+}  // namespace inspire
+
+#endif  // INSPIRE_VECTOR_INDEX_H
@@ -7,6 +7,8 @@
 #include "simd.h"
 #include "herror.h"
 #include <thread>
+#include <shared_mutex>
+#include <map>
 #include "middleware/utils.h"
 #include "middleware/system.h"
 #include "log.h"
@@ -16,6 +18,74 @@
 
 namespace inspire {
 
+namespace {
+
+const size_t kFeatureLength = 512;
+
+float CheckThreshold(float threshold) {
+    if (threshold < -1.0f || threshold > 1.0f) {
+        INSPIRE_LOGW("The search threshold entered does not fit the required range (-1.0f, 1.0f) and has been set to 0.5 by default");
+        return 0.5f;
+    }
+    return threshold;
+}
+
+// Gallery names become part of a file name, only letters, digits, '_' and '-' are accepted
+bool IsValidGalleryName(const std::string &name) {
+    if (name.empty()) {
+        return false;
+    }
+    for (char c : name) {
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Database file of a configuration, a folder holds the database under fileName
+std::string DatabaseFile(const DatabaseConfiguration &configuration, const std::string &fileName) {
+    if (!configuration.enable_persistence) {
+        return ":memory:";
+    }
+    if (IsDirectory(configuration.persistence_db_path)) {
+        return os::PathJoin(configuration.persistence_db_path, fileName);
+    }
+    return configuration.persistence_db_path;
+}
+
+IndexOptions MakeIndexOptions(const SearchIndexConfiguration &searchIndex) {
+    IndexOptions indexOptions;
+    if (searchIndex.index_type == SEARCH_INDEX_HNSW) {
+        indexOptions.type = IndexType::HNSW;
+        if (searchIndex.hnsw_m < 2 || searchIndex.hnsw_ef_construction < 1 || searchIndex.hnsw_ef_search < 1) {
+            INSPIRE_LOGW("The HNSW parameters entered are out of range and the default values are used");
+        } else {
+            indexOptions.hnsw.m = searchIndex.hnsw_m;
+            indexOptions.hnsw.ef_construction = searchIndex.hnsw_ef_construction;
+            indexOptions.hnsw.ef_search = searchIndex.hnsw_ef_search;
+        }
+    }
+    if (searchIndex.vector_storage == SEARCH_STORAGE_FLOAT16) {
+        indexOptions.storage = VectorStorage::FLOAT16;
+    } else if (searchIndex.vector_storage == SEARCH_STORAGE_INT8) {
+        indexOptions.storage = VectorStorage::INT8;
+    }
+    if (searchIndex.rerank_factor < 1) {
+        INSPIRE_LOGW("The rerank factor entered is out of range and the default value is used");
+    } else {
+        indexOptions.rerank_factor = searchIndex.rerank_factor;
+    }
+    if (searchIndex.shards < 1) {
+        INSPIRE_LOGW("The shard count entered is out of range and a single shard is used");
+    } else {
+        indexOptions.shards = searchIndex.shards;
+    }
+    return indexOptions;
+}
+
+}  // namespace
+
 class FeatureHubDB::Impl {
 public:
     Impl() : m_enable_(false), m_recognition_threshold_(0.48f), m_search_mode_(SEARCH_MODE_EAGER) {}
@@ -36,7 +106,36 @@ public:
 
     bool m_enable_;
 
+    // Held exclusively to enable or disable the hub and shared by every other call, the database
+    // serializes its writers itself so searches and writes only have to keep it alive
+    std::shared_timed_mutex m_hub_mutex_;
+    // Guards the result caches above, searches run outside of it and only copy their results in
     std::mutex m_res_mtx_;
+
+    struct Gallery {
+        std::shared_ptr<EmbeddingDB> db;
+        float recognition_threshold;
+        std::string db_file;
+    };
+
+    // Named galleries, an operation copies the database pointer so a concurrent drop only
+    // closes the database once the last operation on it has returned
+    std::map<std::string, Gallery> m_galleries_;
+    std::string m_db_file_;
+    std::shared_timed_mutex m_gallery_mutex_;
+
+    std::shared_ptr<EmbeddingDB> FindGallery(const std::string &name, float *threshold = nullptr) {
+        std::shared_lock<std::shared_timed_mutex> lock(m_gallery_mutex_);
+        auto it = m_galleries_.find(name);
+        if (it == m_galleries_.end()) {
+            INSPIRE_LOGE("Gallery %s does not exist", name.c_str());
+            return nullptr;
+        }
+        if (threshold != nullptr) {
+            *threshold = it->second.recognition_threshold;
+        }
+        return it->second.db;
+    }
 };
 
 std::mutex FeatureHubDB::mutex_;
@@ -55,6 +154,7 @@ std::shared_ptr<FeatureHubDB> FeatureHubDB::GetInstance() {
 }
 
 int32_t FeatureHubDB::DisableHub() {
+    std::lock_guard<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
     if (!pImpl->m_enable_) {
         INSPIRE_LOGW("FeatureHub is already disabled.");
         return HSUCCEED;
@@ -65,6 +165,11 @@ int32_t FeatureHubDB::DisableHub() {
     }
 
     pImpl->m_search_face_feature_cache_.clear();
+    {
+        std::lock_guard<std::shared_timed_mutex> galleryLock(pImpl->m_gallery_mutex_);
+        pImpl->m_galleries_.clear();
+    }
+    pImpl->m_db_file_.clear();
 
     pImpl->m_db_configuration_ = DatabaseConfiguration();
     pImpl->m_recognition_threshold_ = 0.0f;
@@ -77,37 +182,32 @@ int32_t FeatureHubDB::DisableHub() {
 }
 
 int32_t FeatureHubDB::GetAllIds() {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
     if (!pImpl->m_enable_) {
         INSPIRE_LOGE("FeatureHub is disabled, please enable it before it can be served");
         return HERR_FT_HUB_DISABLE;
     }
-    pImpl->m_all_ids_ = EMBEDDING_DB::GetInstance().GetAllIds();
+    auto ids = EMBEDDING_DB::GetInstance().GetAllIds();
+    std::lock_guard<std::mutex> cacheLock(pImpl->m_res_mtx_);
+    pImpl->m_all_ids_ = std::move(ids);
     return HSUCCEED;
 }
 
 int32_t FeatureHubDB::EnableHub(const DatabaseConfiguration &configuration) {
+    std::lock_guard<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
     if (pImpl->m_enable_) {
         INSPIRE_LOGW("You have enabled the FeatureHub feature. It is not valid to do so again");
         return HSUCCEED;
     }
 
     pImpl->m_db_configuration_ = configuration;
-    pImpl->m_recognition_threshold_ = pImpl->m_db_configuration_.recognition_threshold;
-    if (pImpl->m_recognition_threshold_ < -1.0f || pImpl->m_recognition_threshold_ > 1.0f) {
-        INSPIRE_LOGW("The search threshold entered does not fit the required range (-1.0f, 1.0f) and has been set to 0.5 by default");
-        pImpl->m_recognition_threshold_ = 0.5f;
-    }
+    pImpl->m_recognition_threshold_ = CheckThreshold(pImpl->m_db_configuration_.recognition_threshold);
 
-    std::string dbFile = ":memory:";
-    if (pImpl->m_db_configuration_.enable_persistence) {
-        if (IsDirectory(pImpl->m_db_configuration_.persistence_db_path)) {
-            dbFile = os::PathJoin(pImpl->m_db_configuration_.persistence_db_path, DB_FILE_NAME);
-        } else {
-            dbFile = pImpl->m_db_configuration_.persistence_db_path;
-        }
-    }
+    std::string dbFile = DatabaseFile(pImpl->m_db_configuration_, DB_FILE_NAME);
+    IndexOptions indexOptions = MakeIndexOptions(pImpl->m_db_configuration_.search_index);
 
-    EMBEDDING_DB::Init(dbFile, 512, IdMode(configuration.primary_key_mode));
+    EMBEDDING_DB::Init(dbFile, kFeatureLength, IdMode(configuration.primary_key_mode), indexOptions);
+    pImpl->m_db_file_ = dbFile;
     pImpl->m_enable_ = true;
     pImpl->m_face_feature_ptr_cache_ = std::make_shared<FaceFeatureEntity>();
 
@@ -181,6 +281,7 @@ int32_t FeatureHubDB::CosineSimilarity(const float *v1, const float *v2, int32_t
 }
 
 int32_t FeatureHubDB::GetFaceFeatureCount() {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
     if (!pImpl->m_enable_) {
         INSPIRE_LOGW("FeatureHub is disabled, please enable it before it can be served");
         return 0;
@@ -190,16 +291,18 @@ int32_t FeatureHubDB::GetFaceFeatureCount() {
 }
 
 int32_t FeatureHubDB::SearchFaceFeature(const Embedded &queryFeature, FaceSearchResult &searchResult, bool returnFeature) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
     if (!pImpl->m_enable_) {
         INSPIRE_LOGE("FeatureHub is disabled, please enable it before it can be served");
         return HSUCCEED;
     }
 
-    pImpl->m_search_face_feature_cache_.clear();
     auto results = EMBEDDING_DB::GetInstance().SearchSimilarVectors(queryFeature, 1, pImpl->m_recognition_threshold_, returnFeature);
     searchResult.id = -1;
 
+    std::lock_guard<std::mutex> cacheLock(pImpl->m_res_mtx_);
+    pImpl->m_search_face_feature_cache_.clear();
+
     if (!results.empty()) {
         auto &searched = results[0];
         searchResult.similarity = searched.similarity;
@@ -216,15 +319,17 @@ int32_t FeatureHubDB::SearchFaceFeature(const Embedded &queryFeature, FaceSearch
 }
 
 int32_t FeatureHubDB::SearchFaceFeatureTopKCache(const Embedded &queryFeature, size_t topK) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
     if (!pImpl->m_enable_) {
         INSPIRE_LOGE("FeatureHub is disabled, please enable it before it can be served");
         return HERR_FT_HUB_DISABLE;
     }
 
+    auto results = EMBEDDING_DB::GetInstance().SearchSimilarVectors(queryFeature, topK, pImpl->m_recognition_threshold_, false);
+
+    std::lock_guard<std::mutex> cacheLock(pImpl->m_res_mtx_);
     pImpl->m_top_k_confidence_.clear();
     pImpl->m_top_k_custom_ids_cache_.clear();
-    auto results = EMBEDDING_DB::GetInstance().SearchSimilarVectors(queryFeature, topK, pImpl->m_recognition_threshold_, false);
 
     for (size_t i = 0; i < results.size(); i++) {
         pImpl->m_top_k_custom_ids_cache_.push_back(results[i].id);
@@ -236,7 +341,7 @@ int32_t FeatureHubDB::SearchFaceFeatureTopKCache(const Embedded &queryFeature, s
 
 int32_t FeatureHubDB::SearchFaceFeatureTopK(const Embedded &queryFeature, std::vector<FaceSearchResult> &searchResult, size_t topK,
                                             bool returnFeature) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
     if (!pImpl->m_enable_) {
         INSPIRE_LOGW("FeatureHub is disabled, please enable it before it can be served");
         return HERR_FT_HUB_DISABLE;
@@ -246,8 +351,83 @@ int32_t FeatureHubDB::SearchFaceFeatureTopK(const Embedded &queryFeature, std::v
     return HSUCCEED;
 }
 
+int32_t FeatureHubDB::SearchFaceFeatureTopKBatch(const float *queries, size_t numQueries, std::vector<std::vector<FaceSearchResult>> &searchResults,
+                                                 size_t topK, bool returnFeature) {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
+    if (!pImpl->m_enable_) {
+        INSPIRE_LOGW("FeatureHub is disabled, please enable it before it can be served");
+        return HERR_FT_HUB_DISABLE;
+    }
+
+    searchResults = EMBEDDING_DB::GetInstance().BatchSearchSimilarVectors(queries, numQueries, topK, pImpl->m_recognition_threshold_, returnFeature);
+    return HSUCCEED;
+}
+
+int32_t FeatureHubDB::SearchFaceFeatureTopK(const float *queryFeature, size_t topK, FaceSearchTopKBuffer &result) {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
+    if (!pImpl->m_enable_) {
+        INSPIRE_LOGW("FeatureHub is disabled, please enable it before it can be served");
+        return HERR_FT_HUB_DISABLE;
+    }
+    if (queryFeature == nullptr) {
+        return HERR_INVALID_FACE_FEATURE;
+    }
+    if (result.ids == nullptr || result.confidences == nullptr) {
+        return HERR_INVALID_PARAM;
+    }
+
+    EMBEDDING_DB::GetInstance().SearchSimilarVectors(queryFeature, topK, pImpl->m_recognition_threshold_, result);
+    return HSUCCEED;
+}
+
+int32_t FeatureHubDB::SearchFaceFeatureTopK(const float *queryFeature, size_t topK, const FaceSearchFilter &filter, FaceSearchTopKBuffer &result) {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
+    if (!pImpl->m_enable_) {
+        INSPIRE_LOGW("FeatureHub is disabled, please enable it before it can be served");
+        return HERR_FT_HUB_DISABLE;
+    }
+    if (queryFeature == nullptr) {
+        return HERR_INVALID_FACE_FEATURE;
+    }
+    if (result.ids == nullptr || result.confidences == nullptr) {
+        return HERR_INVALID_PARAM;
+    }
+
+    TagFilter tagFilter;
+    tagFilter.all_of = filter.allOf;
+    tagFilter.any_of = filter.anyOf;
+    tagFilter.none_of = filter.noneOf;
+    EMBEDDING_DB::GetInstance().SearchSimilarVectors(queryFeature, topK, pImpl->m_recognition_threshold_, tagFilter, result);
+    return HSUCCEED;
+}
+
+int32_t FeatureHubDB::SearchFaceFeatureTopKBatch(const float *queries, size_t numQueries, size_t topK, FaceSearchTopKBuffer *results) {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
+    if (!pImpl->m_enable_) {
+        INSPIRE_LOGW("FeatureHub is disabled, please enable it before it can be served");
+        return HERR_FT_HUB_DISABLE;
+    }
+    if (numQueries == 0) {
+        return HSUCCEED;
+    }
+    if (queries == nullptr) {
+        return HERR_INVALID_FACE_FEATURE;
+    }
+    if (results == nullptr) {
+        return HERR_INVALID_PARAM;
+    }
+    for (size_t i = 0; i < numQueries; ++i) {
+        if (results[i].ids == nullptr || results[i].confidences == nullptr) {
+            return HERR_INVALID_PARAM;
+        }
+    }
+
+    EMBEDDING_DB::GetInstance().BatchSearchSimilarVectors(queries, numQueries, topK, pImpl->m_recognition_threshold_, results);
+    return HSUCCEED;
+}
+
 int32_t FeatureHubDB::FaceFeatureInsert(const std::vector<float> &feature, int32_t id, int64_t &result_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
     if (!pImpl->m_enable_) {
         INSPIRE_LOGE("FeatureHub is disabled, please enable it before it can be served");
         return HERR_FT_HUB_DISABLE;
@@ -262,8 +442,29 @@ int32_t FeatureHubDB::FaceFeatureInsert(const std::vector<float> &feature, int32
     return HSUCCEED;
 }
 
+int32_t FeatureHubDB::FaceFeatureBatchInsert(const float *features, size_t count, const int64_t *ids, int64_t *result_ids) {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
+    if (!pImpl->m_enable_) {
+        INSPIRE_LOGE("FeatureHub is disabled, please enable it before it can be served");
+        return HERR_FT_HUB_DISABLE;
+    }
+    if (count == 0) {
+        return HSUCCEED;
+    }
+    if (features == nullptr) {
+        return HERR_INVALID_FACE_FEATURE;
+    }
+
+    bool ret = EMBEDDING_DB::GetInstance().BatchInsertVectors(features, count, ids, result_ids);
+    if (!ret) {
+        return HERR_FT_HUB_INSERT_FAILURE;
+    }
+
+    return HSUCCEED;
+}
+
 int32_t FeatureHubDB::FaceFeatureRemove(int32_t id) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
     if (!pImpl->m_enable_) {
         INSPIRE_LOGE("FeatureHub is disabled, please enable it before it can be served");
         return HERR_FT_HUB_DISABLE;
@@ -274,7 +475,7 @@ int32_t FeatureHubDB::FaceFeatureRemove(int32_t id) {
 }
 
 int32_t FeatureHubDB::FaceFeatureUpdate(const std::vector<float> &feature, int32_t customId) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
     if (!pImpl->m_enable_) {
         INSPIRE_LOGE("FeatureHub is disabled, please enable it before it can be served");
         return HERR_FT_HUB_DISABLE;
@@ -285,7 +486,7 @@ int32_t FeatureHubDB::FaceFeatureUpdate(const std::vector<float> &feature, int32
 }
 
 int32_t FeatureHubDB::GetFaceFeature(int32_t id) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
     if (!pImpl->m_enable_) {
         INSPIRE_LOGE("FeatureHub is disabled, please enable it before it can be served");
         return HERR_FT_HUB_DISABLE;
@@ -296,7 +497,8 @@ int32_t FeatureHubDB::GetFaceFeature(int32_t id) {
         return HERR_FT_HUB_NOT_FOUND_FEATURE;
     }
 
-    pImpl->m_getter_face_feature_cache_ = vec;
+    std::lock_guard<std::mutex> cacheLock(pImpl->m_res_mtx_);
+    pImpl->m_getter_face_feature_cache_ = std::move(vec);
     pImpl->m_face_feature_ptr_cache_->data = pImpl->m_getter_face_feature_cache_.data();
     pImpl->m_face_feature_ptr_cache_->dataSize = pImpl->m_getter_face_feature_cache_.size();
 
@@ -304,7 +506,7 @@ int32_t FeatureHubDB::GetFaceFeature(int32_t id) {
 }
 
 int32_t FeatureHubDB::GetFaceFeature(int32_t id, std::vector<float> &feature) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
     if (!pImpl->m_enable_) {
         INSPIRE_LOGW("FeatureHub is disabled, please enable it before it can be served");
         return HERR_FT_HUB_DISABLE;
@@ -318,7 +520,34 @@ int32_t FeatureHubDB::GetFaceFeature(int32_t id, std::vector<float> &feature) {
     return HSUCCEED;
 }
 
+int32_t FeatureHubDB::FaceFeatureSetTags(int64_t id, uint64_t tags) {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
+    if (!pImpl->m_enable_) {
+        INSPIRE_LOGE("FeatureHub is disabled, please enable it before it can be served");
+        return HERR_FT_HUB_DISABLE;
+    }
+
+    if (!EMBEDDING_DB::GetInstance().SetVectorTags(id, tags)) {
+        return HERR_FT_HUB_NOT_FOUND_FEATURE;
+    }
+    return HSUCCEED;
+}
+
+int32_t FeatureHubDB::GetFaceFeatureTags(int64_t id, uint64_t &tags) {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
+    if (!pImpl->m_enable_) {
+        INSPIRE_LOGW("FeatureHub is disabled, please enable it before it can be served");
+        return HERR_FT_HUB_DISABLE;
+    }
+
+    if (!EMBEDDING_DB::GetInstance().GetVectorTags(id, tags)) {
+        return HERR_FT_HUB_NOT_FOUND_FEATURE;
+    }
+    return HSUCCEED;
+}
+
 int32_t FeatureHubDB::ViewDBTable() {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
     if (!pImpl->m_enable_) {
         INSPIRE_LOGE("FeatureHub is disabled, please enable it before it can be served");
         return HERR_FT_HUB_DISABLE;
@@ -328,9 +557,193 @@ int32_t FeatureHubDB::ViewDBTable() {
 }
 
 void FeatureHubDB::SetRecognitionThreshold(float threshold) {
+    // The searches read the threshold under the shared lock
+    std::lock_guard<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
     pImpl->m_recognition_threshold_ = threshold;
 }
 
+int32_t FeatureHubDB::SetSearchIndexEf(int32_t ef) {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
+    if (!pImpl->m_enable_) {
+        INSPIRE_LOGE("FeatureHub is disabled, please enable it before it can be served");
+        return HERR_FT_HUB_DISABLE;
+    }
+    if (ef < 1) {
+        return HERR_INVALID_PARAM;
+    }
+    EMBEDDING_DB::GetInstance().SetSearchEf(ef);
+    return HSUCCEED;
+}
+
+int32_t FeatureHubDB::GetSearchIndexMemoryUsage(size_t &bytes) {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
+    if (!pImpl->m_enable_) {
+        INSPIRE_LOGE("FeatureHub is disabled, please enable it before it can be served");
+        return HERR_FT_HUB_DISABLE;
+    }
+    bytes = EMBEDDING_DB::GetInstance().GetIndexMemoryUsage();
+    return HSUCCEED;
+}
+
+int32_t FeatureHubDB::SaveSearchIndex() {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
+    if (!pImpl->m_enable_) {
+        INSPIRE_LOGE("FeatureHub is disabled, please enable it before it can be served");
+        return HERR_FT_HUB_DISABLE;
+    }
+    if (!EMBEDDING_DB::GetInstance().SaveIndex()) {
+        return HERR_FT_HUB_EXECUTING_FAILURE;
+    }
+    return HSUCCEED;
+}
+
+int32_t FeatureHubDB::CreateGallery(const std::string &name, const DatabaseConfiguration &configuration) {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
+    if (!pImpl->m_enable_) {
+        INSPIRE_LOGE("FeatureHub is disabled, please enable it before it can be served");
+        return HERR_FT_HUB_DISABLE;
+    }
+    if (!IsValidGalleryName(name)) {
+        INSPIRE_LOGE("Invalid gallery name %s, only letters, digits, '_' and '-' are allowed", name.c_str());
+        return HERR_INVALID_PARAM;
+    }
+
+    std::string dbFile = DatabaseFile(configuration, std::string(DB_FILE_NAME) + "_" + name);
+    std::lock_guard<std::shared_timed_mutex> galleryLock(pImpl->m_gallery_mutex_);
+    if (pImpl->m_galleries_.count(name) > 0) {
+        INSPIRE_LOGE("Gallery %s already exists", name.c_str());
+        return HERR_FT_HUB_ENABLE_REPETITION;
+    }
+    // Two connections to one file would each keep their own index of it
+    if (dbFile != ":memory:") {
+        bool shared = dbFile == pImpl->m_db_file_;
+        for (const auto &gallery : pImpl->m_galleries_) {
+            shared = shared || dbFile == gallery.second.db_file;
+        }
+        if (shared) {
+            INSPIRE_LOGE("The database file %s is already in use", dbFile.c_str());
+            return HERR_FT_HUB_OPEN_ERROR;
+        }
+    }
+
+    Impl::Gallery gallery;
+    gallery.db = EmbeddingDB::Create(dbFile, kFeatureLength, IdMode(configuration.primary_key_mode), MakeIndexOptions(configuration.search_index));
+    gallery.recognition_threshold = CheckThreshold(configuration.recognition_threshold);
+    gallery.db_file = dbFile;
+    pImpl->m_galleries_.emplace(name, std::move(gallery));
+    return HSUCCEED;
+}
+
+int32_t FeatureHubDB::DropGallery(const std::string &name) {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
+    if (!pImpl->m_enable_) {
+        INSPIRE_LOGE("FeatureHub is disabled, please enable it before it can be served");
+        return HERR_FT_HUB_DISABLE;
+    }
+    std::lock_guard<std::shared_timed_mutex> galleryLock(pImpl->m_gallery_mutex_);
+    if (pImpl->m_galleries_.erase(name) == 0) {
+        INSPIRE_LOGE("Gallery %s does not exist", name.c_str());
+        return HERR_FT_HUB_GALLERY_NOT_FOUND;
+    }
+    return HSUCCEED;
+}
+
+int32_t FeatureHubDB::GalleryFeatureInsert(const std::string &name, const float *feature, int64_t id, int64_t &result_id) {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
+    if (!pImpl->m_enable_) {
+        INSPIRE_LOGE("FeatureHub is disabled, please enable it before it can be served");
+        return HERR_FT_HUB_DISABLE;
+    }
+    if (feature == nullptr) {
+        return HERR_INVALID_FACE_FEATURE;
+    }
+    auto db = pImpl->FindGallery(name);
+    if (!db) {
+        return HERR_FT_HUB_GALLERY_NOT_FOUND;
+    }
+
+    if (!db->BatchInsertVectors(feature, 1, &id, &result_id)) {
+        result_id = -1;
+        return HERR_FT_HUB_INSERT_FAILURE;
+    }
+    return HSUCCEED;
+}
+
+int32_t FeatureHubDB::GalleryFeatureBatchInsert(const std::string &name, const float *features, size_t count, const int64_t *ids, int64_t *result_ids) {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
+    if (!pImpl->m_enable_) {
+        INSPIRE_LOGE("FeatureHub is disabled, please enable it before it can be served");
+        return HERR_FT_HUB_DISABLE;
+    }
+    auto db = pImpl->FindGallery(name);
+    if (!db) {
+        return HERR_FT_HUB_GALLERY_NOT_FOUND;
+    }
+    if (count == 0) {
+        return HSUCCEED;
+    }
+    if (features == nullptr) {
+        return HERR_INVALID_FACE_FEATURE;
+    }
+
+    if (!db->BatchInsertVectors(features, count, ids, result_ids)) {
+        return HERR_FT_HUB_INSERT_FAILURE;
+    }
+    return HSUCCEED;
+}
+
+int32_t FeatureHubDB::GalleryFeatureRemove(const std::string &name, int64_t id) {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
+    if (!pImpl->m_enable_) {
+        INSPIRE_LOGE("FeatureHub is disabled, please enable it before it can be served");
+        return HERR_FT_HUB_DISABLE;
+    }
+    auto db = pImpl->FindGallery(name);
+    if (!db) {
+        return HERR_FT_HUB_GALLERY_NOT_FOUND;
+    }
+
+    db->DeleteVector(id);
+    return HSUCCEED;
+}
+
+int32_t FeatureHubDB::GallerySearchFaceFeatureTopK(const std::string &name, const float *queryFeature, size_t topK, FaceSearchTopKBuffer &result) {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
+    if (!pImpl->m_enable_) {
+        INSPIRE_LOGW("FeatureHub is disabled, please enable it before it can be served");
+        return HERR_FT_HUB_DISABLE;
+    }
+    if (queryFeature == nullptr) {
+        return HERR_INVALID_FACE_FEATURE;
+    }
+    if (result.ids == nullptr || result.confidences == nullptr) {
+        return HERR_INVALID_PARAM;
+    }
+    float threshold = 0.0f;
+    auto db = pImpl->FindGallery(name, &threshold);
+    if (!db) {
+        return HERR_FT_HUB_GALLERY_NOT_FOUND;
+    }
+
+    db->SearchSimilarVectors(queryFeature, topK, threshold, result);
+    return HSUCCEED;
+}
+
+int32_t FeatureHubDB::GetGalleryFaceFeatureCount(const std::string &name, int32_t &count) {
+    std::shared_lock<std::shared_timed_mutex> lock(pImpl->m_hub_mutex_);
+    if (!pImpl->m_enable_) {
+        INSPIRE_LOGW("FeatureHub is disabled, please enable it before it can be served");
+        return HERR_FT_HUB_DISABLE;
+    }
+    auto db = pImpl->FindGallery(name);
+    if (!db) {
+        return HERR_FT_HUB_GALLERY_NOT_FOUND;
+    }
+
+    count = static_cast<int32_t>(db->GetVectorCount());
+    return HSUCCEED;
+}
+
 void FeatureHubDB::SetRecognitionSearchMode(SearchMode mode) {
     pImpl->m_search_mode_ = mode;
 }
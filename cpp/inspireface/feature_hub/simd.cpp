@@ -0,0 +1,780 @@
+#include "simd.h"
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+// GCC/Clang on x86: build every kernel and pick one at runtime
+#define ISF_SIMD_X86_DISPATCH
+#define ISF_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define ISF_TARGET_AVX512 __attribute__((target("avx512f")))
+#define ISF_TARGET_AVX2_F16C __attribute__((target("avx2,fma,f16c")))
+#define ISF_TARGET_AVX512_VNNI __attribute__((target("avx512f,avx512bw,avx512vnni")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+// MSVC: only the instruction sets enabled by /arch are usable
+#define ISF_SIMD_X86_STATIC
+#define ISF_TARGET_AVX2
+#define ISF_TARGET_AVX512
+#define ISF_TARGET_AVX2_F16C
+#define ISF_TARGET_AVX512_VNNI
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define ISF_SIMD_NEON
+#endif
+
+namespace {
+
+typedef void (*DotRowsFunc)(const float *, const float *, size_t, size_t, size_t, float *);
+typedef void (*DotGatherFunc)(const float *, const float *const *, size_t, size_t, float *);
+
+struct DotRowsKernel {
+    DotRowsFunc rows;
+    DotGatherFunc gather;
+    const char *name;
+};
+
+// Expands the four-row and single-row primitives of one instruction set into the
+// strided (DotRows) and pointer-list (DotGather) entry points
+#define ISF_DEFINE_DOT_KERNELS(SUFFIX, TARGET)                                                                               \
+    TARGET void DotRows##SUFFIX(const float *query, const float *matrix, size_t rows, size_t stride, size_t dim, float *out) { \
+        size_t r = 0;                                                                                                        \
+        for (; r + 4 <= rows; r += 4) {                                                                                      \
+            const float *r0 = matrix + r * stride;                                                                           \
+            Dot4##SUFFIX(query, r0, r0 + stride, r0 + 2 * stride, r0 + 3 * stride, dim, out + r);                            \
+        }                                                                                                                    \
+        for (; r < rows; ++r) {                                                                                              \
+            out[r] = Dot1##SUFFIX(query, matrix + r * stride, dim);                                                          \
+        }                                                                                                                    \
+    }                                                                                                                        \
+    TARGET void DotGather##SUFFIX(const float *query, const float *const *rows, size_t count, size_t dim, float *out) {      \
+        size_t r = 0;                                                                                                        \
+        for (; r + 4 <= count; r += 4) {                                                                                     \
+            Dot4##SUFFIX(query, rows[r], rows[r + 1], rows[r + 2], rows[r + 3], dim, out + r);                               \
+        }                                                                                                                    \
+        for (; r < count; ++r) {                                                                                             \
+            out[r] = Dot1##SUFFIX(query, rows[r], dim);                                                                      \
+        }                                                                                                                    \
+    }
+
+inline float Dot1Scalar(const float *query, const float *row, size_t dim) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < dim; ++i) {
+        sum += query[i] * row[i];
+    }
+    return sum;
+}
+
+inline void Dot4Scalar(const float *query, const float *r0, const float *r1, const float *r2, const float *r3, size_t dim, float *out) {
+    out[0] = Dot1Scalar(query, r0, dim);
+    out[1] = Dot1Scalar(query, r1, dim);
+    out[2] = Dot1Scalar(query, r2, dim);
+    out[3] = Dot1Scalar(query, r3, dim);
+}
+
+#if !defined(ISF_SIMD_X86_DISPATCH) && !defined(ISF_SIMD_X86_STATIC) && !defined(ISF_SIMD_NEON)
+ISF_DEFINE_DOT_KERNELS(Scalar, )
+#endif
+
+#if defined(ISF_SIMD_X86_DISPATCH) || defined(ISF_SIMD_X86_STATIC)
+
+inline float HorizontalSum128(__m128 v) {
+    __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+}
+
+inline float Dot1Sse(const float *query, const float *row, size_t dim) {
+    __m128 acc = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= dim; i += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(query + i), _mm_loadu_ps(row + i)));
+    }
+    float sum = HorizontalSum128(acc);
+    for (; i < dim; ++i) {
+        sum += query[i] * row[i];
+    }
+    return sum;
+}
+
+// Four rows per pass so every query load is reused four times
+inline void Dot4Sse(const float *query, const float *r0, const float *r1, const float *r2, const float *r3, size_t dim, float *out) {
+    __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps(), a2 = _mm_setzero_ps(), a3 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= dim; i += 4) {
+        __m128 q = _mm_loadu_ps(query + i);
+        a0 = _mm_add_ps(a0, _mm_mul_ps(q, _mm_loadu_ps(r0 + i)));
+        a1 = _mm_add_ps(a1, _mm_mul_ps(q, _mm_loadu_ps(r1 + i)));
+        a2 = _mm_add_ps(a2, _mm_mul_ps(q, _mm_loadu_ps(r2 + i)));
+        a3 = _mm_add_ps(a3, _mm_mul_ps(q, _mm_loadu_ps(r3 + i)));
+    }
+    float s0 = HorizontalSum128(a0), s1 = HorizontalSum128(a1), s2 = HorizontalSum128(a2), s3 = HorizontalSum128(a3);
+    for (; i < dim; ++i) {
+        s0 += query[i] * r0[i];
+        s1 += query[i] * r1[i];
+        s2 += query[i] * r2[i];
+        s3 += query[i] * r3[i];
+    }
+    out[0] = s0;
+    out[1] = s1;
+    out[2] = s2;
+    out[3] = s3;
+}
+
+ISF_DEFINE_DOT_KERNELS(Sse, )
+
+#if defined(ISF_SIMD_X86_DISPATCH) || defined(__AVX2__)
+#define ISF_SIMD_HAS_AVX2
+
+ISF_TARGET_AVX2 inline float HorizontalSum256(__m256 v) {
+    __m128 lo = _mm256_castps256_ps128(v);
+    __m128 hi = _mm256_extractf128_ps(v, 1);
+    lo = _mm_add_ps(lo, hi);
+    __m128 shuf = _mm_shuffle_ps(lo, lo, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(lo, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+}
+
+ISF_TARGET_AVX2 inline float Dot1Avx2(const float *query, const float *row, size_t dim) {
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= dim; i += 8) {
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(query + i), _mm256_loadu_ps(row + i), acc);
+    }
+    float sum = HorizontalSum256(acc);
+    for (; i < dim; ++i) {
+        sum += query[i] * row[i];
+    }
+    return sum;
+}
+
+ISF_TARGET_AVX2 inline void Dot4Avx2(const float *query, const float *r0, const float *r1, const float *r2, const float *r3, size_t dim,
+                                     float *out) {
+    __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps(), a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= dim; i += 8) {
+        __m256 q = _mm256_loadu_ps(query + i);
+        a0 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r0 + i), a0);
+        a1 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r1 + i), a1);
+        a2 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r2 + i), a2);
+        a3 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r3 + i), a3);
+    }
+    float s0 = HorizontalSum256(a0), s1 = HorizontalSum256(a1), s2 = HorizontalSum256(a2), s3 = HorizontalSum256(a3);
+    for (; i < dim; ++i) {
+        s0 += query[i] * r0[i];
+        s1 += query[i] * r1[i];
+        s2 += query[i] * r2[i];
+        s3 += query[i] * r3[i];
+    }
+    out[0] = s0;
+    out[1] = s1;
+    out[2] = s2;
+    out[3] = s3;
+}
+
+ISF_DEFINE_DOT_KERNELS(Avx2, ISF_TARGET_AVX2)
+#endif  // AVX2
+
+#if defined(ISF_SIMD_X86_DISPATCH) || defined(__AVX512F__)
+#define ISF_SIMD_HAS_AVX512
+
+ISF_TARGET_AVX512 inline float HorizontalSum512(__m512 v) {
+    // Only runs once per four rows, a spill keeps it portable across compilers
+    alignas(64) float lanes[16];
+    _mm512_store_ps(lanes, v);
+    float sum = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        sum += lanes[i];
+    }
+    return sum;
+}
+
+ISF_TARGET_AVX512 inline float Dot1Avx512(const float *query, const float *row, size_t dim) {
+    __m512 acc = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= dim; i += 16) {
+        acc = _mm512_fmadd_ps(_mm512_loadu_ps(query + i), _mm512_loadu_ps(row + i), acc);
+    }
+    float sum = HorizontalSum512(acc);
+    for (; i < dim; ++i) {
+        sum += query[i] * row[i];
+    }
+    return sum;
+}
+
+ISF_TARGET_AVX512 inline void Dot4Avx512(const float *query, const float *r0, const float *r1, const float *r2, const float *r3, size_t dim,
+                                         float *out) {
+    __m512 a0 = _mm512_setzero_ps(), a1 = _mm512_setzero_ps(), a2 = _mm512_setzero_ps(), a3 = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= dim; i += 16) {
+        __m512 q = _mm512_loadu_ps(query + i);
+        a0 = _mm512_fmadd_ps(q, _mm512_loadu_ps(r0 + i), a0);
+        a1 = _mm512_fmadd_ps(q, _mm512_loadu_ps(r1 + i), a1);
+        a2 = _mm512_fmadd_ps(q, _mm512_loadu_ps(r2 + i), a2);
+        a3 = _mm512_fmadd_ps(q, _mm512_loadu_ps(r3 + i), a3);
+    }
+    float s0 = HorizontalSum512(a0), s1 = HorizontalSum512(a1), s2 = HorizontalSum512(a2), s3 = HorizontalSum512(a3);
+    for (; i < dim; ++i) {
+        s0 += query[i] * r0[i];
+        s1 += query[i] * r1[i];
+        s2 += query[i] * r2[i];
+        s3 += query[i] * r3[i];
+    }
+    out[0] = s0;
+    out[1] = s1;
+    out[2] = s2;
+    out[3] = s3;
+}
+
+ISF_DEFINE_DOT_KERNELS(Avx512, ISF_TARGET_AVX512)
+#endif  // AVX512
+
+#endif  // x86
+
+#if defined(ISF_SIMD_NEON)
+
+inline float HorizontalSumNeon(float32x4_t v) {
+#if defined(__aarch64__)
+    return vaddvq_f32(v);
+#else
+    float32x2_t s = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(s, s), 0);
+#endif
+}
+
+inline float32x4_t MulAddNeon(float32x4_t acc, float32x4_t a, float32x4_t b) {
+#if defined(__aarch64__)
+    return vfmaq_f32(acc, a, b);
+#else
+    return vmlaq_f32(acc, a, b);
+#endif
+}
+
+inline float Dot1Neon(const float *query, const float *row, size_t dim) {
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 4 <= dim; i += 4) {
+        acc = MulAddNeon(acc, vld1q_f32(query + i), vld1q_f32(row + i));
+    }
+    float sum = HorizontalSumNeon(acc);
+    for (; i < dim; ++i) {
+        sum += query[i] * row[i];
+    }
+    return sum;
+}
+
+inline void Dot4Neon(const float *query, const float *r0, const float *r1, const float *r2, const float *r3, size_t dim, float *out) {
+    float32x4_t a0 = vdupq_n_f32(0.0f), a1 = vdupq_n_f32(0.0f), a2 = vdupq_n_f32(0.0f), a3 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 4 <= dim; i += 4) {
+        float32x4_t q = vld1q_f32(query + i);
+        a0 = MulAddNeon(a0, q, vld1q_f32(r0 + i));
+        a1 = MulAddNeon(a1, q, vld1q_f32(r1 + i));
+        a2 = MulAddNeon(a2, q, vld1q_f32(r2 + i));
+        a3 = MulAddNeon(a3, q, vld1q_f32(r3 + i));
+    }
+    float s0 = HorizontalSumNeon(a0), s1 = HorizontalSumNeon(a1), s2 = HorizontalSumNeon(a2), s3 = HorizontalSumNeon(a3);
+    for (; i < dim; ++i) {
+        s0 += query[i] * r0[i];
+        s1 += query[i] * r1[i];
+        s2 += query[i] * r2[i];
+        s3 += query[i] * r3[i];
+    }
+    out[0] = s0;
+    out[1] = s1;
+    out[2] = s2;
+    out[3] = s3;
+}
+
+ISF_DEFINE_DOT_KERNELS(Neon, )
+
+#endif  // NEON
+
+DotRowsKernel SelectDotRowsKernel() {
+#if defined(ISF_SIMD_X86_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return {DotRowsAvx512, DotGatherAvx512, "AVX-512"};
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return {DotRowsAvx2, DotGatherAvx2, "AVX2"};
+    }
+    return {DotRowsSse, DotGatherSse, "SSE"};
+#elif defined(ISF_SIMD_X86_STATIC)
+#if defined(ISF_SIMD_HAS_AVX512)
+    return {DotRowsAvx512, DotGatherAvx512, "AVX-512"};
+#elif defined(ISF_SIMD_HAS_AVX2)
+    return {DotRowsAvx2, DotGatherAvx2, "AVX2"};
+#else
+    return {DotRowsSse, DotGatherSse, "SSE"};
+#endif
+#elif defined(ISF_SIMD_NEON)
+    return {DotRowsNeon, DotGatherNeon, "NEON"};
+#else
+    return {DotRowsScalar, DotGatherScalar, "Scalar"};
+#endif
+}
+
+const DotRowsKernel &GetDotRowsKernel() {
+    static const DotRowsKernel kernel = SelectDotRowsKernel();
+    return kernel;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Quantized kernels, used by the first-pass scan of QuantizedFlatIndex
+// ---------------------------------------------------------------------------------------------
+
+typedef void (*DotRowsS8Func)(const int8_t *, const int8_t *, size_t, size_t, size_t, int32_t *);
+typedef void (*DotRowsF16Func)(const float *, const uint16_t *, size_t, size_t, size_t, float *);
+
+struct QuantDotKernel {
+    DotRowsS8Func rows_s8;
+    DotRowsF16Func rows_f16;
+    const char *name_s8;
+};
+
+// Strided entry point over the four-row and single-row primitives of a quantized format
+#define ISF_DEFINE_QUANT_ROWS(NAME, QT, MT, OT, DOT1, DOT4, TARGET)                                              \
+    TARGET void NAME(const QT *query, const MT *matrix, size_t rows, size_t stride, size_t dim, OT *out) {     \
+        size_t r = 0;                                                                                           \
+        for (; r + 4 <= rows; r += 4) {                                                                         \
+            const MT *r0 = matrix + r * stride;                                                                 \
+            DOT4(query, r0, r0 + stride, r0 + 2 * stride, r0 + 3 * stride, dim, out + r);                       \
+        }                                                                                                       \
+        for (; r < rows; ++r) {                                                                                 \
+            out[r] = DOT1(query, matrix + r * stride, dim);                                                     \
+        }                                                                                                       \
+    }
+
+inline int32_t DotS8Scalar(const int8_t *query, const int8_t *row, size_t dim) {
+    int32_t sum = 0;
+    for (size_t i = 0; i < dim; ++i) {
+        sum += static_cast<int32_t>(query[i]) * row[i];
+    }
+    return sum;
+}
+
+inline void Dot4S8Scalar(const int8_t *query, const int8_t *r0, const int8_t *r1, const int8_t *r2, const int8_t *r3, size_t dim, int32_t *out) {
+    out[0] = DotS8Scalar(query, r0, dim);
+    out[1] = DotS8Scalar(query, r1, dim);
+    out[2] = DotS8Scalar(query, r2, dim);
+    out[3] = DotS8Scalar(query, r3, dim);
+}
+
+inline float DotF16Scalar(const float *query, const uint16_t *row, size_t dim) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < dim; ++i) {
+        sum += query[i] * simd_half_to_float(row[i]);
+    }
+    return sum;
+}
+
+inline void Dot4F16Scalar(const float *query, const uint16_t *r0, const uint16_t *r1, const uint16_t *r2, const uint16_t *r3, size_t dim,
+                          float *out) {
+    out[0] = DotF16Scalar(query, r0, dim);
+    out[1] = DotF16Scalar(query, r1, dim);
+    out[2] = DotF16Scalar(query, r2, dim);
+    out[3] = DotF16Scalar(query, r3, dim);
+}
+
+// Declared inline so that builds which always have a SIMD path do not warn about them
+inline ISF_DEFINE_QUANT_ROWS(DotRowsS8Scalar, int8_t, int8_t, int32_t, DotS8Scalar, Dot4S8Scalar, )
+inline ISF_DEFINE_QUANT_ROWS(DotRowsF16Scalar, float, uint16_t, float, DotF16Scalar, Dot4F16Scalar, )
+
+#if defined(ISF_SIMD_HAS_AVX2)
+
+ISF_TARGET_AVX2 inline int32_t HorizontalSumS32x8(__m256i v) {
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+
+// maddubs multiplies unsigned by signed bytes: |q| times r carrying the sign of q gives q * r,
+// pairs of products stay below the int16 limit because both operands lie in [-127, 127]
+ISF_TARGET_AVX2 inline __m256i MulAddS8Avx2(__m256i acc, __m256i abs_query, __m256i query, __m256i row) {
+    __m256i pairs = _mm256_maddubs_epi16(abs_query, _mm256_sign_epi8(row, query));
+    return _mm256_add_epi32(acc, _mm256_madd_epi16(pairs, _mm256_set1_epi16(1)));
+}
+
+ISF_TARGET_AVX2 inline int32_t DotS8Avx2(const int8_t *query, const int8_t *row, size_t dim) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= dim; i += 32) {
+        __m256i q = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(query + i));
+        acc = MulAddS8Avx2(acc, _mm256_abs_epi8(q), q, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i)));
+    }
+    return HorizontalSumS32x8(acc) + DotS8Scalar(query + i, row + i, dim - i);
+}
+
+ISF_TARGET_AVX2 inline void Dot4S8Avx2(const int8_t *query, const int8_t *r0, const int8_t *r1, const int8_t *r2, const int8_t *r3, size_t dim,
+                                       int32_t *out) {
+    __m256i a0 = _mm256_setzero_si256(), a1 = _mm256_setzero_si256(), a2 = _mm256_setzero_si256(), a3 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= dim; i += 32) {
+        __m256i q = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(query + i));
+        __m256i abs_q = _mm256_abs_epi8(q);
+        a0 = MulAddS8Avx2(a0, abs_q, q, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(r0 + i)));
+        a1 = MulAddS8Avx2(a1, abs_q, q, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(r1 + i)));
+        a2 = MulAddS8Avx2(a2, abs_q, q, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(r2 + i)));
+        a3 = MulAddS8Avx2(a3, abs_q, q, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(r3 + i)));
+    }
+    out[0] = HorizontalSumS32x8(a0) + DotS8Scalar(query + i, r0 + i, dim - i);
+    out[1] = HorizontalSumS32x8(a1) + DotS8Scalar(query + i, r1 + i, dim - i);
+    out[2] = HorizontalSumS32x8(a2) + DotS8Scalar(query + i, r2 + i, dim - i);
+    out[3] = HorizontalSumS32x8(a3) + DotS8Scalar(query + i, r3 + i, dim - i);
+}
+
+ISF_DEFINE_QUANT_ROWS(DotRowsS8Avx2, int8_t, int8_t, int32_t, DotS8Avx2, Dot4S8Avx2, ISF_TARGET_AVX2)
+
+ISF_TARGET_AVX2_F16C inline __m256 LoadF16x8(const uint16_t *src) {
+    return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src)));
+}
+
+ISF_TARGET_AVX2_F16C inline float DotF16Avx2(const float *query, const uint16_t *row, size_t dim) {
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= dim; i += 8) {
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(query + i), LoadF16x8(row + i), acc);
+    }
+    return HorizontalSum256(acc) + DotF16Scalar(query + i, row + i, dim - i);
+}
+
+ISF_TARGET_AVX2_F16C inline void Dot4F16Avx2(const float *query, const uint16_t *r0, const uint16_t *r1, const uint16_t *r2, const uint16_t *r3,
+                                             size_t dim, float *out) {
+    __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps(), a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= dim; i += 8) {
+        __m256 q = _mm256_loadu_ps(query + i);
+        a0 = _mm256_fmadd_ps(q, LoadF16x8(r0 + i), a0);
+        a1 = _mm256_fmadd_ps(q, LoadF16x8(r1 + i), a1);
+        a2 = _mm256_fmadd_ps(q, LoadF16x8(r2 + i), a2);
+        a3 = _mm256_fmadd_ps(q, LoadF16x8(r3 + i), a3);
+    }
+    out[0] = HorizontalSum256(a0) + DotF16Scalar(query + i, r0 + i, dim - i);
+    out[1] = HorizontalSum256(a1) + DotF16Scalar(query + i, r1 + i, dim - i);
+    out[2] = HorizontalSum256(a2) + DotF16Scalar(query + i, r2 + i, dim - i);
+    out[3] = HorizontalSum256(a3) + DotF16Scalar(query + i, r3 + i, dim - i);
+}
+
+ISF_DEFINE_QUANT_ROWS(DotRowsF16Avx2, float, uint16_t, float, DotF16Avx2, Dot4F16Avx2, ISF_TARGET_AVX2_F16C)
+
+#endif  // AVX2
+
+#if defined(ISF_SIMD_X86_DISPATCH) || (defined(__AVX512VNNI__) && defined(__AVX512BW__))
+#define ISF_SIMD_HAS_AVX512_VNNI
+
+ISF_TARGET_AVX512_VNNI inline int32_t HorizontalSumS32x16(__m512i v) {
+    alignas(64) int32_t lanes[16];
+    _mm512_store_si512(lanes, v);
+    int32_t sum = 0;
+    for (int i = 0; i < 16; ++i) {
+        sum += lanes[i];
+    }
+    return sum;
+}
+
+// dpbusd multiplies unsigned by signed bytes, the sign of the query is moved onto the row
+// with a masked negation since AVX-512 has no byte sign instruction
+ISF_TARGET_AVX512_VNNI inline __m512i MulAddS8Vnni(__m512i acc, __m512i abs_query, __mmask64 negative, __m512i row) {
+    return _mm512_dpbusd_epi32(acc, abs_query, _mm512_mask_sub_epi8(row, negative, _mm512_setzero_si512(), row));
+}
+
+ISF_TARGET_AVX512_VNNI inline int32_t DotS8Vnni(const int8_t *query, const int8_t *row, size_t dim) {
+    __m512i acc = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 64 <= dim; i += 64) {
+        __m512i q = _mm512_loadu_si512(query + i);
+        acc = MulAddS8Vnni(acc, _mm512_abs_epi8(q), _mm512_movepi8_mask(q), _mm512_loadu_si512(row + i));
+    }
+    return HorizontalSumS32x16(acc) + DotS8Scalar(query + i, row + i, dim - i);
+}
+
+ISF_TARGET_AVX512_VNNI inline void Dot4S8Vnni(const int8_t *query, const int8_t *r0, const int8_t *r1, const int8_t *r2, const int8_t *r3,
+                                              size_t dim, int32_t *out) {
+    __m512i a0 = _mm512_setzero_si512(), a1 = _mm512_setzero_si512(), a2 = _mm512_setzero_si512(), a3 = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 64 <= dim; i += 64) {
+        __m512i q = _mm512_loadu_si512(query + i);
+        __m512i abs_q = _mm512_abs_epi8(q);
+        __mmask64 negative = _mm512_movepi8_mask(q);
+        a0 = MulAddS8Vnni(a0, abs_q, negative, _mm512_loadu_si512(r0 + i));
+        a1 = MulAddS8Vnni(a1, abs_q, negative, _mm512_loadu_si512(r1 + i));
+        a2 = MulAddS8Vnni(a2, abs_q, negative, _mm512_loadu_si512(r2 + i));
+        a3 = MulAddS8Vnni(a3, abs_q, negative, _mm512_loadu_si512(r3 + i));
+    }
+    out[0] = HorizontalSumS32x16(a0) + DotS8Scalar(query + i, r0 + i, dim - i);
+    out[1] = HorizontalSumS32x16(a1) + DotS8Scalar(query + i, r1 + i, dim - i);
+    out[2] = HorizontalSumS32x16(a2) + DotS8Scalar(query + i, r2 + i, dim - i);
+    out[3] = HorizontalSumS32x16(a3) + DotS8Scalar(query + i, r3 + i, dim - i);
+}
+
+ISF_DEFINE_QUANT_ROWS(DotRowsS8Vnni, int8_t, int8_t, int32_t, DotS8Vnni, Dot4S8Vnni, ISF_TARGET_AVX512_VNNI)
+
+#endif  // AVX512 VNNI
+
+#if defined(ISF_SIMD_HAS_AVX512)
+
+ISF_TARGET_AVX512 inline __m512 LoadF16x16(const uint16_t *src) {
+    // The zero-masked form avoids an undefined source operand that upsets some GCC versions
+    return _mm512_maskz_cvtph_ps(0xffff, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src)));
+}
+
+ISF_TARGET_AVX512 inline float DotF16Avx512(const float *query, const uint16_t *row, size_t dim) {
+    __m512 acc = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= dim; i += 16) {
+        acc = _mm512_fmadd_ps(_mm512_loadu_ps(query + i), LoadF16x16(row + i), acc);
+    }
+    return HorizontalSum512(acc) + DotF16Scalar(query + i, row + i, dim - i);
+}
+
+ISF_TARGET_AVX512 inline void Dot4F16Avx512(const float *query, const uint16_t *r0, const uint16_t *r1, const uint16_t *r2, const uint16_t *r3,
+                                            size_t dim, float *out) {
+    __m512 a0 = _mm512_setzero_ps(), a1 = _mm512_setzero_ps(), a2 = _mm512_setzero_ps(), a3 = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= dim; i += 16) {
+        __m512 q = _mm512_loadu_ps(query + i);
+        a0 = _mm512_fmadd_ps(q, LoadF16x16(r0 + i), a0);
+        a1 = _mm512_fmadd_ps(q, LoadF16x16(r1 + i), a1);
+        a2 = _mm512_fmadd_ps(q, LoadF16x16(r2 + i), a2);
+        a3 = _mm512_fmadd_ps(q, LoadF16x16(r3 + i), a3);
+    }
+    out[0] = HorizontalSum512(a0) + DotF16Scalar(query + i, r0 + i, dim - i);
+    out[1] = HorizontalSum512(a1) + DotF16Scalar(query + i, r1 + i, dim - i);
+    out[2] = HorizontalSum512(a2) + DotF16Scalar(query + i, r2 + i, dim - i);
+    out[3] = HorizontalSum512(a3) + DotF16Scalar(query + i, r3 + i, dim - i);
+}
+
+ISF_DEFINE_QUANT_ROWS(DotRowsF16Avx512, float, uint16_t, float, DotF16Avx512, Dot4F16Avx512, ISF_TARGET_AVX512)
+
+#endif  // AVX512
+
+#if defined(ISF_SIMD_NEON)
+
+#if defined(__aarch64__)
+inline int32_t HorizontalSumS32Neon(int32x4_t v) {
+    return vaddvq_s32(v);
+}
+#else
+inline int32_t HorizontalSumS32Neon(int32x4_t v) {
+    int32x2_t s = vadd_s32(vget_low_s32(v), vget_high_s32(v));
+    return vget_lane_s32(vpadd_s32(s, s), 0);
+}
+#endif
+
+inline int32x4_t MulAddS8Neon(int32x4_t acc, int8x16_t query, int8x16_t row) {
+#if defined(__ARM_FEATURE_DOTPROD)
+    return vdotq_s32(acc, query, row);
+#else
+    int16x8_t pairs = vmull_s8(vget_low_s8(query), vget_low_s8(row));
+    pairs = vmlal_s8(pairs, vget_high_s8(query), vget_high_s8(row));
+    return vpadalq_s16(acc, pairs);
+#endif
+}
+
+inline int32_t DotS8Neon(const int8_t *query, const int8_t *row, size_t dim) {
+    int32x4_t acc = vdupq_n_s32(0);
+    size_t i = 0;
+    for (; i + 16 <= dim; i += 16) {
+        acc = MulAddS8Neon(acc, vld1q_s8(query + i), vld1q_s8(row + i));
+    }
+    return HorizontalSumS32Neon(acc) + DotS8Scalar(query + i, row + i, dim - i);
+}
+
+inline void Dot4S8Neon(const int8_t *query, const int8_t *r0, const int8_t *r1, const int8_t *r2, const int8_t *r3, size_t dim, int32_t *out) {
+    int32x4_t a0 = vdupq_n_s32(0), a1 = vdupq_n_s32(0), a2 = vdupq_n_s32(0), a3 = vdupq_n_s32(0);
+    size_t i = 0;
+    for (; i + 16 <= dim; i += 16) {
+        int8x16_t q = vld1q_s8(query + i);
+        a0 = MulAddS8Neon(a0, q, vld1q_s8(r0 + i));
+        a1 = MulAddS8Neon(a1, q, vld1q_s8(r1 + i));
+        a2 = MulAddS8Neon(a2, q, vld1q_s8(r2 + i));
+        a3 = MulAddS8Neon(a3, q, vld1q_s8(r3 + i));
+    }
+    out[0] = HorizontalSumS32Neon(a0) + DotS8Scalar(query + i, r0 + i, dim - i);
+    out[1] = HorizontalSumS32Neon(a1) + DotS8Scalar(query + i, r1 + i, dim - i);
+    out[2] = HorizontalSumS32Neon(a2) + DotS8Scalar(query + i, r2 + i, dim - i);
+    out[3] = HorizontalSumS32Neon(a3) + DotS8Scalar(query + i, r3 + i, dim - i);
+}
+
+ISF_DEFINE_QUANT_ROWS(DotRowsS8Neon, int8_t, int8_t, int32_t, DotS8Neon, Dot4S8Neon, )
+
+#if defined(__aarch64__)
+#define ISF_SIMD_HAS_NEON_F16
+
+inline float32x4_t LoadF16x4(const uint16_t *src) {
+    return vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src)));
+}
+
+inline float DotF16Neon(const float *query, const uint16_t *row, size_t dim) {
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 4 <= dim; i += 4) {
+        acc = MulAddNeon(acc, vld1q_f32(query + i), LoadF16x4(row + i));
+    }
+    return HorizontalSumNeon(acc) + DotF16Scalar(query + i, row + i, dim - i);
+}
+
+inline void Dot4F16Neon(const float *query, const uint16_t *r0, const uint16_t *r1, const uint16_t *r2, const uint16_t *r3, size_t dim,
+                        float *out) {
+    float32x4_t a0 = vdupq_n_f32(0.0f), a1 = vdupq_n_f32(0.0f), a2 = vdupq_n_f32(0.0f), a3 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 4 <= dim; i += 4) {
+        float32x4_t q = vld1q_f32(query + i);
+        a0 = MulAddNeon(a0, q, LoadF16x4(r0 + i));
+        a1 = MulAddNeon(a1, q, LoadF16x4(r1 + i));
+        a2 = MulAddNeon(a2, q, LoadF16x4(r2 + i));
+        a3 = MulAddNeon(a3, q, LoadF16x4(r3 + i));
+    }
+    out[0] = HorizontalSumNeon(a0) + DotF16Scalar(query + i, r0 + i, dim - i);
+    out[1] = HorizontalSumNeon(a1) + DotF16Scalar(query + i, r1 + i, dim - i);
+    out[2] = HorizontalSumNeon(a2) + DotF16Scalar(query + i, r2 + i, dim - i);
+    out[3] = HorizontalSumNeon(a3) + DotF16Scalar(query + i, r3 + i, dim - i);
+}
+
+ISF_DEFINE_QUANT_ROWS(DotRowsF16Neon, float, uint16_t, float, DotF16Neon, Dot4F16Neon, )
+#endif  // __aarch64__
+
+#endif  // NEON
+
+QuantDotKernel SelectQuantDotKernel() {
+    QuantDotKernel kernel = {DotRowsS8Scalar, DotRowsF16Scalar, "Scalar"};
+#if defined(ISF_SIMD_X86_DISPATCH)
+    __builtin_cpu_init();
+    bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    if (__builtin_cpu_supports("avx512vnni") && __builtin_cpu_supports("avx512bw")) {
+        kernel.rows_s8 = DotRowsS8Vnni;
+        kernel.name_s8 = "AVX-512 VNNI";
+    } else if (avx2) {
+        kernel.rows_s8 = DotRowsS8Avx2;
+        kernel.name_s8 = "AVX2";
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        kernel.rows_f16 = DotRowsF16Avx512;
+    } else if (avx2 && __builtin_cpu_supports("f16c")) {
+        kernel.rows_f16 = DotRowsF16Avx2;
+    }
+#elif defined(ISF_SIMD_X86_STATIC)
+#if defined(ISF_SIMD_HAS_AVX512_VNNI)
+    kernel.rows_s8 = DotRowsS8Vnni;
+    kernel.name_s8 = "AVX-512 VNNI";
+#elif defined(ISF_SIMD_HAS_AVX2)
+    kernel.rows_s8 = DotRowsS8Avx2;
+    kernel.name_s8 = "AVX2";
+#endif
+#if defined(ISF_SIMD_HAS_AVX512)
+    kernel.rows_f16 = DotRowsF16Avx512;
+#elif defined(ISF_SIMD_HAS_AVX2)
+    kernel.rows_f16 = DotRowsF16Avx2;
+#endif
+#elif defined(ISF_SIMD_NEON)
+    kernel.rows_s8 = DotRowsS8Neon;
+#if defined(__ARM_FEATURE_DOTPROD)
+    kernel.name_s8 = "NEON dot-product";
+#else
+    kernel.name_s8 = "NEON";
+#endif
+#if defined(ISF_SIMD_HAS_NEON_F16)
+    kernel.rows_f16 = DotRowsF16Neon;
+#endif
+#endif
+    return kernel;
+}
+
+const QuantDotKernel &GetQuantDotKernel() {
+    static const QuantDotKernel kernel = SelectQuantDotKernel();
+    return kernel;
+}
+
+}  // namespace
+
+void simd_dot_rows(const float *query, const float *matrix, size_t rows, size_t stride, size_t dim, float *out) {
+    GetDotRowsKernel().rows(query, matrix, rows, stride, dim, out);
+}
+
+void simd_dot_gather(const float *query, const float *const *rows, size_t count, size_t dim, float *out) {
+    GetDotRowsKernel().gather(query, rows, count, dim, out);
+}
+
+const char *simd_dot_rows_kernel_name() {
+    return GetDotRowsKernel().name;
+}
+
+void simd_dot_rows_s8(const int8_t *query, const int8_t *matrix, size_t rows, size_t stride, size_t dim, int32_t *out) {
+    GetQuantDotKernel().rows_s8(query, matrix, rows, stride, dim, out);
+}
+
+void simd_dot_rows_f16(const float *query, const uint16_t *matrix, size_t rows, size_t stride, size_t dim, float *out) {
+    GetQuantDotKernel().rows_f16(query, matrix, rows, stride, dim, out);
+}
+
+const char *simd_dot_rows_s8_kernel_name() {
+    return GetQuantDotKernel().name_s8;
+}
+
+uint16_t simd_float_to_half(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+    uint32_t abs = bits & 0x7fffffffu;
+    if (abs >= 0x7f800000u) {
+        // Infinity stays infinity, NaN stays a quiet NaN
+        return sign | 0x7c00u | (abs > 0x7f800000u ? 0x0200u : 0u);
+    }
+    if (abs >= 0x477ff000u) {
+        // Rounds above the largest finite half
+        return sign | 0x7c00u;
+    }
+    if (abs < 0x38800000u) {
+        // Below the smallest normal half, the result is subnormal or zero
+        if (abs < 0x33000000u) {
+            return sign;
+        }
+        uint32_t exponent = abs >> 23;
+        uint32_t mantissa = (abs & 0x007fffffu) | 0x00800000u;
+        uint32_t shift = 126u - exponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1u);
+        uint32_t midpoint = 1u << (shift - 1u);
+        if (rest > midpoint || (rest == midpoint && (half & 1u))) {
+            ++half;
+        }
+        return sign | static_cast<uint16_t>(half);
+    }
+    // Rebias the exponent from 127 to 15 and round the dropped 13 mantissa bits, a carry
+    // into the exponent is the correctly rounded result
+    uint32_t half = (abs - 0x38000000u) >> 13;
+    uint32_t rest = abs & 0x1fffu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) {
+        ++half;
+    }
+    return sign | static_cast<uint16_t>(half);
+}
+
+float simd_half_to_float(uint16_t value) {
+    uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+    uint32_t exponent = (value >> 10) & 0x1fu;
+    uint32_t mantissa = value & 0x03ffu;
+    uint32_t bits;
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        } else {
+            // Subnormal half, normalize it for the wider float exponent
+            exponent = 113;
+            while ((mantissa & 0x0400u) == 0) {
+                mantissa <<= 1;
+                --exponent;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x03ffu) << 13);
+        }
+    } else if (exponent == 0x1f) {
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
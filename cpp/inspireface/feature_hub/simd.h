@@ -1,4 +1,8 @@
+#ifndef INSPIRE_FEATURE_HUB_SIMD_H
+#define INSPIRE_FEATURE_HUB_SIMD_H
+
 #include <cstdint>
+#include <cstddef>
 
 #if defined(_MSC_VER)
 /* Microsoft C/C++-compatible compiler */
@@ -6,7 +10,7 @@
 #elif (defined(__x86_64__) || defined(__i386__))
 /* GCC-compatible compiler, targeting x86/x86-64 */
 #include <x86intrin.h>
-#elif defined(__ARM_NEON__)
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
 /* GCC-compatible compiler, targeting ARM with NEON */
 #include <arm_neon.h>
 #endif
@@ -35,7 +39,7 @@ inline float simd_dot(const float *x, const float *y, const long &len) {
     }
     return inner_prod;
 }
-#elif defined(__ARM_NEON__)
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
 inline float simd_dot(const float *x, const float *y, const long &len) {
     // #pragma message("USE NEON")
     float inner_prod = 0.0f;
@@ -63,4 +67,74 @@ inline float simd_dot(const float *x, const float *y, const long &len) {
     }
     return inner_prod;
 }
-#endif
\ No newline at end of file
+#endif
+
+/**
+ * @brief Computes the dot product of one query against a block of consecutive matrix rows.
+ * @details The best kernel available on the running CPU is selected on first use
+ * (AVX-512 / AVX2+FMA / SSE on x86, NEON on ARM, scalar otherwise).
+ * @param query Query vector, at least dim elements.
+ * @param matrix First row of the row-major matrix.
+ * @param rows Number of rows to process.
+ * @param stride Distance in floats between the starts of two consecutive rows.
+ * @param dim Number of elements to accumulate per row.
+ * @param out Output array receiving rows scores.
+ */
+void simd_dot_rows(const float *query, const float *matrix, size_t rows, size_t stride, size_t dim, float *out);
+
+/**
+ * @brief Computes the dot product of one query against a list of rows scattered in memory.
+ * @details Uses the same kernel as simd_dot_rows, meant for graph indexes that visit neighbours out of order.
+ * @param query Query vector, at least dim elements.
+ * @param rows Pointers to the rows to score.
+ * @param count Number of rows.
+ * @param dim Number of elements to accumulate per row.
+ * @param out Output array receiving count scores.
+ */
+void simd_dot_gather(const float *query, const float *const *rows, size_t count, size_t dim, float *out);
+
+/**
+ * @brief Returns the name of the kernel selected by simd_dot_rows, for logs and benchmarks.
+ */
+const char *simd_dot_rows_kernel_name();
+
+/**
+ * @brief Computes the int8 dot product of one quantized query against a block of consecutive rows.
+ * @details Values must lie in [-127, 127]. The kernel is selected on first use
+ * (AVX-512 VNNI / AVX2 on x86, NEON dot-product on ARM, scalar otherwise).
+ * @param query Quantized query vector, at least dim elements.
+ * @param matrix First row of the row-major int8 matrix.
+ * @param rows Number of rows to process.
+ * @param stride Distance in bytes between the starts of two consecutive rows.
+ * @param dim Number of elements to accumulate per row.
+ * @param out Output array receiving rows integer scores.
+ */
+void simd_dot_rows_s8(const int8_t *query, const int8_t *matrix, size_t rows, size_t stride, size_t dim, int32_t *out);
+
+/**
+ * @brief Computes the dot product of a float query against a block of consecutive half-precision rows.
+ * @param query Query vector, at least dim elements.
+ * @param matrix First row of the row-major matrix of IEEE 754 binary16 values.
+ * @param rows Number of rows to process.
+ * @param stride Distance in elements between the starts of two consecutive rows.
+ * @param dim Number of elements to accumulate per row.
+ * @param out Output array receiving rows scores.
+ */
+void simd_dot_rows_f16(const float *query, const uint16_t *matrix, size_t rows, size_t stride, size_t dim, float *out);
+
+/**
+ * @brief Returns the name of the kernel selected by simd_dot_rows_s8, for logs and benchmarks.
+ */
+const char *simd_dot_rows_s8_kernel_name();
+
+/**
+ * @brief Converts a float to IEEE 754 binary16, rounding to nearest even.
+ */
+uint16_t simd_float_to_half(float value);
+
+/**
+ * @brief Converts an IEEE 754 binary16 value to float.
+ */
+float simd_half_to_float(uint16_t value);
+
+#endif  // INSPIRE_FEATURE_HUB_SIMD_H
@@ -1,10 +1,216 @@
 #include "frame_process.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <MNN/ImageProcess.hpp>
 #include "isf_check.h"
+#include "middleware/thread/thread_pool.h"
+#include "yuv_kernels.h"
 
 namespace inspirecv {
 
+namespace {
+
+/**
+ * @brief Configured ImageProcess objects shared by every FrameProcess of the process.
+ * @details Creating an ImageProcess selects its samplers and allocates its line buffers, and it used to happen for
+ * every crop. A caller takes one for the duration of a conversion and gives it back, so concurrent callers never
+ * share one.
+ */
+class ImageProcessCache {
+public:
+    using ProcessPtr = std::unique_ptr<MNN::CV::ImageProcess>;
+
+    // Idle processes kept per configuration, enough for the tracking threads
+    static const size_t kMaxIdlePerConfig = 16;
+
+    static ImageProcessCache &GetInstance() {
+        static ImageProcessCache instance;
+        return instance;
+    }
+
+    ProcessPtr Acquire(const MNN::CV::ImageProcess::Config &config) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto &idle = idle_[Key(config)];
+            if (!idle.empty()) {
+                ProcessPtr process = std::move(idle.back());
+                idle.pop_back();
+                return process;
+            }
+        }
+        return ProcessPtr(MNN::CV::ImageProcess::create(config));
+    }
+
+    void Release(const MNN::CV::ImageProcess::Config &config, ProcessPtr process) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto &idle = idle_[Key(config)];
+        if (idle.size() < kMaxIdlePerConfig) {
+            idle.push_back(std::move(process));
+        }
+    }
+
+private:
+    // FrameProcess only sets the formats, the filter and the wrap of the configuration
+    static uint32_t Key(const MNN::CV::ImageProcess::Config &config) {
+        return static_cast<uint32_t>(config.sourceFormat) | (static_cast<uint32_t>(config.destFormat) << 8) |
+               (static_cast<uint32_t>(config.filterType) << 16) | (static_cast<uint32_t>(config.wrap) << 24);
+    }
+
+    std::mutex mutex_;
+    std::unordered_map<uint32_t, std::vector<ProcessPtr>> idle_;
+};
+
+/**
+ * @brief An ImageProcess taken from the cache, given back when it goes out of scope.
+ */
+class ImageProcessLease {
+public:
+    explicit ImageProcessLease(const MNN::CV::ImageProcess::Config &config)
+    : config_(config), process_(ImageProcessCache::GetInstance().Acquire(config)) {}
+
+    ~ImageProcessLease() {
+        if (process_ != nullptr) {
+            ImageProcessCache::GetInstance().Release(config_, std::move(process_));
+        }
+    }
+
+    ImageProcessLease(const ImageProcessLease &) = delete;
+    ImageProcessLease &operator=(const ImageProcessLease &) = delete;
+
+    MNN::CV::ImageProcess *operator->() const {
+        return process_.get();
+    }
+
+private:
+    MNN::CV::ImageProcess::Config config_;
+    ImageProcessCache::ProcessPtr process_;
+};
+
+// Converts the frame into a packed 3-channel image of width_out by height_out pixels at dst
+void ConvertFrame(ImageProcessLease &process, const uint8_t *buffer, int width, int height, uint8_t *dst, int width_out, int height_out) {
+    auto ret = process->convert(buffer, width, height, 0, dst, width_out, height_out, 3, 0, halide_type_of<uint8_t>());
+    INSPIREFACE_CHECK_MSG(ret == MNN::ErrorCode::NO_ERROR, "ImageProcess::convert failed");
+}
+
+// Side of the frame tiles converted for the batched crops, even so that the chroma pairs stay together
+const int kBatchTileSize = 32;
+// Crop rows sampled by a thread at once
+const int kBatchCropRows = 16;
+
+// Threads shared by the batched crops, created on first use
+inspire::parallel::ThreadPool &BatchCropPool() {
+    static inspire::parallel::ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+// Calls function(i) for every i in [0, count), split in contiguous ranges over up to num_threads threads
+template <typename Function>
+void BatchParallelFor(size_t count, int num_threads, Function &&function) {
+    const size_t ranges = std::min(count, static_cast<size_t>(std::max(num_threads, 1)));
+    if (ranges <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            function(i);
+        }
+        return;
+    }
+    BatchCropPool().ParallelFor(ranges, [&](size_t r) {
+        for (size_t i = r * count / ranges; i < (r + 1) * count / ranges; ++i) {
+            function(i);
+        }
+    });
+}
+
+// Converts the pixels [x0, x1) x [y0, y1) of a YUV 4:2:0 semi-planar frame to BGR at dst, x0 being even
+void ConvertYUV420SPToBGR(const uint8_t *frame, int width, int height, bool nv21, int x0, int y0, int x1, int y1, uint8_t *dst, size_t dst_stride) {
+    const uint8_t *uv_plane = frame + static_cast<size_t>(width) * height;
+    for (int y = y0; y < y1; ++y) {
+        const uint8_t *y_row = frame + static_cast<size_t>(y) * width;
+        const uint8_t *uv_row = uv_plane + static_cast<size_t>(y / 2) * width;
+        inspire::YUV420SPToBGRRow(y_row + x0, uv_row + x0, x1 - x0, nv21, dst + static_cast<size_t>(y - y0) * dst_stride);
+    }
+}
+
+// Packed pixels the batched crops are sampled from
+struct BatchSource {
+    const uint8_t *data;  // Pixel (origin_x, origin_y) of the frame
+    size_t stride;        // Bytes per row
+    int channels;         // Bytes per pixel
+    int blue;             // Offset of the blue channel in a pixel
+    int green;            // Offset of the green channel in a pixel
+    int red;              // Offset of the red channel in a pixel
+    int origin_x;
+    int origin_y;
+    int width;   // Width of the frame
+    int height;  // Height of the frame
+};
+
+// A crop of the batch, with the frame region it reads
+struct BatchCrop {
+    float matrix[6];  // Maps the crop pixels to the frame
+    int x0, y0, x1, y1;
+    uint8_t *dst;
+    int width_out;
+    int height_out;
+    bool rgb;
+};
+
+// Buffers of the batched crops, kept by each calling thread
+struct BatchScratch {
+    std::vector<BatchCrop> crops;
+    std::vector<uint8_t> tiles;                   // Whether each tile of the region is under a crop
+    std::vector<uint8_t> converted;               // BGR pixels of the region
+    std::vector<std::pair<size_t, int>> bands;    // Crop and first row of each band of rows
+};
+
+BatchScratch &LocalBatchScratch() {
+    static thread_local BatchScratch scratch;
+    return scratch;
+}
+
+// Samples the rows [row_begin, row_end) of a crop with bilinear interpolation, the pixels falling outside the frame are zero
+void SampleCropRows(const BatchSource &src, const BatchCrop &crop, int row_begin, int row_end) {
+    const float *m = crop.matrix;
+    const float max_x = static_cast<float>(src.width - 1);
+    const float max_y = static_cast<float>(src.height - 1);
+    const int dst_blue = crop.rgb ? 2 : 0;
+    const int dst_red = crop.rgb ? 0 : 2;
+    for (int y = row_begin; y < row_end; ++y) {
+        uint8_t *out = crop.dst + static_cast<size_t>(y) * crop.width_out * 3;
+        for (int x = 0; x < crop.width_out; ++x, out += 3) {
+            const float sx = m[0] * x + m[1] * y + m[2];
+            const float sy = m[3] * x + m[4] * y + m[5];
+            if (!(sx >= 0.0f && sy >= 0.0f && sx <= max_x && sy <= max_y)) {
+                out[0] = out[1] = out[2] = 0;
+                continue;
+            }
+            const int ix = static_cast<int>(sx);
+            const int iy = static_cast<int>(sy);
+            // 8-bit weights, the neighbours past the last row or column are the edge pixels
+            const int wx = static_cast<int>((sx - ix) * 256.0f + 0.5f);
+            const int wy = static_cast<int>((sy - iy) * 256.0f + 0.5f);
+            const int dx = ix < src.width - 1 ? src.channels : 0;
+            const size_t dy = iy < src.height - 1 ? src.stride : 0;
+            const uint8_t *p = src.data + static_cast<size_t>(iy - src.origin_y) * src.stride + static_cast<size_t>(ix - src.origin_x) * src.channels;
+            auto sample = [&](int c) {
+                const int top = p[c] * (256 - wx) + p[dx + c] * wx;
+                const int bottom = p[dy + c] * (256 - wx) + p[dy + dx + c] * wx;
+                return static_cast<uint8_t>((top * (256 - wy) + bottom * wy + 32768) >> 16);
+            };
+            out[dst_blue] = sample(src.blue);
+            out[1] = sample(src.green);
+            out[dst_red] = sample(src.red);
+        }
+    }
+}
+
+}  // namespace
+
 class FrameProcess::Impl {
 public:
     Impl() : buffer_(nullptr), height_(0), width_(0), preview_scale_(0), preview_size_(192), rotation_mode_(ROTATION_0) {
@@ -56,6 +262,28 @@ public:
         }
     }
 
+    // Whether the frame is converted by the YUV kernels rather than by MNN
+    bool UseYUVKernels() const {
+        return (config_.sourceFormat == MNN::CV::YUV_NV21 || config_.sourceFormat == MNN::CV::YUV_NV12) &&
+               (config_.destFormat == MNN::CV::BGR || config_.destFormat == MNN::CV::RGB);
+    }
+
+    // Fills the packed 3-channel image at dst, the matrix maps its pixels to the frame
+    void Convert(const MNN::CV::Matrix &matrix, uint8_t *dst, int width_out, int height_out) const {
+        if (UseYUVKernels()) {
+            float m[6];
+            for (int k = 0; k < 6; ++k) {
+                m[k] = matrix[k];
+            }
+            inspire::YUV420SPAffineToBGR(buffer_, width_, height_, config_.sourceFormat == MNN::CV::YUV_NV21, m, dst, width_out, 0, height_out,
+                                         config_.destFormat == MNN::CV::RGB);
+            return;
+        }
+        ImageProcessLease process(config_);
+        process->setMatrix(matrix);
+        ConvertFrame(process, buffer_, width_, height_, dst, width_out, height_out);
+    }
+
     void UpdateTransformMatrix() {
         float srcPoints[] = {0.0f, 0.0f, 0.0f, (float)(height_ - 1), (float)(width_ - 1), 0.0f, (float)(width_ - 1), (float)(height_ - 1)};
 
@@ -208,23 +436,156 @@ ROTATION_MODE FrameProcess::getRotationMode() const {
 
 inspirecv::Image FrameProcess::ExecuteImageAffineProcessing(inspirecv::TransformMatrix &affine_matrix, const int width_out,
                                                             const int height_out) const {
-    int sw = pImpl->width_;
-    int sh = pImpl->height_;
-    int rot_sw = sw;
-    int rot_sh = sh;
+    inspirecv::Image img_out;
+    ExecuteImageAffineProcessing(affine_matrix, width_out, height_out, img_out);
+    return img_out;
+}
+
+void FrameProcess::ExecuteImageAffineProcessing(inspirecv::TransformMatrix &affine_matrix, const int width_out, const int height_out,
+                                                inspirecv::Image &img_out) const {
     MNN::CV::Matrix tr;
-    std::vector<float> tr_cv({1, 0, 0, 0, 1, 0, 0, 0, 1});
-    memcpy(tr_cv.data(), affine_matrix.Squeeze().data(), sizeof(float) * 6);
-    tr.set9(tr_cv.data());
+    float tr_cv[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+    memcpy(tr_cv, affine_matrix.Squeeze().data(), sizeof(float) * 6);
+    tr.set9(tr_cv);
     MNN::CV::Matrix tr_inv;
     tr.invert(&tr_inv);
-    std::shared_ptr<MNN::CV::ImageProcess> process(MNN::CV::ImageProcess::create(pImpl->config_));
-    process->setMatrix(tr_inv);
-    auto img_out = inspirecv::Image::Create(width_out, height_out, 3);
-    std::shared_ptr<MNN::Tensor> tensor(MNN::Tensor::create<uint8_t>(std::vector<int>{1, height_out, width_out, 3}, (uint8_t *)img_out.Data()));
-    auto ret = process->convert(pImpl->buffer_, sw, sh, 0, tensor.get());
-    INSPIREFACE_CHECK_MSG(ret == MNN::ErrorCode::NO_ERROR, "ImageProcess::convert failed");
-    return img_out;
+    if (img_out.Width() != width_out || img_out.Height() != height_out || img_out.Channels() != 3) {
+        img_out = inspirecv::Image::Create(width_out, height_out, 3);
+    }
+    pImpl->Convert(tr_inv, const_cast<uint8_t *>(img_out.Data()), width_out, height_out);
+}
+
+void FrameProcess::ExecuteImageAffineBatchProcessing(const std::vector<AffineCropRequest> &requests, int num_threads) const {
+    const int width = pImpl->width_;
+    const int height = pImpl->height_;
+    BatchScratch &scratch = LocalBatchScratch();
+    auto &crops = scratch.crops;
+    crops.clear();
+    // Union of the frame regions read by the crops
+    int region_x0 = width, region_y0 = height, region_x1 = 0, region_y1 = 0;
+    for (const auto &request : requests) {
+        INSPIREFACE_CHECK_MSG(request.image_out != nullptr, "The crop request has no output image");
+        INSPIREFACE_CHECK_MSG(request.format == BGR || request.format == RGB, "Batched crops are either BGR or RGB");
+        auto &img_out = *request.image_out;
+        if (img_out.Width() != request.width_out || img_out.Height() != request.height_out || img_out.Channels() != 3) {
+            img_out = inspirecv::Image::Create(request.width_out, request.height_out, 3);
+        }
+        auto affine_matrix = request.affine_matrix;
+        MNN::CV::Matrix tr;
+        float tr_cv[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+        memcpy(tr_cv, affine_matrix.Squeeze().data(), sizeof(float) * 6);
+        tr.set9(tr_cv);
+        MNN::CV::Matrix tr_inv;
+        tr.invert(&tr_inv);
+
+        BatchCrop crop;
+        for (int k = 0; k < 6; ++k) {
+            crop.matrix[k] = tr_inv[k];
+        }
+        crop.dst = const_cast<uint8_t *>(img_out.Data());
+        crop.width_out = request.width_out;
+        crop.height_out = request.height_out;
+        crop.rgb = request.format == RGB;
+        // The corners of the crop bound the pixels it reads, the bilinear neighbours included
+        float min_x = width, min_y = height, max_x = -1.0f, max_y = -1.0f;
+        const float corners[4][2] = {{0.0f, 0.0f},
+                                     {request.width_out - 1.0f, 0.0f},
+                                     {0.0f, request.height_out - 1.0f},
+                                     {request.width_out - 1.0f, request.height_out - 1.0f}};
+        for (const auto &corner : corners) {
+            const float sx = crop.matrix[0] * corner[0] + crop.matrix[1] * corner[1] + crop.matrix[2];
+            const float sy = crop.matrix[3] * corner[0] + crop.matrix[4] * corner[1] + crop.matrix[5];
+            min_x = std::min(min_x, sx);
+            min_y = std::min(min_y, sy);
+            max_x = std::max(max_x, sx);
+            max_y = std::max(max_y, sy);
+        }
+        crop.x0 = std::max(0, static_cast<int>(std::floor(min_x)));
+        crop.y0 = std::max(0, static_cast<int>(std::floor(min_y)));
+        crop.x1 = std::min(width, static_cast<int>(std::floor(max_x)) + 2);
+        crop.y1 = std::min(height, static_cast<int>(std::floor(max_y)) + 2);
+        if (crop.x0 < crop.x1 && crop.y0 < crop.y1) {
+            region_x0 = std::min(region_x0, crop.x0);
+            region_y0 = std::min(region_y0, crop.y0);
+            region_x1 = std::max(region_x1, crop.x1);
+            region_y1 = std::max(region_y1, crop.y1);
+        }
+        crops.push_back(crop);
+    }
+    if (crops.empty()) {
+        return;
+    }
+
+    BatchSource source;
+    const auto source_format = pImpl->config_.sourceFormat;
+    if (source_format == MNN::CV::YUV_NV21 || source_format == MNN::CV::YUV_NV12) {
+        source = {nullptr, 0, 3, 0, 1, 2, 0, 0, width, height};
+        if (region_x0 < region_x1 && region_y0 < region_y1) {
+            // Only the tiles under some crop are converted, each one once, from a chroma pair on
+            region_x0 &= ~1;
+            const int tiles_x = (region_x1 - region_x0 + kBatchTileSize - 1) / kBatchTileSize;
+            const int tiles_y = (region_y1 - region_y0 + kBatchTileSize - 1) / kBatchTileSize;
+            auto &tiles = scratch.tiles;
+            tiles.assign(static_cast<size_t>(tiles_x) * tiles_y, 0);
+            for (const auto &crop : crops) {
+                if (crop.x0 >= crop.x1 || crop.y0 >= crop.y1) {
+                    continue;
+                }
+                for (int ty = (crop.y0 - region_y0) / kBatchTileSize; ty <= (crop.y1 - 1 - region_y0) / kBatchTileSize; ++ty) {
+                    for (int tx = (crop.x0 - region_x0) / kBatchTileSize; tx <= (crop.x1 - 1 - region_x0) / kBatchTileSize; ++tx) {
+                        tiles[ty * tiles_x + tx] = 1;
+                    }
+                }
+            }
+            const size_t stride = static_cast<size_t>(region_x1 - region_x0) * 3;
+            auto &converted = scratch.converted;
+            if (converted.size() < stride * (region_y1 - region_y0)) {
+                converted.resize(stride * (region_y1 - region_y0));
+            }
+            uint8_t *region = converted.data();
+            const bool nv21 = source_format == MNN::CV::YUV_NV21;
+            const uint8_t *frame = pImpl->buffer_;
+            BatchParallelFor(tiles_y, num_threads, [&](size_t ty) {
+                const int y0 = region_y0 + static_cast<int>(ty) * kBatchTileSize;
+                const int y1 = std::min(y0 + kBatchTileSize, region_y1);
+                for (int tx = 0; tx < tiles_x; ++tx) {
+                    if (!tiles[ty * tiles_x + tx]) {
+                        continue;
+                    }
+                    const int x0 = region_x0 + tx * kBatchTileSize;
+                    const int x1 = std::min(x0 + kBatchTileSize, region_x1);
+                    ConvertYUV420SPToBGR(frame, width, height, nv21, x0, y0, x1, y1, region + (y0 - region_y0) * stride + (x0 - region_x0) * 3, stride);
+                }
+            });
+            source = {region, stride, 3, 0, 1, 2, region_x0, region_y0, width, height};
+        }
+    } else {
+        // Packed frames are sampled in place
+        const bool four_channels = source_format == MNN::CV::RGBA || source_format == MNN::CV::BGRA;
+        const bool rgb_order = source_format == MNN::CV::RGB || source_format == MNN::CV::RGBA;
+        const int channels = four_channels ? 4 : 3;
+        source = {pImpl->buffer_, static_cast<size_t>(width) * channels, channels, rgb_order ? 2 : 0, 1, rgb_order ? 0 : 2, 0, 0, width, height};
+    }
+
+    // Every crop is split in bands of rows, the bands of all the crops are shared by the threads
+    auto &bands = scratch.bands;
+    bands.clear();
+    for (size_t i = 0; i < crops.size(); ++i) {
+        for (int row = 0; row < crops[i].height_out; row += kBatchCropRows) {
+            bands.emplace_back(i, row);
+        }
+    }
+    BatchParallelFor(bands.size(), num_threads, [&](size_t b) {
+        const auto &crop = crops[bands[b].first];
+        const int row_begin = bands[b].second;
+        const int row_end = std::min(row_begin + kBatchCropRows, crop.height_out);
+        if (crop.x0 >= crop.x1 || crop.y0 >= crop.y1) {
+            // Entirely outside the frame
+            memset(crop.dst + static_cast<size_t>(row_begin) * crop.width_out * 3, 0, static_cast<size_t>(row_end - row_begin) * crop.width_out * 3);
+            return;
+        }
+        SampleCropRows(source, crop, row_begin, row_end);
+    });
 }
 
 inspirecv::Image FrameProcess::ExecutePreviewImageProcessing(bool with_rotation) {
@@ -232,12 +593,6 @@ inspirecv::Image FrameProcess::ExecutePreviewImageProcessing(bool with_rotation)
 }
 
 inspirecv::Image FrameProcess::ExecuteImageScaleProcessing(const float scale, bool with_rotation) {
-    int sw = pImpl->width_;
-    int sh = pImpl->height_;
-    int rot_sw = sw;
-    int rot_sh = sh;
-    // MNN::CV::Matrix tr;
-    std::shared_ptr<MNN::CV::ImageProcess> process(MNN::CV::ImageProcess::create(pImpl->config_));
     if (pImpl->rotation_mode_ == ROTATION_270 && with_rotation) {
         float srcPoints[] = {
           0.0f, 0.0f, 0.0f, (float)(pImpl->height_ - 1), (float)(pImpl->width_ - 1), 0.0f, (float)(pImpl->width_ - 1), (float)(pImpl->height_ - 1),
@@ -247,14 +602,10 @@ inspirecv::Image FrameProcess::ExecuteImageScaleProcessing(const float scale, bo
           (float)(pImpl->width_ * scale - 1)};
 
         pImpl->tr_.setPolyToPoly((MNN::CV::Point *)dstPoints, (MNN::CV::Point *)srcPoints, 4);
-        process->setMatrix(pImpl->tr_);
         int scaled_height = static_cast<int>(pImpl->width_ * scale);
         int scaled_width = static_cast<int>(pImpl->height_ * scale);
         inspirecv::Image img_out(scaled_width, scaled_height, 3);
-        std::shared_ptr<MNN::Tensor> tensor(
-          MNN::Tensor::create<uint8_t>(std::vector<int>{1, scaled_height, scaled_width, 3}, (uint8_t *)img_out.Data()));
-        auto ret = process->convert(pImpl->buffer_, sw, sh, 0, tensor.get());
-        INSPIREFACE_CHECK_MSG(ret == MNN::ErrorCode::NO_ERROR, "ImageProcess::convert failed");
+        pImpl->Convert(pImpl->tr_, const_cast<uint8_t *>(img_out.Data()), scaled_width, scaled_height);
         return img_out;
     } else if (pImpl->rotation_mode_ == ROTATION_90 && with_rotation) {
         float srcPoints[] = {
@@ -271,14 +622,10 @@ inspirecv::Image FrameProcess::ExecuteImageScaleProcessing(const float scale, bo
           0.0f,
         };
         pImpl->tr_.setPolyToPoly((MNN::CV::Point *)dstPoints, (MNN::CV::Point *)srcPoints, 4);
-        process->setMatrix(pImpl->tr_);
         int scaled_height = static_cast<int>(pImpl->width_ * scale);
         int scaled_width = static_cast<int>(pImpl->height_ * scale);
         inspirecv::Image img_out(scaled_width, scaled_height, 3);
-        std::shared_ptr<MNN::Tensor> tensor(
-          MNN::Tensor::create<uint8_t>(std::vector<int>{1, scaled_height, scaled_width, 3}, (uint8_t *)img_out.Data()));
-        auto ret = process->convert(pImpl->buffer_, sw, sh, 0, tensor.get());
-        INSPIREFACE_CHECK_MSG(ret == MNN::ErrorCode::NO_ERROR, "ImageProcess::convert failed");
+        pImpl->Convert(pImpl->tr_, const_cast<uint8_t *>(img_out.Data()), scaled_width, scaled_height);
         return img_out;
     } else if (pImpl->rotation_mode_ == ROTATION_180 && with_rotation) {
         float srcPoints[] = {
@@ -295,14 +642,10 @@ inspirecv::Image FrameProcess::ExecuteImageScaleProcessing(const float scale, bo
           0.0f,
         };
         pImpl->tr_.setPolyToPoly((MNN::CV::Point *)dstPoints, (MNN::CV::Point *)srcPoints, 4);
-        process->setMatrix(pImpl->tr_);
         int scaled_height = static_cast<int>(pImpl->height_ * scale);
         int scaled_width = static_cast<int>(pImpl->width_ * scale);
         inspirecv::Image img_out(scaled_width, scaled_height, 3);
-        std::shared_ptr<MNN::Tensor> tensor(
-          MNN::Tensor::create<uint8_t>(std::vector<int>{1, scaled_height, scaled_width, 3}, (uint8_t *)img_out.Data()));
-        auto ret = process->convert(pImpl->buffer_, sw, sh, 0, tensor.get());
-        INSPIREFACE_CHECK_MSG(ret == MNN::ErrorCode::NO_ERROR, "ImageProcess::convert failed");
+        pImpl->Convert(pImpl->tr_, const_cast<uint8_t *>(img_out.Data()), scaled_width, scaled_height);
         return img_out;
     } else {
         float srcPoints[] = {
@@ -319,15 +662,11 @@ inspirecv::Image FrameProcess::ExecuteImageScaleProcessing(const float scale, bo
           (float)(pImpl->height_ * scale - 1),
         };
         pImpl->tr_.setPolyToPoly((MNN::CV::Point *)dstPoints, (MNN::CV::Point *)srcPoints, 4);
-        process->setMatrix(pImpl->tr_);
         int scaled_height = static_cast<int>(pImpl->height_ * scale);
         int scaled_width = static_cast<int>(pImpl->width_ * scale);
 
         inspirecv::Image img_out(scaled_width, scaled_height, 3);
-        std::shared_ptr<MNN::Tensor> tensor(
-          MNN::Tensor::create<uint8_t>(std::vector<int>{1, scaled_height, scaled_width, 3}, (uint8_t *)img_out.Data()));
-        auto ret = process->convert(pImpl->buffer_, sw, sh, 0, tensor.get());
-        INSPIREFACE_CHECK_MSG(ret == MNN::ErrorCode::NO_ERROR, "ImageProcess::convert failed");
+        pImpl->Convert(pImpl->tr_, const_cast<uint8_t *>(img_out.Data()), scaled_width, scaled_height);
         return img_out;
     }
 }
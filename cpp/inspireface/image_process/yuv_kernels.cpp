@@ -0,0 +1,275 @@
+/**
+ * Created by Jingyu Yan
+ * @date 2024-10-01
+ */
+
+#include "yuv_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#define ISF_YUV_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define ISF_YUV_NEON
+#endif
+
+namespace inspire {
+
+namespace {
+
+inline uint8_t ClampPixel(int value) {
+    return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// MNN computes ((y << 6) + c) >> 6, which is y + (c >> 6) since y << 6 is a multiple of 64, and keeps the
+// vector lanes within 16 bits
+inline void ConvertPixel(int y, int u, int v, uint8_t *out, int blue, int red) {
+    out[blue] = ClampPixel(y + ((130 * u) >> 6));
+    out[1] = ClampPixel(y + ((-25 * u - 37 * v) >> 6));
+    out[red] = ClampPixel(y + ((73 * v) >> 6));
+}
+
+#if defined(ISF_YUV_SSE2)
+
+// Luma and centred chroma of eight pixels to their blue, green and red, 16 bits per lane
+inline void ConvertLanes(__m128i y, __m128i u, __m128i v, __m128i &b, __m128i &g, __m128i &r) {
+    b = _mm_add_epi16(y, _mm_srai_epi16(_mm_mullo_epi16(u, _mm_set1_epi16(130)), 6));
+    g = _mm_add_epi16(y, _mm_srai_epi16(_mm_sub_epi16(_mm_mullo_epi16(u, _mm_set1_epi16(-25)), _mm_mullo_epi16(v, _mm_set1_epi16(37))), 6));
+    r = _mm_add_epi16(y, _mm_srai_epi16(_mm_mullo_epi16(v, _mm_set1_epi16(73)), 6));
+}
+
+// SSE2 has no byte shuffle, the three planes of sixteen pixels are interleaved through the stack
+inline void StoreInterleaved(__m128i first, __m128i second, __m128i third, uint8_t *out) {
+    alignas(16) uint8_t planes[3][16];
+    _mm_store_si128(reinterpret_cast<__m128i *>(planes[0]), first);
+    _mm_store_si128(reinterpret_cast<__m128i *>(planes[1]), second);
+    _mm_store_si128(reinterpret_cast<__m128i *>(planes[2]), third);
+    for (int k = 0; k < 16; ++k) {
+        out[3 * k] = planes[0][k];
+        out[3 * k + 1] = planes[1][k];
+        out[3 * k + 2] = planes[2][k];
+    }
+}
+
+// Chroma of eight pixels from their four interleaved pairs, each pair repeated for its two pixels
+inline void SplitChroma(__m128i pairs, __m128i &first, __m128i &second) {
+    const __m128i bias = _mm_set1_epi16(128);
+    first = _mm_and_si128(pairs, _mm_set1_epi32(0xFFFF));
+    first = _mm_sub_epi16(_mm_or_si128(first, _mm_slli_epi32(first, 16)), bias);
+    second = _mm_srli_epi32(pairs, 16);
+    second = _mm_sub_epi16(_mm_or_si128(second, _mm_slli_epi32(second, 16)), bias);
+}
+
+#elif defined(ISF_YUV_NEON)
+
+inline void ConvertLanes(int16x8_t y, int16x8_t u, int16x8_t v, int16x8_t &b, int16x8_t &g, int16x8_t &r) {
+    b = vaddq_s16(y, vshrq_n_s16(vmulq_n_s16(u, 130), 6));
+    g = vaddq_s16(y, vshrq_n_s16(vmlaq_n_s16(vmulq_n_s16(u, -25), v, -37), 6));
+    r = vaddq_s16(y, vshrq_n_s16(vmulq_n_s16(v, 73), 6));
+}
+
+inline int16x8_t Widen(uint8x8_t value) {
+    return vreinterpretq_s16_u16(vmovl_u8(value));
+}
+
+inline int16x8_t WidenCentred(uint8x8_t value) {
+    return vsubq_s16(Widen(value), vdupq_n_s16(128));
+}
+
+#endif
+
+// Converts count pixels given as planes of luma and chroma
+void YUVPlanesToBGR(const uint8_t *ys, const uint8_t *us, const uint8_t *vs, int count, uint8_t *out, bool rgb) {
+    const int blue = rgb ? 2 : 0;
+    const int red = rgb ? 0 : 2;
+    int i = 0;
+#if defined(ISF_YUV_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi16(128);
+    for (; i + 16 <= count; i += 16) {
+        const __m128i y8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ys + i));
+        const __m128i u8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(us + i));
+        const __m128i v8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(vs + i));
+        __m128i b_lo, g_lo, r_lo, b_hi, g_hi, r_hi;
+        ConvertLanes(_mm_unpacklo_epi8(y8, zero), _mm_sub_epi16(_mm_unpacklo_epi8(u8, zero), bias), _mm_sub_epi16(_mm_unpacklo_epi8(v8, zero), bias),
+                     b_lo, g_lo, r_lo);
+        ConvertLanes(_mm_unpackhi_epi8(y8, zero), _mm_sub_epi16(_mm_unpackhi_epi8(u8, zero), bias), _mm_sub_epi16(_mm_unpackhi_epi8(v8, zero), bias),
+                     b_hi, g_hi, r_hi);
+        const __m128i b = _mm_packus_epi16(b_lo, b_hi);
+        const __m128i g = _mm_packus_epi16(g_lo, g_hi);
+        const __m128i r = _mm_packus_epi16(r_lo, r_hi);
+        StoreInterleaved(rgb ? r : b, g, rgb ? b : r, out + 3 * i);
+    }
+#elif defined(ISF_YUV_NEON)
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16_t y8 = vld1q_u8(ys + i);
+        const uint8x16_t u8 = vld1q_u8(us + i);
+        const uint8x16_t v8 = vld1q_u8(vs + i);
+        int16x8_t b_lo, g_lo, r_lo, b_hi, g_hi, r_hi;
+        ConvertLanes(Widen(vget_low_u8(y8)), WidenCentred(vget_low_u8(u8)), WidenCentred(vget_low_u8(v8)), b_lo, g_lo, r_lo);
+        ConvertLanes(Widen(vget_high_u8(y8)), WidenCentred(vget_high_u8(u8)), WidenCentred(vget_high_u8(v8)), b_hi, g_hi, r_hi);
+        const uint8x16_t b = vcombine_u8(vqmovun_s16(b_lo), vqmovun_s16(b_hi));
+        const uint8x16_t r = vcombine_u8(vqmovun_s16(r_lo), vqmovun_s16(r_hi));
+        uint8x16x3_t pixels;
+        pixels.val[0] = rgb ? r : b;
+        pixels.val[1] = vcombine_u8(vqmovun_s16(g_lo), vqmovun_s16(g_hi));
+        pixels.val[2] = rgb ? b : r;
+        vst3q_u8(out + 3 * i, pixels);
+    }
+#endif
+    for (; i < count; ++i) {
+        ConvertPixel(ys[i], us[i] - 128, vs[i] - 128, out + 3 * i, blue, red);
+    }
+}
+
+// Bilinear interpolation with 8-bit weights
+inline uint8_t Bilinear(int p00, int p01, int p10, int p11, int wx, int wy) {
+    const int top = p00 * (256 - wx) + p01 * wx;
+    const int bottom = p10 * (256 - wx) + p11 * wx;
+    return static_cast<uint8_t>((top * (256 - wy) + bottom * wy + 32768) >> 16);
+}
+
+// Planes of an output row, kept by each thread
+struct RowScratch {
+    std::vector<uint8_t> ys;
+    std::vector<uint8_t> us;
+    std::vector<uint8_t> vs;
+    std::vector<uint8_t> inside;
+};
+
+}  // namespace
+
+void YUV420SPToBGRRow(const uint8_t *y_row, const uint8_t *uv_row, int count, bool nv21, uint8_t *bgr) {
+    int i = 0;
+#if defined(ISF_YUV_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        const __m128i y8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y_row + i));
+        const __m128i c8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(uv_row + i));
+        __m128i first, second, b_lo, g_lo, r_lo, b_hi, g_hi, r_hi;
+        SplitChroma(_mm_unpacklo_epi8(c8, zero), first, second);
+        ConvertLanes(_mm_unpacklo_epi8(y8, zero), nv21 ? second : first, nv21 ? first : second, b_lo, g_lo, r_lo);
+        SplitChroma(_mm_unpackhi_epi8(c8, zero), first, second);
+        ConvertLanes(_mm_unpackhi_epi8(y8, zero), nv21 ? second : first, nv21 ? first : second, b_hi, g_hi, r_hi);
+        StoreInterleaved(_mm_packus_epi16(b_lo, b_hi), _mm_packus_epi16(g_lo, g_hi), _mm_packus_epi16(r_lo, r_hi), bgr + 3 * i);
+    }
+#elif defined(ISF_YUV_NEON)
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16_t y8 = vld1q_u8(y_row + i);
+        // The two bytes of each chroma pair, repeated for the two pixels of the pair
+        const uint8x8x2_t pairs = vld2_u8(uv_row + i);
+        const uint8x8x2_t first = vzip_u8(pairs.val[0], pairs.val[0]);
+        const uint8x8x2_t second = vzip_u8(pairs.val[1], pairs.val[1]);
+        const uint8x8x2_t u = nv21 ? second : first;
+        const uint8x8x2_t v = nv21 ? first : second;
+        int16x8_t b_lo, g_lo, r_lo, b_hi, g_hi, r_hi;
+        ConvertLanes(Widen(vget_low_u8(y8)), WidenCentred(u.val[0]), WidenCentred(v.val[0]), b_lo, g_lo, r_lo);
+        ConvertLanes(Widen(vget_high_u8(y8)), WidenCentred(u.val[1]), WidenCentred(v.val[1]), b_hi, g_hi, r_hi);
+        uint8x16x3_t pixels;
+        pixels.val[0] = vcombine_u8(vqmovun_s16(b_lo), vqmovun_s16(b_hi));
+        pixels.val[1] = vcombine_u8(vqmovun_s16(g_lo), vqmovun_s16(g_hi));
+        pixels.val[2] = vcombine_u8(vqmovun_s16(r_lo), vqmovun_s16(r_hi));
+        vst3q_u8(bgr + 3 * i, pixels);
+    }
+#endif
+    for (; i < count; ++i) {
+        const uint8_t *uv = uv_row + (i & ~1);
+        ConvertPixel(y_row[i], (nv21 ? uv[1] : uv[0]) - 128, (nv21 ? uv[0] : uv[1]) - 128, bgr + 3 * i, 0, 2);
+    }
+}
+
+void YUV420SPAffineToBGR(const uint8_t *frame, int width, int height, bool nv21, const float *matrix, uint8_t *dst, int width_out, int row_begin,
+                         int row_end, bool rgb) {
+    const float *m = matrix;
+    const uint8_t *uv_plane = frame + static_cast<size_t>(width) * height;
+    const bool translation = m[0] == 1.0f && m[1] == 0.0f && m[3] == 0.0f && m[4] == 1.0f && m[2] == std::floor(m[2]) && m[5] == std::floor(m[5]);
+    if (translation && !rgb) {
+        // Whole pixel moves, e.g. the full resolution frame, need no interpolation
+        const int tx = static_cast<int>(m[2]);
+        const int ty = static_cast<int>(m[5]);
+        const int x0 = std::min(width_out, std::max(0, -tx));
+        const int x1 = std::max(x0, std::min(width_out, width - tx));
+        for (int y = row_begin; y < row_end; ++y) {
+            uint8_t *out = dst + static_cast<size_t>(y) * width_out * 3;
+            const int sy = y + ty;
+            if (sy < 0 || sy >= height || x0 == x1) {
+                memset(out, 0, static_cast<size_t>(width_out) * 3);
+                continue;
+            }
+            memset(out, 0, static_cast<size_t>(x0) * 3);
+            memset(out + static_cast<size_t>(x1) * 3, 0, static_cast<size_t>(width_out - x1) * 3);
+            const uint8_t *y_row = frame + static_cast<size_t>(sy) * width;
+            const uint8_t *uv_row = uv_plane + static_cast<size_t>(sy / 2) * width;
+            int x = x0;
+            if ((x + tx) & 1) {
+                // The row kernel starts on a chroma pair
+                const uint8_t *uv = uv_row + ((x + tx) & ~1);
+                ConvertPixel(y_row[x + tx], (nv21 ? uv[1] : uv[0]) - 128, (nv21 ? uv[0] : uv[1]) - 128, out + 3 * x, 0, 2);
+                x++;
+            }
+            YUV420SPToBGRRow(y_row + x + tx, uv_row + x + tx, x1 - x, nv21, out + 3 * x);
+        }
+        return;
+    }
+
+    static thread_local RowScratch scratch;
+    if (scratch.ys.size() < static_cast<size_t>(width_out)) {
+        scratch.ys.resize(width_out);
+        scratch.us.resize(width_out);
+        scratch.vs.resize(width_out);
+        scratch.inside.resize(width_out);
+    }
+    uint8_t *ys = scratch.ys.data();
+    uint8_t *us = scratch.us.data();
+    uint8_t *vs = scratch.vs.data();
+    uint8_t *inside = scratch.inside.data();
+    const float max_x = static_cast<float>(width - 1);
+    const float max_y = static_cast<float>(height - 1);
+    const int u_offset = nv21 ? 1 : 0;
+    const int v_offset = nv21 ? 0 : 1;
+    for (int y = row_begin; y < row_end; ++y) {
+        bool all_inside = true;
+        for (int x = 0; x < width_out; ++x) {
+            const float sx = m[0] * x + m[1] * y + m[2];
+            const float sy = m[3] * x + m[4] * y + m[5];
+            inside[x] = sx >= 0.0f && sy >= 0.0f && sx <= max_x && sy <= max_y;
+            if (!inside[x]) {
+                all_inside = false;
+                ys[x] = 0;
+                us[x] = 128;
+                vs[x] = 128;
+                continue;
+            }
+            const int ix = static_cast<int>(sx);
+            const int iy = static_cast<int>(sy);
+            const int wx = static_cast<int>((sx - ix) * 256.0f + 0.5f);
+            const int wy = static_cast<int>((sy - iy) * 256.0f + 0.5f);
+            const int ix1 = ix < width - 1 ? ix + 1 : ix;
+            const int iy1 = iy < height - 1 ? iy + 1 : iy;
+            const uint8_t *y0 = frame + static_cast<size_t>(iy) * width;
+            const uint8_t *y1 = frame + static_cast<size_t>(iy1) * width;
+            ys[x] = Bilinear(y0[ix], y0[ix1], y1[ix], y1[ix1], wx, wy);
+            // The chroma of the four neighbours, interpolated as the converted pixels would be
+            const uint8_t *c0 = uv_plane + static_cast<size_t>(iy >> 1) * width;
+            const uint8_t *c1 = uv_plane + static_cast<size_t>(iy1 >> 1) * width;
+            const int cx0 = ix & ~1;
+            const int cx1 = ix1 & ~1;
+            us[x] = Bilinear(c0[cx0 + u_offset], c0[cx1 + u_offset], c1[cx0 + u_offset], c1[cx1 + u_offset], wx, wy);
+            vs[x] = Bilinear(c0[cx0 + v_offset], c0[cx1 + v_offset], c1[cx0 + v_offset], c1[cx1 + v_offset], wx, wy);
+        }
+        uint8_t *out = dst + static_cast<size_t>(y) * width_out * 3;
+        YUVPlanesToBGR(ys, us, vs, width_out, out, rgb);
+        if (!all_inside) {
+            for (int x = 0; x < width_out; ++x) {
+                if (!inside[x]) {
+                    out[3 * x] = out[3 * x + 1] = out[3 * x + 2] = 0;
+                }
+            }
+        }
+    }
+}
+
+}  // namespace inspire
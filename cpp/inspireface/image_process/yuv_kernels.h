@@ -0,0 +1,46 @@
+/**
+ * Created by Jingyu Yan
+ * @date 2024-10-01
+ */
+#pragma once
+#ifndef INSPIRE_FACE_IMAGE_PROCESS_YUV_KERNELS_H
+#define INSPIRE_FACE_IMAGE_PROCESS_YUV_KERNELS_H
+
+#include <cstdint>
+
+namespace inspire {
+
+/**
+ * @brief Converts a row of a YUV 4:2:0 semi-planar frame to BGR, with the integer coefficients of MNN.
+ * @details The pixels are converted 16 at a time with SSE2 or NEON when available.
+ * @param y_row Luma of the first pixel, at an even column.
+ * @param uv_row Interleaved chroma of the row pair, at the same column.
+ * @param count Number of pixels.
+ * @param nv21 True for NV21, V first, false for NV12, U first.
+ * @param bgr Receives count packed BGR pixels.
+ */
+void YUV420SPToBGRRow(const uint8_t *y_row, const uint8_t *uv_row, int count, bool nv21, uint8_t *bgr);
+
+/**
+ * @brief Samples rows of an affine-transformed YUV 4:2:0 semi-planar frame, converting to BGR or RGB in the same pass.
+ * @details Each output pixel is the bilinear interpolation of the four frame pixels around its position, which
+ * is what converting the whole frame first and resizing it afterwards gives, without the converted frame. The
+ * pixels falling outside the frame are zero. A matrix that only moves the frame by whole pixels is copied
+ * row by row.
+ * @param frame Luma plane followed by the interleaved chroma plane.
+ * @param width Width of the frame.
+ * @param height Height of the frame.
+ * @param nv21 True for NV21, V first, false for NV12, U first.
+ * @param matrix Maps the output pixels to the frame, x' = m0 x + m1 y + m2 and y' = m3 x + m4 y + m5.
+ * @param dst First pixel of the output image, 3 channels.
+ * @param width_out Width of the output image.
+ * @param row_begin First output row to produce.
+ * @param row_end Output row after the last one to produce.
+ * @param rgb True to write RGB instead of BGR.
+ */
+void YUV420SPAffineToBGR(const uint8_t *frame, int width, int height, bool nv21, const float *matrix, uint8_t *dst, int width_out, int row_begin,
+                         int row_end, bool rgb);
+
+}  // namespace inspire
+
+#endif  // INSPIRE_FACE_IMAGE_PROCESS_YUV_KERNELS_H
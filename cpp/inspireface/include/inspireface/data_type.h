@@ -236,6 +236,30 @@ struct FaceSearchResult {
     std::vector<float> feature;
 };
 
+/** @struct FaceSearchTopKBuffer
+ *  @brief Caller-owned output of a top k search.
+ *
+ *  The arrays are provided by the caller, so concurrent searches never share result memory.
+ */
+struct FaceSearchTopKBuffer {
+    int64_t* ids;        ///< Output ids, room for at least topK elements
+    float* confidences;  ///< Output similarities, room for at least topK elements
+    float* features;     ///< Optional output features, room for topK x feature length elements, may be null
+    size_t size;         ///< Number of results written
+};
+
+/** @struct FaceSearchFilter
+ *  @brief Predicate on the 64 tag bits of the stored features, used by filtered searches.
+ *
+ *  A feature matches when it has every bit of allOf, at least one bit of anyOf (unless anyOf is 0)
+ *  and no bit of noneOf. A zero filter matches every feature.
+ */
+struct FaceSearchFilter {
+    uint64_t allOf;   ///< Bits that must all be set
+    uint64_t anyOf;   ///< Bits of which at least one must be set, ignored when 0
+    uint64_t noneOf;  ///< Bits that must all be clear
+};
+
 /** @struct FaceEmbedding
  *  @brief Struct for face embedding data.
  *
@@ -8,6 +8,7 @@
 #ifndef INSPIRE_FACE_FACEDATATYPE_H
 #define INSPIRE_FACE_FACEDATATYPE_H
 
+#include <vector>
 #include "data_type.h"
 
 namespace inspire {
@@ -68,6 +69,28 @@ typedef struct FaceTrackWrap {
     int densityLandmarkEnable;     ///< Density landmark enable
 } FaceTrackWrap;
 
+/**
+ * Struct to represent everything a stream session computed for one frame.
+ *
+ * Every vector except embeddings holds one entry per face, in the order of faces. Results of
+ * disabled functions are -1.
+ */
+struct FaceStreamResult {
+    uint64_t frameId;                                      ///< Id given to the frame when it was pushed
+    int32_t streamId;                                      ///< Stream of a stream server the frame belongs to, 0 for a stream session
+    int32_t status;                                        ///< HSUCCEED, or the error of the first stage that failed
+    double latencyMs;                                      ///< Milliseconds from push to delivery
+    std::vector<FaceTrackWrap> faces;                      ///< Detected and tracked faces
+    std::vector<float> detConfidence;                      ///< Detection confidence
+    std::vector<float> qualityConfidence;                  ///< Face quality confidence
+    std::vector<float> rgbLivenessConfidence;              ///< RGB liveness confidence
+    std::vector<float> maskConfidence;                     ///< Mask confidence
+    std::vector<FaceAttributeResult> attributeResult;      ///< Race, gender and age bracket
+    std::vector<FaceInteractionState> interactionState;    ///< Eye status
+    std::vector<FaceInteractionAction> interactionAction;  ///< Interaction actions
+    std::vector<FaceEmbedding> embeddings;                 ///< One per face when recognition is enabled, otherwise empty
+};
+
 }  // namespace inspire
 
 #endif  // INSPIRE_FACE_FACEDATATYPE_H
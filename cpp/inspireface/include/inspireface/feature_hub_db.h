@@ -26,6 +26,31 @@ typedef enum PrimaryKeyMode {
     MANUAL_INPUT,        // Manual input primary key
 } PrimaryKeyMode;
 
+typedef enum SearchIndexType {
+    SEARCH_INDEX_FLAT = 0,  // Exact search, every stored feature is compared with the query.
+    SEARCH_INDEX_HNSW,      // Approximate search over an HNSW graph, sub-linear in the number of features.
+} SearchIndexType;
+
+typedef enum SearchVectorStorage {
+    SEARCH_STORAGE_FLOAT32 = 0,  // Features are scanned as stored.
+    SEARCH_STORAGE_FLOAT16,      // Half precision copy scanned in memory, half the bandwidth of float32.
+    SEARCH_STORAGE_INT8,         // Int8 copy scanned in memory with one scale per feature, a quarter of the bandwidth of float32.
+} SearchVectorStorage;
+
+/**
+ * @struct SearchIndexConfiguration
+ * @brief Structure to select and tune the index that serves FeatureHub searches.
+ */
+using SearchIndexConfiguration = struct SearchIndexConfiguration {
+    SearchIndexType index_type = SEARCH_INDEX_FLAT;  ///< Index used to serve searches
+    int32_t hnsw_m = 16;                             ///< HNSW: max links per node, higher improves recall and costs memory
+    int32_t hnsw_ef_construction = 200;              ///< HNSW: candidate list size when inserting, higher builds a better graph
+    int32_t hnsw_ef_search = 64;                     ///< HNSW: candidate list size when searching, trades latency for recall
+    SearchVectorStorage vector_storage = SEARCH_STORAGE_FLOAT32;  ///< Flat: precision of the in-memory copy, reduced precision is re-ranked
+    int32_t rerank_factor = 4;                                    ///< Flat: candidates re-ranked at full precision per requested result
+    int32_t shards = 1;                                           ///< Indexes the features are split over, searched in parallel
+};
+
 /**
  * @struct DatabaseConfiguration
  * @brief Structure to configure database settings for FaceRecognition.
@@ -36,6 +61,7 @@ using DatabaseConfiguration = struct DatabaseConfiguration {
     std::string persistence_db_path;                                   ///< Path to the database file.
     float recognition_threshold = 0.48f;                               ///< Face search threshold
     SearchMode search_mode = SEARCH_MODE_EAGER;                        ///< Search mode (!!Temporarily unavailable!!)
+    SearchIndexConfiguration search_index;                             ///< Index used to serve searches
 };
 
 /**
@@ -112,6 +138,52 @@ public:
      */
     int32_t SearchFaceFeatureTopK(const Embedded& queryFeature, std::vector<FaceSearchResult>& searchResult, size_t topK, bool returnFeature = false);
 
+    /**
+     * @brief Search the stored data for the top k most similar facial features of several queries at once.
+     * @details All queries are scored in a single blocked pass over the gallery, which is much cheaper than
+     * issuing one search per query when many faces have to be identified in the same frame.
+     * @param queries Row-major query matrix of numQueries x feature length elements.
+     * @param numQueries Number of queries.
+     * @param searchResults Output results, one vector per query in query order.
+     * @param topK Maximum number of results to return per query.
+     * @param returnFeature Whether to return the feature data.
+     * @return int32_t Status code of the search operation.
+     */
+    int32_t SearchFaceFeatureTopKBatch(const float* queries, size_t numQueries, std::vector<std::vector<FaceSearchResult>>& searchResults, size_t topK,
+                                       bool returnFeature = false);
+
+    /**
+     * @brief Search the stored data for the top k most similar facial features into caller-owned buffers.
+     * @details Nothing is written to the internal caches, any number of threads can search at the same time.
+     * @param queryFeature Query of feature length elements.
+     * @param topK Maximum number of results, the buffers must have room for this many entries.
+     * @param result Caller-owned buffers, its size receives the number of results.
+     * @return int32_t Status code of the search operation.
+     */
+    int32_t SearchFaceFeatureTopK(const float* queryFeature, size_t topK, FaceSearchTopKBuffer& result);
+
+    /**
+     * @brief Batched top k search into caller-owned buffers, see SearchFaceFeatureTopK.
+     * @param queries Row-major query matrix of numQueries x feature length elements.
+     * @param numQueries Number of queries.
+     * @param topK Maximum number of results per query.
+     * @param results Array of numQueries caller-owned buffers, filled in query order.
+     * @return int32_t Status code of the search operation.
+     */
+    int32_t SearchFaceFeatureTopKBatch(const float* queries, size_t numQueries, size_t topK, FaceSearchTopKBuffer* results);
+
+    /**
+     * @brief Top k search into caller-owned buffers restricted to the features whose tags match filter.
+     * @details The tags are tested during the scan, so a selective filter makes the search cheaper
+     * instead of dropping results after the top k was taken.
+     * @param queryFeature Query of feature length elements.
+     * @param topK Maximum number of results, the buffers must have room for this many entries.
+     * @param filter Tag predicate of the features to consider.
+     * @param result Caller-owned buffers, its size receives the number of results.
+     * @return int32_t Status code of the search operation.
+     */
+    int32_t SearchFaceFeatureTopK(const float* queryFeature, size_t topK, const FaceSearchFilter& filter, FaceSearchTopKBuffer& result);
+
     /**
      * @brief Inserts a face feature with a custom ID.
      * @param feature Vector of floats representing the face feature.
@@ -121,6 +193,17 @@ public:
      */
     int32_t FaceFeatureInsert(const std::vector<float>& feature, int32_t id, int64_t& result_id);
 
+    /**
+     * @brief Inserts a contiguous block of face features in a single transaction.
+     * @details Either every feature is inserted or none of them is.
+     * @param features Row-major matrix of count x feature length elements.
+     * @param count Number of features.
+     * @param ids Custom IDs of the features, required in manual ID mode and ignored otherwise.
+     * @param result_ids Output array of count IDs assigned to the features, may be null.
+     * @return int32_t Status code of the insertion operation.
+     */
+    int32_t FaceFeatureBatchInsert(const float* features, size_t count, const int64_t* ids, int64_t* result_ids);
+
     /**
      * @brief Removes a face feature by its ID.
      * @param id ID of the feature to remove.
@@ -151,6 +234,24 @@ public:
      */
     int32_t GetFaceFeature(int32_t id, std::vector<float>& feature);
 
+    /**
+     * @brief Sets the tag bits of a stored face feature, see FaceSearchFilter.
+     * @details Features are inserted without tags, the tags are kept when the feature is updated
+     * and removed with it.
+     * @param id ID of the feature.
+     * @param tags New tag bits, 0 clears them.
+     * @return int32_t Status code of the operation.
+     */
+    int32_t FaceFeatureSetTags(int64_t id, uint64_t tags);
+
+    /**
+     * @brief Gets the tag bits of a stored face feature.
+     * @param id ID of the feature.
+     * @param tags Output tag bits.
+     * @return int32_t Status code of the operation.
+     */
+    int32_t GetFaceFeatureTags(int64_t id, uint64_t& tags);
+
     /**
      * @brief Views the database table containing face data.
      * @return int32_t Status code of the operation.
@@ -163,6 +264,91 @@ public:
      */
     void SetRecognitionThreshold(float threshold);
 
+    /**
+     * @brief Sets the candidate list size of HNSW searches, has no effect on the flat index.
+     * @param ef Candidate list size, larger values raise recall and latency.
+     * @return int32_t Status code of the operation.
+     */
+    int32_t SetSearchIndexEf(int32_t ef);
+
+    /**
+     * @brief Gets the approximate memory held by the in-memory search index.
+     * @param bytes Output memory in bytes, the SQLite storage is not included.
+     * @return int32_t Status code of the operation.
+     */
+    int32_t GetSearchIndexMemoryUsage(size_t& bytes);
+
+    /**
+     * @brief Saves the search index next to the persistent database now instead of when the hub is disabled.
+     * @return int32_t Status code of the operation.
+     */
+    int32_t SaveSearchIndex();
+
+    /**
+     * @brief Creates a named gallery, a feature database independent from the default one.
+     * @details A gallery split over several shards (search_index.shards) is searched on all of them in
+     * parallel. Galleries are dropped when the hub is disabled; a persistent gallery whose path is a
+     * folder is stored in a file named after it.
+     * @param name Unique name of the gallery, made of letters, digits, '_' and '-'.
+     * @param configuration Database settings of the gallery.
+     * @return int32_t Status code of the operation.
+     */
+    int32_t CreateGallery(const std::string& name, const DatabaseConfiguration& configuration);
+
+    /**
+     * @brief Drops a named gallery, its persistent file is kept.
+     * @param name Name of the gallery.
+     * @return int32_t Status code of the operation.
+     */
+    int32_t DropGallery(const std::string& name);
+
+    /**
+     * @brief Inserts a face feature into a named gallery.
+     * @param name Name of the gallery.
+     * @param feature Feature of feature length elements.
+     * @param id Custom ID of the feature, ignored in auto-increment mode.
+     * @param result_id Output parameter to store the resulting ID.
+     * @return int32_t Status code of the insertion operation.
+     */
+    int32_t GalleryFeatureInsert(const std::string& name, const float* feature, int64_t id, int64_t& result_id);
+
+    /**
+     * @brief Inserts a contiguous block of face features into a named gallery, see FaceFeatureBatchInsert.
+     * @param name Name of the gallery.
+     * @param features Row-major matrix of count x feature length elements.
+     * @param count Number of features.
+     * @param ids Custom IDs of the features, required in manual ID mode and ignored otherwise.
+     * @param result_ids Output array of count IDs assigned to the features, may be null.
+     * @return int32_t Status code of the insertion operation.
+     */
+    int32_t GalleryFeatureBatchInsert(const std::string& name, const float* features, size_t count, const int64_t* ids, int64_t* result_ids);
+
+    /**
+     * @brief Removes a face feature from a named gallery.
+     * @param name Name of the gallery.
+     * @param id ID of the feature to remove.
+     * @return int32_t Status code of the removal operation.
+     */
+    int32_t GalleryFeatureRemove(const std::string& name, int64_t id);
+
+    /**
+     * @brief Top k search of a named gallery into caller-owned buffers, see SearchFaceFeatureTopK.
+     * @param name Name of the gallery.
+     * @param queryFeature Query of feature length elements.
+     * @param topK Maximum number of results, the buffers must have room for this many entries.
+     * @param result Caller-owned buffers, its size receives the number of results.
+     * @return int32_t Status code of the search operation.
+     */
+    int32_t GallerySearchFaceFeatureTopK(const std::string& name, const float* queryFeature, size_t topK, FaceSearchTopKBuffer& result);
+
+    /**
+     * @brief Retrieves the number of facial features stored in a named gallery.
+     * @param name Name of the gallery.
+     * @param count Output number of features.
+     * @return int32_t Status code of the operation.
+     */
+    int32_t GetGalleryFaceFeatureCount(const std::string& name, int32_t& count);
+
     /**
      * @brief Sets the search mode for face recognition.
      * @param mode Search mode.
@@ -2,6 +2,7 @@
 #define INSPIREFACE_FRAME_PROCESS_H
 
 #include <memory>
+#include <vector>
 #include <inspirecv/inspirecv.h>
 #include "data_type.h"
 
@@ -17,6 +18,17 @@ enum ROTATION_MODE { ROTATION_0 = 0, ROTATION_90 = 1, ROTATION_180 = 2, ROTATION
  */
 enum DATA_FORMAT { NV21 = 0, NV12 = 1, RGBA = 2, RGB = 3, BGR = 4, BGRA = 5 };
 
+/**
+ * @brief A crop requested from FrameProcess::ExecuteImageAffineBatchProcessing.
+ */
+struct AffineCropRequest {
+    inspirecv::TransformMatrix affine_matrix;  ///< Maps the frame to the crop, as for ExecuteImageAffineProcessing.
+    int width_out = 0;                         ///< Width of the crop.
+    int height_out = 0;                        ///< Height of the crop.
+    DATA_FORMAT format = BGR;                  ///< Channel order of the crop, BGR or RGB.
+    inspirecv::Image* image_out = nullptr;     ///< Receives the crop, its buffer is reused when it already has the crop size.
+};
+
 /**
  * @brief A class to handle camera stream and image processing.
  */
@@ -129,6 +141,33 @@ public:
      */
     inspirecv::Image ExecuteImageAffineProcessing(inspirecv::TransformMatrix& affine_matrix, const int width_out, const int height_out) const;
 
+    /**
+     * @brief Get an affine-transformed image into an image of the caller.
+     *
+     * The buffer of img_out is reused when it already has the output size and 3 channels, so a caller
+     * keeping its crops from frame to frame does not allocate them again.
+     *
+     * @param affine_matrix Affine transformation matrix.
+     * @param width_out Width of the output image.
+     * @param height_out Height of the output image.
+     * @param img_out Receives the affine-transformed image.
+     */
+    void ExecuteImageAffineProcessing(inspirecv::TransformMatrix& affine_matrix, const int width_out, const int height_out,
+                                      inspirecv::Image& img_out) const;
+
+    /**
+     * @brief Get many affine-transformed images in a single pass over the frame.
+     *
+     * The frame regions under the crops are colour-converted once, whatever the number of crops
+     * covering them, then every crop is sampled from them with bilinear interpolation. Both steps
+     * are split by rows over up to num_threads threads. The crops match the ones of
+     * ExecuteImageAffineProcessing within a level of rounding.
+     *
+     * @param requests Crops to produce, typically every crop of every face of the frame.
+     * @param num_threads Maximum number of threads working on the batch, the calling thread included.
+     */
+    void ExecuteImageAffineBatchProcessing(const std::vector<AffineCropRequest>& requests, int num_threads = 1) const;
+
     /**
      * @brief Get a preview image with optional rotation.
      *
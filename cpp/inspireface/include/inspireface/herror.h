@@ -48,6 +48,10 @@
 
 #define HERR_SESS_FACE_DATA_ERROR (HERR_SESS_BASE + 30)  // Face data parsing
 
+#define HERR_SESS_STREAM_QUEUE_FULL (HERR_SESS_BASE + 31)  // Stream frame queue is full
+#define HERR_SESS_STREAM_TIMEOUT (HERR_SESS_BASE + 32)     // No stream result within the timeout
+#define HERR_SESS_STREAM_STOPPED (HERR_SESS_BASE + 33)     // Stream session is stopped
+
 #define HERR_SESS_FACE_REC_OPTION_ERROR (HERR_SESS_BASE + 40)  // An optional parameter is incorrect
 
 #define HERR_FT_HUB_DISABLE (HERR_SESS_BASE + 49)                // FeatureHub is disabled
@@ -62,6 +66,7 @@
 #define HERR_FT_HUB_ENABLE_REPETITION (HERR_SESS_BASE + 58)      // Enable db function repeatedly
 #define HERR_FT_HUB_DISABLE_REPETITION (HERR_SESS_BASE + 59)     // Disable db function repeatedly
 #define HERR_FT_HUB_NOT_FOUND_FEATURE (HERR_SESS_BASE + 60)      // Get face feature error
+#define HERR_FT_HUB_GALLERY_NOT_FOUND (HERR_SESS_BASE + 61)      // Named gallery does not exist
 
 #define HERR_ARCHIVE_LOAD_FAILURE (HERR_SESS_BASE + 80)        // Archive load failure
 #define HERR_ARCHIVE_LOAD_MODEL_FAILURE (HERR_SESS_BASE + 81)  // Model load failure
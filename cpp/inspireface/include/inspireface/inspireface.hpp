@@ -1,4 +1,6 @@
 #include "session.h"
+#include "stream_session.h"
+#include "stream_server.h"
 #include "cuda_toolkit.h"
 #include "data_type.h"
 #include "log.h"
@@ -83,6 +83,13 @@ public:
     // Get the cuda device id
     int32_t GetCudaDeviceId() const;
 
+    // Set whether the sessions created afterwards share one loaded copy of each model. Saves the memory
+    // of a model per session, but the inferences of a shared model run one at a time
+    void SetModelSharing(bool enable);
+
+    // Get whether the sessions share the loaded models
+    bool GetModelSharing() const;
+
 private:
     // Private constructor for the singleton pattern
     Launch();
@@ -83,6 +83,26 @@ public:
      */
     void SetTrackModeDetectInterval(int32_t detect_interval);
 
+    /**
+     * @brief Detect when the scene changes or a track weakens instead of at the detect interval.
+     * @param max_interval The maximum number of frames between two detections, 0 or less goes back to the detect interval.
+     */
+    void SetTrackModeAdaptiveDetect(int32_t max_interval);
+
+    /**
+     * @brief Detect frames larger than the tile size on overlapping tiles at full resolution, for small faces.
+     * @param tile_size The side of the tiles in frame pixels, 0 or less detects on the preview only.
+     * @param motion_only Detect only the tiles that changed since they were last detected.
+     */
+    void SetTrackModeTiledDetect(int32_t tile_size, bool motion_only = false);
+
+    /**
+     * @brief Set the number of threads tracking the faces of a frame.
+     * @param num_threads The number of threads, 1 tracks on the calling thread only.
+     * @return The status of the operation.
+     */
+    int32_t SetTrackNumThreads(int32_t num_threads);
+
     /**
      * @brief Detect and track the faces in the frame.
      * @param process The frame process.
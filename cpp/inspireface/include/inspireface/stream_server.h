@@ -0,0 +1,131 @@
+#ifndef INSPIRE_FACE_STREAM_SERVER_API_H
+#define INSPIRE_FACE_STREAM_SERVER_API_H
+#include <functional>
+#include <memory>
+#include "data_type.h"
+#include "frame_process.h"
+#include "face_warpper.h"
+
+namespace inspire {
+
+/**
+ * @brief The face algorithm server for many video streams.
+ *
+ * Each worker thread loads one set of models and serves the streams in turn, every stream keeps its own
+ * tracker state. RGB liveness and recognition of the streams served together run as one batch. Results
+ * carry the id of their stream and arrive through the result callback or PollResult.
+ */
+class INSPIRE_API_EXPORT StreamServer {
+public:
+    using ResultCallback = std::function<void(const FaceStreamResult&)>;
+
+    StreamServer();
+    ~StreamServer();
+
+    StreamServer(StreamServer&&) noexcept;
+    StreamServer& operator=(StreamServer&&) noexcept;
+
+    StreamServer(const StreamServer&) = delete;
+    StreamServer& operator=(const StreamServer&) = delete;
+
+    /**
+     * @brief Create a new stream server with the given parameters.
+     * @param detect_mode The mode of face detection.
+     * @param max_detect_face The maximum number of faces to detect.
+     * @param param The functions run on every frame.
+     * @param detect_level_px The detection level in pixels.
+     * @param track_by_detect_mode_fps The tracking frame rate.
+     * @param num_workers The number of worker threads, each loads its own models.
+     * @param max_batch_streams The maximum number of streams a worker serves in one round.
+     * @param queue_capacity The number of frames the queue of each stream can hold.
+     * @return A new stream server.
+     */
+    static StreamServer Create(DetectModuleMode detect_mode, int32_t max_detect_face, const CustomPipelineParameter& param,
+                               int32_t detect_level_px = -1, int32_t track_by_detect_mode_fps = -1, int32_t num_workers = 1,
+                               int32_t max_batch_streams = 8, int32_t queue_capacity = 4);
+
+    /**
+     * @brief Create a new stream server pointer with the given parameters.
+     * @return A raw pointer to new stream server. The caller is responsible for memory management.
+     */
+    static StreamServer* CreatePtr(DetectModuleMode detect_mode, int32_t max_detect_face, const CustomPipelineParameter& param,
+                                   int32_t detect_level_px = -1, int32_t track_by_detect_mode_fps = -1, int32_t num_workers = 1,
+                                   int32_t max_batch_streams = 8, int32_t queue_capacity = 4) {
+        return new StreamServer(
+          Create(detect_mode, max_detect_face, param, detect_level_px, track_by_detect_mode_fps, num_workers, max_batch_streams, queue_capacity));
+    }
+
+    /**
+     * @brief Set the track preview size of every stream, the open ones use it from their next frame.
+     * @param preview_size The preview size.
+     */
+    void SetTrackPreviewSize(int32_t preview_size);
+
+    /**
+     * @brief Set the track mode detect interval of every stream, the open ones use it from their next frame.
+     * @param detect_interval The track mode detect interval.
+     */
+    void SetTrackModeDetectInterval(int32_t detect_interval);
+
+    /**
+     * @brief Open a stream with a fresh tracker state.
+     * @param stream_id Receives the id of the stream.
+     * @return The status of the operation.
+     */
+    int32_t OpenStream(int32_t& stream_id);
+
+    /**
+     * @brief Close a stream, its queued frames are dropped.
+     * @param stream_id The id of the stream.
+     * @return The status of the operation.
+     */
+    int32_t CloseStream(int32_t stream_id);
+
+    /**
+     * @brief Set the function receiving the results on the worker threads, nullptr to poll instead.
+     * @param callback The result callback.
+     */
+    void SetResultCallback(ResultCallback callback);
+
+    /**
+     * @brief Copy a frame into the queue of a stream.
+     * @param stream_id The id of the stream.
+     * @param data The image data.
+     * @param height The height of the image.
+     * @param width The width of the image.
+     * @param data_format The data format of the image.
+     * @param rotation_mode The rotation of the image.
+     * @param block Wait for room in the queue, otherwise fail with HERR_SESS_STREAM_QUEUE_FULL.
+     * @param frame_id Receives the id of the frame within its stream, may be nullptr.
+     * @return The status of the operation.
+     */
+    int32_t PushFrame(int32_t stream_id, const uint8_t* data, int32_t height, int32_t width, inspirecv::DATA_FORMAT data_format = inspirecv::BGR,
+                      inspirecv::ROTATION_MODE rotation_mode = inspirecv::ROTATION_0, bool block = true, uint64_t* frame_id = nullptr);
+
+    /**
+     * @brief Take the oldest result of any stream when no result callback is set.
+     * @param result Receives the result.
+     * @param timeout_ms Milliseconds to wait for a result.
+     * @return HSUCCEED, HERR_SESS_STREAM_TIMEOUT or HERR_SESS_STREAM_STOPPED.
+     */
+    int32_t PollResult(FaceStreamResult& result, int64_t timeout_ms);
+
+    /**
+     * @brief Wait until every pushed frame reached the callback or the result queue.
+     * @return The status of the operation.
+     */
+    int32_t Flush();
+
+    /**
+     * @brief Stop the stream server, frames not processed yet are dropped.
+     */
+    void Stop();
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> pImpl;
+};
+
+}  // namespace inspire
+
+#endif  // INSPIRE_FACE_STREAM_SERVER_API_H
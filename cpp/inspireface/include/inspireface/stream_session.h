@@ -0,0 +1,111 @@
+#ifndef INSPIRE_FACE_STREAM_SESSION_API_H
+#define INSPIRE_FACE_STREAM_SESSION_API_H
+#include <functional>
+#include <memory>
+#include "data_type.h"
+#include "frame_process.h"
+#include "face_warpper.h"
+
+namespace inspire {
+
+/**
+ * @brief The face algorithm session for video streams.
+ *
+ * Frames are pushed into a bounded queue and copied, detection and tracking run on one thread and
+ * the face pipeline on another, so consecutive frames overlap. Results arrive in push order through
+ * the result callback or PollResult.
+ */
+class INSPIRE_API_EXPORT StreamSession {
+public:
+    using ResultCallback = std::function<void(const FaceStreamResult&)>;
+
+    StreamSession();
+    ~StreamSession();
+
+    StreamSession(StreamSession&&) noexcept;
+    StreamSession& operator=(StreamSession&&) noexcept;
+
+    StreamSession(const StreamSession&) = delete;
+    StreamSession& operator=(const StreamSession&) = delete;
+
+    /**
+     * @brief Create a new stream session with the given parameters.
+     * @param detect_mode The mode of face detection.
+     * @param max_detect_face The maximum number of faces to detect.
+     * @param param The functions run on every frame.
+     * @param detect_level_px The detection level in pixels.
+     * @param track_by_detect_mode_fps The tracking frame rate.
+     * @param queue_capacity The number of frames each queue between the stages can hold.
+     * @return A new stream session.
+     */
+    static StreamSession Create(DetectModuleMode detect_mode, int32_t max_detect_face, const CustomPipelineParameter& param,
+                                int32_t detect_level_px = -1, int32_t track_by_detect_mode_fps = -1, int32_t queue_capacity = 4);
+
+    /**
+     * @brief Create a new stream session pointer with the given parameters.
+     * @return A raw pointer to new stream session. The caller is responsible for memory management.
+     */
+    static StreamSession* CreatePtr(DetectModuleMode detect_mode, int32_t max_detect_face, const CustomPipelineParameter& param,
+                                    int32_t detect_level_px = -1, int32_t track_by_detect_mode_fps = -1, int32_t queue_capacity = 4) {
+        return new StreamSession(Create(detect_mode, max_detect_face, param, detect_level_px, track_by_detect_mode_fps, queue_capacity));
+    }
+
+    /**
+     * @brief Set the track preview size, before the first frame is pushed.
+     * @param preview_size The preview size.
+     */
+    void SetTrackPreviewSize(int32_t preview_size);
+
+    /**
+     * @brief Set the track mode detect interval, before the first frame is pushed.
+     * @param detect_interval The track mode detect interval.
+     */
+    void SetTrackModeDetectInterval(int32_t detect_interval);
+
+    /**
+     * @brief Set the function receiving the results on the pipeline thread, nullptr to poll instead.
+     * @param callback The result callback.
+     */
+    void SetResultCallback(ResultCallback callback);
+
+    /**
+     * @brief Copy a frame into the input queue.
+     * @param data The image data.
+     * @param height The height of the image.
+     * @param width The width of the image.
+     * @param data_format The data format of the image.
+     * @param rotation_mode The rotation of the image.
+     * @param block Wait for room in the queue, otherwise fail with HERR_SESS_STREAM_QUEUE_FULL.
+     * @param frame_id Receives the id of the frame, may be nullptr.
+     * @return The status of the operation.
+     */
+    int32_t PushFrame(const uint8_t* data, int32_t height, int32_t width, inspirecv::DATA_FORMAT data_format = inspirecv::BGR,
+                      inspirecv::ROTATION_MODE rotation_mode = inspirecv::ROTATION_0, bool block = true, uint64_t* frame_id = nullptr);
+
+    /**
+     * @brief Take the oldest result when no result callback is set.
+     * @param result Receives the result.
+     * @param timeout_ms Milliseconds to wait for a result.
+     * @return HSUCCEED, HERR_SESS_STREAM_TIMEOUT or HERR_SESS_STREAM_STOPPED.
+     */
+    int32_t PollResult(FaceStreamResult& result, int64_t timeout_ms);
+
+    /**
+     * @brief Wait until every pushed frame reached the callback or the result queue.
+     * @return The status of the operation.
+     */
+    int32_t Flush();
+
+    /**
+     * @brief Stop the stream session, frames not processed yet are dropped.
+     */
+    void Stop();
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> pImpl;
+};
+
+}  // namespace inspire
+
+#endif  // INSPIRE_FACE_STREAM_SESSION_API_H
@@ -27,7 +27,7 @@ namespace inspire {
 // Implementation class definition
 class Launch::Impl {
 public:
-    Impl() : m_load_(false), m_archive_(nullptr), m_cuda_device_id_(0), m_global_coreml_inference_mode_(InferenceWrapper::COREML_ANE) {
+    Impl() : m_load_(false), m_archive_(nullptr), m_cuda_device_id_(0), m_global_coreml_inference_mode_(InferenceWrapper::COREML_ANE), m_model_sharing_(false) {
 #if defined(ISF_ENABLE_RGA)
 #if defined(ISF_RKNPU_RV1106)
         m_rockchip_dma_heap_path_ = RV1106_CMA_HEAP_PATH;
@@ -49,6 +49,7 @@ public:
     bool m_load_;
     int32_t m_cuda_device_id_;
     InferenceWrapper::SpecialBackend m_global_coreml_inference_mode_;
+    bool m_model_sharing_;
 };
 
 // Initialize static members
@@ -242,4 +243,14 @@ int32_t Launch::GetCudaDeviceId() const {
     return pImpl->m_cuda_device_id_;
 }
 
+void Launch::SetModelSharing(bool enable) {
+    std::lock_guard<std::mutex> lock(pImpl->mutex_);
+    pImpl->m_model_sharing_ = enable;
+}
+
+bool Launch::GetModelSharing() const {
+    std::lock_guard<std::mutex> lock(pImpl->mutex_);
+    return pImpl->m_model_sharing_;
+}
+
 }  // namespace inspire
\ No newline at end of file
@@ -7,6 +7,8 @@
 #define INSPIREFACE_ANYNETADAPTER_H
 
 #include <utility>
+#include <algorithm>
+#include <cstring>
 #include <inspirecv/inspirecv.h>
 #include "data_type.h"
 #include "inference_wrapper/inference_wrapper.h"
@@ -21,6 +23,111 @@ namespace inspire {
 
 using AnyTensorOutputs = std::vector<std::pair<std::string, std::vector<float>>>;
 
+/**
+ * @class AnyTensorView
+ * @brief Read-only view of an output tensor, or of the rows of some images of a batched one.
+ *
+ * The view does not own the values. The views returned by an adapter point in the output tensors of its
+ * inference engine and are valid until its next forward.
+ */
+class AnyTensorView {
+public:
+    /**
+     * @brief Views the values of a tensor.
+     * @param name Name of the tensor, kept by reference.
+     * @param data First value.
+     * @param size Number of values, all the rows of the batch.
+     * @param batch Number of rows, one per image.
+     * @param dims Dimensions reported by the engine, kept by reference, may be null.
+     * @param nchw Layout of the tensor.
+     */
+    AnyTensorView(const std::string &name, const float *data, size_t size, int32_t batch = 1, const std::vector<int32_t> *dims = nullptr,
+                  bool nchw = true)
+    : m_name_(&name), m_data_(data), m_size_(size), m_batch_(batch), m_dims_(dims), m_nchw_(nchw) {}
+
+    /**
+     * @brief Views a tensor copied in AnyTensorOutputs, as a single row.
+     */
+    explicit AnyTensorView(const std::pair<std::string, std::vector<float>> &output)
+    : AnyTensorView(output.first, output.second.data(), output.second.size()) {}
+
+    const std::string &Name() const {
+        return *m_name_;
+    }
+
+    const float *Data() const {
+        return m_data_;
+    }
+
+    /** @brief Number of values of all the rows. */
+    size_t Size() const {
+        return m_size_;
+    }
+
+    /** @brief Number of rows, one per image. */
+    int32_t Batch() const {
+        return m_batch_;
+    }
+
+    /** @brief Number of values of a row. */
+    size_t RowSize() const {
+        return m_batch_ > 0 ? m_size_ / m_batch_ : 0;
+    }
+
+    bool IsNCHW() const {
+        return m_nchw_;
+    }
+
+    /**
+     * @brief Dimensions of the tensor, the first one being the number of rows of the view.
+     * @return std::vector<int32_t> The engine dimensions when known, otherwise {Batch(), RowSize()}.
+     */
+    std::vector<int32_t> Shape() const {
+        if (m_dims_ == nullptr || m_dims_->empty()) {
+            return {m_batch_, static_cast<int32_t>(RowSize())};
+        }
+        std::vector<int32_t> shape = *m_dims_;
+        shape[0] = m_batch_;
+        return shape;
+    }
+
+    /**
+     * @brief Views the row of one image.
+     * @param index Index of the image in the batch.
+     */
+    AnyTensorView Row(size_t index) const {
+        const size_t row_size = RowSize();
+        return AnyTensorView(*m_name_, m_data_ + index * row_size, row_size, 1, m_dims_, m_nchw_);
+    }
+
+    /** @brief Copies the values, for the results that outlive the next forward. */
+    std::vector<float> ToVector() const {
+        return std::vector<float>(m_data_, m_data_ + m_size_);
+    }
+
+    float operator[](size_t index) const {
+        return m_data_[index];
+    }
+
+    const float *begin() const {
+        return m_data_;
+    }
+
+    const float *end() const {
+        return m_data_ + m_size_;
+    }
+
+private:
+    const std::string *m_name_;
+    const float *m_data_;
+    size_t m_size_;
+    int32_t m_batch_;
+    const std::vector<int32_t> *m_dims_;
+    bool m_nchw_;
+};
+
+using AnyTensorViews = std::vector<AnyTensorView>;
+
 /**
  * @class AnyNet
  * @brief Generic neural network class for various inference tasks.
@@ -111,8 +218,16 @@ public:
                 return InferenceWrapper::WrapperError;
             }
             std::string filePath = os::PathJoin(extensionPath, model.fullname);
+            if (INSPIREFACE_CONTEXT->GetModelSharing()) {
+                m_nn_inference_->SetSharedModelKey(filePath);
+            }
             ret = m_nn_inference_->Initialize(filePath, m_input_tensor_info_list_, m_output_tensor_info_list_);
         } else {
+            if (INSPIREFACE_CONTEXT->GetModelSharing()) {
+                // Keyed by content, a buffer released and another one allocated at its address is a different model
+                m_nn_inference_->SetSharedModelKey(model.name + "#" + std::to_string(model.bufferSize) + "#" +
+                                                   std::to_string(HashModelBuffer(model.buffer, model.bufferSize)));
+            }
             ret = m_nn_inference_->Initialize(model.buffer, model.bufferSize, m_input_tensor_info_list_, m_output_tensor_info_list_);
         }
         if (ret != InferenceWrapper::WrapperOk) {
@@ -162,6 +277,8 @@ public:
         input_tensor_info.image_info.swap_color = getData<bool>("swap_color");
 
         m_input_tensor_info_list_.push_back(input_tensor_info);
+        m_batch_enabled_ = m_nn_inference_->SupportBatchInput() && m_infer_type_ != InferenceWrapper::INFER_RKNN &&
+                           input_tensor_info.data_type == InputTensorInfo::DataTypeImage;
 
         if (dynamic) {
             m_nn_inference_->ResizeInput(m_input_tensor_info_list_);
@@ -171,17 +288,7 @@ public:
     }
 
     void Forward(const inspirecv::Image &image, AnyTensorOutputs &outputs) {
-        InputTensorInfo &input_tensor_info = getMInputTensorInfoList()[0];
-        if (m_infer_type_ == InferenceWrapper::INFER_RKNN) {
-            if (getData<bool>("swap_color")) {
-                m_cache_ = image.SwapRB();
-                input_tensor_info.data = (uint8_t *)m_cache_.Data();
-            } else {
-                input_tensor_info.data = (uint8_t *)image.Data();
-            }
-        } else {
-            input_tensor_info.data = (uint8_t *)image.Data();
-        }
+        SetImageInput(image);
         Forward(outputs);
     }
 
@@ -190,21 +297,87 @@ public:
      * @param outputs Outputs of the network (tensor outputs).
      */
     void Forward(AnyTensorOutputs &outputs) {
-        //        LOGD("ppPreProcess");
-        if (m_nn_inference_->PreProcess(m_input_tensor_info_list_) != InferenceWrapper::WrapperOk) {
-            INSPIRE_LOGD("PreProcess error");
+        Run();
+        for (const auto &view : UpdateViews(1, 1)) {
+            outputs.emplace_back(view.Name(), view.ToVector());
         }
-        //        LOGD("PreProcess");
-        if (m_nn_inference_->Process(m_output_tensor_info_list_) != InferenceWrapper::WrapperOk) {
-            INSPIRE_LOGD("Process error");
+    }
+
+    /**
+     * @brief Performs a forward pass of one image without copying the outputs.
+     * @param image Image of the input size.
+     * @return const AnyTensorViews& Views of the output tensors, valid until the next forward of this adapter.
+     */
+    const AnyTensorViews &ForwardViews(const inspirecv::Image &image) {
+        SetImageInput(image);
+        Run();
+        return UpdateViews(1, 1);
+    }
+
+    /**
+     * @brief Performs a forward pass over several images of the input size.
+     * @details The images are stacked along the batch dimension when the engine and the model allow it,
+     * otherwise they are run one by one. The batch is rounded up to a power of two so that the session is
+     * only resized when the number of images changes a lot, the padding rows are dropped from the outputs.
+     * @param images Images of the input size.
+     * @param outputs Outputs of the network, each tensor holds the rows of every image one after the other.
+     */
+    void ForwardBatch(const std::vector<inspirecv::Image> &images, AnyTensorOutputs &outputs) {
+        outputs.clear();
+        ForwardBatchPasses(images, [&](size_t) { AppendViews(m_output_views_, outputs); });
+    }
+
+    /**
+     * @brief Performs a forward pass over several images of the input size without copying the outputs when possible.
+     * @details When the images run in a single pass the views point in the output tensors, otherwise the rows
+     * of the passes are gathered in buffers of the adapter, kept from one call to the next.
+     * @param images Images of the input size.
+     * @return const AnyTensorViews& Views of the output tensors, each holds the rows of every image one after the
+     * other, valid until the next forward of this adapter. Empty when there is no image.
+     */
+    const AnyTensorViews &ForwardBatchViews(const std::vector<inspirecv::Image> &images) {
+        m_output_views_.clear();
+        bool gathered = false;
+        ForwardBatchPasses(images, [&](size_t count) {
+            if (count == images.size()) {
+                // The only pass, the views already hold every image
+                return;
+            }
+            if (!gathered) {
+                m_gathered_outputs_.resize(m_output_views_.size());
+                for (auto &rows : m_gathered_outputs_) {
+                    rows.clear();
+                }
+                gathered = true;
+            }
+            for (size_t i = 0; i < m_output_views_.size(); ++i) {
+                m_gathered_outputs_[i].insert(m_gathered_outputs_[i].end(), m_output_views_[i].begin(), m_output_views_[i].end());
+            }
+        });
+        if (gathered) {
+            m_output_views_.clear();
+            for (size_t i = 0; i < m_gathered_outputs_.size(); ++i) {
+                const auto &info = m_output_tensor_info_list_[i];
+                m_output_views_.emplace_back(info.name, m_gathered_outputs_[i].data(), m_gathered_outputs_[i].size(),
+                                             static_cast<int32_t>(images.size()), &info.tensor_dims, info.is_nchw);
+            }
         }
-        //        LOGD("Process");
-        for (int i = 0; i < m_output_tensor_info_list_.size(); ++i) {
-            std::vector<float> output_score_raw_list(m_output_tensor_info_list_[i].GetDataAsFloat(),
-                                                     m_output_tensor_info_list_[i].GetDataAsFloat() + m_output_tensor_info_list_[i].GetElementNum());
-            //            LOGE("m_output_tensor_info_list_[i].GetElementNum(): %d",m_output_tensor_info_list_[i].GetElementNum());
-            outputs.push_back(std::make_pair(m_output_tensor_info_list_[i].name, output_score_raw_list));
+        return m_output_views_;
+    }
+
+    /**
+     * @brief Splits a tensor returned by ForwardBatch into the rows of each image.
+     * @param tensor Tensor holding the rows of every image.
+     * @param count Number of images.
+     * @return std::vector<std::vector<float>> Rows of each image.
+     */
+    static std::vector<std::vector<float>> SplitBatch(const std::vector<float> &tensor, size_t count) {
+        std::vector<std::vector<float>> rows(count);
+        const size_t row_size = count == 0 ? 0 : tensor.size() / count;
+        for (size_t i = 0; i < count; ++i) {
+            rows[i].assign(tensor.begin() + i * row_size, tensor.begin() + (i + 1) * row_size);
         }
+        return rows;
     }
 
 public:
@@ -257,6 +430,130 @@ public:
         return result;
     }
 
+private:
+    // FNV-1a hash of the model content
+    static uint64_t HashModelBuffer(const char *buffer, size_t size) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ static_cast<uint8_t>(buffer[i])) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    // Points the input at the image, a single one
+    void SetImageInput(const inspirecv::Image &image) {
+        SetInputBatch(1);
+        InputTensorInfo &input_tensor_info = getMInputTensorInfoList()[0];
+        if (m_infer_type_ == InferenceWrapper::INFER_RKNN) {
+            if (getData<bool>("swap_color")) {
+                m_cache_ = image.SwapRB();
+                input_tensor_info.data = (uint8_t *)m_cache_.Data();
+            } else {
+                input_tensor_info.data = (uint8_t *)image.Data();
+            }
+        } else {
+            input_tensor_info.data = (uint8_t *)image.Data();
+        }
+    }
+
+    // Runs the engine on the current input, the results stay in the output tensors
+    void Run() {
+        if (m_nn_inference_->PreProcess(m_input_tensor_info_list_) != InferenceWrapper::WrapperOk) {
+            INSPIRE_LOGD("PreProcess error");
+        }
+        if (m_nn_inference_->Process(m_output_tensor_info_list_) != InferenceWrapper::WrapperOk) {
+            INSPIRE_LOGD("Process error");
+        }
+    }
+
+    // Views the first count images of the output tensors of a pass over batch images
+    const AnyTensorViews &UpdateViews(int32_t batch, size_t count) {
+        m_output_views_.clear();
+        for (auto &info : m_output_tensor_info_list_) {
+            const size_t size = static_cast<size_t>(info.GetElementNum()) / batch * count;
+            m_output_views_.emplace_back(info.name, info.GetDataAsFloat(), size, static_cast<int32_t>(count), &info.tensor_dims, info.is_nchw);
+        }
+        return m_output_views_;
+    }
+
+    // Runs the images in as few passes as possible, stacked along the batch when allowed. After each pass
+    // consume(count) is called with m_output_views_ holding the rows of its count images
+    template <typename ConsumeT>
+    void ForwardBatchPasses(const std::vector<inspirecv::Image> &images, ConsumeT consume) {
+        const InputTensorInfo &input_tensor_info = m_input_tensor_info_list_[0];
+        const size_t image_bytes = static_cast<size_t>(input_tensor_info.image_info.width) * input_tensor_info.image_info.height *
+                                   input_tensor_info.image_info.channel;
+        bool batch = m_batch_enabled_ && images.size() > 1;
+        for (const auto &image : images) {
+            batch = batch && static_cast<size_t>(image.Width()) * image.Height() * image.Channels() == image_bytes;
+        }
+        const size_t max_batch = 32;
+        size_t start = 0;
+        while (batch && start < images.size()) {
+            size_t count = (std::min)(max_batch, images.size() - start);
+            batch = ForwardBatchChunk(images, start, count, image_bytes);
+            if (batch) {
+                consume(count);
+                start += count;
+            }
+        }
+        for (; start < images.size(); ++start) {
+            ForwardViews(images[start]);
+            consume(1);
+        }
+    }
+
+    // Resizes the input to the given batch, only when it changes since resizing reallocates the session
+    void SetInputBatch(int32_t batch) {
+        InputTensorInfo &input_tensor_info = m_input_tensor_info_list_[0];
+        if (input_tensor_info.tensor_dims.empty() || input_tensor_info.tensor_dims[0] == batch) {
+            return;
+        }
+        input_tensor_info.tensor_dims[0] = batch;
+        m_nn_inference_->ResizeInput(m_input_tensor_info_list_);
+    }
+
+    // Runs count images from start in one pass, padded with copies of the last one up to a power of two, and
+    // views their rows. Returns false when the model does not follow the batch
+    bool ForwardBatchChunk(const std::vector<inspirecv::Image> &images, size_t start, size_t count, size_t image_bytes) {
+        int32_t batch = 1;
+        while (static_cast<size_t>(batch) < count) {
+            batch <<= 1;
+        }
+        SetInputBatch(batch);
+        m_batch_buffer_.resize(batch * image_bytes);
+        for (int32_t b = 0; b < batch; ++b) {
+            const auto &image = images[start + (std::min)(static_cast<size_t>(b), count - 1)];
+            std::memcpy(m_batch_buffer_.data() + b * image_bytes, image.Data(), image_bytes);
+        }
+        m_input_tensor_info_list_[0].data = m_batch_buffer_.data();
+
+        Run();
+        for (const auto &output : m_output_tensor_info_list_) {
+            if (output.GetBatch() != batch) {
+                INSPIRE_LOGW("%s does not support a dynamic batch, falling back to one image per pass", m_name_.c_str());
+                m_batch_enabled_ = false;
+                SetInputBatch(1);
+                return false;
+            }
+        }
+        UpdateViews(batch, count);
+        return true;
+    }
+
+    // Appends a copy of the rows of each viewed tensor to the same tensor of dst
+    static void AppendViews(const AnyTensorViews &src, AnyTensorOutputs &dst) {
+        if (dst.empty()) {
+            for (const auto &view : src) {
+                dst.emplace_back(view.Name(), view.ToVector());
+            }
+            return;
+        }
+        for (size_t i = 0; i < src.size() && i < dst.size(); ++i) {
+            dst[i].second.insert(dst[i].second.end(), src[i].begin(), src[i].end());
+        }
+    }
+
 protected:
     std::string m_name_;  ///< Name of the neural network.
 
@@ -269,6 +566,10 @@ private:
     std::vector<OutputTensorInfo> m_output_tensor_info_list_;  ///< List of output tensor information.
     inspirecv::Size<int> m_input_image_size_{};                ///< Size of the input image.
     inspirecv::Image m_cache_;                                 ///< Cached matrix for image data.
+    bool m_batch_enabled_{false};                              ///< Whether ForwardBatch stacks images along the batch.
+    std::vector<uint8_t> m_batch_buffer_;                      ///< Images of the current batch, one after the other.
+    AnyTensorViews m_output_views_;                            ///< Views of the outputs of the last forward.
+    std::vector<std::vector<float>> m_gathered_outputs_;       ///< Rows of the batches run in several passes.
 };
 
 template <typename ImageT, typename TensorT>
@@ -234,8 +234,22 @@ public:
         return WrapperOk;
     };
 
+    // Wrappers initialized with the same key share the loaded model where the engine allows it, their
+    // inferences may then run one at a time. The key must identify the model content. Empty (the
+    // default) loads a private copy
+    virtual int32_t SetSharedModelKey(const std::string& key) {
+        shared_model_key_ = key;
+        return WrapperOk;
+    };
+
     virtual int32_t ResizeInput(const std::vector<InputTensorInfo>& input_tensor_info_list) = 0;
 
+    // True when the batch of tensor_dims can be raised with ResizeInput, the images of an image
+    // input are then read one after the other from data
+    virtual bool SupportBatchInput() const {
+        return false;
+    }
+
     virtual std::vector<std::string> GetInputNames() = 0;
 
 protected:
@@ -252,6 +266,7 @@ protected:
     EngineType helper_type_;
     SpecialBackend special_backend_ = DEFAULT_CPU;
     int32_t device_id_ = 0;
+    std::string shared_model_key_;
 };
 
 #endif
@@ -19,8 +19,59 @@
 
 using namespace inspire;
 
+MNNInterpreterRegistry& MNNInterpreterRegistry::GetInstance() {
+    static MNNInterpreterRegistry registry;
+    return registry;
+}
+
+std::shared_ptr<MNNInterpreterRegistry::Entry> MNNInterpreterRegistry::Acquire(const std::string& key,
+                                                                              const std::function<MNN::Interpreter*()>& create) {
+    if (key.empty()) {
+        auto entry = std::make_shared<Entry>();
+        entry->net.reset(create());
+        return entry;
+    }
+    // Loading under the lock keeps two sessions created at once from parsing the same model twice
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        auto entry = it->second.lock();
+        if (entry) {
+            return entry;
+        }
+    }
+    auto entry = std::make_shared<Entry>();
+    entry->net.reset(create());
+    if (!entry->net) {
+        return entry;
+    }
+    // Drop the entries whose models were released meanwhile
+    for (auto expired = entries_.begin(); expired != entries_.end();) {
+        if (expired->second.expired()) {
+            expired = entries_.erase(expired);
+        } else {
+            ++expired;
+        }
+    }
+    entries_[key] = entry;
+    return entry;
+}
+
+size_t MNNInterpreterRegistry::GetModelCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (auto& entry : entries_) {
+        if (!entry.second.expired()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
 InferenceWrapperMNN::InferenceWrapperMNN() {
     num_threads_ = 1;
+    net_ = nullptr;
+    session_ = nullptr;
 }
 
 InferenceWrapperMNN::~InferenceWrapperMNN() {}
@@ -112,7 +163,9 @@ int32_t InferenceWrapperMNN::ParameterInitialization(std::vector<InputTensorInfo
 
 int32_t InferenceWrapperMNN::Initialize(char* model_buffer, int model_size, std::vector<InputTensorInfo>& input_tensor_info_list,
                                         std::vector<OutputTensorInfo>& output_tensor_info_list) {
-    net_.reset(MNN::Interpreter::createFromBuffer(model_buffer, model_size));
+    model_ = MNNInterpreterRegistry::GetInstance().Acquire(shared_model_key_,
+                                                           [&]() { return MNN::Interpreter::createFromBuffer(model_buffer, model_size); });
+    net_ = model_->net.get();
     if (!net_) {
         PRINT_E("Failed to load model model buffer\n");
         return WrapperError;
@@ -132,21 +185,24 @@ int32_t InferenceWrapperMNN::Initialize(char* model_buffer, int model_size, std:
     }
     scheduleConfig.backendConfig = &bnconfig;
 
+    std::lock_guard<std::mutex> lock(model_->mutex);
     session_ = net_->createSession(scheduleConfig);
-    for (auto& item : net_->getSessionInputAll(session_)) {
-        input_names_.push_back(item.first.c_str());
-    }
     if (!session_) {
         PRINT_E("Failed to create session\n");
         return WrapperError;
     }
+    for (auto& item : net_->getSessionInputAll(session_)) {
+        input_names_.push_back(item.first.c_str());
+    }
 
     return ParameterInitialization(input_tensor_info_list, output_tensor_info_list);
 }
 
 int32_t InferenceWrapperMNN::Initialize(const std::string& model_filename, std::vector<InputTensorInfo>& input_tensor_info_list,
                                         std::vector<OutputTensorInfo>& output_tensor_info_list) {
-    net_.reset(MNN::Interpreter::createFromFile(model_filename.c_str()));
+    model_ = MNNInterpreterRegistry::GetInstance().Acquire(shared_model_key_,
+                                                           [&]() { return MNN::Interpreter::createFromFile(model_filename.c_str()); });
+    net_ = model_->net.get();
     if (!net_) {
         PRINT_E("Failed to load model file (%s)\n", model_filename.c_str());
         return WrapperError;
@@ -159,6 +215,7 @@ int32_t InferenceWrapperMNN::Initialize(const std::string& model_filename, std::
     // bnconfig.power = MNN::BackendConfig::Power_High;
     // bnconfig.precision = MNN::BackendConfig::Precision_Low;
     // scheduleConfig.backendConfig = &bnconfig;
+    std::lock_guard<std::mutex> lock(model_->mutex);
     session_ = net_->createSession(scheduleConfig);
     if (!session_) {
         PRINT_E("Failed to create session\n");
@@ -169,9 +226,14 @@ int32_t InferenceWrapperMNN::Initialize(const std::string& model_filename, std::
 };
 
 int32_t InferenceWrapperMNN::Finalize(void) {
-    net_->releaseSession(session_);
-    net_->releaseModel();
-    net_.reset();
+    if (net_ != nullptr && session_ != nullptr) {
+        std::lock_guard<std::mutex> lock(model_->mutex);
+        net_->releaseSession(session_);
+    }
+    session_ = nullptr;
+    // The last wrapper of the model destroys the interpreter
+    net_ = nullptr;
+    model_.reset();
     out_mat_list_.clear();
     return WrapperOk;
 }
@@ -240,8 +302,26 @@ int32_t InferenceWrapperMNN::PreProcess(const std::vector<InputTensorInfo>& inpu
             /* Do pre-process */
             std::shared_ptr<MNN::CV::ImageProcess> pretreat(MNN::CV::ImageProcess::create(image_processconfig));
             pretreat->setMatrix(trans);
-            pretreat->convert(static_cast<uint8_t*>(input_tensor_info.data), input_tensor_info.image_info.crop_width,
-                              input_tensor_info.image_info.crop_height, 0, input_tensor);
+            const int32_t batch = input_tensor_info.GetBatch();
+            if (batch <= 1) {
+                pretreat->convert(static_cast<uint8_t*>(input_tensor_info.data), input_tensor_info.image_info.crop_width,
+                                  input_tensor_info.image_info.crop_height, 0, input_tensor);
+            } else {
+                /* Batch: the images follow each other in data, each one is converted into its slice of a host tensor */
+                auto dim_type = input_tensor_info.is_nchw ? MNN::Tensor::CAFFE : MNN::Tensor::TENSORFLOW;
+                std::unique_ptr<MNN::Tensor> host(new MNN::Tensor(input_tensor, dim_type));
+                std::vector<int> item_shape = input_tensor_info.tensor_dims;
+                item_shape[0] = 1;
+                const size_t item_bytes = host->size() / batch;
+                const size_t image_bytes = static_cast<size_t>(input_tensor_info.image_info.crop_width) * input_tensor_info.image_info.crop_height *
+                                           input_tensor_info.image_info.channel;
+                for (int32_t b = 0; b < batch; b++) {
+                    std::unique_ptr<MNN::Tensor> item(MNN::Tensor::create(item_shape, host->getType(), host->host<uint8_t>() + b * item_bytes, dim_type));
+                    pretreat->convert(static_cast<uint8_t*>(input_tensor_info.data) + b * image_bytes, input_tensor_info.image_info.crop_width,
+                                      input_tensor_info.image_info.crop_height, 0, item.get());
+                }
+                input_tensor->copyFromHostTensor(host.get());
+            }
 
         } else if ((input_tensor_info.data_type == InputTensorInfo::DataTypeBlobNhwc) ||
                    (input_tensor_info.data_type == InputTensorInfo::DataTypeBlobNchw)) {
@@ -311,9 +391,11 @@ std::vector<std::string> InferenceWrapperMNN::GetInputNames() {
 }
 
 int32_t InferenceWrapperMNN::ResizeInput(const std::vector<InputTensorInfo>& input_tensor_info_list) {
+    std::lock_guard<std::mutex> lock(model_->mutex);
     for (const auto& input_tensor_info : input_tensor_info_list) {
         auto input_tensor = net_->getSessionInput(session_, input_tensor_info.name.c_str());
-        net_->resizeTensor(input_tensor, {1, input_tensor_info.GetChannel(), input_tensor_info.GetHeight(), input_tensor_info.GetWidth()});
+        const int32_t batch = (std::max)(1, input_tensor_info.GetBatch());
+        net_->resizeTensor(input_tensor, {batch, input_tensor_info.GetChannel(), input_tensor_info.GetHeight(), input_tensor_info.GetWidth()});
         net_->resizeSession(session_);
     }
     return 0;
@@ -7,11 +7,40 @@
 #include <vector>
 #include <array>
 #include <memory>
+#include <mutex>
+#include <functional>
+#include <unordered_map>
 #include <MNN/ImageProcess.hpp>
 #include <MNN/Interpreter.hpp>
 #include <MNN/AutoTime.hpp>
 #include "inference_wrapper.h"
 
+// Process-wide table of the interpreters loaded by the MNN wrappers given a shared model key, only set
+// when the models are shared (Launch::SetModelSharing). An interpreter holds the parsed model, the
+// wrappers of every session loading the same model create their MNN session from one interpreter
+// instead of parsing their own copy. runSession locks the interpreter, so the sessions of a shared
+// model run one at a time. Entries live as long as a wrapper uses them.
+class MNNInterpreterRegistry {
+public:
+    struct Entry {
+        std::unique_ptr<MNN::Interpreter> net;
+        std::mutex mutex;  // Guards creating, resizing and releasing the sessions of net
+    };
+
+    static MNNInterpreterRegistry& GetInstance();
+
+    // Returns the interpreter of key, created with create if no wrapper holds it. Empty key or a
+    // failed create returns an entry of its own
+    std::shared_ptr<Entry> Acquire(const std::string& key, const std::function<MNN::Interpreter*()>& create);
+
+    // Number of interpreters held by at least one wrapper
+    size_t GetModelCount();
+
+private:
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::weak_ptr<Entry>> entries_;
+};
+
 class InferenceWrapperMNN : public InferenceWrapper {
 public:
     InferenceWrapperMNN();
@@ -29,10 +58,15 @@ public:
 
     int32_t ResizeInput(const std::vector<InputTensorInfo>& input_tensor_info_list) override;
 
+    bool SupportBatchInput() const override {
+        return true;
+    }
+
     std::vector<std::string> GetInputNames() override;
 
 private:
-    std::unique_ptr<MNN::Interpreter> net_;
+    std::shared_ptr<MNNInterpreterRegistry::Entry> model_;
+    MNN::Interpreter* net_;  // Interpreter of model_, shared with the other wrappers of the model
     MNN::Session* session_;
     std::vector<std::unique_ptr<MNN::Tensor>> out_mat_list_;
     int32_t num_threads_;
@@ -0,0 +1,118 @@
+#ifndef INSPIRE_BOUNDED_QUEUE_H
+#define INSPIRE_BOUNDED_QUEUE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace inspire {
+namespace parallel {
+
+/**
+ * @brief BoundedQueue is a thread-safe FIFO holding at most a fixed number of items.
+ *
+ * Push blocks while the queue is full and Pop blocks while it is empty, which gives the stages of a
+ * pipeline back pressure. Close wakes every waiter: pushes fail from then on, pops drain what is left
+ * and fail once the queue is empty.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : m_capacity(capacity > 0 ? capacity : 1), m_closed(false) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * @brief Appends an item, waiting for a free slot.
+     * @return false if the queue was closed.
+     */
+    bool Push(T&& item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_full.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+        if (m_closed) {
+            return false;
+        }
+        m_items.push_back(std::move(item));
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Appends an item only if a slot is free.
+     * @return false if the queue is full or closed, the item is left untouched.
+     */
+    bool TryPush(T&& item) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_closed || m_items.size() >= m_capacity) {
+            return false;
+        }
+        m_items.push_back(std::move(item));
+        m_not_empty.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest item, waiting until one is available.
+     * @return false if the queue was closed and is empty.
+     */
+    bool Pop(T& item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_empty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+        return PopLocked(item);
+    }
+
+    /**
+     * @brief Removes the oldest item, waiting at most timeout_ms milliseconds.
+     * @return false on timeout, or if the queue was closed and is empty.
+     */
+    bool Pop(T& item, int64_t timeout_ms) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_empty.wait_for(lock, std::chrono::milliseconds(timeout_ms > 0 ? timeout_ms : 0),
+                             [this] { return m_closed || !m_items.empty(); });
+        return PopLocked(item);
+    }
+
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_not_full.notify_all();
+        m_not_empty.notify_all();
+    }
+
+    size_t Size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_items.size();
+    }
+
+    size_t Capacity() const {
+        return m_capacity;
+    }
+
+private:
+    bool PopLocked(T& item) {
+        if (m_items.empty()) {
+            return false;
+        }
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        m_not_full.notify_one();
+        return true;
+    }
+
+private:
+    const size_t m_capacity;
+    bool m_closed;
+    std::deque<T> m_items;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_not_empty;
+    std::condition_variable m_not_full;
+};
+
+}  // namespace parallel
+}  // namespace inspire
+
+#endif  // INSPIRE_BOUNDED_QUEUE_H
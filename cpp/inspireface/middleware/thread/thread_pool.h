@@ -0,0 +1,162 @@
+#ifndef INSPIRE_THREAD_POOL_H
+#define INSPIRE_THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace inspire {
+namespace parallel {
+
+/**
+ * @brief ThreadPool runs tasks on a fixed set of worker threads.
+ *
+ * Tasks are taken from a single queue in submission order. ParallelFor splits a loop over the
+ * workers and the calling thread, which keeps working until the loop is done, so it makes progress
+ * even when every worker is busy and it can be called from a task. A pool without workers runs
+ * everything on the calling thread.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t num_threads) : m_stop(false) {
+        m_workers.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            m_workers.emplace_back([this] { WorkerLoop(); });
+        }
+    }
+
+    /**
+     * @brief Runs the tasks still queued, then joins the workers.
+     */
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_condition.notify_all();
+        for (auto& worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t Size() const {
+        return m_workers.size();
+    }
+
+    /**
+     * @brief Queues a task.
+     * @param function Callable without arguments.
+     * @return Future receiving the result of the task.
+     */
+    template <typename Function>
+    auto Submit(Function&& function) -> std::future<decltype(function())> {
+        using Result = decltype(function());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+        std::future<Result> result = task->get_future();
+        if (m_workers.empty()) {
+            (*task)();
+        } else {
+            Enqueue([task] { (*task)(); });
+        }
+        return result;
+    }
+
+    /**
+     * @brief Calls function(i) for every i in [0, count) and returns once all calls are done.
+     * @param count Number of iterations, each one is a separate unit of work.
+     * @param function Callable taking the iteration index, calls may run concurrently.
+     */
+    template <typename Function>
+    void ParallelFor(size_t count, Function&& function) {
+        const size_t helpers = count > 0 ? std::min(count - 1, m_workers.size()) : 0;
+        if (helpers == 0) {
+            for (size_t i = 0; i < count; ++i) {
+                function(i);
+            }
+            return;
+        }
+        // Helpers that start after the last index was claimed return without touching function,
+        // so the caller only has to wait for the claimed iterations
+        auto state = std::make_shared<ParallelForState>(count);
+        const std::function<void(size_t)> body = [&function](size_t i) { function(i); };
+        state->body = &body;
+        for (size_t i = 0; i < helpers; ++i) {
+            Enqueue([state] { state->Run(); });
+        }
+        state->Run();
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->finished.wait(lock, [&state] { return state->done == state->count; });
+    }
+
+private:
+    struct ParallelForState {
+        explicit ParallelForState(size_t n) : count(n), next(0), done(0), body(nullptr) {}
+
+        void Run() {
+            size_t completed = 0;
+            for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+                (*body)(i);
+                ++completed;
+            }
+            if (completed > 0) {
+                std::lock_guard<std::mutex> lock(mutex);
+                done += completed;
+                if (done == count) {
+                    finished.notify_all();
+                }
+            }
+        }
+
+        const size_t count;
+        std::atomic<size_t> next;
+        size_t done;
+        const std::function<void(size_t)>* body;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+
+    void Enqueue(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push(std::move(task));
+        }
+        m_condition.notify_one();
+    }
+
+    void WorkerLoop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+                if (m_tasks.empty()) {
+                    return;
+                }
+                task = std::move(m_tasks.front());
+                m_tasks.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stop;
+};
+
+}  // namespace parallel
+}  // namespace inspire
+
+#endif  // INSPIRE_THREAD_POOL_H
@@ -11,20 +11,18 @@ namespace inspire {
 FaceAttributePredictAdapt::FaceAttributePredictAdapt() : AnyNetAdapter("FaceAttributePredictAdapt") {}
 
 std::vector<int> FaceAttributePredictAdapt::operator()(const inspirecv::Image &bgr_affine) {
-    AnyTensorOutputs outputs;
+    inspirecv::Image resized;
     if (bgr_affine.Width() != INPUT_WIDTH || bgr_affine.Height() != INPUT_HEIGHT) {
-        auto resized = bgr_affine.Resize(INPUT_WIDTH, INPUT_HEIGHT);
-        Forward(resized, outputs);
-    } else {
-        Forward(bgr_affine, outputs);
+        resized = bgr_affine.Resize(INPUT_WIDTH, INPUT_HEIGHT);
     }
+    const auto &outputs = ForwardViews(resized.Empty() ? bgr_affine : resized);
 
     // cv::imshow("w", bgr_affine);
     // cv::waitKey(0);
 
-    std::vector<float> &raceOut = outputs[0].second;
-    std::vector<float> &genderOut = outputs[1].second;
-    std::vector<float> &ageOut = outputs[2].second;
+    const AnyTensorView &raceOut = outputs[0];
+    const AnyTensorView &genderOut = outputs[1];
+    const AnyTensorView &ageOut = outputs[2];
 
     auto raceIdx = argmax(raceOut.begin(), raceOut.end());
     auto genderIdx = argmax(genderOut.begin(), genderOut.end());
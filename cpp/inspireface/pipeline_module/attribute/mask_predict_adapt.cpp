@@ -10,9 +10,9 @@ namespace inspire {
 MaskPredictAdapt::MaskPredictAdapt() : AnyNetAdapter("MaskPredictAdapt") {}
 
 float MaskPredictAdapt::operator()(const inspirecv::Image& bgr_affine) {
-    AnyTensorOutputs outputs;
+    const AnyTensorViews* outputs;
     if (bgr_affine.Height() == m_input_size_ && bgr_affine.Width() == m_input_size_) {
-        Forward(bgr_affine, outputs);
+        outputs = &ForwardViews(bgr_affine);
 
     } else {
         // auto resized = bgr_affine.Resize(m_input_size_, m_input_size_);
@@ -20,14 +20,14 @@ float MaskPredictAdapt::operator()(const inspirecv::Image& bgr_affine) {
         m_processor_->Resize(bgr_affine.Data(), bgr_affine.Width(), bgr_affine.Height(), bgr_affine.Channels(), &resized_data, m_input_size_,
                              m_input_size_);
         auto resized = inspirecv::Image::Create(m_input_size_, m_input_size_, bgr_affine.Channels(), resized_data, false);
-        Forward(resized, outputs);
+        outputs = &ForwardViews(resized);
     }
     m_processor_->MarkDone();
 #ifdef INFERENCE_WRAPPER_ENABLE_RKNN2
-    auto sm = Softmax(outputs[0].second);
+    auto sm = Softmax((*outputs)[0].ToVector());
     return sm[0];
 #else
-    return outputs[0].second[0];
+    return (*outputs)[0][0];
 #endif
 }
 
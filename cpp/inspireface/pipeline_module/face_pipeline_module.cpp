@@ -74,20 +74,19 @@ FacePipelineModule::FacePipelineModule(InspireArchive &archive, bool enableLiven
 }
 
 int32_t FacePipelineModule::Process(inspirecv::FrameProcess &processor, const FaceTrackWrap &face, FaceProcessFunctionOption proc) {
-    inspirecv::Image originImage;
-    inspirecv::Image scaleImage;
+    PipelineFrameCache cache;
+    cache.Reset(processor, 1);
+    return Process(cache, 0, face, proc);
+}
+
+int32_t FacePipelineModule::Process(PipelineFrameCache &cache, size_t face_index, const FaceTrackWrap &face, FaceProcessFunctionOption proc) {
     switch (proc) {
         case PROCESS_MASK: {
             if (m_mask_predict_ == nullptr) {
                 return HERR_SESS_PIPELINE_FAILURE;  // uninitialized
             }
-            std::vector<inspirecv::Point2f> pointsFive;
-            for (const auto &p : face.keyPoints) {
-                pointsFive.push_back(inspirecv::Point2f(p.x, p.y));
-            }
-
-            auto trans = inspirecv::SimilarityTransformEstimateUmeyama(SIMILARITY_TRANSFORM_DEST, pointsFive);
-            auto crop = processor.ExecuteImageAffineProcessing(trans, FACE_CROP_SIZE, FACE_CROP_SIZE);
+            // The aligned crop is shared with the attribute
+            const auto &crop = cache.GetAlignedCrop(face_index, face);
             auto mask_score = (*m_mask_predict_)(crop);
             // crop.Show();
             faceMaskCache = mask_score;
@@ -98,9 +97,7 @@ int32_t FacePipelineModule::Process(inspirecv::FrameProcess &processor, const Fa
                 return HERR_SESS_PIPELINE_FAILURE;  // uninitialized
             }
 
-            if (originImage.Empty()) {
-                originImage = processor.ExecuteImageScaleProcessing(1.0, true);
-            }
+            const auto &originImage = cache.GetOriginImage();
             inspirecv::Rect2i oriRect(face.rect.x, face.rect.y, face.rect.width, face.rect.height);
             auto rect = GetNewBox(originImage.Width(), originImage.Height(), oriRect, 2.7f);
             auto crop = originImage.Crop(rect);
@@ -113,15 +110,15 @@ int32_t FacePipelineModule::Process(inspirecv::FrameProcess &processor, const Fa
             if (m_blink_predict_ == nullptr) {
                 return HERR_SESS_PIPELINE_FAILURE;  // uninitialized
             }
-            if (originImage.Empty()) {
-                originImage = processor.ExecuteImageScaleProcessing(1.0, true);
-            }
+            // The origin image is shared with the liveness, the affine matrix below is the one it was produced with
+            const auto &originImage = cache.GetOriginImage();
+            const auto &originInverse = cache.GetOriginInverseMatrix();
             std::vector<std::vector<int>> order_list = {HLMK_LEFT_EYE_POINTS_INDEX, HLMK_RIGHT_EYE_POINTS_INDEX};
             eyesStatusCache = {0, 0};
             inspirecv::Point2f left_eye = inspirecv::Point2f(face.keyPoints[0].x, face.keyPoints[0].y);
             inspirecv::Point2f right_eye = inspirecv::Point2f(face.keyPoints[1].x, face.keyPoints[1].y);
             std::vector<inspirecv::Point2f> eyes = {left_eye, right_eye};
-            auto new_eyes_points = inspirecv::ApplyTransformToPoints(eyes, processor.GetAffineMatrix().GetInverse());
+            auto new_eyes_points = inspirecv::ApplyTransformToPoints(eyes, originInverse);
             for (size_t i = 0; i < order_list.size(); i++) {
                 const auto &index = order_list[i];
                 std::vector<inspirecv::Point2i> points;
@@ -129,8 +126,7 @@ int32_t FacePipelineModule::Process(inspirecv::FrameProcess &processor, const Fa
                     points.emplace_back(face.densityLandmark[idx].x, face.densityLandmark[idx].y);
                 }
                 auto rect = inspirecv::MinBoundingRect(points);
-                auto mat = processor.GetAffineMatrix();
-                auto new_rect = inspirecv::ApplyTransformToRect(rect, mat.GetInverse()).Square(1.3f);
+                auto new_rect = inspirecv::ApplyTransformToRect(rect, originInverse).Square(1.3f);
                 // Use more accurate 5 key point calibration
                 auto cx = new_eyes_points[i].GetX();
                 auto cy = new_eyes_points[i].GetY();
@@ -176,12 +172,7 @@ int32_t FacePipelineModule::Process(inspirecv::FrameProcess &processor, const Fa
             if (m_attribute_predict_ == nullptr) {
                 return HERR_SESS_PIPELINE_FAILURE;  // uninitialized
             }
-            std::vector<inspirecv::Point2f> pointsFive;
-            for (const auto &p : face.keyPoints) {
-                pointsFive.push_back(inspirecv::Point2f(p.x, p.y));
-            }
-            auto trans = inspirecv::SimilarityTransformEstimateUmeyama(SIMILARITY_TRANSFORM_DEST, pointsFive);
-            auto crop = processor.ExecuteImageAffineProcessing(trans, FACE_CROP_SIZE, FACE_CROP_SIZE);
+            const auto &crop = cache.GetAlignedCrop(face_index, face);
             auto outputs = (*m_attribute_predict_)(crop);
             faceAttributeCache = inspirecv::Vec3i{outputs[0], outputs[1], outputs[2]};
             break;
@@ -190,6 +181,35 @@ int32_t FacePipelineModule::Process(inspirecv::FrameProcess &processor, const Fa
     return HSUCCEED;
 }
 
+int32_t FacePipelineModule::ProcessRGBLiveness(const std::vector<inspirecv::FrameProcess *> &processors,
+                                               const std::vector<std::vector<FaceTrackWrap>> &faces, std::vector<float> &confidences) {
+    if (m_rgb_anti_spoofing_ == nullptr) {
+        return HERR_SESS_PIPELINE_FAILURE;  // uninitialized
+    }
+    // The scaled frames stay alive until the batch ran, the crops may share their data
+    std::vector<inspirecv::Image> originImages(processors.size());
+    std::vector<inspirecv::Image> crops;
+    for (size_t n = 0; n < processors.size(); ++n) {
+        if (faces[n].empty()) {
+            continue;
+        }
+        // The same crops as PROCESS_RGB_LIVENESS, each frame is only scaled once
+        auto &originImage = originImages[n];
+        originImage = processors[n]->ExecuteImageScaleProcessing(1.0, true);
+        for (const auto &face : faces[n]) {
+            inspirecv::Rect2i oriRect(face.rect.x, face.rect.y, face.rect.width, face.rect.height);
+            auto rect = GetNewBox(originImage.Width(), originImage.Height(), oriRect, 2.7f);
+            crops.push_back(originImage.Crop(rect));
+        }
+    }
+    if (crops.empty()) {
+        confidences.clear();
+        return HSUCCEED;
+    }
+    confidences = (*m_rgb_anti_spoofing_)(crops);
+    return HSUCCEED;
+}
+
 int32_t FacePipelineModule::Process(inspirecv::FrameProcess &processor, FaceObjectInternal &face) {
     // In the tracking state, the count meets the requirements or the pipeline is executed in the detection state
     auto lmk = face.keyPointFive;
@@ -14,6 +14,7 @@
 #include "liveness/blink_predict_adapt.h"
 #include "middleware/model_archive/inspire_archive.h"
 #include "face_warpper.h"
+#include "pipeline_frame_cache.h"
 
 namespace inspire {
 
@@ -68,6 +69,31 @@ public:
      */
     int32_t Process(inspirecv::FrameProcess &processor, const FaceTrackWrap &face, FaceProcessFunctionOption proc);
 
+    /**
+     * @brief Processes a face of a frame using the specified FaceProcessFunction.
+     *
+     * The images and transforms derived from the frame are taken from the cache, so they are computed once
+     * for all the options and all the faces of the frame.
+     *
+     * @param cache Artifacts of the frame, reset for the frame by the caller.
+     * @param face_index Index of the face in the frame.
+     * @param face FaceTrackWrap representing the detected face.
+     * @param proc The FaceProcessFunction to apply to the face.
+     * @return int32_t Status code indicating success (0) or failure.
+     */
+    int32_t Process(PipelineFrameCache &cache, size_t face_index, const FaceTrackWrap &face, FaceProcessFunctionOption proc);
+
+    /**
+     * @brief Runs RGB liveness detection on the faces of several frames in a single batch.
+     *
+     * @param processors Frame of each group of faces.
+     * @param faces Faces of each frame.
+     * @param confidences Receives the liveness confidence of each face, the faces of the first frame first.
+     * @return int32_t Status code indicating success (0) or failure.
+     */
+    int32_t ProcessRGBLiveness(const std::vector<inspirecv::FrameProcess *> &processors, const std::vector<std::vector<FaceTrackWrap>> &faces,
+                               std::vector<float> &confidences);
+
     /**
      * @brief Get Rgb AntiSpoofing module
      * @return AntiSpoofing module
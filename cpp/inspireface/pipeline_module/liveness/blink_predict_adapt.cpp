@@ -11,16 +11,11 @@ namespace inspire {
 BlinkPredictAdapt::BlinkPredictAdapt() : AnyNetAdapter("BlinkPredictAdapt") {}
 
 float BlinkPredictAdapt::operator()(const inspirecv::Image &bgr_affine) {
-    AnyTensorOutputs outputs;
-    if (bgr_affine.Width() == BLINK_EYE_INPUT_SIZE && bgr_affine.Height() == BLINK_EYE_INPUT_SIZE) {
-        auto input = bgr_affine.ToGray();
-        Forward(input, outputs);
-    } else {
-        auto input = bgr_affine.ToGray();
+    auto input = bgr_affine.ToGray();
+    if (bgr_affine.Width() != BLINK_EYE_INPUT_SIZE || bgr_affine.Height() != BLINK_EYE_INPUT_SIZE) {
         input = input.Resize(BLINK_EYE_INPUT_SIZE, BLINK_EYE_INPUT_SIZE);
-        Forward(input, outputs);
     }
-    auto &map = outputs[0].second;
+    const auto &map = ForwardViews(input)[0];
 
     return map[1];
 }
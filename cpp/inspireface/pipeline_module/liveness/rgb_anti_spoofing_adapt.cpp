@@ -13,7 +13,7 @@ RBGAntiSpoofingAdapt::RBGAntiSpoofingAdapt(int input_size, bool use_softmax) : A
 }
 
 float RBGAntiSpoofingAdapt::operator()(const inspirecv::Image& bgr_affine27) {
-    AnyTensorOutputs outputs;
+    const AnyTensorViews* outputs;
     if (bgr_affine27.Width() != m_input_size_ || bgr_affine27.Height() != m_input_size_) {
         // auto resized = bgr_affine27.Resize(m_input_size_, m_input_size_);
         uint8_t* resized_data = nullptr;
@@ -21,16 +21,45 @@ float RBGAntiSpoofingAdapt::operator()(const inspirecv::Image& bgr_affine27) {
         m_processor_->Resize(bgr_affine27.Data(), bgr_affine27.Width(), bgr_affine27.Height(), bgr_affine27.Channels(), &resized_data, m_input_size_,
                              m_input_size_);
         auto resized = inspirecv::Image::Create(m_input_size_, m_input_size_, bgr_affine27.Channels(), resized_data, false);
-        Forward(resized, outputs);
+        outputs = &ForwardViews(resized);
     } else {
-        Forward(bgr_affine27, outputs);
+        outputs = &ForwardViews(bgr_affine27);
     }
     if (m_softmax_) {
-        auto sm = Softmax(outputs[0].second);
+        auto sm = Softmax((*outputs)[0].ToVector());
         return sm[1];
     } else {
-        return outputs[0].second[1];
+        return (*outputs)[0][1];
     }
 }
 
+std::vector<float> RBGAntiSpoofingAdapt::operator()(const std::vector<inspirecv::Image>& bgr_affine27s) {
+    std::vector<inspirecv::Image> resized(bgr_affine27s.size());
+    for (size_t i = 0; i < bgr_affine27s.size(); ++i) {
+        const auto& bgr_affine27 = bgr_affine27s[i];
+        if (bgr_affine27.Width() == m_input_size_ && bgr_affine27.Height() == m_input_size_) {
+            resized[i] = bgr_affine27;
+            continue;
+        }
+        uint8_t* resized_data = nullptr;
+        m_processor_->Resize(bgr_affine27.Data(), bgr_affine27.Width(), bgr_affine27.Height(), bgr_affine27.Channels(), &resized_data, m_input_size_,
+                             m_input_size_);
+        // Copied, the processor buffer is released before the batch runs
+        resized[i] = inspirecv::Image::Create(m_input_size_, m_input_size_, bgr_affine27.Channels(), resized_data, true);
+        m_processor_->MarkDone();
+    }
+
+    const auto& outputs = ForwardBatchViews(resized);
+    std::vector<float> scores;
+    if (outputs.empty()) {
+        return scores;
+    }
+    scores.resize(bgr_affine27s.size());
+    for (size_t i = 0; i < scores.size(); ++i) {
+        const AnyTensorView row = outputs[0].Row(i);
+        scores[i] = m_softmax_ ? Softmax(row.ToVector())[1] : row[1];
+    }
+    return scores;
+}
+
 }  // namespace inspire
\ No newline at end of file
@@ -34,6 +34,14 @@ public:
      */
     float operator()(const inspirecv::Image& bgr_affine27);
 
+    /**
+     * @brief Performs RGB anti-spoofing on several face crops in a single forward pass.
+     *
+     * @param bgr_affine27s The face crops, resized to the input size when needed.
+     * @return std::vector<float> The anti-spoofing result of each crop, empty when the inference failed.
+     */
+    std::vector<float> operator()(const std::vector<inspirecv::Image>& bgr_affine27s);
+
 private:
     int m_input_size_;        ///< The input size for the model.
     bool m_softmax_ = false;  ///< Whether to use softmax activation.
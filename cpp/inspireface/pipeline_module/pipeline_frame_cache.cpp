@@ -0,0 +1,63 @@
+/**
+ * Created by Jingyu Yan
+ * @date 2024-10-01
+ */
+
+#include "pipeline_frame_cache.h"
+#include "recognition_module/dest_const.h"
+
+namespace inspire {
+
+void PipelineFrameCache::Reset(inspirecv::FrameProcess &processor, size_t num_faces) {
+    m_processor_ = &processor;
+    m_has_origin_ = false;
+    m_origin_image_ = inspirecv::Image();
+    m_align_transforms_.resize(num_faces);
+    m_has_transform_.assign(num_faces, 0);
+    if (m_aligned_crops_.size() < num_faces) {
+        m_aligned_crops_.resize(num_faces);
+    }
+    m_has_crop_.assign(num_faces, 0);
+}
+
+inspirecv::FrameProcess &PipelineFrameCache::GetProcessor() {
+    return *m_processor_;
+}
+
+const inspirecv::Image &PipelineFrameCache::GetOriginImage() {
+    if (!m_has_origin_) {
+        m_origin_image_ = m_processor_->ExecuteImageScaleProcessing(1.0, true);
+        // The scaling set the affine matrix of the processor to the one of the origin image
+        m_origin_inverse_ = m_processor_->GetAffineMatrix().GetInverse();
+        m_has_origin_ = true;
+    }
+    return m_origin_image_;
+}
+
+const inspirecv::TransformMatrix &PipelineFrameCache::GetOriginInverseMatrix() {
+    GetOriginImage();
+    return m_origin_inverse_;
+}
+
+const inspirecv::TransformMatrix &PipelineFrameCache::GetAlignTransform(size_t index, const FaceTrackWrap &face) {
+    if (!m_has_transform_[index]) {
+        std::vector<inspirecv::Point2f> pointsFive;
+        for (const auto &p : face.keyPoints) {
+            pointsFive.push_back(inspirecv::Point2f(p.x, p.y));
+        }
+        m_align_transforms_[index] = inspirecv::SimilarityTransformEstimateUmeyama(SIMILARITY_TRANSFORM_DEST, pointsFive);
+        m_has_transform_[index] = 1;
+    }
+    return m_align_transforms_[index];
+}
+
+const inspirecv::Image &PipelineFrameCache::GetAlignedCrop(size_t index, const FaceTrackWrap &face) {
+    if (!m_has_crop_[index]) {
+        auto trans = GetAlignTransform(index, face);
+        m_processor_->ExecuteImageAffineProcessing(trans, FACE_CROP_SIZE, FACE_CROP_SIZE, m_aligned_crops_[index]);
+        m_has_crop_[index] = 1;
+    }
+    return m_aligned_crops_[index];
+}
+
+}  // namespace inspire
@@ -0,0 +1,76 @@
+/**
+ * Created by Jingyu Yan
+ * @date 2024-10-01
+ */
+#pragma once
+#ifndef INSPIRE_FACE_PIPELINE_FRAME_CACHE_H
+#define INSPIRE_FACE_PIPELINE_FRAME_CACHE_H
+
+#include <cstdint>
+#include <vector>
+#include <inspirecv/inspirecv.h>
+#include "frame_process.h"
+#include "face_warpper.h"
+
+namespace inspire {
+
+/**
+ * @class PipelineFrameCache
+ * @brief Images and transforms derived from a frame, shared by every pipeline option and every face of the frame.
+ *
+ * Each artifact is computed on first use: the full resolution upright frame used by the RGB liveness and the
+ * interaction, and for each face its alignment transform and 112 aligned crop used by the mask and the attribute.
+ * Reset starts the next frame and keeps the buffers of the crops.
+ */
+class PipelineFrameCache {
+public:
+    /**
+     * @brief Starts a new frame.
+     * @param processor Frame the artifacts are derived from, it must outlive their use.
+     * @param num_faces Number of faces of the frame.
+     */
+    void Reset(inspirecv::FrameProcess &processor, size_t num_faces);
+
+    /**
+     * @brief Frame processor of the current frame.
+     */
+    inspirecv::FrameProcess &GetProcessor();
+
+    /**
+     * @brief Frame at full resolution with the rotation applied.
+     */
+    const inspirecv::Image &GetOriginImage();
+
+    /**
+     * @brief Inverse of the affine matrix of the processor once the origin image is produced.
+     */
+    const inspirecv::TransformMatrix &GetOriginInverseMatrix();
+
+    /**
+     * @brief Similarity transform aligning the five key points of a face.
+     * @param index Index of the face in the frame.
+     * @param face The face.
+     */
+    const inspirecv::TransformMatrix &GetAlignTransform(size_t index, const FaceTrackWrap &face);
+
+    /**
+     * @brief Aligned crop of a face, FACE_CROP_SIZE on each side.
+     * @param index Index of the face in the frame.
+     * @param face The face.
+     */
+    const inspirecv::Image &GetAlignedCrop(size_t index, const FaceTrackWrap &face);
+
+private:
+    inspirecv::FrameProcess *m_processor_ = nullptr;
+    inspirecv::Image m_origin_image_;
+    inspirecv::TransformMatrix m_origin_inverse_;
+    bool m_has_origin_ = false;
+    std::vector<inspirecv::TransformMatrix> m_align_transforms_;
+    std::vector<inspirecv::Image> m_aligned_crops_;  ///< Kept from frame to frame, their buffers are reused
+    std::vector<uint8_t> m_has_transform_;
+    std::vector<uint8_t> m_has_crop_;
+};
+
+}  // namespace inspire
+
+#endif  // INSPIRE_FACE_PIPELINE_FRAME_CACHE_H
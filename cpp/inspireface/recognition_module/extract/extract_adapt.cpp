@@ -8,17 +8,11 @@
 namespace inspire {
 
 Embedded ExtractAdapt::GetFaceFeature(const inspirecv::Image &bgr_affine) {
-    AnyTensorOutputs outputs;
-    Forward(bgr_affine, outputs);
-
-    return outputs[0].second;
+    return ForwardViews(bgr_affine)[0].ToVector();
 }
 
 Embedded ExtractAdapt::operator()(const inspirecv::Image &bgr_affine, float &norm, bool normalize) {
-    AnyTensorOutputs outputs;
-    Forward(bgr_affine, outputs);
-
-    auto &embedded = outputs[0].second;
+    Embedded embedded = ForwardViews(bgr_affine)[0].ToVector();
     float mse = 0.0f;
     for (const auto &one : embedded) {
         mse += one * one;
@@ -35,6 +29,31 @@ Embedded ExtractAdapt::operator()(const inspirecv::Image &bgr_affine, float &nor
     return embedded;
 }
 
+std::vector<Embedded> ExtractAdapt::operator()(const std::vector<inspirecv::Image> &bgr_affines, std::vector<float> &norms, bool normalize) {
+    const auto &outputs = ForwardBatchViews(bgr_affines);
+    std::vector<Embedded> embeddings;
+    norms.assign(bgr_affines.size(), 0.0f);
+    if (outputs.empty()) {
+        return embeddings;
+    }
+    embeddings.resize(bgr_affines.size());
+    for (size_t i = 0; i < embeddings.size(); ++i) {
+        embeddings[i] = outputs[0].Row(i).ToVector();
+        float mse = 0.0f;
+        for (const auto &one : embeddings[i]) {
+            mse += one * one;
+        }
+        mse = sqrt(mse);
+        norms[i] = mse;
+        if (normalize) {
+            for (float &one : embeddings[i]) {
+                one /= mse;
+            }
+        }
+    }
+    return embeddings;
+}
+
 ExtractAdapt::ExtractAdapt() : AnyNetAdapter("ExtractAdapt") {}
 
 }  // namespace inspire
\ No newline at end of file
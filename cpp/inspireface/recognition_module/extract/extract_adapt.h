@@ -33,6 +33,15 @@ public:
      */
     Embedded operator()(const inspirecv::Image& bgr_affine, float& norm, bool normalize = true);
 
+    /**
+     * @brief Extracts the features of several affine-transformed face images in a single forward pass.
+     * @param bgr_affines Affine-transformed face images in BGR format.
+     * @param norms Receives the L2 norm of each feature.
+     * @param normalize Whether the obtained features are normalized.
+     * @return std::vector<Embedded> Feature of each image.
+     */
+    std::vector<Embedded> operator()(const std::vector<inspirecv::Image>& bgr_affines, std::vector<float>& norms, bool normalize = true);
+
     /**
      * @brief Gets the facial features from an affine-transformed face image.
      * @param bgr_affine Affine-transformed face image in BGR format.
@@ -83,6 +83,37 @@ int32_t FeatureExtractionModule::FaceExtract(inspirecv::FrameProcess &processor,
     return 0;
 }
 
+int32_t FeatureExtractionModule::FaceExtract(const std::vector<inspirecv::FrameProcess *> &processors,
+                                             const std::vector<std::vector<FaceTrackWrap>> &faces, std::vector<Embedded> &embeddings,
+                                             std::vector<float> &norms, bool normalize) {
+    if (m_extract_ == nullptr) {
+        return HERR_SESS_REC_EXTRACT_FAILURE;
+    }
+
+    std::vector<inspirecv::Image> crops;
+    for (size_t n = 0; n < processors.size(); ++n) {
+        for (const auto &face : faces[n]) {
+            std::vector<inspirecv::Point2f> pointsFive;
+            for (const auto &p : face.keyPoints) {
+                pointsFive.push_back(inspirecv::Point2f(p.x, p.y));
+            }
+            auto trans = inspirecv::SimilarityTransformEstimateUmeyama(SIMILARITY_TRANSFORM_DEST, pointsFive);
+            crops.push_back(processors[n]->ExecuteImageAffineProcessing(trans, FACE_CROP_SIZE, FACE_CROP_SIZE));
+        }
+    }
+    if (crops.empty()) {
+        embeddings.clear();
+        norms.clear();
+        return 0;
+    }
+    embeddings = (*m_extract_)(crops, norms, normalize);
+    if (embeddings.size() != crops.size()) {
+        return HERR_SESS_REC_EXTRACT_FAILURE;
+    }
+
+    return 0;
+}
+
 const std::shared_ptr<ExtractAdapt> &FeatureExtractionModule::getMExtract() const {
     return m_extract_;
 }
@@ -52,6 +52,18 @@ public:
      */
     int32_t FaceExtract(inspirecv::FrameProcess &processor, const FaceTrackWrap &face, Embedded &embedded, float &norm, bool normalize = true);
 
+    /**
+     * @brief Extracts the facial features of the faces of several frames in a single batch.
+     *
+     * @param processors Frame of each group of faces.
+     * @param faces Faces of each frame.
+     * @param embeddings Receives the feature of each face, the faces of the first frame first.
+     * @param norms Receives the L2 norm of each feature, in the order of embeddings.
+     * @return int32_t Status code indicating success (0) or failure.
+     */
+    int32_t FaceExtract(const std::vector<inspirecv::FrameProcess *> &processors, const std::vector<std::vector<FaceTrackWrap>> &faces,
+                        std::vector<Embedded> &embeddings, std::vector<float> &norms, bool normalize = true);
+
     /**
      * @brief Gets the Extract instance associated with this FaceRecognition.
      *
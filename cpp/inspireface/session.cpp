@@ -40,6 +40,18 @@ public:
         m_face_session_->SetTrackModeDetectInterval(detect_interval);
     }
 
+    void SetTrackModeAdaptiveDetect(int32_t max_interval) {
+        m_face_session_->SetTrackModeAdaptiveDetect(max_interval);
+    }
+
+    void SetTrackModeTiledDetect(int32_t tile_size, bool motion_only) {
+        m_face_session_->SetTrackModeTiledDetect(tile_size, motion_only);
+    }
+
+    int32_t SetTrackNumThreads(int32_t num_threads) {
+        return m_face_session_->SetTrackNumThreads(num_threads);
+    }
+
     int32_t FaceDetectAndTrack(inspirecv::FrameProcess& process, std::vector<FaceTrackWrap>& results) {
         int32_t ret = m_face_session_->FaceDetectAndTrack(process);
         if (ret < 0) {
@@ -193,6 +205,18 @@ void Session::SetTrackModeDetectInterval(int32_t detect_interval) {
     pImpl->SetTrackModeDetectInterval(detect_interval);
 }
 
+void Session::SetTrackModeAdaptiveDetect(int32_t max_interval) {
+    pImpl->SetTrackModeAdaptiveDetect(max_interval);
+}
+
+void Session::SetTrackModeTiledDetect(int32_t tile_size, bool motion_only) {
+    pImpl->SetTrackModeTiledDetect(tile_size, motion_only);
+}
+
+int32_t Session::SetTrackNumThreads(int32_t num_threads) {
+    return pImpl->SetTrackNumThreads(num_threads);
+}
+
 int32_t Session::FaceDetectAndTrack(inspirecv::FrameProcess& process, std::vector<FaceTrackWrap>& results) {
     return pImpl->FaceDetectAndTrack(process, results);
 }
@@ -0,0 +1,76 @@
+#include <memory>
+#include "stream_server.h"
+#include "engine/face_stream_server.h"
+
+namespace inspire {
+
+class StreamServer::Impl {
+public:
+    Impl() : m_stream_server_(std::make_unique<FaceStreamServer>()) {}
+
+    int32_t Configure(DetectModuleMode detect_mode, int32_t max_detect_face, CustomPipelineParameter param, int32_t detect_level_px,
+                      int32_t track_by_detect_mode_fps, int32_t num_workers, int32_t max_batch_streams, int32_t queue_capacity) {
+        return m_stream_server_->Configuration(detect_mode, max_detect_face, param, detect_level_px, track_by_detect_mode_fps, num_workers,
+                                               max_batch_streams, queue_capacity);
+    }
+
+    ~Impl() = default;
+
+    std::unique_ptr<FaceStreamServer> m_stream_server_;
+};
+
+StreamServer::StreamServer() : pImpl(std::make_unique<Impl>()) {}
+
+StreamServer::~StreamServer() = default;
+
+StreamServer::StreamServer(StreamServer&&) noexcept = default;
+
+StreamServer& StreamServer::operator=(StreamServer&&) noexcept = default;
+
+StreamServer StreamServer::Create(DetectModuleMode detect_mode, int32_t max_detect_face, const CustomPipelineParameter& param,
+                                  int32_t detect_level_px, int32_t track_by_detect_mode_fps, int32_t num_workers, int32_t max_batch_streams,
+                                  int32_t queue_capacity) {
+    StreamServer server;
+    server.pImpl->Configure(detect_mode, max_detect_face, param, detect_level_px, track_by_detect_mode_fps, num_workers, max_batch_streams,
+                            queue_capacity);
+    return server;
+}
+
+void StreamServer::SetTrackPreviewSize(int32_t preview_size) {
+    pImpl->m_stream_server_->SetTrackPreviewSize(preview_size);
+}
+
+void StreamServer::SetTrackModeDetectInterval(int32_t detect_interval) {
+    pImpl->m_stream_server_->SetTrackModeDetectInterval(detect_interval);
+}
+
+int32_t StreamServer::OpenStream(int32_t& stream_id) {
+    return pImpl->m_stream_server_->OpenStream(stream_id);
+}
+
+int32_t StreamServer::CloseStream(int32_t stream_id) {
+    return pImpl->m_stream_server_->CloseStream(stream_id);
+}
+
+void StreamServer::SetResultCallback(ResultCallback callback) {
+    pImpl->m_stream_server_->SetResultCallback(std::move(callback));
+}
+
+int32_t StreamServer::PushFrame(int32_t stream_id, const uint8_t* data, int32_t height, int32_t width, inspirecv::DATA_FORMAT data_format,
+                                inspirecv::ROTATION_MODE rotation_mode, bool block, uint64_t* frame_id) {
+    return pImpl->m_stream_server_->PushFrame(stream_id, data, height, width, data_format, rotation_mode, block, frame_id);
+}
+
+int32_t StreamServer::PollResult(FaceStreamResult& result, int64_t timeout_ms) {
+    return pImpl->m_stream_server_->PollResult(result, timeout_ms);
+}
+
+int32_t StreamServer::Flush() {
+    return pImpl->m_stream_server_->Flush();
+}
+
+void StreamServer::Stop() {
+    pImpl->m_stream_server_->Stop();
+}
+
+}  // namespace inspire
@@ -0,0 +1,65 @@
+#include <memory>
+#include "stream_session.h"
+#include "engine/face_stream_session.h"
+
+namespace inspire {
+
+class StreamSession::Impl {
+public:
+    Impl() : m_stream_session_(std::make_unique<FaceStreamSession>()) {}
+
+    int32_t Configure(DetectModuleMode detect_mode, int32_t max_detect_face, CustomPipelineParameter param, int32_t detect_level_px,
+                      int32_t track_by_detect_mode_fps, int32_t queue_capacity) {
+        return m_stream_session_->Configuration(detect_mode, max_detect_face, param, detect_level_px, track_by_detect_mode_fps, queue_capacity);
+    }
+
+    ~Impl() = default;
+
+    std::unique_ptr<FaceStreamSession> m_stream_session_;
+};
+
+StreamSession::StreamSession() : pImpl(std::make_unique<Impl>()) {}
+
+StreamSession::~StreamSession() = default;
+
+StreamSession::StreamSession(StreamSession&&) noexcept = default;
+
+StreamSession& StreamSession::operator=(StreamSession&&) noexcept = default;
+
+StreamSession StreamSession::Create(DetectModuleMode detect_mode, int32_t max_detect_face, const CustomPipelineParameter& param,
+                                    int32_t detect_level_px, int32_t track_by_detect_mode_fps, int32_t queue_capacity) {
+    StreamSession session;
+    session.pImpl->Configure(detect_mode, max_detect_face, param, detect_level_px, track_by_detect_mode_fps, queue_capacity);
+    return session;
+}
+
+void StreamSession::SetTrackPreviewSize(int32_t preview_size) {
+    pImpl->m_stream_session_->TrackSession().SetTrackPreviewSize(preview_size);
+}
+
+void StreamSession::SetTrackModeDetectInterval(int32_t detect_interval) {
+    pImpl->m_stream_session_->TrackSession().SetTrackModeDetectInterval(detect_interval);
+}
+
+void StreamSession::SetResultCallback(ResultCallback callback) {
+    pImpl->m_stream_session_->SetResultCallback(std::move(callback));
+}
+
+int32_t StreamSession::PushFrame(const uint8_t* data, int32_t height, int32_t width, inspirecv::DATA_FORMAT data_format,
+                                 inspirecv::ROTATION_MODE rotation_mode, bool block, uint64_t* frame_id) {
+    return pImpl->m_stream_session_->PushFrame(data, height, width, data_format, rotation_mode, block, frame_id);
+}
+
+int32_t StreamSession::PollResult(FaceStreamResult& result, int64_t timeout_ms) {
+    return pImpl->m_stream_session_->PollResult(result, timeout_ms);
+}
+
+int32_t StreamSession::Flush() {
+    return pImpl->m_stream_session_->Flush();
+}
+
+void StreamSession::Stop() {
+    pImpl->m_stream_session_->Stop();
+}
+
+}  // namespace inspire
@@ -0,0 +1,88 @@
+/**
+ * Created by Jingyu Yan
+ * @date 2024-10-01
+ */
+
+#include "detect_scheduler.h"
+#include <cstdlib>
+
+namespace inspire {
+
+DetectScheduler::DetectScheduler(int max_interval, float motion_threshold, float confidence_threshold, int weak_interval)
+: m_max_interval_(max_interval > 0 ? max_interval : 1),
+  m_motion_threshold_(motion_threshold),
+  m_confidence_threshold_(confidence_threshold),
+  m_weak_interval_(weak_interval > 0 ? weak_interval : 1),
+  m_frames_since_weak_(m_weak_interval_) {}
+
+bool DetectScheduler::Schedule(const inspirecv::Image &thumbnail, bool force) {
+    const int width = thumbnail.Width();
+    const int height = thumbnail.Height();
+    const size_t size = static_cast<size_t>(width) * height * thumbnail.Channels();
+    const uint8_t *data = thumbnail.Data();
+
+    // A track that stays weak is not detected again before the weak interval
+    const bool weak = m_weak_ && m_frames_since_weak_ + 1 >= m_weak_interval_;
+    bool detect = force || m_pending_ || weak || m_frames_since_detect_ + 1 >= m_max_interval_;
+    if (width != m_reference_width_ || height != m_reference_height_ || size != m_reference_.size()) {
+        // Nothing to compare with, the resolution or rotation of the stream changed
+        m_last_motion_ = 255.0f;
+        detect = true;
+    } else {
+        uint64_t energy = 0;
+        for (size_t i = 0; i < size; ++i) {
+            energy += std::abs(static_cast<int>(data[i]) - static_cast<int>(m_reference_[i]));
+        }
+        m_last_motion_ = size > 0 ? static_cast<float>(energy) / size : 0.0f;
+        detect = detect || m_last_motion_ >= m_motion_threshold_;
+    }
+
+    if (detect) {
+        // Later frames are compared with the last one the detector saw
+        m_reference_.assign(data, data + size);
+        m_reference_width_ = width;
+        m_reference_height_ = height;
+        m_frames_since_detect_ = 0;
+        m_pending_ = false;
+        m_frames_since_weak_ = m_weak_ ? 0 : m_frames_since_weak_ + 1;
+    } else {
+        m_frames_since_detect_++;
+        m_frames_since_weak_++;
+    }
+    return detect;
+}
+
+void DetectScheduler::ObserveTracks(size_t num_lost, float min_confidence) {
+    if (num_lost > 0) {
+        m_pending_ = true;
+    }
+    m_weak_ = min_confidence < m_confidence_threshold_;
+    if (!m_weak_) {
+        // The next track getting weak is detected right away
+        m_frames_since_weak_ = m_weak_interval_;
+    }
+}
+
+void DetectScheduler::Reset() {
+    m_reference_.clear();
+    m_reference_width_ = 0;
+    m_reference_height_ = 0;
+    m_frames_since_detect_ = 0;
+    m_pending_ = true;
+    m_weak_ = false;
+    m_frames_since_weak_ = m_weak_interval_;
+}
+
+float DetectScheduler::GetLastMotion() const {
+    return m_last_motion_;
+}
+
+int DetectScheduler::GetMaxInterval() const {
+    return m_max_interval_;
+}
+
+void DetectScheduler::SetWeakInterval(int weak_interval) {
+    m_weak_interval_ = weak_interval > 0 ? weak_interval : 1;
+}
+
+}  // namespace inspire
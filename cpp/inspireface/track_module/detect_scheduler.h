@@ -0,0 +1,92 @@
+/**
+ * Created by Jingyu Yan
+ * @date 2024-10-01
+ */
+#pragma once
+#ifndef INSPIRE_FACE_TRACK_MODULE_DETECT_SCHEDULER_H
+#define INSPIRE_FACE_TRACK_MODULE_DETECT_SCHEDULER_H
+#include <cstdint>
+#include <vector>
+#include <inspirecv/inspirecv.h>
+#include "data_type.h"
+
+namespace inspire {
+
+/**
+ * @class DetectScheduler
+ * @brief Decides on which frames the light track mode runs the detector.
+ *
+ * Instead of a fixed interval, the detector runs when the scene changed since the last detection,
+ * measured on a thumbnail of the frame, when a track got weak or was lost on the previous frame,
+ * and at the latest every max_interval frames. Static scenes are then detected rarely while new
+ * faces in a busy scene are found within a frame or two. A track that stays weak is detected again
+ * at most every weak_interval frames, so that it does not turn every frame into a detection.
+ */
+class INSPIRE_API DetectScheduler {
+public:
+    /**
+     * @brief Long side of the thumbnails passed to Schedule.
+     */
+    static const int THUMBNAIL_SIZE = 32;
+
+    /**
+     * @brief Constructor.
+     * @param max_interval Maximum number of frames between two detections.
+     * @param motion_threshold Mean absolute difference of the thumbnail pixels to the last detected one that triggers a detection.
+     * @param confidence_threshold Track confidence under which the next frame is detected.
+     * @param weak_interval Minimum number of frames between two detections asked by tracks that stay weak.
+     */
+    explicit DetectScheduler(int max_interval = 60, float motion_threshold = 8.0f, float confidence_threshold = 0.5f, int weak_interval = 10);
+
+    /**
+     * @brief Decides whether the current frame is detected.
+     * @param thumbnail Thumbnail of the frame, its long side is about THUMBNAIL_SIZE.
+     * @param force Detect anyway, e.g. when no face is tracked.
+     * @return bool True to run the detector on the frame.
+     */
+    bool Schedule(const inspirecv::Image &thumbnail, bool force);
+
+    /**
+     * @brief Reports the tracking result of the frame, a lost track makes the next frame detected.
+     * @details A track getting weak also makes the next frame detected, then every weak_interval frames while it stays weak.
+     * @param num_lost Number of tracks lost on the frame.
+     * @param min_confidence Lowest confidence of the remaining tracks, 1 if there are none.
+     */
+    void ObserveTracks(size_t num_lost, float min_confidence);
+
+    /**
+     * @brief Forgets the last detected thumbnail, the next frame is detected.
+     */
+    void Reset();
+
+    /**
+     * @brief Mean absolute difference between the last thumbnail and the last detected one.
+     */
+    float GetLastMotion() const;
+
+    int GetMaxInterval() const;
+
+    /**
+     * @brief Sets the minimum number of frames between two detections asked by tracks that stay weak.
+     */
+    void SetWeakInterval(int weak_interval);
+
+private:
+    int m_max_interval_;            ///< Maximum number of frames between two detections
+    float m_motion_threshold_;      ///< Motion energy triggering a detection
+    float m_confidence_threshold_;  ///< Track confidence triggering a detection
+    int m_weak_interval_;           ///< Minimum number of frames between two detections of a weak track
+
+    std::vector<uint8_t> m_reference_;  ///< Thumbnail of the last detected frame
+    int m_reference_width_ = 0;
+    int m_reference_height_ = 0;
+    int m_frames_since_detect_ = 0;  ///< Frames scheduled since the last detection
+    bool m_pending_ = true;          ///< A track signal asks for a detection on the next frame
+    bool m_weak_ = false;            ///< A track was weak on the last observed frame
+    int m_frames_since_weak_ = 0;    ///< Frames scheduled since the last detection of a weak track
+    float m_last_motion_ = 0.0f;
+};
+
+}  // namespace inspire
+
+#endif  // INSPIRE_FACE_TRACK_MODULE_DETECT_SCHEDULER_H
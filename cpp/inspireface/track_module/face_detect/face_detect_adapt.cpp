@@ -6,11 +6,81 @@
 #include "face_detect_adapt.h"
 #include "cost_time.h"
 #include "spend_timer.h"
+#include <algorithm>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#define ISF_DETECT_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define ISF_DETECT_NEON
+#endif
 
 namespace inspire {
 
+namespace {
+
+// Anchors per cell of the detection grid
+const int kAnchorsPerCell = 2;
+
+/**
+ * @brief Writes the indices of the scores above threshold to indices and returns how many there are.
+ * @details Most anchors of a frame are background, the scores are compared 8 at a time and only the
+ * groups holding a candidate are looked at one by one.
+ */
+size_t CompactAboveThreshold(const float *scores, size_t count, float threshold, int *indices) {
+    size_t found = 0;
+    size_t i = 0;
+#if defined(ISF_DETECT_SSE2)
+    const __m128 bar = _mm_set1_ps(threshold);
+    for (; i + 8 <= count; i += 8) {
+        int mask = _mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(scores + i), bar)) |
+                   (_mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(scores + i + 4), bar)) << 4);
+        while (mask != 0) {
+            int bit = 0;
+            while (((mask >> bit) & 1) == 0) {
+                ++bit;
+            }
+            indices[found++] = static_cast<int>(i + bit);
+            mask &= mask - 1;
+        }
+    }
+#elif defined(ISF_DETECT_NEON)
+    const float32x4_t bar = vdupq_n_f32(threshold);
+    for (; i + 8 <= count; i += 8) {
+        uint32x4_t above = vorrq_u32(vcgtq_f32(vld1q_f32(scores + i), bar), vcgtq_f32(vld1q_f32(scores + i + 4), bar));
+        uint32x2_t folded = vorr_u32(vget_low_u32(above), vget_high_u32(above));
+        if ((vget_lane_u32(folded, 0) | vget_lane_u32(folded, 1)) == 0) {
+            continue;
+        }
+        for (size_t j = i; j < i + 8; ++j) {
+            if (scores[j] > threshold) {
+                indices[found++] = static_cast<int>(j);
+            }
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        if (scores[i] > threshold) {
+            indices[found++] = static_cast<int>(i);
+        }
+    }
+    return found;
+}
+
+}  // namespace
+
 FaceDetectAdapt::FaceDetectAdapt(int input_size, float nms_threshold, float cls_threshold)
-: AnyNetAdapter("FaceDetectAdapt"), m_nms_threshold_(nms_threshold), m_cls_threshold_(cls_threshold), m_input_size_(input_size) {}
+: AnyNetAdapter("FaceDetectAdapt"),
+  m_nms_threshold_(nms_threshold),
+  m_cls_threshold_(cls_threshold),
+  m_input_size_(input_size),
+  m_strides_({8, 16, 32}) {
+    // The grid only depends on the input size, it is generated once instead of on every frame
+    m_anchor_grid_.resize(m_strides_.size());
+    for (size_t i = 0; i < m_strides_.size(); ++i) {
+        _generate_anchors(m_strides_[i], m_input_size_, kAnchorsPerCell, m_anchor_grid_[i]);
+    }
+}
 
 FaceLocList FaceDetectAdapt::operator()(const inspirecv::Image &bgr) {
     inspire::SpendTimer time_image_process("Image process");
@@ -30,29 +100,74 @@ FaceLocList FaceDetectAdapt::operator()(const inspirecv::Image &bgr) {
     // std::cout << time_image_process << std::endl;
     // pad.Write("pad.jpg");
     //    LOGD("Prepare");
-    AnyTensorOutputs outputs;
     inspire::SpendTimer time_forward("Forward");
     time_forward.Start();
-    Forward(pad, outputs);
+    const auto &outputs = ForwardViews(pad);
     time_forward.Stop();
     // std::cout << time_forward << std::endl;
     //    LOGD("Forward");
 
+    FaceLocList results = Decode(outputs, 0, scale);
+    m_processor_->MarkDone();
+
+    return results;
+}
+
+std::vector<FaceLocList> FaceDetectAdapt::operator()(const std::vector<inspirecv::Image> &bgrs) {
+    std::vector<inspirecv::Image> pads(bgrs.size());
+    std::vector<float> scales(bgrs.size());
+    for (size_t i = 0; i < bgrs.size(); ++i) {
+        uint8_t *resized_data = nullptr;
+        m_processor_->ResizeAndPadding(bgrs[i].Data(), bgrs[i].Width(), bgrs[i].Height(), bgrs[i].Channels(), m_input_size_, m_input_size_,
+                                       &resized_data, scales[i]);
+        // The processor reuses its buffer, each image keeps a copy until the batch runs
+        pads[i] = inspirecv::Image::Create(m_input_size_, m_input_size_, bgrs[i].Channels(), resized_data, true);
+        m_processor_->MarkDone();
+    }
+
+    const auto &outputs = ForwardBatchViews(pads);
+    std::vector<FaceLocList> results(bgrs.size());
+    if (outputs.empty()) {
+        return results;
+    }
+    for (size_t i = 0; i < bgrs.size(); ++i) {
+        results[i] = Decode(outputs, i, scales[i]);
+    }
+    return results;
+}
+
+void FaceDetectAdapt::MergeFaces(FaceLocList &faces) const {
+    _nms(faces, m_nms_threshold_);
+    std::sort(faces.begin(), faces.end(),
+              [](const FaceLoc &a, const FaceLoc &b) { return (a.y2 - a.y1) * (a.x2 - a.x1) > (b.y2 - b.y1) * (b.x2 - b.x1); });
+}
+
+FaceLocList FaceDetectAdapt::Decode(const AnyTensorOutputs &outputs, float scale) {
+    AnyTensorViews views;
+    views.reserve(outputs.size());
+    for (const auto &output : outputs) {
+        views.emplace_back(output);
+    }
+    return Decode(views, 0, scale);
+}
+
+FaceLocList FaceDetectAdapt::Decode(const AnyTensorViews &outputs, size_t index, float scale) {
     inspire::SpendTimer time_decode("Decode");
     time_decode.Start();
     std::vector<FaceLoc> results;
-    std::vector<int> strides = {8, 16, 32};
-    for (int i = 0; i < strides.size(); ++i) {
-        const std::vector<float> &tensor_cls = outputs[i].second;
-        const std::vector<float> &tensor_box = outputs[i + 3].second;
-        const std::vector<float> &tensor_lmk = outputs[i + 6].second;
-        _decode(tensor_cls, tensor_box, tensor_lmk, strides[i], results);
+    for (int i = 0; i < int(m_strides_.size()); ++i) {
+        const AnyTensorView tensor_cls = outputs[i].Row(index);
+        const AnyTensorView tensor_box = outputs[i + 3].Row(index);
+        const AnyTensorView tensor_lmk = outputs[i + 6].Row(index);
+        size_t num_anchors = std::min({m_anchor_grid_[i].size() / 2, tensor_cls.Size(), tensor_box.Size() / 4, tensor_lmk.Size() / 10});
+        _decode(tensor_cls.Data(), tensor_box.Data(), tensor_lmk.Data(), num_anchors, i, results);
     }
     time_decode.Stop();
     // std::cout << time_decode << std::endl;
 
     _nms(results, m_nms_threshold_);
-    std::sort(results.begin(), results.end(), [](FaceLoc a, FaceLoc b) { return (a.y2 - a.y1) * (a.x2 - a.x1) > (b.y2 - b.y1) * (b.x2 - b.x1); });
+    std::sort(results.begin(), results.end(),
+              [](const FaceLoc &a, const FaceLoc &b) { return (a.y2 - a.y1) * (a.x2 - a.x1) > (b.y2 - b.y1) * (b.x2 - b.x1); });
     for (auto &face : results) {
         face.x1 = face.x1 / scale;
         face.y1 = face.y1 / scale;
@@ -63,40 +178,53 @@ FaceLocList FaceDetectAdapt::operator()(const inspirecv::Image &bgr) {
             face.lmk[i * 2 + 1] = face.lmk[i * 2 + 1] / scale;
         }
     }
-    m_processor_->MarkDone();
-
     return results;
 }
 
 void FaceDetectAdapt::_nms(std::vector<FaceLoc> &input_faces, float nms_threshold) {
-    std::sort(input_faces.begin(), input_faces.end(), [](FaceLoc a, FaceLoc b) { return a.score > b.score; });
-    std::vector<float> area(input_faces.size());
-    for (int i = 0; i < int(input_faces.size()); ++i) {
-        area[i] = (input_faces.at(i).x2 - input_faces.at(i).x1 + 1) * (input_faces.at(i).y2 - input_faces.at(i).y1 + 1);
+    // A single sort by score, then the greedy pass works on packed coordinates and a list of the
+    // indices still alive, compacted in place after each kept face. The faces are moved only once
+    std::sort(input_faces.begin(), input_faces.end(), [](const FaceLoc &a, const FaceLoc &b) { return a.score > b.score; });
+    const int count = int(input_faces.size());
+    std::vector<float> x1(count), y1(count), x2(count), y2(count), area(count);
+    std::vector<int> alive(count);
+    for (int i = 0; i < count; ++i) {
+        x1[i] = input_faces[i].x1;
+        y1[i] = input_faces[i].y1;
+        x2[i] = input_faces[i].x2;
+        y2[i] = input_faces[i].y2;
+        area[i] = (x2[i] - x1[i] + 1) * (y2[i] - y1[i] + 1);
+        alive[i] = i;
     }
-    for (int i = 0; i < int(input_faces.size()); ++i) {
-        for (int j = i + 1; j < int(input_faces.size());) {
-            float xx1 = (std::max)(input_faces[i].x1, input_faces[j].x1);
-            float yy1 = (std::max)(input_faces[i].y1, input_faces[j].y1);
-            float xx2 = (std::min)(input_faces[i].x2, input_faces[j].x2);
-            float yy2 = (std::min)(input_faces[i].y2, input_faces[j].y2);
+    int kept = 0;
+    int remaining = count;
+    while (remaining > 0) {
+        const int i = alive[0];
+        int next = 0;
+        for (int k = 1; k < remaining; ++k) {
+            const int j = alive[k];
+            float xx1 = (std::max)(x1[i], x1[j]);
+            float yy1 = (std::max)(y1[i], y1[j]);
+            float xx2 = (std::min)(x2[i], x2[j]);
+            float yy2 = (std::min)(y2[i], y2[j]);
             float w = (std::max)(float(0), xx2 - xx1 + 1);
             float h = (std::max)(float(0), yy2 - yy1 + 1);
             float inter = w * h;
             float ovr = inter / (area[i] + area[j] - inter);
-            if (ovr >= nms_threshold) {
-                input_faces.erase(input_faces.begin() + j);
-                area.erase(area.begin() + j);
-            } else {
-                j++;
+            if (ovr < nms_threshold) {
+                alive[next++] = j;
             }
         }
+        remaining = next;
+        input_faces[kept++] = input_faces[i];
     }
+    input_faces.resize(kept);
 }
 
 void FaceDetectAdapt::_generate_anchors(int stride, int input_size, int num_anchors, std::vector<float> &anchors) {
     int height = ceil(input_size / stride);
     int width = ceil(input_size / stride);
+    anchors.reserve(anchors.size() + height * width * num_anchors * 2);
     for (int j = 0; j < height; ++j) {
         for (int i = 0; i < width; ++i) {
             for (int k = 0; k < num_anchors; ++k) {
@@ -107,36 +235,29 @@ void FaceDetectAdapt::_generate_anchors(int stride, int input_size, int num_anch
     }
 }
 
-void FaceDetectAdapt::_decode(const std::vector<float> &cls_pred, const std::vector<float> &box_pred, const std::vector<float> &lmk_pred, int stride,
+void FaceDetectAdapt::_decode(const float *cls_pred, const float *box_pred, const float *lmk_pred, size_t num_anchors, int stride_index,
                               std::vector<FaceLoc> &results) {
-    std::vector<float> anchors_center;
-    _generate_anchors(stride, m_input_size_, 2, anchors_center);
-
-    for (int i = 0; i < anchors_center.size() / 2; ++i) {
-        if (cls_pred[i] > m_cls_threshold_) {
-            FaceLoc faceInfo;
-            float cx = anchors_center[i * 2 + 0];
-            float cy = anchors_center[i * 2 + 1];
-            float x1 = cx - box_pred[i * 4 + 0] * stride;
-            float y1 = cy - box_pred[i * 4 + 1] * stride;
-            float x2 = cx + box_pred[i * 4 + 2] * stride;
-            float y2 = cy + box_pred[i * 4 + 3] * stride;
-            faceInfo.x1 = x1;
-            faceInfo.y1 = y1;
-            faceInfo.x2 = x2;
-            faceInfo.y2 = y2;
-            faceInfo.score = cls_pred[i];
-            //            if (use_kps_) {
-            for (int j = 0; j < 5; ++j) {
-                float px = cx + lmk_pred[i * 10 + j * 2 + 0] * stride;
-                float py = cy + lmk_pred[i * 10 + j * 2 + 1] * stride;
-                faceInfo.lmk[j * 2 + 0] = px;
-                faceInfo.lmk[j * 2 + 1] = py;
-            }
-            //            }
-            results.push_back(faceInfo);
+    const float *anchors_center = m_anchor_grid_[stride_index].data();
+    const float stride = static_cast<float>(m_strides_[stride_index]);
+    m_candidates_.resize(num_anchors);
+    size_t found = CompactAboveThreshold(cls_pred, num_anchors, m_cls_threshold_, m_candidates_.data());
+
+    results.reserve(results.size() + found);
+    for (size_t n = 0; n < found; ++n) {
+        const int i = m_candidates_[n];
+        FaceLoc faceInfo;
+        float cx = anchors_center[i * 2 + 0];
+        float cy = anchors_center[i * 2 + 1];
+        faceInfo.x1 = cx - box_pred[i * 4 + 0] * stride;
+        faceInfo.y1 = cy - box_pred[i * 4 + 1] * stride;
+        faceInfo.x2 = cx + box_pred[i * 4 + 2] * stride;
+        faceInfo.y2 = cy + box_pred[i * 4 + 3] * stride;
+        faceInfo.score = cls_pred[i];
+        for (int j = 0; j < 5; ++j) {
+            faceInfo.lmk[j * 2 + 0] = cx + lmk_pred[i * 10 + j * 2 + 0] * stride;
+            faceInfo.lmk[j * 2 + 1] = cy + lmk_pred[i * 10 + j * 2 + 1] * stride;
         }
-        std::sort(results.begin(), results.end(), SortBoxSizeAdapt);
+        results.push_back(faceInfo);
     }
 }
 
@@ -154,4 +275,4 @@ bool SortBoxSizeAdapt(const FaceLoc &a, const FaceLoc &b) {
     return sq_a > sq_b;
 }
 
-}  // namespace inspire
\ No newline at end of file
+}  // namespace inspire
@@ -35,6 +35,36 @@ public:
      */
     FaceLocList operator()(const inspirecv::Image &bgr);
 
+    /**
+     * @brief Detects faces in several images in a single forward pass.
+     * @param bgrs The input images in BGR format.
+     * @return std::vector<FaceLocList> Faces of each image, in the coordinates of that image.
+     */
+    std::vector<FaceLocList> operator()(const std::vector<inspirecv::Image> &bgrs);
+
+    /**
+     * @brief Merges the faces detected in overlapping parts of the same frame.
+     * @param faces Faces in the coordinates of the frame, the overlapping ones are suppressed, sorted by decreasing area.
+     */
+    void MergeFaces(FaceLocList &faces) const;
+
+    /**
+     * @brief Decodes the raw network outputs into faces, non-maximum suppression included.
+     * @param outputs Class, box and landmark tensors of the 3 strides, in the order given by the model.
+     * @param scale Scale applied to the image when it was resized to the input size.
+     * @return FaceLocList Faces in the coordinates of the original image, sorted by decreasing area.
+     */
+    FaceLocList Decode(const AnyTensorOutputs &outputs, float scale);
+
+    /**
+     * @brief Decodes the rows of one image of the network outputs into faces, non-maximum suppression included.
+     * @param outputs Class, box and landmark tensors of the 3 strides, in the order given by the model.
+     * @param index Index of the image in the batch.
+     * @param scale Scale applied to the image when it was resized to the input size.
+     * @return FaceLocList Faces in the coordinates of the original image, sorted by decreasing area.
+     */
+    FaceLocList Decode(const AnyTensorViews &outputs, size_t index, float scale);
+
     /** @brief Set non-maximum suppression threshold */
     void SetNmsThreshold(float mNmsThreshold);
 
@@ -60,19 +90,26 @@ private:
 
     /**
      * @brief Decodes network outputs to face locations.
-     * @param cls_pred Classification predictions.
-     * @param box_pred Bounding box predictions.
-     * @param lmk_pred Landmark predictions.
-     * @param stride The stride of the detection.
-     * @param results Decoded face locations.
+     * @details Only the anchors whose score passes the threshold are decoded, they are found with a
+     * vectorized pass over the scores.
+     * @param cls_pred Classification predictions, one per anchor.
+     * @param box_pred Bounding box predictions, 4 per anchor.
+     * @param lmk_pred Landmark predictions, 10 per anchor.
+     * @param num_anchors Number of anchors to decode.
+     * @param stride_index Index of the stride in the anchor tables.
+     * @param results Decoded face locations, appended.
      */
-    void _decode(const std::vector<float> &cls_pred, const std::vector<float> &box_pred, const std::vector<float> &lmk_pred, int stride,
+    void _decode(const float *cls_pred, const float *box_pred, const float *lmk_pred, size_t num_anchors, int stride_index,
                  std::vector<FaceLoc> &results);
 
 private:
     float m_nms_threshold_;  ///< Threshold for non-maximum suppression.
     float m_cls_threshold_;  ///< Threshold for classification score.
     int m_input_size_;       ///< Input size for the neural network model.
+
+    std::vector<int> m_strides_;                     ///< Strides of the 3 output levels.
+    std::vector<std::vector<float>> m_anchor_grid_;  ///< Anchor centers (x, y) of every stride, generated once.
+    std::vector<int> m_candidates_;                  ///< Anchors passing the threshold, reused across frames.
 };
 
 /**
@@ -14,18 +14,43 @@ float RNetAdapt::operator()(const inspirecv::Image &bgr_affine) {
     m_processor_->Resize(bgr_affine.Data(), bgr_affine.Width(), bgr_affine.Height(), bgr_affine.Channels(), &resized_data, 24, 24);
     auto resized = inspirecv::Image::Create(24, 24, bgr_affine.Channels(), resized_data, false);
 
-    AnyTensorOutputs outputs;
-    Forward(resized, outputs);
+    const auto &outputs = ForwardViews(resized);
     m_processor_->MarkDone();
 #ifdef INFERENCE_WRAPPER_ENABLE_RKNN2
-    auto sm = Softmax(outputs[0].second);
+    auto sm = Softmax(outputs[0].ToVector());
     return sm[1];
 #else
-    return outputs[0].second[1];
+    return outputs[0][1];
     // std::cout << outputs[0].second[0] << ", " << outputs[0].second[1] << std ::endl;
 #endif
 }
 
+std::vector<float> RNetAdapt::operator()(const std::vector<inspirecv::Image> &bgr_affines) {
+    std::vector<inspirecv::Image> resized(bgr_affines.size());
+    for (size_t i = 0; i < bgr_affines.size(); ++i) {
+        uint8_t *resized_data = nullptr;
+        const auto &bgr_affine = bgr_affines[i];
+        m_processor_->Resize(bgr_affine.Data(), bgr_affine.Width(), bgr_affine.Height(), bgr_affine.Channels(), &resized_data, 24, 24);
+        // Copied, the processor buffer is released before the batch runs
+        resized[i] = inspirecv::Image::Create(24, 24, bgr_affine.Channels(), resized_data, true);
+        m_processor_->MarkDone();
+    }
+
+    const auto &outputs = ForwardBatchViews(resized);
+    std::vector<float> scores(bgr_affines.size());
+    if (outputs.empty()) {
+        return scores;
+    }
+    for (size_t i = 0; i < scores.size(); ++i) {
+#ifdef INFERENCE_WRAPPER_ENABLE_RKNN2
+        scores[i] = Softmax(outputs[0].Row(i).ToVector())[1];
+#else
+        scores[i] = outputs[0].Row(i)[1];
+#endif
+    }
+    return scores;
+}
+
 RNetAdapt::RNetAdapt() : AnyNetAdapter("RNetAdapt") {}
 
 }  //  namespace inspire
\ No newline at end of file
@@ -30,6 +30,13 @@ public:
      * @return float Score representing the quality or confidence of the refinement.
      */
     float operator()(const inspirecv::Image& bgr_affine);
+
+    /**
+     * @brief Scores several affine-transformed face images in a single forward pass.
+     * @param bgr_affines Affine-transformed face images in BGR format.
+     * @return std::vector<float> Score of each image.
+     */
+    std::vector<float> operator()(const std::vector<inspirecv::Image>& bgr_affines);
 };
 
 }  //  namespace inspire
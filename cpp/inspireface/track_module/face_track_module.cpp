@@ -7,7 +7,10 @@
 #include "log.h"
 #include "landmark/mean_shape.h"
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #include "middleware/costman.h"
 #include "middleware/model_archive/inspire_archive.h"
 #include "middleware/utils.h"
@@ -18,6 +21,42 @@
 
 namespace inspire {
 
+namespace {
+
+// Distance in pixels to an inner edge of a tile under which a box is taken as cut by the edge
+const float kTileEdgeMargin = 2.0f;
+// Mean absolute difference of the thumbnail pixels of a tile that marks the tile as changed
+const float kTileMotionThreshold = 8.0f;
+// Side of a tile in the thumbnail comparing the tiles with the last time they were detected
+const int kTileThumbnailCells = 8;
+
+// Scales a box, then moves it by (dx, dy)
+void MapFaceLoc(FaceLoc &box, float scale, float dx, float dy) {
+    box.x1 = box.x1 * scale + dx;
+    box.y1 = box.y1 * scale + dy;
+    box.x2 = box.x2 * scale + dx;
+    box.y2 = box.y2 * scale + dy;
+    for (int i = 0; i < 5; ++i) {
+        box.lmk[i * 2 + 0] = box.lmk[i * 2 + 0] * scale + dx;
+        box.lmk[i * 2 + 1] = box.lmk[i * 2 + 1] * scale + dy;
+    }
+}
+
+// Start of the tiles along one side, the last tile ends with the side
+std::vector<int> TileStarts(int length, int tile_size, int stride) {
+    std::vector<int> starts;
+    for (int start = 0;; start += stride) {
+        if (start + tile_size >= length) {
+            starts.push_back((std::max)(0, length - tile_size));
+            break;
+        }
+        starts.push_back(start);
+    }
+    return starts;
+}
+
+}  // namespace
+
 FaceTrackModule::FaceTrackModule(DetectModuleMode mode, int max_detected_faces, int detection_interval, int track_preview_size,
                                  int dynamic_detection_input_level, int TbD_mode_fps, bool detect_mode_landmark)
 : m_mode_(mode),
@@ -42,21 +81,23 @@ FaceTrackModule::FaceTrackModule(DetectModuleMode mode, int max_detected_faces,
     }
 }
 
-void FaceTrackModule::SparseLandmarkPredict(const inspirecv::Image &raw_face_crop, std::vector<inspirecv::Point2f> &landmarks_output, float &score,
-                                            float size) {
+void FaceTrackModule::SparseLandmarkPredict(TrackNetworks &networks, const std::vector<inspirecv::Image> &raw_face_crops,
+                                            std::vector<std::vector<inspirecv::Point2f>> &landmarks_output, std::vector<float> &scores, float size) {
     COST_TIME_SIMPLE(SparseLandmarkPredict);
-    landmarks_output.resize(FaceLandmarkAdapt::NUM_OF_LANDMARK);
-    std::vector<float> lmk_out = (*m_landmark_predictor_)(raw_face_crop);
-    for (int i = 0; i < FaceLandmarkAdapt::NUM_OF_LANDMARK; ++i) {
-        float x = lmk_out[i * 2 + 0] * size;
-        float y = lmk_out[i * 2 + 1] * size;
-        landmarks_output[i] = inspirecv::Point<float>(x, y);
+    std::vector<std::vector<float>> lmk_outs = (*networks.landmark)(raw_face_crops);
+    landmarks_output.resize(raw_face_crops.size());
+    for (size_t n = 0; n < raw_face_crops.size(); ++n) {
+        landmarks_output[n].resize(FaceLandmarkAdapt::NUM_OF_LANDMARK);
+        for (int i = 0; i < FaceLandmarkAdapt::NUM_OF_LANDMARK; ++i) {
+            float x = lmk_outs[n][i * 2 + 0] * size;
+            float y = lmk_outs[n][i * 2 + 1] * size;
+            landmarks_output[n][i] = inspirecv::Point<float>(x, y);
+        }
     }
-    score = (*m_refine_net_)(raw_face_crop);
+    scores = (*networks.refine)(raw_face_crops);
 }
 
-bool FaceTrackModule::TrackFace(inspirecv::FrameProcess &image, FaceObjectInternal &face) {
-    COST_TIME_SIMPLE(TrackFace);
+bool FaceTrackModule::PrepareTrackFace(inspirecv::FrameProcess &image, FaceObjectInternal &face) {
     // If the face confidence level is below 0.1, disable tracking
     if (face.GetConfidence() < 0.1) {
         face.DisableTracking();
@@ -64,12 +105,10 @@ bool FaceTrackModule::TrackFace(inspirecv::FrameProcess &image, FaceObjectIntern
     }
 
     inspirecv::TransformMatrix affine;
-    std::vector<inspirecv::Point2f> landmark_back;
 
     // Increase track count
     face.IncrementTrackingCount();
 
-    float score;
     // If it is a detection state, calculate the affine transformation matrix
     if (face.TrackingState() == ISF_DETECT) {
         COST_TIME_SIMPLE(GetRectSquare);
@@ -102,114 +141,218 @@ bool FaceTrackModule::TrackFace(inspirecv::FrameProcess &image, FaceObjectIntern
             face.bbox_ = restore_rect.As<int>();
         }
     }
+    return true;
+}
 
-    if (m_face_quality_ != nullptr) {
-        COST_TIME_SIMPLE(FaceQuality);
-        auto affine_extensive = face.getTransMatrixExtensive();
-        auto pre_crop = image.ExecuteImageAffineProcessing(affine_extensive, m_crop_extensive_size_, m_crop_extensive_size_);
-        auto res = (*m_face_quality_)(pre_crop);
+void FaceTrackModule::UpdateTrackedLandmark(FaceObjectInternal &face, const std::vector<inspirecv::Point2f> &landmark_rawout) {
+    inspirecv::TransformMatrix affine = face.getTransMatrix();
+    inspirecv::TransformMatrix affine_inv = affine.GetInverse();
+    std::vector<inspirecv::Point2f> landmark_back;
 
-        auto affine_extensive_inv = affine_extensive.GetInverse();
-        std::vector<inspirecv::Point2f> lmk_extensive = ApplyTransformToPoints(res.lmk, affine_extensive_inv);
-        res.lmk = lmk_extensive;
-        face.high_result = res;
+    // Extract 5 key points
+    std::vector<inspirecv::Point2f> lmk_5 = {
+      landmark_rawout[FaceLandmarkAdapt::LEFT_EYE_CENTER], landmark_rawout[FaceLandmarkAdapt::RIGHT_EYE_CENTER],
+      landmark_rawout[FaceLandmarkAdapt::NOSE_CORNER], landmark_rawout[FaceLandmarkAdapt::MOUTH_LEFT_CORNER],
+      landmark_rawout[FaceLandmarkAdapt::MOUTH_RIGHT_CORNER]};
+    face.setAlignMeanSquareError(lmk_5);
+
+    // Convert key points back to the original coordinate system
+    landmark_back.resize(landmark_rawout.size());
+    landmark_back = inspirecv::ApplyTransformToPoints(landmark_rawout, affine_inv);
+    int MODE = 1;
+
+    if (MODE > 0) {
+        if (face.TrackingState() == ISF_DETECT) {
+            face.ReadyTracking();
+        } else if (face.TrackingState() == ISF_READY || face.TrackingState() == ISF_TRACKING) {
+            COST_TIME_SIMPLE(LandmarkBack);
+            inspirecv::TransformMatrix trans_m;
+            inspirecv::TransformMatrix tmp = face.getTransMatrix();
+            std::vector<inspirecv::Point2f> inside_points = landmark_rawout;
+
+            static const std::vector<inspirecv::Point2f> mean_shape_ = []() {
+                std::vector<inspirecv::Point2f> points(FaceLandmarkAdapt::NUM_OF_LANDMARK);
+                for (int k = 0; k < FaceLandmarkAdapt::NUM_OF_LANDMARK; k++) {
+                    points[k].SetX(mean_shape[k * 2]);
+                    points[k].SetY(mean_shape[k * 2 + 1]);
+                }
+                return points;
+            }();
+
+            auto _affine = inspirecv::SimilarityTransformEstimate(inside_points, mean_shape_);
+            auto mid_inside_points = ApplyTransformToPoints(inside_points, _affine);
+            inside_points = FixPointsMeanshape(mid_inside_points, mean_shape_);
+
+            trans_m = inspirecv::SimilarityTransformEstimate(landmark_back, inside_points);
+            face.setTransMatrix(trans_m);
+            face.EnableTracking();
+
+            Timer extensive_cost_time;
+            // Add extensive rect
+            // Calculate center point of landmarks
+            inspirecv::Point2f center(0.0f, 0.0f);
+            for (const auto &pt : landmark_back) {
+                center.SetX(center.GetX() + pt.GetX());
+                center.SetY(center.GetY() + pt.GetY());
+            }
+            center.SetX(center.GetX() / landmark_back.size());
+            center.SetY(center.GetY() / landmark_back.size());
+
+            // Create expanded points by scaling from center by 1.3
+            std::vector<inspirecv::Point2f> lmk_back_rect = landmark_back;
+            for (auto &pt : lmk_back_rect) {
+                pt.SetX(center.GetX() + (pt.GetX() - center.GetX()) * m_crop_extensive_ratio_);
+                pt.SetY(center.GetY() + (pt.GetY() - center.GetY()) * m_crop_extensive_ratio_);
+            }
+            inspirecv::TransformMatrix extensive_affine = inspirecv::SimilarityTransformEstimate(lmk_back_rect, mid_inside_points);
+            face.setTransMatrixExtensive(extensive_affine);
+            // INSPIRE_LOGD("Extensive Affine Cost %f", extensive_cost_time.GetCostTimeUpdate());
+        }
+    }
+    // Add five key points to landmark_back
+    for (int i = 0; i < 5; i++) {
+        landmark_back.push_back(face.high_result.lmk[i]);
+    }
+    // Update face key points
+    face.SetLandmark(landmark_back, true, true, m_track_mode_smooth_ratio_, m_track_mode_num_smooth_cache_frame_,
+                     (FaceLandmarkAdapt::NUM_OF_LANDMARK + 10) * 2);
+    // Get the smoothed landmark
+    auto &landmark_smooth = face.landmark_;
+    // Update the face key points
+    face.high_result.lmk[0] = landmark_smooth[FaceLandmarkAdapt::NUM_OF_LANDMARK + 0];
+    face.high_result.lmk[1] = landmark_smooth[FaceLandmarkAdapt::NUM_OF_LANDMARK + 1];
+    face.high_result.lmk[2] = landmark_smooth[FaceLandmarkAdapt::NUM_OF_LANDMARK + 2];
+    face.high_result.lmk[3] = landmark_smooth[FaceLandmarkAdapt::NUM_OF_LANDMARK + 3];
+    face.high_result.lmk[4] = landmark_smooth[FaceLandmarkAdapt::NUM_OF_LANDMARK + 4];
+}
+
+void FaceTrackModule::TrackFaceRange(inspirecv::FrameProcess &image, std::vector<FaceObjectInternal> &faces, size_t begin, size_t end,
+                                     TrackNetworks &networks, std::vector<uint8_t> &alive, int crop_threads) {
+    std::vector<FaceObjectInternal *> tracked;
+    tracked.reserve(end - begin);
+    for (size_t i = begin; i < end; ++i) {
+        alive[i] = PrepareTrackFace(image, faces[i]);
+        if (alive[i]) {
+            tracked.push_back(&faces[i]);
+        }
+    }
+    if (tracked.empty()) {
+        return;
     }
 
+    // The crops of every network are taken from the frame in one pass
+    auto &requests = networks.crop_requests;
+    requests.clear();
+    if (networks.quality != nullptr) {
+        networks.quality_crops.resize(tracked.size());
+        for (size_t i = 0; i < tracked.size(); ++i) {
+            inspirecv::AffineCropRequest request;
+            request.affine_matrix = tracked[i]->getTransMatrixExtensive();
+            request.width_out = m_crop_extensive_size_;
+            request.height_out = m_crop_extensive_size_;
+            request.image_out = &networks.quality_crops[i];
+            requests.push_back(request);
+        }
+    }
     if (m_detect_mode_landmark_) {
-        // If Landmark need to be extracted in detection mode,
-        // Landmark must be detected when fast tracing is enabled
-        affine = face.getTransMatrix();
-        inspirecv::Image crop;
-        // Get the RGB image after affine transformation
-        crop = image.ExecuteImageAffineProcessing(affine, 112, 112);
-        inspirecv::TransformMatrix affine_inv = affine.GetInverse();
+        networks.landmark_crops.resize(tracked.size());
+        for (size_t i = 0; i < tracked.size(); ++i) {
+            inspirecv::AffineCropRequest request;
+            request.affine_matrix = tracked[i]->getTransMatrix();
+            request.width_out = 112;
+            request.height_out = 112;
+            request.image_out = &networks.landmark_crops[i];
+            requests.push_back(request);
+        }
+    }
+    image.ExecuteImageAffineBatchProcessing(requests, crop_threads);
 
-        std::vector<inspirecv::Point2f> landmark_rawout;
-        std::vector<float> bbox;
+    // The crops of the range go through each network in a single batch
+    if (networks.quality != nullptr) {
+        COST_TIME_SIMPLE(FaceQuality);
+        auto &crops = networks.quality_crops;
+        auto results = (*networks.quality)(crops);
+        for (size_t i = 0; i < tracked.size(); ++i) {
+            auto &res = results[i];
+            auto affine_extensive = tracked[i]->getTransMatrixExtensive();
+            auto affine_extensive_inv = affine_extensive.GetInverse();
+            std::vector<inspirecv::Point2f> lmk_extensive = ApplyTransformToPoints(res.lmk, affine_extensive_inv);
+            res.lmk = lmk_extensive;
+            tracked[i]->high_result = res;
+        }
+    }
 
-        Timer lmk_cost_time;
+    if (m_detect_mode_landmark_) {
+        // If Landmark need to be extracted in detection mode,
+        // Landmark must be detected when fast tracing is enabled
+        auto &crops = networks.landmark_crops;
+        std::vector<std::vector<inspirecv::Point2f>> landmarks_rawout;
+        std::vector<float> scores;
         // Predicted sparse key point
-        SparseLandmarkPredict(crop, landmark_rawout, score, 112);
-        // Extract 5 key points
-        std::vector<inspirecv::Point2f> lmk_5 = {
-          landmark_rawout[FaceLandmarkAdapt::LEFT_EYE_CENTER], landmark_rawout[FaceLandmarkAdapt::RIGHT_EYE_CENTER],
-          landmark_rawout[FaceLandmarkAdapt::NOSE_CORNER], landmark_rawout[FaceLandmarkAdapt::MOUTH_LEFT_CORNER],
-          landmark_rawout[FaceLandmarkAdapt::MOUTH_RIGHT_CORNER]};
-        face.setAlignMeanSquareError(lmk_5);
-
-        // Convert key points back to the original coordinate system
-        landmark_back.resize(landmark_rawout.size());
-        landmark_back = inspirecv::ApplyTransformToPoints(landmark_rawout, affine_inv);
-        int MODE = 1;
-
-        if (MODE > 0) {
-            if (face.TrackingState() == ISF_DETECT) {
-                face.ReadyTracking();
-            } else if (face.TrackingState() == ISF_READY || face.TrackingState() == ISF_TRACKING) {
-                COST_TIME_SIMPLE(LandmarkBack);
-                inspirecv::TransformMatrix trans_m;
-                inspirecv::TransformMatrix tmp = face.getTransMatrix();
-                std::vector<inspirecv::Point2f> inside_points = landmark_rawout;
-
-                std::vector<inspirecv::Point2f> mean_shape_(FaceLandmarkAdapt::NUM_OF_LANDMARK);
-                for (int k = 0; k < FaceLandmarkAdapt::NUM_OF_LANDMARK; k++) {
-                    mean_shape_[k].SetX(mean_shape[k * 2]);
-                    mean_shape_[k].SetY(mean_shape[k * 2 + 1]);
-                }
-
-                auto _affine = inspirecv::SimilarityTransformEstimate(inside_points, mean_shape_);
-                auto mid_inside_points = ApplyTransformToPoints(inside_points, _affine);
-                inside_points = FixPointsMeanshape(mid_inside_points, mean_shape_);
-
-                trans_m = inspirecv::SimilarityTransformEstimate(landmark_back, inside_points);
-                face.setTransMatrix(trans_m);
-                face.EnableTracking();
-
-                Timer extensive_cost_time;
-                // Add extensive rect
-                // Calculate center point of landmarks
-                inspirecv::Point2f center(0.0f, 0.0f);
-                for (const auto &pt : landmark_back) {
-                    center.SetX(center.GetX() + pt.GetX());
-                    center.SetY(center.GetY() + pt.GetY());
-                }
-                center.SetX(center.GetX() / landmark_back.size());
-                center.SetY(center.GetY() / landmark_back.size());
-
-                // Create expanded points by scaling from center by 1.3
-                std::vector<inspirecv::Point2f> lmk_back_rect = landmark_back;
-                for (auto &pt : lmk_back_rect) {
-                    pt.SetX(center.GetX() + (pt.GetX() - center.GetX()) * m_crop_extensive_ratio_);
-                    pt.SetY(center.GetY() + (pt.GetY() - center.GetY()) * m_crop_extensive_ratio_);
-                }
-                inspirecv::TransformMatrix extensive_affine = inspirecv::SimilarityTransformEstimate(lmk_back_rect, mid_inside_points);
-                face.setTransMatrixExtensive(extensive_affine);
-                // INSPIRE_LOGD("Extensive Affine Cost %f", extensive_cost_time.GetCostTimeUpdate());
+        SparseLandmarkPredict(networks, crops, landmarks_rawout, scores, 112);
+        for (size_t i = 0; i < tracked.size(); ++i) {
+            UpdateTrackedLandmark(*tracked[i], landmarks_rawout[i]);
+            // If tracking status, update the confidence level
+            if (tracked[i]->TrackingState() == ISF_TRACKING) {
+                tracked[i]->SetConfidence(scores[i]);
             }
         }
-        // Add five key points to landmark_back
-        for (int i = 0; i < 5; i++) {
-            landmark_back.push_back(face.high_result.lmk[i]);
+    }
+}
+
+void FaceTrackModule::TrackFaces(inspirecv::FrameProcess &image, std::vector<FaceObjectInternal> &faces) {
+    COST_TIME_SIMPLE(TrackFaces);
+    auto &alive = m_track_alive_;
+    alive.assign(faces.size(), 0);
+    if (m_track_pool_ == nullptr || faces.size() < 2) {
+        // The networks may have been reloaded since the last frame, the crop buffers are kept
+        auto &networks = m_local_networks_;
+        networks.landmark = m_landmark_predictor_;
+        networks.refine = m_refine_net_;
+        networks.quality = m_face_quality_;
+        // A single range has the whole thread budget for its crops
+        TrackFaceRange(image, faces, 0, faces.size(), networks, alive, m_track_num_threads_);
+    } else {
+        // One contiguous range of faces per thread, each range borrows its own set of networks and
+        // crops on its own thread since the threads already split the faces
+        const size_t ranges = std::min(faces.size(), m_track_pool_->Size() + 1);
+        m_track_pool_->ParallelFor(ranges, [&](size_t r) {
+            auto networks = m_track_networks_->AcquireResource();
+            TrackFaceRange(image, faces, r * faces.size() / ranges, (r + 1) * faces.size() / ranges, *networks, alive, 1);
+        });
+    }
+    // The lost faces are removed afterwards, the others keep their order
+    size_t kept = 0;
+    for (size_t i = 0; i < faces.size(); ++i) {
+        if (alive[i]) {
+            if (kept != i) {
+                std::swap(faces[kept], faces[i]);
+            }
+            kept++;
         }
-        // Update face key points
-        face.SetLandmark(landmark_back, true, true, m_track_mode_smooth_ratio_, m_track_mode_num_smooth_cache_frame_,
-                         (FaceLandmarkAdapt::NUM_OF_LANDMARK + 10) * 2);
-        // Get the smoothed landmark
-        auto &landmark_smooth = face.landmark_smooth_aux_.back();
-        // Update the face key points
-        face.high_result.lmk[0] = landmark_smooth[FaceLandmarkAdapt::NUM_OF_LANDMARK + 0];
-        face.high_result.lmk[1] = landmark_smooth[FaceLandmarkAdapt::NUM_OF_LANDMARK + 1];
-        face.high_result.lmk[2] = landmark_smooth[FaceLandmarkAdapt::NUM_OF_LANDMARK + 2];
-        face.high_result.lmk[3] = landmark_smooth[FaceLandmarkAdapt::NUM_OF_LANDMARK + 3];
-        face.high_result.lmk[4] = landmark_smooth[FaceLandmarkAdapt::NUM_OF_LANDMARK + 4];
     }
+    RetireFaces(faces, kept);
+}
 
-    // If tracking status, update the confidence level
-    if (face.TrackingState() == ISF_TRACKING) {
-        face.SetConfidence(score);
+FaceObjectInternal FaceTrackModule::AcquireFace(int instance_id, const inspirecv::Rect2i &bbox) {
+    if (m_face_pool_.empty()) {
+        FaceObjectInternal face(instance_id, bbox, FaceLandmarkAdapt::NUM_OF_LANDMARK + 10);
+        face.detect_bbox_ = bbox;
+        return face;
     }
+    FaceObjectInternal face = std::move(m_face_pool_.back());
+    m_face_pool_.pop_back();
+    face.Reset(instance_id, bbox, FaceLandmarkAdapt::NUM_OF_LANDMARK + 10);
+    return face;
+}
 
-    return true;
+void FaceTrackModule::RetireFaces(std::vector<FaceObjectInternal> &faces, size_t begin) {
+    // Enough faces are kept to replace a full frame of tracks
+    const size_t capacity = static_cast<size_t>(max_detected_faces_) * 2;
+    for (size_t i = begin; i < faces.size() && m_face_pool_.size() < capacity; ++i) {
+        m_face_pool_.push_back(std::move(faces[i]));
+    }
+    faces.erase(faces.begin() + begin, faces.end());
 }
 
 void FaceTrackModule::UpdateStream(inspirecv::FrameProcess &image) {
@@ -218,9 +361,21 @@ void FaceTrackModule::UpdateStream(inspirecv::FrameProcess &image) {
     COST_TIME_SIMPLE(FaceTrackUpdateStream);
     detection_index_ += 1;
     if (m_mode_ == DETECT_MODE_ALWAYS_DETECT || m_mode_ == DETECT_MODE_TRACK_BY_DETECT)
-        trackingFace.clear();
-    if (trackingFace.empty() || detection_index_ % detection_interval_ == 0 || m_mode_ == DETECT_MODE_ALWAYS_DETECT ||
-        m_mode_ == DETECT_MODE_TRACK_BY_DETECT) {
+        RetireFaces(trackingFace, 0);
+    bool detect = trackingFace.empty() || m_mode_ == DETECT_MODE_ALWAYS_DETECT || m_mode_ == DETECT_MODE_TRACK_BY_DETECT;
+    if (m_detect_scheduler_ != nullptr && m_mode_ == DETECT_MODE_LIGHT_TRACK) {
+        // A thumbnail is enough to tell whether the scene changed since the last detection
+        const float scale = static_cast<float>(DetectScheduler::THUMBNAIL_SIZE) / (std::max)(image.GetWidth(), image.GetHeight());
+        detect = m_detect_scheduler_->Schedule(image.ExecuteImageScaleProcessing(scale, false), detect);
+    } else {
+        detect = detect || detection_index_ % detection_interval_ == 0;
+    }
+    if (detect && m_tile_size_ > 0 && (std::max)(image.GetWidth(), image.GetHeight()) > m_tile_size_) {
+        m_detect_count_++;
+        nms();
+        DetectFaceTiles(image);
+    } else if (detect) {
+        m_detect_count_++;
         image.SetPreviewSize(track_preview_size_);
         inspirecv::Image image_detect = image.ExecutePreviewImageProcessing(true);
 
@@ -241,30 +396,41 @@ void FaceTrackModule::UpdateStream(inspirecv::FrameProcess &image) {
 
     if (!candidate_faces_.empty()) {
         for (int i = 0; i < candidate_faces_.size(); i++) {
-            trackingFace.push_back(candidate_faces_[i]);
+            trackingFace.push_back(std::move(candidate_faces_[i]));
         }
         candidate_faces_.clear();
     }
 
-    for (std::vector<FaceObjectInternal>::iterator iter = trackingFace.begin(); iter != trackingFace.end();) {
-        if (!TrackFace(image, *iter)) {
-            iter = trackingFace.erase(iter);
-        } else {
-            iter++;
+    const size_t num_faces = trackingFace.size();
+    TrackFaces(image, trackingFace);
+    if (m_detect_scheduler_ != nullptr) {
+        float min_confidence = 1.0f;
+        for (auto const &face : trackingFace) {
+            min_confidence = (std::min)(min_confidence, face.GetConfidence());
         }
+        m_detect_scheduler_->ObserveTracks(num_faces - trackingFace.size(), min_confidence);
     }
     total.Stop();
     // std::cout << total << std::endl;
 }
 
 void FaceTrackModule::nms(float th) {
-    std::sort(trackingFace.begin(), trackingFace.end(), [](FaceObjectInternal a, FaceObjectInternal b) { return a.confidence_ > b.confidence_; });
+    std::sort(trackingFace.begin(), trackingFace.end(),
+              [](const FaceObjectInternal &a, const FaceObjectInternal &b) { return a.confidence_ > b.confidence_; });
     std::vector<float> area(trackingFace.size());
     for (int i = 0; i < int(trackingFace.size()); ++i) {
         area[i] = trackingFace.at(i).getBbox().Area();
     }
+    // The suppressed faces are marked, then moved behind the kept ones in a single pass
+    std::vector<uint8_t> suppressed(trackingFace.size(), 0);
     for (int i = 0; i < int(trackingFace.size()); ++i) {
-        for (int j = i + 1; j < int(trackingFace.size());) {
+        if (suppressed[i]) {
+            continue;
+        }
+        for (int j = i + 1; j < int(trackingFace.size()); ++j) {
+            if (suppressed[j]) {
+                continue;
+            }
             float xx1 = (std::max)(trackingFace[i].getBbox().GetX(), trackingFace[j].getBbox().GetX());
             float yy1 = (std::max)(trackingFace[i].getBbox().GetY(), trackingFace[j].getBbox().GetY());
             float xx2 = (std::min)(trackingFace[i].getBbox().GetX() + trackingFace[i].getBbox().GetWidth(),
@@ -276,13 +442,20 @@ void FaceTrackModule::nms(float th) {
             float inter = w * h;
             float ovr = inter / (area[i] + area[j] - inter);
             if (ovr >= th) {
-                trackingFace.erase(trackingFace.begin() + j);
-                area.erase(area.begin() + j);
-            } else {
-                j++;
+                suppressed[j] = 1;
+            }
+        }
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < trackingFace.size(); ++i) {
+        if (!suppressed[i]) {
+            if (kept != i) {
+                std::swap(trackingFace[kept], trackingFace[i]);
             }
+            kept++;
         }
     }
+    RetireFaces(trackingFace, kept);
 }
 
 void FaceTrackModule::BlackingTrackingRegion(inspirecv::Image &image, inspirecv::Rect2f &rect_mask) {
@@ -296,7 +469,143 @@ void FaceTrackModule::BlackingTrackingRegion(inspirecv::Image &image, inspirecv:
 
 void FaceTrackModule::DetectFace(const inspirecv::Image &input, float scale) {
     std::vector<FaceLoc> boxes = (*m_face_detector_)(input);
+    AppendCandidates(boxes, scale);
+}
+
+void FaceTrackModule::DetectFaceTiles(inspirecv::FrameProcess &image) {
+    COST_TIME_SIMPLE(DetectFaceTiles);
+    // The candidates keep the precision of the frame, a small face would be a few pixels of the preview
+    image.SetPreviewScale(1.0f);
+    const bool rotated = image.getRotationMode() == inspirecv::ROTATION_90 || image.getRotationMode() == inspirecv::ROTATION_270;
+    const int width = rotated ? image.GetHeight() : image.GetWidth();
+    const int height = rotated ? image.GetWidth() : image.GetHeight();
+    inspirecv::TransformMatrix rotation_mode_affine = image.GetAffineMatrix();
+    auto rotation_mode_affine_inv = rotation_mode_affine.GetInverse();
+    std::vector<inspirecv::Rect2f> tracked_rects;
+    for (auto const &face : trackingFace) {
+        std::vector<inspirecv::Point2f> pts = face.GetRect().As<float>().ToFourVertices();
+        tracked_rects.push_back(inspirecv::MinBoundingRect(inspirecv::ApplyTransformToPoints(pts, rotation_mode_affine_inv)));
+    }
+
+    // The whole frame at the preview size finds the faces too large for the overlap of the tiles
+    const float preview_scale = track_preview_size_ / static_cast<float>((std::max)(width, height));
+    inspirecv::Image image_detect = image.ExecuteImageScaleProcessing(preview_scale, true);
+    for (auto const &rect : tracked_rects) {
+        inspirecv::Rect2f mask_rect = inspirecv::Rect2f::Create(rect.GetX() * preview_scale, rect.GetY() * preview_scale, rect.GetWidth() * preview_scale,
+                                    rect.GetHeight() * preview_scale);
+        BlackingTrackingRegion(image_detect, mask_rect);
+    }
+    std::vector<FaceLoc> boxes = (*m_face_detector_)(image_detect);
+    for (auto &box : boxes) {
+        MapFaceLoc(box, 1.0f / preview_scale, 0.0f, 0.0f);
+    }
+
+    auto tiles = SelectDetectTiles(image, width, height);
+    const float tile_size = static_cast<float>(m_tile_size_);
+    std::vector<inspirecv::Point2f> dst_pts = {{0, 0}, {tile_size, 0}, {tile_size, tile_size}, {0, tile_size}};
+    // The tiles overlap, a single batch converts the frame under them once
+    std::vector<inspirecv::Image> crops(tiles.size());
+    std::vector<inspirecv::AffineCropRequest> requests(tiles.size());
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        std::vector<inspirecv::Point2f> camera_pts = ApplyTransformToPoints(tiles[i].As<float>().ToFourVertices(), rotation_mode_affine);
+        requests[i].affine_matrix = inspirecv::SimilarityTransformEstimate(camera_pts, dst_pts);
+        requests[i].width_out = m_tile_size_;
+        requests[i].height_out = m_tile_size_;
+        requests[i].image_out = &crops[i];
+    }
+    image.ExecuteImageAffineBatchProcessing(requests, m_track_num_threads_);
+    auto tile_boxes = (*m_face_detector_)(crops);
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        const auto &tile = tiles[i];
+        const bool inner_left = tile.GetX() > 0;
+        const bool inner_top = tile.GetY() > 0;
+        const bool inner_right = tile.GetX() + m_tile_size_ < width;
+        const bool inner_bottom = tile.GetY() + m_tile_size_ < height;
+        for (auto box : tile_boxes[i]) {
+            // A face cut by an inner edge is whole in the neighbouring tile or in the whole frame
+            if ((inner_left && box.x1 < kTileEdgeMargin) || (inner_top && box.y1 < kTileEdgeMargin) ||
+                (inner_right && box.x2 > tile_size - kTileEdgeMargin) || (inner_bottom && box.y2 > tile_size - kTileEdgeMargin)) {
+                continue;
+            }
+            MapFaceLoc(box, 1.0f, tile.GetX(), tile.GetY());
+            // The tracked faces are not blacked out of the tiles, their detections are dropped instead
+            const float cx = (box.x1 + box.x2) / 2;
+            const float cy = (box.y1 + box.y2) / 2;
+            bool tracked = false;
+            for (auto const &rect : tracked_rects) {
+                if (cx >= rect.GetX() && cx <= rect.GetX() + rect.GetWidth() && cy >= rect.GetY() && cy <= rect.GetY() + rect.GetHeight()) {
+                    tracked = true;
+                    break;
+                }
+            }
+            if (!tracked) {
+                boxes.push_back(box);
+            }
+        }
+    }
+
+    m_face_detector_->MergeFaces(boxes);
+    // The scaled images above replaced the transform of the frame, the candidates are mapped with the native one
+    image.SetPreviewScale(1.0f);
+    AppendCandidates(boxes, 1.0f);
+}
+
+std::vector<inspirecv::Rect2i> FaceTrackModule::SelectDetectTiles(inspirecv::FrameProcess &image, int width, int height) {
+    // Neighbouring tiles overlap by a quarter, a face up to that size is whole in one of them
+    const int stride = (std::max)(1, m_tile_size_ * 3 / 4);
+    std::vector<inspirecv::Rect2i> tiles;
+    for (int y : TileStarts(height, m_tile_size_, stride)) {
+        for (int x : TileStarts(width, m_tile_size_, stride)) {
+            tiles.push_back(inspirecv::Rect<int>::Create(x, y, m_tile_size_, m_tile_size_));
+        }
+    }
+    if (!m_tile_motion_only_) {
+        return tiles;
+    }
 
+    const float thumbnail_scale = kTileThumbnailCells / static_cast<float>(m_tile_size_);
+    inspirecv::Image thumbnail = image.ExecuteImageScaleProcessing(thumbnail_scale, true);
+    const int thumbnail_width = thumbnail.Width();
+    const int thumbnail_height = thumbnail.Height();
+    const int channels = thumbnail.Channels();
+    const uint8_t *data = thumbnail.Data();
+    const size_t size = static_cast<size_t>(thumbnail_width) * thumbnail_height * channels;
+    if (thumbnail_width != m_tile_reference_width_ || thumbnail_height != m_tile_reference_height_ || size != m_tile_reference_.size()) {
+        // Nothing to compare with, every tile is detected
+        m_tile_reference_.assign(data, data + size);
+        m_tile_reference_width_ = thumbnail_width;
+        m_tile_reference_height_ = thumbnail_height;
+        return tiles;
+    }
+
+    std::vector<inspirecv::Rect2i> changed;
+    for (auto const &tile : tiles) {
+        const int x0 = (std::min)(thumbnail_width, static_cast<int>(tile.GetX() * thumbnail_scale));
+        const int y0 = (std::min)(thumbnail_height, static_cast<int>(tile.GetY() * thumbnail_scale));
+        const int x1 = (std::min)(thumbnail_width, static_cast<int>(std::ceil((tile.GetX() + m_tile_size_) * thumbnail_scale)));
+        const int y1 = (std::min)(thumbnail_height, static_cast<int>(std::ceil((tile.GetY() + m_tile_size_) * thumbnail_scale)));
+        const size_t row_bytes = static_cast<size_t>(x1 - x0) * channels;
+        uint64_t energy = 0;
+        for (int y = y0; y < y1; ++y) {
+            const size_t offset = (static_cast<size_t>(y) * thumbnail_width + x0) * channels;
+            for (size_t b = 0; b < row_bytes; ++b) {
+                energy += std::abs(static_cast<int>(data[offset + b]) - static_cast<int>(m_tile_reference_[offset + b]));
+            }
+        }
+        const size_t count = row_bytes * (y1 - y0);
+        if (count == 0 || energy >= kTileMotionThreshold * count) {
+            changed.push_back(tile);
+            // The tile is compared with this frame from now on
+            for (int y = y0; y < y1; ++y) {
+                const size_t offset = (static_cast<size_t>(y) * thumbnail_width + x0) * channels;
+                std::memcpy(m_tile_reference_.data() + offset, data + offset, row_bytes);
+            }
+        }
+    }
+    return changed;
+}
+
+void FaceTrackModule::AppendCandidates(const std::vector<FaceLoc> &boxes, float scale) {
     if (m_mode_ == DETECT_MODE_TRACK_BY_DETECT) {
         std::vector<Object> objects;
         auto num_of_effective = std::min(boxes.size(), (size_t)max_detected_faces_);
@@ -315,9 +624,7 @@ void FaceTrackModule::DetectFace(const inspirecv::Image &input, float scale) {
         std::vector<STrack> output_stracks = m_TbD_tracker_->update(objects);
         for (const auto &st_track : output_stracks) {
             inspirecv::Rect<int> rect = inspirecv::Rect<int>(st_track.tlwh[0], st_track.tlwh[1], st_track.tlwh[2], st_track.tlwh[3]);
-            FaceObjectInternal faceinfo(st_track.track_id, rect, FaceLandmarkAdapt::NUM_OF_LANDMARK + 10);
-            faceinfo.detect_bbox_ = rect.As<int>();
-            candidate_faces_.push_back(faceinfo);
+            candidate_faces_.push_back(AcquireFace(st_track.track_id, rect));
         }
     } else {
         std::vector<inspirecv::Rect2i> bbox;
@@ -336,16 +643,13 @@ void FaceTrackModule::DetectFace(const inspirecv::Image &input, float scale) {
                 tracking_idx_ = tracking_idx_ + 1;
             }
 
-            FaceObjectInternal faceinfo(tracking_idx_, bbox[i], FaceLandmarkAdapt::NUM_OF_LANDMARK + 10);
-            faceinfo.detect_bbox_ = bbox[i];
-            faceinfo.SetConfidence(boxes[i].score);
-
             // Control that the number of faces detected does not exceed the maximum limit
             if (candidate_faces_.size() >= max_detected_faces_) {
                 continue;
             }
 
-            candidate_faces_.push_back(faceinfo);
+            candidate_faces_.push_back(AcquireFace(tracking_idx_, bbox[i]));
+            candidate_faces_.back().SetConfidence(boxes[i].score);
         }
     }
 }
@@ -389,10 +693,14 @@ int FaceTrackModule::Configuration(inspire::InspireArchive &archive, const std::
     }
     InitFacePoseModel(pquModel);
 
+    if (m_track_num_threads_ > 1) {
+        return SetTrackNumThreads(m_track_num_threads_);
+    }
     return 0;
 }
 
 int FaceTrackModule::InitLandmarkModel(InspireModel &model) {
+    m_landmark_model_ = model;
     m_landmark_predictor_ = std::make_shared<FaceLandmarkAdapt>(112);
     auto ret = m_landmark_predictor_->LoadData(model, model.modelType);
     if (ret != InferenceWrapper::WrapperOk) {
@@ -414,6 +722,7 @@ int FaceTrackModule::InitDetectModel(InspireModel &model) {
 }
 
 int FaceTrackModule::InitRNetModel(InspireModel &model) {
+    m_rnet_model_ = model;
     m_refine_net_ = std::make_shared<RNetAdapt>();
     auto ret = m_refine_net_->LoadData(model, model.modelType);
     if (ret != InferenceWrapper::WrapperOk) {
@@ -423,6 +732,7 @@ int FaceTrackModule::InitRNetModel(InspireModel &model) {
 }
 
 int FaceTrackModule::InitFacePoseModel(InspireModel &model) {
+    m_face_pose_model_ = model;
     m_face_quality_ = std::make_shared<FacePoseQualityAdapt>();
     auto ret = m_face_quality_->LoadData(model, model.modelType);
     if (ret != InferenceWrapper::WrapperOk) {
@@ -495,6 +805,74 @@ void FaceTrackModule::SetTrackModeNumSmoothCacheFrame(int value) {
 
 void FaceTrackModule::SetTrackModeDetectInterval(int value) {
     detection_interval_ = value;
+    if (m_detect_scheduler_ != nullptr) {
+        m_detect_scheduler_->SetWeakInterval(value);
+    }
+}
+
+void FaceTrackModule::SetTrackModeAdaptiveDetect(int max_interval) {
+    if (max_interval > 0) {
+        m_detect_scheduler_ = std::make_unique<DetectScheduler>(max_interval);
+        // A track that stays weak is detected again at the fixed interval at most
+        m_detect_scheduler_->SetWeakInterval(detection_interval_);
+    } else {
+        m_detect_scheduler_.reset();
+    }
+}
+
+void FaceTrackModule::SetTrackModeTiledDetect(int tile_size, bool motion_only) {
+    m_tile_size_ = tile_size > 0 ? tile_size : 0;
+    m_tile_motion_only_ = motion_only;
+    m_tile_reference_.clear();
+    m_tile_reference_width_ = 0;
+    m_tile_reference_height_ = 0;
+}
+
+int64_t FaceTrackModule::GetDetectCount() const {
+    return m_detect_count_;
+}
+
+int FaceTrackModule::SetTrackNumThreads(int num_threads) {
+    m_track_num_threads_ = num_threads;
+    m_track_pool_.reset();
+    m_track_networks_.reset();
+    if (num_threads <= 1 || m_landmark_predictor_ == nullptr) {
+        // Applied by Configuration once the models are loaded
+        return HSUCCEED;
+    }
+    std::unique_ptr<parallel::ResourcePool<TrackNetworks>> networks(new parallel::ResourcePool<TrackNetworks>(num_threads));
+    networks->AddResource({m_landmark_predictor_, m_refine_net_, m_face_quality_});
+    for (int i = 1; i < num_threads; ++i) {
+        TrackNetworks worker;
+        worker.landmark = std::make_shared<FaceLandmarkAdapt>(112);
+        worker.refine = std::make_shared<RNetAdapt>();
+        worker.quality = std::make_shared<FacePoseQualityAdapt>();
+        if (worker.landmark->LoadData(m_landmark_model_, m_landmark_model_.modelType) != InferenceWrapper::WrapperOk ||
+            worker.refine->LoadData(m_rnet_model_, m_rnet_model_.modelType) != InferenceWrapper::WrapperOk ||
+            worker.quality->LoadData(m_face_pose_model_, m_face_pose_model_.modelType) != InferenceWrapper::WrapperOk) {
+            INSPIRE_LOGE("Failed to create the networks of tracking thread %d", i);
+            return HERR_ARCHIVE_LOAD_FAILURE;
+        }
+        networks->AddResource(std::move(worker));
+    }
+    m_track_networks_ = std::move(networks);
+    // The calling thread takes part in every frame, it counts as one of the threads
+    m_track_pool_.reset(new parallel::ThreadPool(num_threads - 1));
+    return HSUCCEED;
+}
+
+void FaceTrackModule::ShareNetworks(const FaceTrackModule &source) {
+    m_face_detector_ = source.m_face_detector_;
+    m_landmark_predictor_ = source.m_landmark_predictor_;
+    m_refine_net_ = source.m_refine_net_;
+    m_face_quality_ = source.m_face_quality_;
+    m_landmark_model_ = source.m_landmark_model_;
+    m_rnet_model_ = source.m_rnet_model_;
+    m_face_pose_model_ = source.m_face_pose_model_;
+    // The network sets of the tracking threads were built from the previous networks
+    m_track_num_threads_ = 1;
+    m_track_pool_.reset();
+    m_track_networks_.reset();
 }
 
 }  // namespace inspire
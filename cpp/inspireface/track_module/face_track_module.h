@@ -12,8 +12,11 @@
 #include "common/face_info/face_object_internal.h"
 #include "frame_process.h"
 #include "quality/face_pose_quality_adapt.h"
+#include "detect_scheduler.h"
 #include "middleware/model_archive/inspire_archive.h"
 #include "tracker_optional/bytetrack/BYTETracker.h"
+#include "middleware/thread/thread_pool.h"
+#include "middleware/thread/resource_pool.h"
 #include <data_type.h>
 
 namespace inspire {
@@ -60,22 +63,64 @@ public:
 
 private:
     /**
-     * @brief Predicts sparse landmarks for a cropped face image.
-     * @param raw_face_crop Cropped face image.
-     * @param landmarks_output Output vector for predicted landmarks.
-     * @param score Confidence score for the landmarks prediction.
+     * @brief Networks run on the crops of the tracked faces, one set per tracking thread.
+     */
+    struct TrackNetworks {
+        std::shared_ptr<FaceLandmarkAdapt> landmark;   ///< Landmark predictor.
+        std::shared_ptr<RNetAdapt> refine;             ///< RNet model.
+        std::shared_ptr<FacePoseQualityAdapt> quality;  ///< Face pose quality assessor.
+        std::vector<inspirecv::Image> quality_crops;    ///< Crops of the quality network, their buffers reused from frame to frame.
+        std::vector<inspirecv::Image> landmark_crops;   ///< Crops of the landmark networks, their buffers reused from frame to frame.
+        std::vector<inspirecv::AffineCropRequest> crop_requests;  ///< Both kinds of crops, extracted in one batch.
+    };
+
+    /**
+     * @brief Predicts sparse landmarks for cropped face images, all faces in one batch.
+     * @param networks Networks used for the prediction.
+     * @param raw_face_crops Cropped face images.
+     * @param landmarks_output Output vector for the predicted landmarks of each face.
+     * @param scores Confidence score for the landmarks prediction of each face.
      * @param size Size for normalizing the face crop.
      */
-    void SparseLandmarkPredict(const inspirecv::Image &raw_face_crop, std::vector<inspirecv::Point2f> &landmarks_output, float &score,
-                               float size = 112.0);
+    void SparseLandmarkPredict(TrackNetworks &networks, const std::vector<inspirecv::Image> &raw_face_crops,
+                               std::vector<std::vector<inspirecv::Point2f>> &landmarks_output, std::vector<float> &scores, float size = 112.0);
 
     /**
-     * @brief Tracks a face in the given image stream.
+     * @brief Updates the tracking state and the crop matrices of a face before its networks run.
      * @param image Camera stream containing the face.
      * @param face FaceObject to be tracked.
-     * @return bool Status of face tracking.
+     * @return bool False when the face is lost and must be removed.
+     */
+    bool PrepareTrackFace(inspirecv::FrameProcess &image, FaceObjectInternal &face);
+
+    /**
+     * @brief Applies the predicted landmarks to a face and prepares its crop matrices for the next frame.
+     * @param face FaceObject being tracked.
+     * @param landmark_rawout Landmarks predicted in the coordinates of the face crop.
+     */
+    void UpdateTrackedLandmark(FaceObjectInternal &face, const std::vector<inspirecv::Point2f> &landmark_rawout);
+
+    /**
+     * @brief Tracks a contiguous range of faces with one set of networks.
+     * @param image Camera stream containing the faces.
+     * @param faces All the FaceObjects being tracked.
+     * @param begin First face of the range.
+     * @param end One past the last face of the range.
+     * @param networks Networks used for the range, not shared with another thread.
+     * @param alive Set to 1 for the faces of the range that are still tracked.
+     * @param crop_threads Threads extracting the crops of the range, the calling thread included.
+     */
+    void TrackFaceRange(inspirecv::FrameProcess &image, std::vector<FaceObjectInternal> &faces, size_t begin, size_t end, TrackNetworks &networks,
+                        std::vector<uint8_t> &alive, int crop_threads);
+
+    /**
+     * @brief Tracks the faces in the given image stream.
+     * @details The quality, landmark and refine networks each run once for all the faces of the frame. With
+     * several tracking threads, the faces are split into ranges tracked in parallel.
+     * @param image Camera stream containing the faces.
+     * @param faces FaceObjects to be tracked, the lost ones are removed.
      */
-    bool TrackFace(inspirecv::FrameProcess &image, FaceObjectInternal &face);
+    void TrackFaces(inspirecv::FrameProcess &image, std::vector<FaceObjectInternal> &faces);
 
     /**
      * @brief Blacks out the region specified in the image for tracking.
@@ -90,6 +135,21 @@ private:
      */
     void nms(float th = 0.5);
 
+    /**
+     * @brief Gives a newly detected face, reusing the buffers of a retired one when there is one.
+     * @param instance_id Tracking id of the face.
+     * @param bbox Detected rectangle of the face.
+     * @return FaceObjectInternal The face in the detect state.
+     */
+    FaceObjectInternal AcquireFace(int instance_id, const inspirecv::Rect2i &bbox);
+
+    /**
+     * @brief Removes the faces from begin to the end of the list, their buffers are kept for the next detections.
+     * @param faces List of faces.
+     * @param begin Index of the first face removed.
+     */
+    void RetireFaces(std::vector<FaceObjectInternal> &faces, size_t begin);
+
     /**
      * @brief Detects faces in the given image.
      * @param input Image in which faces are to be detected.
@@ -97,6 +157,29 @@ private:
      */
     void DetectFace(const inspirecv::Image &input, float scale);
 
+    /**
+     * @brief Turns detected boxes into candidate faces.
+     * @param boxes Detected boxes in the coordinates of the preview.
+     * @param scale Scale of the preview to the frame.
+     */
+    void AppendCandidates(const std::vector<FaceLoc> &boxes, float scale);
+
+    /**
+     * @brief Detects faces on the whole frame at the preview size and on overlapping tiles at native scale.
+     * @details The preview scale of image is set to 1, the candidates are in the coordinates of the rotated frame.
+     * @param image Frame to detect.
+     */
+    void DetectFaceTiles(inspirecv::FrameProcess &image);
+
+    /**
+     * @brief Selects the tiles to detect, every tile or only those changed since they were last detected.
+     * @param image Frame to detect.
+     * @param width Width of the rotated frame.
+     * @param height Height of the rotated frame.
+     * @return std::vector<inspirecv::Rect2i> Tiles in the coordinates of the rotated frame.
+     */
+    std::vector<inspirecv::Rect2i> SelectDetectTiles(inspirecv::FrameProcess &image, int width, int height);
+
     /**
      * @brief Initializes the landmark model.
      * @param model Pointer to the landmark model.
@@ -163,10 +246,49 @@ public:
 
     /**
      * @brief Set the detect interval
+     * @details With adaptive detection, it is the minimum interval between two detections asked by a track that stays weak.
      * @param value Interval between detections
      */
     void SetTrackModeDetectInterval(int value);
 
+    /**
+     * @brief Detect when the scene changes or a track weakens instead of at a fixed interval, light track mode only
+     * @param max_interval Maximum number of frames between two detections, 0 or less goes back to the fixed interval
+     */
+    void SetTrackModeAdaptiveDetect(int max_interval);
+
+    /**
+     * @brief Also detect on overlapping tiles of the frame at native scale, for small faces in high resolution frames
+     * @details The tiles are detected in one batch together with the whole frame at the preview size, and the
+     * faces found in several of them are merged. Frames not larger than a tile are detected as usual.
+     * @param tile_size Side of the tiles in pixels of the frame, 0 or less turns the tiles off
+     * @param motion_only Only detect the tiles that changed since they were last detected
+     */
+    void SetTrackModeTiledDetect(int tile_size, bool motion_only = false);
+
+    /**
+     * @brief Get the number of frames the detector ran on
+     * @return int64_t Number of detections since the module was created
+     */
+    int64_t GetDetectCount() const;
+
+    /**
+     * @brief Set the number of threads tracking the faces of a frame
+     * @details Each extra thread gets its own landmark, refine and pose networks. The order of the
+     * faces and their track ids do not depend on the number of threads.
+     * @param num_threads Number of threads including the calling one, 1 or less tracks on the calling thread only
+     * @return int Status of the networks creation
+     */
+    int SetTrackNumThreads(int num_threads);
+
+    /**
+     * @brief Track with the networks of another module instead of its own
+     * @details The tracker state of this module is kept. The caller keeps the two modules from running at the
+     * same time, and the extra tracking threads of this module are dropped.
+     * @param source Module whose networks are used, configured with the same detection level
+     */
+    void ShareNetworks(const FaceTrackModule &source);
+
 public:
     std::vector<FaceObjectInternal> trackingFace;  ///< Vector of FaceObjects currently being tracked.
 
@@ -202,6 +324,27 @@ private:
     int m_track_mode_num_smooth_cache_frame_ = 5;  ///< Track mode number of smooth cache frame
 
     float m_track_mode_smooth_ratio_ = 0.05;  ///< Track mode smooth ratio
+
+    InspireModel m_landmark_model_;   ///< Landmark model, kept to create the networks of the tracking threads
+    InspireModel m_rnet_model_;       ///< RNet model, kept to create the networks of the tracking threads
+    InspireModel m_face_pose_model_;  ///< Pose quality model, kept to create the networks of the tracking threads
+
+    std::unique_ptr<DetectScheduler> m_detect_scheduler_;  ///< Adaptive detection, null when detecting at a fixed interval
+    int64_t m_detect_count_ = 0;                             ///< Number of frames the detector ran on
+
+    int m_tile_size_ = 0;                   ///< Side of the detection tiles in pixels of the frame, 0 when not tiling
+    bool m_tile_motion_only_ = false;       ///< Only detect the tiles that changed
+    std::vector<uint8_t> m_tile_reference_;  ///< Thumbnail of the frame as each tile looked when last detected
+    int m_tile_reference_width_ = 0;
+    int m_tile_reference_height_ = 0;
+
+    std::vector<FaceObjectInternal> m_face_pool_;  ///< Retired faces whose buffers are reused by the next detections
+    std::vector<uint8_t> m_track_alive_;            ///< Whether each face is still tracked on the current frame
+    TrackNetworks m_local_networks_;                ///< Networks and crop buffers of the calling thread when tracking without the pool
+
+    int m_track_num_threads_ = 1;                                             ///< Number of threads tracking the faces
+    std::unique_ptr<parallel::ThreadPool> m_track_pool_;                      ///< Extra tracking threads, null when tracking on the calling thread
+    std::unique_ptr<parallel::ResourcePool<TrackNetworks>> m_track_networks_;  ///< Network sets of the tracking threads
 };
 
 }  // namespace inspire
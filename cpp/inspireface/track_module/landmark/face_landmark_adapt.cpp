@@ -10,11 +10,20 @@ namespace inspire {
 
 std::vector<float> FaceLandmarkAdapt::operator()(const inspirecv::Image& bgr_affine) {
     COST_TIME_SIMPLE(FaceLandmarkAdapt);
-    AnyTensorOutputs outputs;
-    Forward(bgr_affine, outputs);
-    const auto& out = outputs[0].second;
+    return ForwardViews(bgr_affine)[0].ToVector();
+}
 
-    return out;
+std::vector<std::vector<float>> FaceLandmarkAdapt::operator()(const std::vector<inspirecv::Image>& bgr_affines) {
+    COST_TIME_SIMPLE(FaceLandmarkAdaptBatch);
+    const auto& outputs = ForwardBatchViews(bgr_affines);
+    if (outputs.empty()) {
+        return {};
+    }
+    std::vector<std::vector<float>> rows(bgr_affines.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        rows[i] = outputs[0].Row(i).ToVector();
+    }
+    return rows;
 }
 
 FaceLandmarkAdapt::FaceLandmarkAdapt(int input_size) : AnyNetAdapter("FaceLandmarkAdapt"), m_input_size_(input_size) {}
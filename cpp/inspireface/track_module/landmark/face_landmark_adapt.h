@@ -25,6 +25,13 @@ public:
      */
     std::vector<float> operator()(const inspirecv::Image& bgr_affine);
 
+    /**
+     * @brief Predicts the landmarks of several affine-transformed faces in a single forward pass.
+     * @param bgr_affines Affine-transformed face images in BGR format.
+     * @return std::vector<std::vector<float>> Landmark coordinates of each face.
+     */
+    std::vector<std::vector<float>> operator()(const std::vector<inspirecv::Image>& bgr_affines);
+
     /**
      * @brief Constructor for the FaceLandmark class.
      * @param input_size The size of the input image for the neural network.
@@ -11,16 +11,29 @@ namespace inspire {
 FacePoseQualityAdapt::FacePoseQualityAdapt() : AnyNetAdapter("FacePoseQuality") {}
 
 FacePoseQualityAdaptResult FacePoseQualityAdapt::operator()(const inspirecv::Image &img) {
+    return DecodeOutput(ForwardViews(img)[0]);
+}
+
+std::vector<FacePoseQualityAdaptResult> FacePoseQualityAdapt::operator()(const std::vector<inspirecv::Image> &imgs) {
+    const auto &outputs = ForwardBatchViews(imgs);
+    std::vector<FacePoseQualityAdaptResult> results;
+    if (outputs.empty()) {
+        return results;
+    }
+    results.reserve(imgs.size());
+    for (size_t i = 0; i < imgs.size(); ++i) {
+        results.push_back(DecodeOutput(outputs[0].Row(i)));
+    }
+    return results;
+}
+
+FacePoseQualityAdaptResult FacePoseQualityAdapt::DecodeOutput(const AnyTensorView &output) {
     FacePoseQualityAdaptResult res;
-    AnyTensorOutputs outputs;
-    Forward(img, outputs);
-    const auto &output = outputs[0].second;
     res.pitch = output[0] * 90;
     res.yaw = output[1] * 90;
     res.roll = output[2] * 90;
-    std::vector<float> quality(output.begin() + 13, output.end());
-    res.lmk_quality = quality;
-    std::vector<float> face_pts5(output.begin() + 3, output.begin() + 13);
+    res.lmk_quality.assign(output.begin() + 13, output.end());
+    const float *face_pts5 = output.begin() + 3;
     res.lmk.resize(5);
     for (int i = 0; i < 5; i++) {
         res.lmk[i].SetX((face_pts5[i * 2] + 1) * (INPUT_WIDTH / 2));
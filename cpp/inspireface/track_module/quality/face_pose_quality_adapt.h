@@ -45,6 +45,13 @@ public:
      */
     FacePoseQualityAdaptResult operator()(const inspirecv::Image& img);
 
+    /**
+     * @brief Computes the face pose quality of several affine-transformed face images in a single forward pass.
+     * @param imgs Affine-transformed face images in BGR format.
+     * @return std::vector<FacePoseQualityAdaptResult> The face pose quality metrics of each image.
+     */
+    std::vector<FacePoseQualityAdaptResult> operator()(const std::vector<inspirecv::Image>& imgs);
+
     /**
      * @brief Computes the affine transformation matrix for face cropping.
      * @param rect Rectangle representing the face in the image.
@@ -52,6 +59,14 @@ public:
      */
     static inspirecv::TransformMatrix ComputeCropMatrix(const inspirecv::Rect2i& rect);
 
+private:
+    /**
+     * @brief Decodes the network output of one image.
+     * @param output Output row of the image.
+     * @return FacePoseQualityResult The face pose quality metrics.
+     */
+    static FacePoseQualityAdaptResult DecodeOutput(const AnyTensorView& output);
+
 public:
     const static int INPUT_WIDTH = 96;   ///< Width of the input image for the network.
     const static int INPUT_HEIGHT = 96;  ///< Height of the input image for the network.
@@ -10,6 +10,9 @@
 #include "unit/test_helper/test_help.h"
 #include "unit/test_helper/test_tools.h"
 #include "middleware/costman.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 #ifdef ISF_ENABLE_BENCHMARK
 
@@ -204,6 +207,51 @@ TEST_CASE("test_BenchmarkFaceExtractWithAlign", "[benchmark]") {
     REQUIRE(ret == HSUCCEED);
 }
 
+TEST_CASE("test_BenchmarkFacePipeline", "[benchmark]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+
+    const int loop = 200;
+    HResult ret;
+    HFSessionCustomParameter parameter = {0};
+    parameter.enable_liveness = 1;
+    parameter.enable_mask_detect = 1;
+    parameter.enable_face_attribute = 1;
+    parameter.enable_interaction_liveness = 1;
+    HFDetectMode detMode = HF_DETECT_MODE_ALWAYS_DETECT;
+    HFSession session;
+    ret = HFCreateInspireFaceSession(parameter, detMode, 20, 640, -1, &session);
+    REQUIRE(ret == HSUCCEED);
+    HFSessionSetFilterMinimumFacePixelSize(session, 0);
+
+    // Many faces, each option of each face shares the upright frame and the aligned crops
+    HFImageStream imgHandle;
+    auto image = inspirecv::Image::Create(GET_DATA("data/bulk/pedestrian.png"));
+    ret = CVImageToImageStream(image, imgHandle);
+    REQUIRE(ret == HSUCCEED);
+
+    HFMultipleFaceData multipleFaceData = {0};
+    ret = HFExecuteFaceTrack(session, imgHandle, &multipleFaceData);
+    REQUIRE(ret == HSUCCEED);
+    REQUIRE(multipleFaceData.detectedNum > 0);
+
+    inspire::SpendTimer timeSpend("Face Pipeline All Options");
+    for (size_t i = 0; i < loop; i++) {
+        timeSpend.Start();
+        ret = HFMultipleFacePipelineProcess(session, imgHandle, &multipleFaceData, parameter);
+        REQUIRE(ret == HSUCCEED);
+        timeSpend.Stop();
+    }
+    std::cout << timeSpend << std::endl;
+    TEST_PRINT("<Benchmark> Face pipeline with all options -> Faces: {}", multipleFaceData.detectedNum);
+
+    ret = HFReleaseImageStream(imgHandle);
+    REQUIRE(ret == HSUCCEED);
+
+    ret = HFReleaseInspireFaceSession(session);
+    REQUIRE(ret == HSUCCEED);
+}
+
 TEST_CASE("test_BenchmarkFaceComparison", "[benchmark]") {
     DRAW_SPLIT_LINE
     TEST_PRINT_OUTPUT(true);
@@ -665,6 +713,730 @@ TEST_CASE("test_BenchmarkFaceHubSearchMemory", "[benchmark]") {
         ret = HFFeatureHubDataDisable();
         REQUIRE(ret == HSUCCEED);
     }
+
+    SECTION("Benchmark search 100k@Memory") {
+        const int loop = 1000;
+        HResult ret;
+        HFFeatureHubConfiguration configuration;
+        configuration.primaryKeyMode = HF_PK_AUTO_INCREMENT;
+        configuration.enablePersistence = 0;
+        configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+        configuration.searchThreshold = 0.48f;
+
+        ret = HFFeatureHubDataEnable(configuration);
+        REQUIRE(ret == HSUCCEED);
+
+        // Only the target is kept on the test side, the gallery itself lives in the hub
+        size_t genSizeOfBase = 100000;
+        HInt32 targetId = 98000;
+        std::vector<HFloat> targetFeature;
+        HInt32 featureLength;
+        HFGetFeatureLength(&featureLength);
+        REQUIRE(featureLength > 0);
+        for (int i = 0; i < genSizeOfBase; ++i) {
+            auto feat = GenerateRandomFeature(featureLength);
+            if (i == targetId - 1) {
+                targetFeature = feat;
+            }
+            // Construct face feature
+            HFFaceFeature feature = {0};
+            feature.size = feat.size();
+            feature.data = feat.data();
+            HFFaceFeatureIdentity identity = {0};
+            identity.feature = &feature;
+            HFaceId allocId;
+            ret = HFFeatureHubInsertFeature(identity, &allocId);
+            REQUIRE(ret == HSUCCEED);
+        }
+        HInt32 totalFace;
+        ret = HFFeatureHubGetFaceCount(&totalFace);
+        REQUIRE(ret == HSUCCEED);
+        REQUIRE(totalFace == genSizeOfBase);
+
+        auto searchFeat = SimulateSimilarVector(targetFeature);
+        HFFaceFeature searchFeature = {0};
+        searchFeature.size = searchFeat.size();
+        searchFeature.data = searchFeat.data();
+        HFloat confidence = 0.0f;
+        HFFaceFeatureIdentity mostSimilar = {0};
+        inspire::SpendTimer timeSpend("Face Search 100k@Memory");
+        for (size_t i = 0; i < loop; i++) {
+            timeSpend.Start();
+            ret = HFFeatureHubFaceSearch(searchFeature, &confidence, &mostSimilar);
+            REQUIRE(ret == HSUCCEED);
+            REQUIRE(mostSimilar.id == targetId);
+            REQUIRE(confidence > 0.88f);
+            timeSpend.Stop();
+        }
+        std::cout << timeSpend << std::endl;
+
+        ret = HFFeatureHubDataDisable();
+        REQUIRE(ret == HSUCCEED);
+    }
+
+    SECTION("Benchmark search 1M@Memory") {
+        const int loop = 100;
+        HResult ret;
+        HFFeatureHubConfiguration configuration;
+        configuration.primaryKeyMode = HF_PK_AUTO_INCREMENT;
+        configuration.enablePersistence = 0;
+        configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+        configuration.searchThreshold = 0.48f;
+
+        ret = HFFeatureHubDataEnable(configuration);
+        REQUIRE(ret == HSUCCEED);
+
+        // Only the target is kept on the test side, the gallery itself lives in the hub
+        size_t genSizeOfBase = 1000000;
+        HInt32 targetId = 980000;
+        std::vector<HFloat> targetFeature;
+        HInt32 featureLength;
+        HFGetFeatureLength(&featureLength);
+        REQUIRE(featureLength > 0);
+        for (int i = 0; i < genSizeOfBase; ++i) {
+            auto feat = GenerateRandomFeature(featureLength);
+            if (i == targetId - 1) {
+                targetFeature = feat;
+            }
+            // Construct face feature
+            HFFaceFeature feature = {0};
+            feature.size = feat.size();
+            feature.data = feat.data();
+            HFFaceFeatureIdentity identity = {0};
+            identity.feature = &feature;
+            HFaceId allocId;
+            ret = HFFeatureHubInsertFeature(identity, &allocId);
+            REQUIRE(ret == HSUCCEED);
+        }
+        HInt32 totalFace;
+        ret = HFFeatureHubGetFaceCount(&totalFace);
+        REQUIRE(ret == HSUCCEED);
+        REQUIRE(totalFace == genSizeOfBase);
+
+        auto searchFeat = SimulateSimilarVector(targetFeature);
+        HFFaceFeature searchFeature = {0};
+        searchFeature.size = searchFeat.size();
+        searchFeature.data = searchFeat.data();
+        HFloat confidence = 0.0f;
+        HFFaceFeatureIdentity mostSimilar = {0};
+        inspire::SpendTimer timeSpend("Face Search 1M@Memory");
+        for (size_t i = 0; i < loop; i++) {
+            timeSpend.Start();
+            ret = HFFeatureHubFaceSearch(searchFeature, &confidence, &mostSimilar);
+            REQUIRE(ret == HSUCCEED);
+            REQUIRE(mostSimilar.id == targetId);
+            REQUIRE(confidence > 0.88f);
+            timeSpend.Stop();
+        }
+        std::cout << timeSpend << std::endl;
+
+        ret = HFFeatureHubDataDisable();
+        REQUIRE(ret == HSUCCEED);
+    }
+}
+
+TEST_CASE("test_BenchmarkFaceHubSearchBatch", "[benchmark]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+
+    SECTION("Benchmark batch search 32 queries 100k@Memory") {
+        const int loop = 20;
+        const int numQueries = 32;
+        const int topK = 5;
+        HResult ret;
+        HFFeatureHubConfiguration configuration;
+        configuration.primaryKeyMode = HF_PK_AUTO_INCREMENT;
+        configuration.enablePersistence = 0;
+        configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+        configuration.searchThreshold = 0.48f;
+        ret = HFFeatureHubDataEnable(configuration);
+        REQUIRE(ret == HSUCCEED);
+
+        size_t genSizeOfBase = 100000;
+        HInt32 featureLength;
+        HFGetFeatureLength(&featureLength);
+        REQUIRE(featureLength > 0);
+        // Every 1000th feature is used as the target of one query
+        std::vector<std::vector<HFloat>> queryFeats;
+        std::vector<HFaceId> targetIds;
+        for (int i = 0; i < genSizeOfBase; ++i) {
+            auto feat = GenerateRandomFeature(featureLength);
+            HFFaceFeature feature = {0};
+            feature.size = feat.size();
+            feature.data = feat.data();
+            HFFaceFeatureIdentity identity = {0};
+            identity.feature = &feature;
+            HFaceId allocId;
+            ret = HFFeatureHubInsertFeature(identity, &allocId);
+            REQUIRE(ret == HSUCCEED);
+            if (i % 1000 == 0 && queryFeats.size() < numQueries) {
+                queryFeats.push_back(SimulateSimilarVector(feat));
+                targetIds.push_back(allocId);
+            }
+        }
+        std::vector<HFFaceFeature> queries(numQueries);
+        for (int i = 0; i < numQueries; ++i) {
+            queries[i].size = queryFeats[i].size();
+            queries[i].data = queryFeats[i].data();
+        }
+
+        inspire::SpendTimer singleSpend("Face Search TopK x32 one by one 100k@Memory");
+        for (size_t i = 0; i < loop; i++) {
+            singleSpend.Start();
+            for (int j = 0; j < numQueries; ++j) {
+                HFSearchTopKResults results = {0};
+                ret = HFFeatureHubFaceSearchTopK(queries[j], topK, &results);
+                REQUIRE(ret == HSUCCEED);
+                REQUIRE(results.size > 0);
+                REQUIRE(results.ids[0] == targetIds[j]);
+            }
+            singleSpend.Stop();
+        }
+        std::cout << singleSpend << std::endl;
+
+        std::vector<HFSearchTopKResults> batchResults(numQueries);
+        inspire::SpendTimer batchSpend("Face Search TopK x32 batched 100k@Memory");
+        for (size_t i = 0; i < loop; i++) {
+            batchSpend.Start();
+            ret = HFFeatureHubFaceSearchTopKBatch(queries.data(), numQueries, topK, batchResults.data());
+            REQUIRE(ret == HSUCCEED);
+            for (int j = 0; j < numQueries; ++j) {
+                REQUIRE(batchResults[j].size > 0);
+                REQUIRE(batchResults[j].ids[0] == targetIds[j]);
+            }
+            batchSpend.Stop();
+        }
+        std::cout << batchSpend << std::endl;
+
+        ret = HFFeatureHubDataDisable();
+        REQUIRE(ret == HSUCCEED);
+    }
+}
+
+TEST_CASE("test_BenchmarkFaceHubSearchHnsw", "[benchmark]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+
+    SECTION("Benchmark recall@k vs latency 100k@HNSW") {
+        const int numIdentities = 10000;
+        const int samplesPerIdentity = 10;
+        const int numQueries = 200;
+        const int topK = 10;
+        HResult ret;
+        HInt32 featureLength;
+        HFGetFeatureLength(&featureLength);
+        REQUIRE(featureLength > 0);
+
+        // Clustered gallery like a real one, every identity has several noisy samples.
+        // Samples are regenerated from their seed so both indexes receive the same data.
+        std::vector<std::vector<HFloat>> centers;
+        for (int i = 0; i < numIdentities; ++i) {
+            centers.push_back(GenerateRandomFeature(featureLength));
+        }
+        auto makeSample = [&](int identity, uint32_t seed) {
+            std::mt19937 gen(seed);
+            std::normal_distribution<float> noise(0.0f, 0.02f);
+            std::vector<HFloat> sample(centers[identity]);
+            for (auto &value : sample) {
+                value += noise(gen);
+            }
+            return sample;
+        };
+        auto insertGallery = [&]() {
+            for (int i = 0; i < numIdentities * samplesPerIdentity; ++i) {
+                auto feat = makeSample(i / samplesPerIdentity, i);
+                HFFaceFeature feature = {0};
+                feature.size = feat.size();
+                feature.data = feat.data();
+                HFFaceFeatureIdentity identity = {0};
+                identity.feature = &feature;
+                HFaceId allocId;
+                REQUIRE(HFFeatureHubInsertFeature(identity, &allocId) == HSUCCEED);
+            }
+        };
+        std::vector<std::vector<HFloat>> queryFeats;
+        for (int i = 0; i < numQueries; ++i) {
+            queryFeats.push_back(makeSample((i * 7919) % numIdentities, numIdentities * samplesPerIdentity + i));
+        }
+
+        HFFeatureHubConfiguration configuration;
+        configuration.primaryKeyMode = HF_PK_AUTO_INCREMENT;
+        configuration.enablePersistence = 0;
+        configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+        configuration.searchThreshold = -1.0f;
+
+        // Exact neighbours from the flat index are the ground truth
+        ret = HFFeatureHubDataEnable(configuration);
+        REQUIRE(ret == HSUCCEED);
+        insertGallery();
+        std::vector<std::vector<HFaceId>> truth;
+        inspire::SpendTimer flatSpend("Face Search Top10 100k@Flat");
+        for (auto &feat : queryFeats) {
+            HFFaceFeature searchFeature = {0};
+            searchFeature.size = feat.size();
+            searchFeature.data = feat.data();
+            HFSearchTopKResults results = {0};
+            flatSpend.Start();
+            ret = HFFeatureHubFaceSearchTopK(searchFeature, topK, &results);
+            flatSpend.Stop();
+            REQUIRE(ret == HSUCCEED);
+            truth.emplace_back(results.ids, results.ids + results.size);
+        }
+        std::cout << flatSpend << std::endl;
+        ret = HFFeatureHubDataDisable();
+        REQUIRE(ret == HSUCCEED);
+
+        HFFeatureHubIndexConfiguration indexConfiguration;
+        indexConfiguration.indexType = HF_SEARCH_INDEX_HNSW;
+        indexConfiguration.hnswM = 16;
+        indexConfiguration.hnswEfConstruction = 100;
+        indexConfiguration.hnswEfSearch = 64;
+        indexConfiguration.vectorStorage = HF_SEARCH_STORAGE_FLOAT32;
+        indexConfiguration.rerankFactor = 4;
+        ret = HFFeatureHubDataEnableWithIndex(configuration, indexConfiguration);
+        REQUIRE(ret == HSUCCEED);
+        inspire::SpendTimer buildSpend("Build HNSW 100k");
+        buildSpend.Start();
+        insertGallery();
+        buildSpend.Stop();
+        std::cout << buildSpend << std::endl;
+
+        for (HInt32 ef : {16, 32, 64, 128, 256}) {
+            ret = HFFeatureHubSetSearchEf(ef);
+            REQUIRE(ret == HSUCCEED);
+            double recallAt1 = 0.0;
+            double recallAtK = 0.0;
+            inspire::SpendTimer hnswSpend("Face Search Top10 100k@HNSW ef=" + std::to_string(ef));
+            for (int i = 0; i < numQueries; ++i) {
+                HFFaceFeature searchFeature = {0};
+                searchFeature.size = queryFeats[i].size();
+                searchFeature.data = queryFeats[i].data();
+                HFSearchTopKResults results = {0};
+                hnswSpend.Start();
+                ret = HFFeatureHubFaceSearchTopK(searchFeature, topK, &results);
+                hnswSpend.Stop();
+                REQUIRE(ret == HSUCCEED);
+                std::vector<HFaceId> found(results.ids, results.ids + results.size);
+                recallAt1 += (!found.empty() && found[0] == truth[i][0]) ? 1.0 : 0.0;
+                size_t hit = 0;
+                for (auto id : truth[i]) {
+                    hit += std::find(found.begin(), found.end(), id) != found.end();
+                }
+                recallAtK += static_cast<double>(hit) / truth[i].size();
+            }
+            std::cout << hnswSpend << std::endl;
+            TEST_PRINT("ef={} recall@1={:.4f} recall@{}={:.4f}", ef, recallAt1 / numQueries, topK, recallAtK / numQueries);
+        }
+
+        ret = HFFeatureHubDataDisable();
+        REQUIRE(ret == HSUCCEED);
+    }
+}
+
+TEST_CASE("test_BenchmarkFaceHubSearchQuantized", "[benchmark]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+
+    SECTION("Benchmark memory and recall@k 100k@Flat float16/int8") {
+        const int numIdentities = 10000;
+        const int samplesPerIdentity = 10;
+        const int numQueries = 200;
+        const int topK = 10;
+        HResult ret;
+        HInt32 featureLength;
+        HFGetFeatureLength(&featureLength);
+        REQUIRE(featureLength > 0);
+
+        // Same clustered gallery as the HNSW benchmark, near duplicates are where precision matters
+        std::vector<std::vector<HFloat>> centers;
+        for (int i = 0; i < numIdentities; ++i) {
+            centers.push_back(GenerateRandomFeature(featureLength));
+        }
+        auto makeSample = [&](int identity, uint32_t seed) {
+            std::mt19937 gen(seed);
+            std::normal_distribution<float> noise(0.0f, 0.02f);
+            std::vector<HFloat> sample(centers[identity]);
+            for (auto &value : sample) {
+                value += noise(gen);
+            }
+            return sample;
+        };
+        std::vector<std::vector<HFloat>> queryFeats;
+        for (int i = 0; i < numQueries; ++i) {
+            queryFeats.push_back(makeSample((i * 7919) % numIdentities, numIdentities * samplesPerIdentity + i));
+        }
+
+        HFFeatureHubConfiguration configuration;
+        configuration.primaryKeyMode = HF_PK_AUTO_INCREMENT;
+        configuration.enablePersistence = 0;
+        configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+        configuration.searchThreshold = -1.0f;
+
+        HFFeatureHubIndexConfiguration indexConfiguration;
+        indexConfiguration.indexType = HF_SEARCH_INDEX_FLAT;
+        indexConfiguration.hnswM = 16;
+        indexConfiguration.hnswEfConstruction = 200;
+        indexConfiguration.hnswEfSearch = 64;
+        indexConfiguration.rerankFactor = 4;
+
+        std::vector<std::vector<HFaceId>> truth;
+        HSize float32Memory = 0;
+        const std::vector<std::pair<HFSearchVectorStorage, std::string>> storages = {
+          {HF_SEARCH_STORAGE_FLOAT32, "float32"}, {HF_SEARCH_STORAGE_FLOAT16, "float16"}, {HF_SEARCH_STORAGE_INT8, "int8"}};
+        for (const auto &storage : storages) {
+            indexConfiguration.vectorStorage = storage.first;
+            ret = HFFeatureHubDataEnableWithIndex(configuration, indexConfiguration);
+            REQUIRE(ret == HSUCCEED);
+            for (int i = 0; i < numIdentities * samplesPerIdentity; ++i) {
+                auto feat = makeSample(i / samplesPerIdentity, i);
+                HFFaceFeature feature = {0};
+                feature.size = feat.size();
+                feature.data = feat.data();
+                HFFaceFeatureIdentity identity = {0};
+                identity.feature = &feature;
+                HFaceId allocId;
+                REQUIRE(HFFeatureHubInsertFeature(identity, &allocId) == HSUCCEED);
+            }
+            HSize memory = 0;
+            ret = HFFeatureHubGetSearchIndexMemoryUsage(&memory);
+            REQUIRE(ret == HSUCCEED);
+
+            double recallAt1 = 0.0;
+            double recallAtK = 0.0;
+            inspire::SpendTimer spend("Face Search Top10 100k@Flat " + storage.second);
+            for (int i = 0; i < numQueries; ++i) {
+                HFFaceFeature searchFeature = {0};
+                searchFeature.size = queryFeats[i].size();
+                searchFeature.data = queryFeats[i].data();
+                HFSearchTopKResults results = {0};
+                spend.Start();
+                ret = HFFeatureHubFaceSearchTopK(searchFeature, topK, &results);
+                spend.Stop();
+                REQUIRE(ret == HSUCCEED);
+                std::vector<HFaceId> found(results.ids, results.ids + results.size);
+                if (storage.first == HF_SEARCH_STORAGE_FLOAT32) {
+                    // Exact neighbours from the float32 index are the ground truth
+                    truth.push_back(found);
+                    continue;
+                }
+                recallAt1 += (!found.empty() && found[0] == truth[i][0]) ? 1.0 : 0.0;
+                size_t hit = 0;
+                for (auto id : truth[i]) {
+                    hit += std::find(found.begin(), found.end(), id) != found.end();
+                }
+                recallAtK += static_cast<double>(hit) / truth[i].size();
+            }
+            std::cout << spend << std::endl;
+            if (storage.first == HF_SEARCH_STORAGE_FLOAT32) {
+                float32Memory = memory;
+                TEST_PRINT("{} index memory={:.1f}MB", storage.second, memory / (1024.0 * 1024.0));
+            } else {
+                TEST_PRINT("{} index memory={:.1f}MB ({:.1f}% of float32) recall@1 delta={:.4f} recall@{} delta={:.4f}", storage.second,
+                           memory / (1024.0 * 1024.0), 100.0 * memory / float32Memory, recallAt1 / numQueries - 1.0, topK,
+                           recallAtK / numQueries - 1.0);
+            }
+
+            ret = HFFeatureHubDataDisable();
+            REQUIRE(ret == HSUCCEED);
+        }
+    }
+}
+
+TEST_CASE("test_BenchmarkFaceHubSearchConcurrency", "[benchmark]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+
+    SECTION("Benchmark search throughput vs threads 50k@Flat with a steady writer") {
+        const int genSizeOfBase = 50000;
+        const int numQueries = 200;
+        const auto measureTime = std::chrono::seconds(3);
+        // One insert every 5 ms, 200 inserts per second
+        const auto insertInterval = std::chrono::milliseconds(5);
+        HResult ret;
+        HInt32 featureLength;
+        HFGetFeatureLength(&featureLength);
+        REQUIRE(featureLength > 0);
+
+        HFFeatureHubConfiguration configuration;
+        configuration.primaryKeyMode = HF_PK_AUTO_INCREMENT;
+        configuration.enablePersistence = 0;
+        configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+        configuration.searchThreshold = 0.48f;
+        size_t baselineRss = getCurrentMemoryUsage();
+        ret = HFFeatureHubDataEnable(configuration);
+        REQUIRE(ret == HSUCCEED);
+
+        std::vector<std::vector<HFloat>> queryFeats;
+        for (int i = 0; i < genSizeOfBase; ++i) {
+            auto feat = GenerateRandomFeature(featureLength);
+            HFFaceFeature feature = {0};
+            feature.size = feat.size();
+            feature.data = feat.data();
+            HFFaceFeatureIdentity identity = {0};
+            identity.feature = &feature;
+            HFaceId allocId;
+            REQUIRE(HFFeatureHubInsertFeature(identity, &allocId) == HSUCCEED);
+            if (i % (genSizeOfBase / numQueries) == 0) {
+                queryFeats.push_back(SimulateSimilarVector(feat));
+            }
+        }
+        std::vector<std::vector<HFloat>> writerFeats;
+        for (int i = 0; i < 1000; ++i) {
+            writerFeats.push_back(GenerateRandomFeature(featureLength));
+        }
+        HSize indexMemory = 0;
+        REQUIRE(HFFeatureHubGetSearchIndexMemoryUsage(&indexMemory) == HSUCCEED);
+        // The process peak includes the SQLite pages of the in-memory table next to the index
+        TEST_PRINT("index memory={:.1f}MB process memory growth={}MB", indexMemory / (1024.0 * 1024.0),
+                   static_cast<int64_t>(getCurrentMemoryUsage()) - static_cast<int64_t>(baselineRss));
+
+        double baseThroughput = 0.0;
+        for (int numThreads : {1, 2, 4, 8}) {
+            std::atomic<bool> running(true);
+            std::atomic<long> searches(0);
+            std::atomic<long> inserts(0);
+            std::vector<std::thread> threads;
+            auto begin = std::chrono::steady_clock::now();
+            for (int t = 0; t < numThreads; ++t) {
+                threads.emplace_back([&, t]() {
+                    for (int j = t; running; ++j) {
+                        auto &feat = queryFeats[j % queryFeats.size()];
+                        HFFaceFeature searchFeature = {0};
+                        searchFeature.size = feat.size();
+                        searchFeature.data = feat.data();
+                        HFloat score;
+                        HFFaceFeatureIdentity identity = {0};
+                        HFFeatureHubFaceSearchWithBuffer(searchFeature, &score, &identity);
+                        searches++;
+                    }
+                });
+            }
+            std::thread writer([&]() {
+                auto next = std::chrono::steady_clock::now();
+                for (int j = 0; running; ++j) {
+                    auto &feat = writerFeats[j % writerFeats.size()];
+                    HFFaceFeature feature = {0};
+                    feature.size = feat.size();
+                    feature.data = feat.data();
+                    HFFaceFeatureIdentity identity = {0};
+                    identity.feature = &feature;
+                    HFaceId allocId;
+                    HFFeatureHubInsertFeature(identity, &allocId);
+                    inserts++;
+                    next += insertInterval;
+                    std::this_thread::sleep_until(next);
+                }
+            });
+            std::this_thread::sleep_for(measureTime);
+            running = false;
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            writer.join();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            double throughput = searches / seconds;
+            if (numThreads == 1) {
+                baseThroughput = throughput;
+            }
+            TEST_PRINT("threads={} searches/s={:.1f} speedup={:.2f}x inserts/s={:.1f}", numThreads, throughput, throughput / baseThroughput,
+                       inserts / seconds);
+        }
+
+        ret = HFFeatureHubDataDisable();
+        REQUIRE(ret == HSUCCEED);
+    }
+}
+
+
+TEST_CASE("test_BenchmarkFaceHubBatchInsert", "[benchmark]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+
+    const int genSize = 100000;
+    HInt32 featureLength;
+    HFGetFeatureLength(&featureLength);
+    REQUIRE(featureLength > 0);
+    std::vector<HFloat> features;
+    features.reserve(static_cast<size_t>(genSize) * featureLength);
+    for (int i = 0; i < genSize; ++i) {
+        auto feat = GenerateRandomFeature(featureLength);
+        features.insert(features.end(), feat.begin(), feat.end());
+    }
+    auto dbPath = GET_SAVE_DATA(".test");
+    HString dbPathStr = new char[dbPath.size() + 1];
+    std::strcpy(dbPathStr, dbPath.c_str());
+
+    for (int persistence : {0, 1}) {
+        HFFeatureHubConfiguration configuration;
+        configuration.primaryKeyMode = HF_PK_AUTO_INCREMENT;
+        configuration.enablePersistence = persistence;
+        configuration.persistenceDbPath = dbPathStr;
+        configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+        configuration.searchThreshold = 0.48f;
+
+        // One insert call per feature
+        std::remove(dbPathStr);
+        REQUIRE(HFFeatureHubDataEnable(configuration) == HSUCCEED);
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < genSize; ++i) {
+            HFFaceFeature feature = {0};
+            feature.size = featureLength;
+            feature.data = features.data() + static_cast<size_t>(i) * featureLength;
+            HFFaceFeatureIdentity identity = {0};
+            identity.feature = &feature;
+            HFaceId allocId;
+            REQUIRE(HFFeatureHubInsertFeature(identity, &allocId) == HSUCCEED);
+        }
+        double singleSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        REQUIRE(HFFeatureHubDataDisable() == HSUCCEED);
+
+        // The whole gallery in one bulk import
+        std::remove(dbPathStr);
+        REQUIRE(HFFeatureHubDataEnable(configuration) == HSUCCEED);
+        begin = std::chrono::steady_clock::now();
+        REQUIRE(HFFeatureHubBatchInsertFeatures(features.data(), genSize, nullptr, nullptr) == HSUCCEED);
+        double batchSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        HInt32 count;
+        REQUIRE(HFFeatureHubGetFaceCount(&count) == HSUCCEED);
+        REQUIRE(count == genSize);
+        REQUIRE(HFFeatureHubDataDisable() == HSUCCEED);
+
+        double singleRate = genSize / singleSeconds;
+        double batchRate = genSize / batchSeconds;
+        TEST_PRINT("{}k@{} inserts/s one by one={:.1f} batch={:.1f} speedup={:.2f}x", genSize / 1000, persistence ? "Persistence" : "Memory",
+                   singleRate, batchRate, batchRate / singleRate);
+    }
+    std::remove(dbPathStr);
+    delete[] dbPathStr;
+}
+
+TEST_CASE("test_BenchmarkFaceHubShardedSearch", "[benchmark]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+
+    const int genSize = 200000;
+    const int loop = 200;
+    const HInt32 topK = 10;
+    HInt32 featureLength;
+    HFGetFeatureLength(&featureLength);
+    REQUIRE(featureLength > 0);
+    std::vector<HFloat> features;
+    features.reserve(static_cast<size_t>(genSize) * featureLength);
+    for (int i = 0; i < genSize; ++i) {
+        auto feat = GenerateRandomFeature(featureLength);
+        features.insert(features.end(), feat.begin(), feat.end());
+    }
+
+    HFFeatureHubConfiguration configuration;
+    configuration.primaryKeyMode = HF_PK_AUTO_INCREMENT;
+    configuration.enablePersistence = 0;
+    configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+    configuration.searchThreshold = 0.48f;
+    HFFeatureHubIndexConfiguration indexConfiguration;
+    indexConfiguration.indexType = HF_SEARCH_INDEX_FLAT;
+    indexConfiguration.hnswM = 16;
+    indexConfiguration.hnswEfConstruction = 200;
+    indexConfiguration.hnswEfSearch = 64;
+    indexConfiguration.vectorStorage = HF_SEARCH_STORAGE_FLOAT32;
+    indexConfiguration.rerankFactor = 4;
+    REQUIRE(HFFeatureHubDataEnable(configuration) == HSUCCEED);
+
+    std::vector<HFloat> target(features.begin() + 1234 * featureLength, features.begin() + 1235 * featureLength);
+    auto searchFeat = SimulateSimilarVector(target);
+    HFFaceFeature searchFeature = {0};
+    searchFeature.size = searchFeat.size();
+    searchFeature.data = searchFeat.data();
+    std::vector<HFloat> confidence(topK);
+    std::vector<HFaceId> ids(topK);
+    double baseline = 0.0;
+    for (HInt32 shards : {1, 2, 4, 8}) {
+        std::string name = "shards_" + std::to_string(shards);
+        REQUIRE(HFFeatureHubCreateGallery((HString)name.c_str(), configuration, indexConfiguration, shards) == HSUCCEED);
+        REQUIRE(HFFeatureHubGalleryBatchInsertFeatures((HString)name.c_str(), features.data(), genSize, nullptr, nullptr) == HSUCCEED);
+        HFSearchTopKResults results = {0, confidence.data(), ids.data()};
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < loop; ++i) {
+            REQUIRE(HFFeatureHubGalleryFaceSearchTopK((HString)name.c_str(), searchFeature, topK, &results) == HSUCCEED);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        REQUIRE(results.size > 0);
+        REQUIRE(results.ids[0] == 1235);
+        REQUIRE(HFFeatureHubDropGallery((HString)name.c_str()) == HSUCCEED);
+
+        double qps = loop / seconds;
+        if (shards == 1) {
+            baseline = qps;
+        }
+        TEST_PRINT("{}k@{} shards search qps={:.1f} latency={:.3f}ms speedup={:.2f}x", genSize / 1000, shards, qps, seconds * 1000.0 / loop,
+                   qps / baseline);
+    }
+    REQUIRE(HFFeatureHubDataDisable() == HSUCCEED);
+}
+
+TEST_CASE("test_BenchmarkFaceHubFilteredSearch", "[benchmark]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+
+    const int genSize = 100000;
+    const int loop = 500;
+    const HInt32 topK = 10;
+    HInt32 featureLength;
+    HFGetFeatureLength(&featureLength);
+    REQUIRE(featureLength > 0);
+    std::vector<HFloat> features;
+    features.reserve(static_cast<size_t>(genSize) * featureLength);
+    for (int i = 0; i < genSize; ++i) {
+        auto feat = GenerateRandomFeature(featureLength);
+        features.insert(features.end(), feat.begin(), feat.end());
+    }
+
+    HFFeatureHubConfiguration configuration;
+    configuration.primaryKeyMode = HF_PK_AUTO_INCREMENT;
+    configuration.enablePersistence = 0;
+    configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+    configuration.searchThreshold = 0.48f;
+    REQUIRE(HFFeatureHubDataEnable(configuration) == HSUCCEED);
+    REQUIRE(HFFeatureHubBatchInsertFeatures(features.data(), genSize, nullptr, nullptr) == HSUCCEED);
+    // 1/16 of the gallery in each scattered group, plus one contiguous block of the same size
+    const HUInt64 block = 1ull << 32;
+    for (HFaceId id = 1; id <= genSize; ++id) {
+        REQUIRE(HFFeatureHubSetFaceTags(id, (1ull << (id % 16)) | (id <= genSize / 16 ? block : 0)) == HSUCCEED);
+    }
+
+    const HFaceId targetId = 1232;
+    std::vector<HFloat> target(features.begin() + (targetId - 1) * featureLength, features.begin() + targetId * featureLength);
+    auto searchFeat = SimulateSimilarVector(target);
+    HFFaceFeature searchFeature = {0};
+    searchFeature.size = searchFeat.size();
+    searchFeature.data = searchFeat.data();
+    std::vector<HFloat> confidence(topK);
+    std::vector<HFaceId> ids(topK);
+
+    HFSearchFilter everything = {0};
+    HFSearchFilter scattered = {0};
+    scattered.anyOf = 1ull << (targetId % 16);
+    HFSearchFilter contiguous = {0};
+    contiguous.allOf = block;
+    const std::pair<const char *, HFSearchFilter> filters[] = {{"no filter", everything}, {"scattered 1/16", scattered}, {"contiguous 1/16", contiguous}};
+    double baseline = 0.0;
+    for (const auto &filter : filters) {
+        HFSearchTopKResults results = {0, confidence.data(), ids.data()};
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < loop; ++i) {
+            REQUIRE(HFFeatureHubFaceSearchTopKFiltered(searchFeature, topK, filter.second, &results) == HSUCCEED);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        REQUIRE(results.size > 0);
+        REQUIRE(results.ids[0] == targetId);
+
+        double qps = loop / seconds;
+        if (baseline == 0.0) {
+            baseline = qps;
+        }
+        TEST_PRINT("{}k {} search qps={:.1f} latency={:.3f}ms speedup={:.2f}x", genSize / 1000, filter.first, qps, seconds * 1000.0 / loop,
+                   qps / baseline);
+    }
+    REQUIRE(HFFeatureHubDataDisable() == HSUCCEED);
 }
 
 #endif
\ No newline at end of file
@@ -404,4 +404,82 @@ TEST_CASE("test_MultipleLevelFaceDetect", "[face_detect]") {
         ret = HFReleaseInspireFaceSession(session);
         REQUIRE(ret == HSUCCEED);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("test_FaceTrackNumThreads", "[face_track]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+
+    HResult ret;
+    HFSessionCustomParameter parameter = {0};
+    HFDetectMode detMode = HF_DETECT_MODE_LIGHT_TRACK;
+    HInt32 detectPixelLevel = 640;
+    HFSession single;
+    ret = HFCreateInspireFaceSession(parameter, detMode, 25, detectPixelLevel, -1, &single);
+    REQUIRE(ret == HSUCCEED);
+    HFSession multiple;
+    ret = HFCreateInspireFaceSession(parameter, detMode, 25, detectPixelLevel, -1, &multiple);
+    REQUIRE(ret == HSUCCEED);
+    ret = HFSessionSetTrackNumThreads(multiple, 4);
+    REQUIRE(ret == HSUCCEED);
+    for (auto session : {single, multiple}) {
+        HFSessionSetTrackPreviewSize(session, detectPixelLevel);
+        HFSessionSetFilterMinimumFacePixelSize(session, 0);
+    }
+
+    HFImageStream imgHandle;
+    auto image = inspirecv::Image::Create(GET_DATA("data/bulk/pedestrian.png"));
+    ret = CVImageToImageStream(image, imgHandle);
+    REQUIRE(ret == HSUCCEED);
+
+    SECTION("Same faces and track ids for any number of threads") {
+        // The first frame detects, the next ones track
+        for (int frame = 0; frame < 5; frame++) {
+            HFMultipleFaceData singleData = {0};
+            ret = HFExecuteFaceTrack(single, imgHandle, &singleData);
+            REQUIRE(ret == HSUCCEED);
+            HFMultipleFaceData multipleData = {0};
+            ret = HFExecuteFaceTrack(multiple, imgHandle, &multipleData);
+            REQUIRE(ret == HSUCCEED);
+
+            REQUIRE(singleData.detectedNum > 1);
+            REQUIRE(singleData.detectedNum == multipleData.detectedNum);
+            for (int i = 0; i < singleData.detectedNum; i++) {
+                CHECK(singleData.trackIds[i] == multipleData.trackIds[i]);
+                CHECK(singleData.rects[i].x == multipleData.rects[i].x);
+                CHECK(singleData.rects[i].y == multipleData.rects[i].y);
+                CHECK(singleData.rects[i].width == multipleData.rects[i].width);
+                CHECK(singleData.rects[i].height == multipleData.rects[i].height);
+            }
+        }
+    }
+
+    SECTION("Track threads benchmark") {
+#ifdef ISF_ENABLE_BENCHMARK
+        int loop = 200;
+        HFMultipleFaceData multipleFaceData = {0};
+        for (auto session : {single, multiple}) {
+            // Warm up into the tracking state
+            ret = HFExecuteFaceTrack(session, imgHandle, &multipleFaceData);
+            REQUIRE(ret == HSUCCEED);
+            auto timer = inspire::Timer();
+            for (int i = 0; i < loop; ++i) {
+                ret = HFExecuteFaceTrack(session, imgHandle, &multipleFaceData);
+            }
+            auto cost = timer.GetCostTime();
+            REQUIRE(ret == HSUCCEED);
+            TEST_PRINT("<Benchmark> Face light track {} faces, {} threads -> Loop: {}, Total Time: {:.5f}ms, Average Time: {:.5f}ms",
+                       multipleFaceData.detectedNum, session == single ? 1 : 4, loop, cost, cost / loop);
+        }
+#else
+        TEST_PRINT("Skip the track threads benchmark test. To run it, you need to turn on the benchmark test.");
+#endif
+    }
+
+    ret = HFReleaseImageStream(imgHandle);
+    REQUIRE(ret == HSUCCEED);
+    ret = HFReleaseInspireFaceSession(single);
+    REQUIRE(ret == HSUCCEED);
+    ret = HFReleaseInspireFaceSession(multiple);
+    REQUIRE(ret == HSUCCEED);
+}
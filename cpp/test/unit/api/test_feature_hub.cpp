@@ -7,6 +7,7 @@
 #include "inspireface/c_api/inspireface.h"
 #include "unit/test_helper/test_help.h"
 #include <thread>
+#include <atomic>
 
 TEST_CASE("test_FeatureHubBase", "[FeatureHub][BasicFunction]") {
     DRAW_SPLIT_LINE
@@ -117,6 +118,96 @@ TEST_CASE("test_FeatureHubBase", "[FeatureHub][BasicFunction]") {
         delete[] dbPathStr;
     }
 
+    SECTION("FeatureHub batched search top-k") {
+        HResult ret;
+        HFFeatureHubConfiguration configuration;
+        configuration.primaryKeyMode = HF_PK_AUTO_INCREMENT;
+        configuration.enablePersistence = 0;
+        configuration.persistenceDbPath = nullptr;
+        configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+        configuration.searchThreshold = 0.48f;
+        ret = HFFeatureHubDataEnable(configuration);
+        REQUIRE(ret == HSUCCEED);
+
+        std::vector<std::vector<HFloat>> baseFeatures;
+        size_t genSizeOfBase = 2000;
+        HInt32 featureLength;
+        HFGetFeatureLength(&featureLength);
+        REQUIRE(featureLength > 0);
+        for (int i = 0; i < genSizeOfBase; ++i) {
+            auto feat = GenerateRandomFeature(featureLength);
+            baseFeatures.push_back(feat);
+            HFFaceFeature feature = {0};
+            feature.size = feat.size();
+            feature.data = feat.data();
+            HFFaceFeatureIdentity identity = {0};
+            identity.feature = &feature;
+            HFaceId allocId;
+            ret = HFFeatureHubInsertFeature(identity, &allocId);
+            REQUIRE(ret == HSUCCEED);
+        }
+
+        // Each query is a noisy copy of a stored feature, the last one matches nothing
+        std::vector<HInt32> targetIds = {7, 524, 1024, 1999};
+        std::vector<std::vector<HFloat>> queryFeats;
+        for (auto id : targetIds) {
+            queryFeats.push_back(SimulateSimilarVector(baseFeatures[id - 1]));
+        }
+        queryFeats.push_back(GenerateRandomFeature(featureLength));
+        std::vector<HFFaceFeature> queries(queryFeats.size());
+        for (size_t i = 0; i < queryFeats.size(); ++i) {
+            queries[i].size = queryFeats[i].size();
+            queries[i].data = queryFeats[i].data();
+        }
+
+        // Reference results from one search per query
+        auto topK = 5;
+        std::vector<std::vector<HFaceId>> expectIds;
+        for (auto &query : queries) {
+            HFSearchTopKResults single = {0};
+            ret = HFFeatureHubFaceSearchTopK(query, topK, &single);
+            REQUIRE(ret == HSUCCEED);
+            expectIds.emplace_back(single.ids, single.ids + single.size);
+        }
+
+        std::vector<HFSearchTopKResults> results(queries.size());
+        ret = HFFeatureHubFaceSearchTopKBatch(queries.data(), queries.size(), topK, results.data());
+        REQUIRE(ret == HSUCCEED);
+        for (size_t i = 0; i < queries.size(); ++i) {
+            REQUIRE(results[i].size == expectIds[i].size());
+            for (int j = 0; j < results[i].size; ++j) {
+                REQUIRE(results[i].ids[j] == expectIds[i][j]);
+            }
+        }
+        for (size_t i = 0; i < targetIds.size(); ++i) {
+            REQUIRE(results[i].size > 0);
+            REQUIRE(results[i].ids[0] == targetIds[i]);
+        }
+        REQUIRE(results.back().size == 0);
+
+        // The result arrays belong to the calling thread, a batch searched on another thread leaves them intact
+        std::vector<HFSearchTopKResults> otherResults(1);
+        HResult otherRet = HERR_INVALID_PARAM;
+        std::thread other([&]() { otherRet = HFFeatureHubFaceSearchTopKBatch(queries.data() + 1, 1, 1, otherResults.data()); });
+        other.join();
+        REQUIRE(otherRet == HSUCCEED);
+        REQUIRE(otherResults[0].size == 1);
+        for (size_t i = 0; i < queries.size(); ++i) {
+            REQUIRE(results[i].size == expectIds[i].size());
+            for (int j = 0; j < results[i].size; ++j) {
+                REQUIRE(results[i].ids[j] == expectIds[i][j]);
+            }
+        }
+
+        // A feature of the wrong length is rejected
+        queries[1].size = featureLength - 1;
+        ret = HFFeatureHubFaceSearchTopKBatch(queries.data(), queries.size(), topK, results.data());
+        REQUIRE(ret == HERR_INVALID_FACE_FEATURE);
+
+        ret = HFFeatureHubDataDisable();
+        REQUIRE(ret == HSUCCEED);
+    }
+
     SECTION("Repeat the enable and disable tests") {
         HResult ret;
         auto dbPath = GET_SAVE_DATA(".test");
@@ -443,6 +534,270 @@ TEST_CASE("test_ConcurrencySearch", "[FeatureHub][Concurrency]") {
     delete[] dbPathStr;
 }
 
+TEST_CASE("test_ConcurrencySearchWhileWriting", "[FeatureHub][Concurrency]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+
+    HResult ret;
+    HFFeatureHubConfiguration configuration;
+    configuration.primaryKeyMode = HF_PK_AUTO_INCREMENT;
+    configuration.enablePersistence = 0;
+    configuration.persistenceDbPath = nullptr;
+    configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+    configuration.searchThreshold = 0.48f;
+    ret = HFFeatureHubDataEnable(configuration);
+    REQUIRE(ret == HSUCCEED);
+
+    HInt32 featureLength;
+    HFGetFeatureLength(&featureLength);
+    REQUIRE(featureLength > 0);
+
+    const int genSizeOfBase = 2000;
+    std::vector<std::vector<HFloat>> baseFeatures;
+    for (int i = 0; i < genSizeOfBase; ++i) {
+        auto feat = GenerateRandomFeature(featureLength);
+        HFFaceFeature feature = {0};
+        feature.size = feat.size();
+        feature.data = feat.data();
+        HFFaceFeatureIdentity identity = {0};
+        identity.feature = &feature;
+        HFaceId allocId;
+        ret = HFFeatureHubInsertFeature(identity, &allocId);
+        REQUIRE(ret == HSUCCEED);
+        baseFeatures.push_back(feat);
+    }
+
+    // The first half of the base is searched, the writer only removes from the second half
+    const int searchable = genSizeOfBase / 2;
+    std::vector<std::vector<HFloat>> queries;
+    for (int i = 0; i < searchable; ++i) {
+        queries.push_back(SimulateSimilarVector(baseFeatures[i]));
+    }
+
+    const int numThreads = 4;
+    const int numInserts = 200;
+    const int numRemoves = 50;
+    std::atomic<bool> writing(true);
+    std::atomic<int> searches(0);
+    std::atomic<int> mismatches(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            std::mt19937 gen(t);
+            std::uniform_int_distribution<> dis(0, searchable - 1);
+            // Keep searching until the writer is done, at least a few rounds when it is faster
+            for (int j = 0; writing || j < 50; ++j) {
+                int idx = dis(gen);
+                std::vector<HFloat> query = queries[idx];
+                HFFaceFeature feature = {0};
+                feature.data = query.data();
+                feature.size = query.size();
+                HFloat score;
+                HFFaceFeatureIdentity identity = {0};
+                HResult searchRet = HFFeatureHubFaceSearchWithBuffer(feature, &score, &identity);
+                if (searchRet != HSUCCEED || identity.id != idx + 1) {
+                    mismatches++;
+                }
+                searches++;
+            }
+        });
+    }
+
+    std::vector<HFaceId> insertedIds;
+    std::vector<std::vector<HFloat>> insertedFeatures;
+    for (int i = 0; i < numInserts; ++i) {
+        auto feat = GenerateRandomFeature(featureLength);
+        HFFaceFeature feature = {0};
+        feature.size = feat.size();
+        feature.data = feat.data();
+        HFFaceFeatureIdentity identity = {0};
+        identity.feature = &feature;
+        HFaceId allocId;
+        ret = HFFeatureHubInsertFeature(identity, &allocId);
+        REQUIRE(ret == HSUCCEED);
+        insertedIds.push_back(allocId);
+        insertedFeatures.push_back(feat);
+        if (i < numRemoves) {
+            ret = HFFeatureHubFaceRemove(genSizeOfBase - i);
+            REQUIRE(ret == HSUCCEED);
+        }
+    }
+    writing = false;
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    TEST_PRINT("{} searches ran while writing", searches.load());
+    REQUIRE(mismatches == 0);
+
+    HInt32 count;
+    ret = HFFeatureHubGetFaceCount(&count);
+    REQUIRE(ret == HSUCCEED);
+    REQUIRE(count == genSizeOfBase + numInserts - numRemoves);
+
+    // Every write is visible once it has returned
+    for (int i = 0; i < numInserts; ++i) {
+        HFFaceFeature feature = {0};
+        feature.data = insertedFeatures[i].data();
+        feature.size = insertedFeatures[i].size();
+        HFloat score;
+        HFFaceFeatureIdentity identity = {0};
+        ret = HFFeatureHubFaceSearch(feature, &score, &identity);
+        REQUIRE(ret == HSUCCEED);
+        REQUIRE(identity.id == insertedIds[i]);
+    }
+    for (int i = 0; i < numRemoves; ++i) {
+        HFFaceFeatureIdentity identity = {0};
+        ret = HFFeatureHubGetFaceIdentity(genSizeOfBase - i, &identity);
+        REQUIRE(ret != HSUCCEED);
+    }
+
+    ret = HFFeatureHubDataDisable();
+    REQUIRE(ret == HSUCCEED);
+}
+
+TEST_CASE("test_FeatureHubSearchWithBuffer", "[FeatureHub][Concurrency]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+
+    HResult ret;
+    HFFeatureHubConfiguration configuration;
+    configuration.primaryKeyMode = HF_PK_AUTO_INCREMENT;
+    configuration.enablePersistence = 0;
+    configuration.persistenceDbPath = nullptr;
+    configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+    configuration.searchThreshold = 0.48f;
+    ret = HFFeatureHubDataEnable(configuration);
+    REQUIRE(ret == HSUCCEED);
+
+    HInt32 featureLength;
+    HFGetFeatureLength(&featureLength);
+    REQUIRE(featureLength > 0);
+
+    const int genSizeOfBase = 500;
+    std::vector<std::vector<HFloat>> baseFeatures;
+    std::vector<std::vector<HFloat>> queries;
+    for (int i = 0; i < genSizeOfBase; ++i) {
+        auto feat = GenerateRandomFeature(featureLength);
+        HFFaceFeature feature = {0};
+        feature.size = feat.size();
+        feature.data = feat.data();
+        HFFaceFeatureIdentity identity = {0};
+        identity.feature = &feature;
+        HFaceId allocId;
+        ret = HFFeatureHubInsertFeature(identity, &allocId);
+        REQUIRE(ret == HSUCCEED);
+        baseFeatures.push_back(feat);
+        queries.push_back(SimulateSimilarVector(feat));
+    }
+
+    SECTION("The caller buffers receive the same results as the cached search") {
+        const HInt32 topK = 5;
+        for (int i = 0; i < 20; ++i) {
+            HFFaceFeature searchFeature = {0};
+            searchFeature.size = queries[i].size();
+            searchFeature.data = queries[i].data();
+
+            std::vector<HFloat> matched(featureLength);
+            HFFaceFeature matchedFeature = {0};
+            matchedFeature.size = matched.size();
+            matchedFeature.data = matched.data();
+            HFFaceFeatureIdentity identity = {0};
+            identity.feature = &matchedFeature;
+            HFloat confidence;
+            ret = HFFeatureHubFaceSearchWithBuffer(searchFeature, &confidence, &identity);
+            REQUIRE(ret == HSUCCEED);
+            REQUIRE(identity.id == i + 1);
+            REQUIRE(confidence > 0.8f);
+            REQUIRE(matched == baseFeatures[i]);
+
+            std::vector<HFaceId> ids(topK);
+            std::vector<HFloat> confidences(topK);
+            HFSearchTopKResults owned = {0};
+            owned.ids = ids.data();
+            owned.confidence = confidences.data();
+            ret = HFFeatureHubFaceSearchTopKWithBuffer(searchFeature, topK, &owned);
+            REQUIRE(ret == HSUCCEED);
+
+            HFSearchTopKResults cached = {0};
+            ret = HFFeatureHubFaceSearchTopK(searchFeature, topK, &cached);
+            REQUIRE(ret == HSUCCEED);
+            REQUIRE(owned.size == cached.size);
+            for (int k = 0; k < owned.size; ++k) {
+                REQUIRE(owned.ids[k] == cached.ids[k]);
+                REQUIRE(owned.confidence[k] == Approx(cached.confidence[k]));
+            }
+        }
+
+        // No match leaves the id at -1 and does not touch the feature buffer
+        auto notSimilar = GenerateRandomFeature(featureLength);
+        HFFaceFeature searchFeature = {0};
+        searchFeature.size = notSimilar.size();
+        searchFeature.data = notSimilar.data();
+        HFFaceFeatureIdentity identity = {0};
+        HFloat confidence;
+        ret = HFFeatureHubFaceSearchWithBuffer(searchFeature, &confidence, &identity);
+        REQUIRE(ret == HSUCCEED);
+        REQUIRE(identity.id == -1);
+    }
+
+    SECTION("Concurrent searches do not share results") {
+        const int numThreads = 4;
+        const int searchesPerThread = 100;
+        const HInt32 topK = 3;
+        std::atomic<int> mismatches(0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < numThreads; ++t) {
+            threads.emplace_back([&, t]() {
+                std::vector<HFaceId> ids(topK);
+                std::vector<HFloat> confidences(topK);
+                for (int j = 0; j < searchesPerThread; ++j) {
+                    int idx = (t * searchesPerThread + j) % genSizeOfBase;
+                    HFFaceFeature searchFeature = {0};
+                    searchFeature.size = queries[idx].size();
+                    searchFeature.data = queries[idx].data();
+                    HFSearchTopKResults results = {0};
+                    results.ids = ids.data();
+                    results.confidence = confidences.data();
+                    HResult searchRet = HFFeatureHubFaceSearchTopKWithBuffer(searchFeature, topK, &results);
+                    if (searchRet != HSUCCEED || results.size < 1 || results.ids[0] != idx + 1) {
+                        mismatches++;
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        REQUIRE(mismatches == 0);
+    }
+
+    SECTION("Batched search into caller buffers") {
+        const int numQueries = 16;
+        const HInt32 topK = 3;
+        std::vector<HFFaceFeature> searchFeatures(numQueries);
+        for (int i = 0; i < numQueries; ++i) {
+            searchFeatures[i].size = queries[i * 7].size();
+            searchFeatures[i].data = queries[i * 7].data();
+        }
+        std::vector<HFaceId> ids(numQueries * topK);
+        std::vector<HFloat> confidences(numQueries * topK);
+        std::vector<HFSearchTopKResults> results(numQueries);
+        for (int i = 0; i < numQueries; ++i) {
+            results[i].ids = ids.data() + i * topK;
+            results[i].confidence = confidences.data() + i * topK;
+        }
+        ret = HFFeatureHubFaceSearchTopKBatchWithBuffer(searchFeatures.data(), numQueries, topK, results.data());
+        REQUIRE(ret == HSUCCEED);
+        for (int i = 0; i < numQueries; ++i) {
+            REQUIRE(results[i].size >= 1);
+            REQUIRE(results[i].ids[0] == i * 7 + 1);
+        }
+    }
+
+    ret = HFFeatureHubDataDisable();
+    REQUIRE(ret == HSUCCEED);
+}
+
 TEST_CASE("test_FeatureCache", "[FeatureHub][Concurrency]") {
     DRAW_SPLIT_LINE
     TEST_PRINT_OUTPUT(true);
@@ -550,3 +905,660 @@ TEST_CASE("test_FeatureHubManualInput", "[FeatureHub][ManualInput]") {
     ret = HFFeatureHubDataDisable();
     REQUIRE(ret == HSUCCEED);
 }
+
+TEST_CASE("test_FeatureHubBatchInsert", "[FeatureHub][BatchInsert]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+    HResult ret;
+    HInt32 featureLength;
+    HFGetFeatureLength(&featureLength);
+    const int num = 200;
+    std::vector<float> features;
+    features.reserve(num * featureLength);
+    for (int i = 0; i < num; ++i) {
+        auto vec = GenerateRandomFeature(featureLength);
+        features.insert(features.end(), vec.begin(), vec.end());
+    }
+
+    SECTION("Auto increment") {
+        HFFeatureHubConfiguration configuration;
+        configuration.primaryKeyMode = HF_PK_AUTO_INCREMENT;
+        configuration.enablePersistence = 0;
+        configuration.searchThreshold = 0.5f;
+        configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+        ret = HFFeatureHubDataEnable(configuration);
+        REQUIRE(ret == HSUCCEED);
+
+        std::vector<HFaceId> allocIds(num, -1);
+        ret = HFFeatureHubBatchInsertFeatures(features.data(), num, nullptr, allocIds.data());
+        REQUIRE(ret == HSUCCEED);
+        HInt32 count;
+        ret = HFFeatureHubGetFaceCount(&count);
+        REQUIRE(ret == HSUCCEED);
+        REQUIRE(count == num);
+
+        // Every imported feature is found again under the id returned for it
+        for (int i = 0; i < num; i += 17) {
+            HFFaceFeature query = {0};
+            query.data = features.data() + i * featureLength;
+            query.size = featureLength;
+            HFloat confidence;
+            HFFaceFeatureIdentity mostSimilar = {0};
+            ret = HFFeatureHubFaceSearchWithBuffer(query, &confidence, &mostSimilar);
+            REQUIRE(ret == HSUCCEED);
+            REQUIRE(mostSimilar.id == allocIds[i]);
+        }
+
+        ret = HFFeatureHubDataDisable();
+        REQUIRE(ret == HSUCCEED);
+    }
+
+    SECTION("Manual input") {
+        HFFeatureHubConfiguration configuration;
+        configuration.primaryKeyMode = HF_PK_MANUAL_INPUT;
+        configuration.enablePersistence = 0;
+        configuration.searchThreshold = 0.5f;
+        configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+        ret = HFFeatureHubDataEnable(configuration);
+        REQUIRE(ret == HSUCCEED);
+
+        // Ids are required in manual mode
+        ret = HFFeatureHubBatchInsertFeatures(features.data(), num, nullptr, nullptr);
+        REQUIRE(ret == HERR_FT_HUB_INSERT_FAILURE);
+
+        std::vector<HFaceId> ids(num);
+        for (int i = 0; i < num; ++i) {
+            ids[i] = 5000 + i * 3;
+        }
+        std::vector<HFaceId> allocIds(num, -1);
+        ret = HFFeatureHubBatchInsertFeatures(features.data(), num, ids.data(), allocIds.data());
+        REQUIRE(ret == HSUCCEED);
+        REQUIRE(allocIds == ids);
+
+        HFFaceFeatureIdentity identity = {0};
+        ret = HFFeatureHubGetFaceIdentity(ids[42], &identity);
+        REQUIRE(ret == HSUCCEED);
+        REQUIRE(identity.id == ids[42]);
+
+        // A duplicate id rolls back the whole batch
+        std::vector<HFaceId> duplicated = {1, 2, ids[0]};
+        ret = HFFeatureHubBatchInsertFeatures(features.data(), 3, duplicated.data(), nullptr);
+        REQUIRE(ret == HERR_FT_HUB_INSERT_FAILURE);
+        HInt32 count;
+        ret = HFFeatureHubGetFaceCount(&count);
+        REQUIRE(ret == HSUCCEED);
+        REQUIRE(count == num);
+
+        ret = HFFeatureHubDataDisable();
+        REQUIRE(ret == HSUCCEED);
+    }
+}
+
+TEST_CASE("test_FeatureHubHnswIndex", "[FeatureHub][Hnsw]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+
+    HFFeatureHubIndexConfiguration indexConfiguration;
+    indexConfiguration.indexType = HF_SEARCH_INDEX_HNSW;
+    indexConfiguration.hnswM = 16;
+    indexConfiguration.hnswEfConstruction = 100;
+    indexConfiguration.hnswEfSearch = 64;
+    indexConfiguration.vectorStorage = HF_SEARCH_STORAGE_FLOAT32;
+    indexConfiguration.rerankFactor = 4;
+
+    SECTION("Insert, update, remove and search") {
+        HResult ret;
+        HFFeatureHubConfiguration configuration;
+        configuration.primaryKeyMode = HF_PK_AUTO_INCREMENT;
+        configuration.enablePersistence = 0;
+        configuration.persistenceDbPath = nullptr;
+        configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+        configuration.searchThreshold = 0.48f;
+        ret = HFFeatureHubDataEnableWithIndex(configuration, indexConfiguration);
+        REQUIRE(ret == HSUCCEED);
+
+        std::vector<std::vector<HFloat>> baseFeatures;
+        size_t genSizeOfBase = 2000;
+        HInt32 featureLength;
+        HFGetFeatureLength(&featureLength);
+        for (int i = 0; i < genSizeOfBase; ++i) {
+            auto feat = GenerateRandomFeature(featureLength);
+            baseFeatures.push_back(feat);
+            HFFaceFeature feature = {0};
+            feature.size = feat.size();
+            feature.data = feat.data();
+            HFFaceFeatureIdentity identity = {0};
+            identity.feature = &feature;
+            HFaceId allocId;
+            ret = HFFeatureHubInsertFeature(identity, &allocId);
+            REQUIRE(ret == HSUCCEED);
+        }
+        HInt32 totalFace;
+        ret = HFFeatureHubGetFaceCount(&totalFace);
+        REQUIRE(ret == HSUCCEED);
+        REQUIRE(totalFace == genSizeOfBase);
+
+        for (HFaceId targetId : {1, 777, 2000}) {
+            auto searchFeat = SimulateSimilarVector(baseFeatures[targetId - 1]);
+            HFFaceFeature searchFeature = {0};
+            searchFeature.size = searchFeat.size();
+            searchFeature.data = searchFeat.data();
+            HFloat confidence;
+            HFFaceFeatureIdentity mostSimilar = {0};
+            ret = HFFeatureHubFaceSearch(searchFeature, &confidence, &mostSimilar);
+            REQUIRE(ret == HSUCCEED);
+            REQUIRE(mostSimilar.id == targetId);
+            REQUIRE(confidence > 0.88f);
+        }
+
+        // Move id 100 onto the vector of id 1500, both must now be found for the same query
+        auto movedFeat = SimulateSimilarVector(baseFeatures[1500 - 1]);
+        HFFaceFeature movedFeature = {0};
+        movedFeature.size = movedFeat.size();
+        movedFeature.data = movedFeat.data();
+        HFFaceFeatureIdentity movedIdentity = {0};
+        movedIdentity.feature = &movedFeature;
+        movedIdentity.id = 100;
+        ret = HFFeatureHubFaceUpdate(movedIdentity);
+        REQUIRE(ret == HSUCCEED);
+
+        auto searchFeat = SimulateSimilarVector(baseFeatures[1500 - 1]);
+        HFFaceFeature searchFeature = {0};
+        searchFeature.size = searchFeat.size();
+        searchFeature.data = searchFeat.data();
+        HFSearchTopKResults results = {0};
+        ret = HFFeatureHubFaceSearchTopK(searchFeature, 5, &results);
+        REQUIRE(ret == HSUCCEED);
+        REQUIRE(results.size == 2);
+        std::vector<HFaceId> found(results.ids, results.ids + results.size);
+        REQUIRE(std::find(found.begin(), found.end(), 100) != found.end());
+        REQUIRE(std::find(found.begin(), found.end(), 1500) != found.end());
+
+        // A removed feature is never returned
+        ret = HFFeatureHubFaceRemove(1500);
+        REQUIRE(ret == HSUCCEED);
+        ret = HFFeatureHubFaceSearchTopK(searchFeature, 5, &results);
+        REQUIRE(ret == HSUCCEED);
+        REQUIRE(results.size == 1);
+        REQUIRE(results.ids[0] == 100);
+        ret = HFFeatureHubGetFaceCount(&totalFace);
+        REQUIRE(ret == HSUCCEED);
+        REQUIRE(totalFace == genSizeOfBase - 1);
+
+        ret = HFFeatureHubSetSearchEf(128);
+        REQUIRE(ret == HSUCCEED);
+        ret = HFFeatureHubSetSearchEf(0);
+        REQUIRE(ret == HERR_INVALID_PARAM);
+
+        ret = HFFeatureHubDataDisable();
+        REQUIRE(ret == HSUCCEED);
+    }
+
+    SECTION("The graph is saved and reloaded with the database") {
+        HResult ret;
+        HFFeatureHubConfiguration configuration;
+        auto dbPath = GET_SAVE_DATA(".test_hnsw");
+        HString dbPathStr = new char[dbPath.size() + 1];
+        std::strcpy(dbPathStr, dbPath.c_str());
+        configuration.primaryKeyMode = HF_PK_AUTO_INCREMENT;
+        configuration.enablePersistence = 1;
+        configuration.persistenceDbPath = dbPathStr;
+        configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+        configuration.searchThreshold = 0.48f;
+        // Delete the previous data before testing
+        std::remove(dbPath.c_str());
+        std::remove((dbPath + ".hnsw").c_str());
+        ret = HFFeatureHubDataEnableWithIndex(configuration, indexConfiguration);
+        REQUIRE(ret == HSUCCEED);
+
+        size_t genSizeOfBase = 1000;
+        HInt32 targetId = 321;
+        std::vector<HFloat> targetFeature;
+        HInt32 featureLength;
+        HFGetFeatureLength(&featureLength);
+        for (int i = 0; i < genSizeOfBase; ++i) {
+            auto feat = GenerateRandomFeature(featureLength);
+            if (i == targetId - 1) {
+                targetFeature = feat;
+            }
+            HFFaceFeature feature = {0};
+            feature.size = feat.size();
+            feature.data = feat.data();
+            HFFaceFeatureIdentity identity = {0};
+            identity.feature = &feature;
+            HFaceId allocId;
+            ret = HFFeatureHubInsertFeature(identity, &allocId);
+            REQUIRE(ret == HSUCCEED);
+        }
+        ret = HFFeatureHubDataDisable();
+        REQUIRE(ret == HSUCCEED);
+
+        // Disabling the hub writes the graph next to the database
+        std::ifstream indexFile(dbPath + ".hnsw", std::ios::binary);
+        REQUIRE(indexFile.good());
+        indexFile.close();
+
+        ret = HFFeatureHubDataEnableWithIndex(configuration, indexConfiguration);
+        REQUIRE(ret == HSUCCEED);
+        HInt32 totalFace;
+        ret = HFFeatureHubGetFaceCount(&totalFace);
+        REQUIRE(ret == HSUCCEED);
+        REQUIRE(totalFace == genSizeOfBase);
+
+        auto searchFeat = SimulateSimilarVector(targetFeature);
+        HFFaceFeature searchFeature = {0};
+        searchFeature.size = searchFeat.size();
+        searchFeature.data = searchFeat.data();
+        HFloat confidence;
+        HFFaceFeatureIdentity mostSimilar = {0};
+        ret = HFFeatureHubFaceSearch(searchFeature, &confidence, &mostSimilar);
+        REQUIRE(ret == HSUCCEED);
+        REQUIRE(mostSimilar.id == targetId);
+
+        ret = HFFeatureHubDataDisable();
+        REQUIRE(ret == HSUCCEED);
+
+        delete[] dbPathStr;
+    }
+}
+
+TEST_CASE("test_FeatureHubQuantizedStorage", "[FeatureHub][Quantized]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+
+    HResult ret;
+    HFFeatureHubConfiguration configuration;
+    configuration.primaryKeyMode = HF_PK_AUTO_INCREMENT;
+    configuration.enablePersistence = 0;
+    configuration.persistenceDbPath = nullptr;
+    configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+    configuration.searchThreshold = 0.48f;
+
+    HFFeatureHubIndexConfiguration indexConfiguration;
+    indexConfiguration.indexType = HF_SEARCH_INDEX_FLAT;
+    indexConfiguration.hnswM = 16;
+    indexConfiguration.hnswEfConstruction = 200;
+    indexConfiguration.hnswEfSearch = 64;
+    indexConfiguration.rerankFactor = 4;
+
+    std::vector<std::vector<HFloat>> baseFeatures;
+    size_t genSizeOfBase = 2000;
+    HInt32 featureLength;
+    HFGetFeatureLength(&featureLength);
+    for (int i = 0; i < genSizeOfBase; ++i) {
+        baseFeatures.push_back(GenerateRandomFeature(featureLength));
+    }
+    auto insertBase = [&]() {
+        for (auto &feat : baseFeatures) {
+            HFFaceFeature feature = {0};
+            feature.size = feat.size();
+            feature.data = feat.data();
+            HFFaceFeatureIdentity identity = {0};
+            identity.feature = &feature;
+            HFaceId allocId;
+            REQUIRE(HFFeatureHubInsertFeature(identity, &allocId) == HSUCCEED);
+        }
+    };
+
+    indexConfiguration.vectorStorage = HF_SEARCH_STORAGE_FLOAT32;
+    ret = HFFeatureHubDataEnableWithIndex(configuration, indexConfiguration);
+    REQUIRE(ret == HSUCCEED);
+    insertBase();
+    HSize float32Memory = 0;
+    ret = HFFeatureHubGetSearchIndexMemoryUsage(&float32Memory);
+    REQUIRE(ret == HSUCCEED);
+    ret = HFFeatureHubDataDisable();
+    REQUIRE(ret == HSUCCEED);
+
+    for (HFSearchVectorStorage storage : {HF_SEARCH_STORAGE_FLOAT16, HF_SEARCH_STORAGE_INT8}) {
+        indexConfiguration.vectorStorage = storage;
+        ret = HFFeatureHubDataEnableWithIndex(configuration, indexConfiguration);
+        REQUIRE(ret == HSUCCEED);
+        insertBase();
+
+        HSize memory = 0;
+        ret = HFFeatureHubGetSearchIndexMemoryUsage(&memory);
+        REQUIRE(ret == HSUCCEED);
+        // The float32 hub also keeps every feature in its table, the quantized one keeps them in the index only
+        REQUIRE(memory > float32Memory);
+        REQUIRE(memory < 2 * float32Memory);
+
+        // Scores are re-ranked, so they are exact and the stored features are returned as inserted
+        for (HFaceId targetId : {1, 777, 2000}) {
+            auto searchFeat = SimulateSimilarVector(baseFeatures[targetId - 1]);
+            HFFaceFeature searchFeature = {0};
+            searchFeature.size = searchFeat.size();
+            searchFeature.data = searchFeat.data();
+            HFloat confidence;
+            HFFaceFeatureIdentity mostSimilar = {0};
+            ret = HFFeatureHubFaceSearch(searchFeature, &confidence, &mostSimilar);
+            REQUIRE(ret == HSUCCEED);
+            REQUIRE(mostSimilar.id == targetId);
+
+            HFFaceFeature targetFeature = {0};
+            targetFeature.size = baseFeatures[targetId - 1].size();
+            targetFeature.data = baseFeatures[targetId - 1].data();
+            HFloat exact;
+            ret = HFFaceComparison(searchFeature, targetFeature, &exact);
+            REQUIRE(ret == HSUCCEED);
+            REQUIRE(confidence == Approx(exact).epsilon(1e-4));
+
+            HFFaceFeatureIdentity identity = {0};
+            ret = HFFeatureHubGetFaceIdentity(targetId, &identity);
+            REQUIRE(ret == HSUCCEED);
+            std::vector<HFloat> stored(identity.feature->data, identity.feature->data + identity.feature->size);
+            REQUIRE(stored == baseFeatures[targetId - 1]);
+        }
+
+        // A removed feature is never returned
+        auto searchFeat = SimulateSimilarVector(baseFeatures[500 - 1]);
+        HFFaceFeature searchFeature = {0};
+        searchFeature.size = searchFeat.size();
+        searchFeature.data = searchFeat.data();
+        ret = HFFeatureHubFaceRemove(500);
+        REQUIRE(ret == HSUCCEED);
+        HFSearchTopKResults results = {0};
+        ret = HFFeatureHubFaceSearchTopK(searchFeature, 5, &results);
+        REQUIRE(ret == HSUCCEED);
+        REQUIRE(results.size == 0);
+
+        ret = HFFeatureHubDataDisable();
+        REQUIRE(ret == HSUCCEED);
+    }
+}
+
+TEST_CASE("test_FeatureHubSnapshot", "[FeatureHub][Snapshot]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+
+    HResult ret;
+    HFFeatureHubConfiguration configuration;
+    auto dbPath = GET_SAVE_DATA(".test_snapshot");
+    HString dbPathStr = new char[dbPath.size() + 1];
+    std::strcpy(dbPathStr, dbPath.c_str());
+    configuration.primaryKeyMode = HF_PK_AUTO_INCREMENT;
+    configuration.enablePersistence = 1;
+    configuration.persistenceDbPath = dbPathStr;
+    configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+    configuration.searchThreshold = 0.48f;
+    // Delete the previous data before testing
+    std::remove(dbPath.c_str());
+    std::remove((dbPath + ".snap").c_str());
+    ret = HFFeatureHubDataEnable(configuration);
+    REQUIRE(ret == HSUCCEED);
+
+    const int genSizeOfBase = 1000;
+    HInt32 featureLength;
+    HFGetFeatureLength(&featureLength);
+    std::vector<HFloat> features;
+    for (int i = 0; i < genSizeOfBase; ++i) {
+        auto feat = GenerateRandomFeature(featureLength);
+        features.insert(features.end(), feat.begin(), feat.end());
+    }
+    ret = HFFeatureHubBatchInsertFeatures(features.data(), genSizeOfBase, nullptr, nullptr);
+    REQUIRE(ret == HSUCCEED);
+    ret = HFFeatureHubSaveSearchIndex();
+    REQUIRE(ret == HSUCCEED);
+    std::ifstream snapshotFile(dbPath + ".snap", std::ios::binary);
+    REQUIRE(snapshotFile.good());
+    snapshotFile.close();
+    ret = HFFeatureHubDataDisable();
+    REQUIRE(ret == HSUCCEED);
+
+    // The snapshot is mapped instead of loading the rows, the heap only holds the empty id map
+    ret = HFFeatureHubDataEnable(configuration);
+    REQUIRE(ret == HSUCCEED);
+    HSize usage = 0;
+    ret = HFFeatureHubGetSearchIndexMemoryUsage(&usage);
+    REQUIRE(ret == HSUCCEED);
+    REQUIRE(usage < static_cast<HSize>(featureLength * sizeof(float)));
+    HInt32 totalFace;
+    ret = HFFeatureHubGetFaceCount(&totalFace);
+    REQUIRE(ret == HSUCCEED);
+    REQUIRE(totalFace == genSizeOfBase);
+
+    const HInt32 targetId = 321;
+    std::vector<HFloat> targetFeature(features.begin() + (targetId - 1) * featureLength, features.begin() + targetId * featureLength);
+    auto searchFeat = SimulateSimilarVector(targetFeature);
+    HFFaceFeature searchFeature = {0};
+    searchFeature.size = searchFeat.size();
+    searchFeature.data = searchFeat.data();
+    HFloat confidence;
+    HFFaceFeatureIdentity mostSimilar = {0};
+    ret = HFFeatureHubFaceSearchWithBuffer(searchFeature, &confidence, &mostSimilar);
+    REQUIRE(ret == HSUCCEED);
+    REQUIRE(mostSimilar.id == targetId);
+    HFFaceFeatureIdentity identity = {0};
+    ret = HFFeatureHubGetFaceIdentity(targetId, &identity);
+    REQUIRE(ret == HSUCCEED);
+    std::vector<HFloat> stored(identity.feature->data, identity.feature->data + identity.feature->size);
+    REQUIRE(stored == targetFeature);
+
+    // Writes move the rows to the heap and drop the stale snapshot
+    ret = HFFeatureHubFaceRemove(targetId);
+    REQUIRE(ret == HSUCCEED);
+    ret = HFFeatureHubFaceSearchWithBuffer(searchFeature, &confidence, &mostSimilar);
+    REQUIRE(ret == HSUCCEED);
+    REQUIRE(mostSimilar.id != targetId);
+    std::ifstream staleFile(dbPath + ".snap", std::ios::binary);
+    REQUIRE(!staleFile.good());
+    ret = HFFeatureHubDataDisable();
+    REQUIRE(ret == HSUCCEED);
+
+    // Disabling saved a new snapshot without the removed feature
+    ret = HFFeatureHubDataEnable(configuration);
+    REQUIRE(ret == HSUCCEED);
+    ret = HFFeatureHubGetFaceCount(&totalFace);
+    REQUIRE(ret == HSUCCEED);
+    REQUIRE(totalFace == genSizeOfBase - 1);
+    ret = HFFeatureHubFaceSearchWithBuffer(searchFeature, &confidence, &mostSimilar);
+    REQUIRE(ret == HSUCCEED);
+    REQUIRE(mostSimilar.id != targetId);
+    ret = HFFeatureHubDataDisable();
+    REQUIRE(ret == HSUCCEED);
+
+    delete[] dbPathStr;
+}
+
+TEST_CASE("test_FeatureHubGallery", "[FeatureHub][Gallery]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+
+    HResult ret;
+    HFFeatureHubConfiguration configuration;
+    configuration.primaryKeyMode = HF_PK_AUTO_INCREMENT;
+    configuration.enablePersistence = 0;
+    configuration.searchThreshold = 0.48f;
+    configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+    HFFeatureHubIndexConfiguration indexConfiguration;
+    indexConfiguration.indexType = HF_SEARCH_INDEX_FLAT;
+    indexConfiguration.hnswM = 16;
+    indexConfiguration.hnswEfConstruction = 200;
+    indexConfiguration.hnswEfSearch = 64;
+    indexConfiguration.vectorStorage = HF_SEARCH_STORAGE_FLOAT32;
+    indexConfiguration.rerankFactor = 4;
+
+    // Galleries need the feature hub
+    ret = HFFeatureHubCreateGallery((HString) "single", configuration, indexConfiguration, 1);
+    REQUIRE(ret == HERR_FT_HUB_DISABLE);
+    ret = HFFeatureHubDataEnable(configuration);
+    REQUIRE(ret == HSUCCEED);
+
+    ret = HFFeatureHubCreateGallery((HString) "single", configuration, indexConfiguration, 1);
+    REQUIRE(ret == HSUCCEED);
+    ret = HFFeatureHubCreateGallery((HString) "sharded", configuration, indexConfiguration, 4);
+    REQUIRE(ret == HSUCCEED);
+    ret = HFFeatureHubCreateGallery((HString) "sharded", configuration, indexConfiguration, 2);
+    REQUIRE(ret != HSUCCEED);
+    // Names end up in database file names
+    for (const char *name : {"", "..", "../outside", "a/b", "a\\b", "with space", "dot.name"}) {
+        ret = HFFeatureHubCreateGallery((HString)name, configuration, indexConfiguration, 1);
+        REQUIRE(ret == HERR_INVALID_PARAM);
+    }
+
+    const int num = 2000;
+    HInt32 featureLength;
+    HFGetFeatureLength(&featureLength);
+    std::vector<HFloat> features;
+    for (int i = 0; i < num; ++i) {
+        auto feat = GenerateRandomFeature(featureLength);
+        features.insert(features.end(), feat.begin(), feat.end());
+    }
+    ret = HFFeatureHubGalleryBatchInsertFeatures((HString) "single", features.data(), num, nullptr, nullptr);
+    REQUIRE(ret == HSUCCEED);
+    ret = HFFeatureHubGalleryBatchInsertFeatures((HString) "sharded", features.data(), num, nullptr, nullptr);
+    REQUIRE(ret == HSUCCEED);
+
+    // Galleries are isolated from the default database and from each other
+    HInt32 count;
+    ret = HFFeatureHubGetFaceCount(&count);
+    REQUIRE(ret == HSUCCEED);
+    REQUIRE(count == 0);
+    ret = HFFeatureHubGalleryGetFaceCount((HString) "sharded", &count);
+    REQUIRE(ret == HSUCCEED);
+    REQUIRE(count == num);
+
+    // The merged results of the shards are the results of a single index
+    const HInt32 topK = 5;
+    for (int i = 0; i < num; i += 97) {
+        std::vector<HFloat> target(features.begin() + i * featureLength, features.begin() + (i + 1) * featureLength);
+        auto searchFeat = SimulateSimilarVector(target);
+        HFFaceFeature searchFeature = {0};
+        searchFeature.size = searchFeat.size();
+        searchFeature.data = searchFeat.data();
+        std::vector<HFloat> singleConfidence(topK), shardedConfidence(topK);
+        std::vector<HFaceId> singleIds(topK), shardedIds(topK);
+        HFSearchTopKResults single = {0, singleConfidence.data(), singleIds.data()};
+        HFSearchTopKResults sharded = {0, shardedConfidence.data(), shardedIds.data()};
+        ret = HFFeatureHubGalleryFaceSearchTopK((HString) "single", searchFeature, topK, &single);
+        REQUIRE(ret == HSUCCEED);
+        ret = HFFeatureHubGalleryFaceSearchTopK((HString) "sharded", searchFeature, topK, &sharded);
+        REQUIRE(ret == HSUCCEED);
+        REQUIRE(sharded.size > 0);
+        REQUIRE(sharded.ids[0] == i + 1);
+        REQUIRE(sharded.size == single.size);
+        for (int k = 0; k < sharded.size; ++k) {
+            REQUIRE(sharded.ids[k] == single.ids[k]);
+        }
+    }
+
+    ret = HFFeatureHubGalleryRemove((HString) "sharded", 1);
+    REQUIRE(ret == HSUCCEED);
+    ret = HFFeatureHubGalleryGetFaceCount((HString) "sharded", &count);
+    REQUIRE(ret == HSUCCEED);
+    REQUIRE(count == num - 1);
+
+    ret = HFFeatureHubDropGallery((HString) "sharded");
+    REQUIRE(ret == HSUCCEED);
+    ret = HFFeatureHubGalleryGetFaceCount((HString) "sharded", &count);
+    REQUIRE(ret == HERR_FT_HUB_GALLERY_NOT_FOUND);
+
+    // Disabling the hub drops the remaining galleries
+    ret = HFFeatureHubDataDisable();
+    REQUIRE(ret == HSUCCEED);
+    ret = HFFeatureHubDataEnable(configuration);
+    REQUIRE(ret == HSUCCEED);
+    ret = HFFeatureHubGalleryGetFaceCount((HString) "single", &count);
+    REQUIRE(ret == HERR_FT_HUB_GALLERY_NOT_FOUND);
+    ret = HFFeatureHubDataDisable();
+    REQUIRE(ret == HSUCCEED);
+}
+
+TEST_CASE("test_FeatureHubFilteredSearch", "[FeatureHub][Filter]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+
+    HResult ret;
+    HFFeatureHubConfiguration configuration;
+    auto dbPath = GET_SAVE_DATA(".test_filtered_search");
+    HString dbPathStr = new char[dbPath.size() + 1];
+    std::strcpy(dbPathStr, dbPath.c_str());
+    configuration.primaryKeyMode = HF_PK_AUTO_INCREMENT;
+    configuration.enablePersistence = 1;
+    configuration.persistenceDbPath = dbPathStr;
+    configuration.searchMode = HF_SEARCH_MODE_EXHAUSTIVE;
+    configuration.searchThreshold = 0.48f;
+    // Delete the previous data before testing
+    std::remove(dbPath.c_str());
+    std::remove((dbPath + ".snap").c_str());
+    ret = HFFeatureHubDataEnable(configuration);
+    REQUIRE(ret == HSUCCEED);
+
+    // Every feature belongs to one of four groups, the first half is also on a watch list
+    const int genSizeOfBase = 1000;
+    const HUInt64 watchList = 1ull << 63;
+    HInt32 featureLength;
+    HFGetFeatureLength(&featureLength);
+    std::vector<HFloat> features;
+    for (int i = 0; i < genSizeOfBase; ++i) {
+        auto feat = GenerateRandomFeature(featureLength);
+        features.insert(features.end(), feat.begin(), feat.end());
+    }
+    ret = HFFeatureHubBatchInsertFeatures(features.data(), genSizeOfBase, nullptr, nullptr);
+    REQUIRE(ret == HSUCCEED);
+    auto groupTags = [&](HFaceId id) { return (1ull << (id % 4)) | (id <= genSizeOfBase / 2 ? watchList : 0); };
+    for (HFaceId id = 1; id <= genSizeOfBase; ++id) {
+        ret = HFFeatureHubSetFaceTags(id, groupTags(id));
+        REQUIRE(ret == HSUCCEED);
+    }
+    ret = HFFeatureHubSetFaceTags(genSizeOfBase + 1, 1);
+    REQUIRE(ret == HERR_FT_HUB_NOT_FOUND_FEATURE);
+
+    const HInt32 targetId = 123;
+    std::vector<HFloat> targetFeature(features.begin() + (targetId - 1) * featureLength, features.begin() + targetId * featureLength);
+    auto searchFeat = SimulateSimilarVector(targetFeature);
+    HFFaceFeature searchFeature = {0};
+    searchFeature.size = searchFeat.size();
+    searchFeature.data = searchFeat.data();
+    const HInt32 topK = 10;
+    std::vector<HFloat> confidence(topK);
+    std::vector<HFaceId> ids(topK);
+    HFSearchTopKResults results = {0, confidence.data(), ids.data()};
+
+    auto checkFilteredSearch = [&]() {
+        // The group of the target finds it
+        HFSearchFilter filter = {0};
+        filter.anyOf = groupTags(targetId) & ~watchList;
+        ret = HFFeatureHubFaceSearchTopKFiltered(searchFeature, topK, filter, &results);
+        REQUIRE(ret == HSUCCEED);
+        REQUIRE(results.size > 0);
+        REQUIRE(results.ids[0] == targetId);
+
+        // Any other group never returns it, and every result matches the filter
+        filter.anyOf = 0;
+        filter.allOf = watchList;
+        filter.noneOf = groupTags(targetId) & ~watchList;
+        ret = HFFeatureHubFaceSearchTopKFiltered(searchFeature, topK, filter, &results);
+        REQUIRE(ret == HSUCCEED);
+        for (int k = 0; k < results.size; ++k) {
+            REQUIRE(results.ids[k] != targetId);
+            HUInt64 tags = 0;
+            ret = HFFeatureHubGetFaceTags(results.ids[k], &tags);
+            REQUIRE(ret == HSUCCEED);
+            REQUIRE((tags & watchList) != 0);
+            REQUIRE((tags & filter.noneOf) == 0);
+        }
+    };
+    checkFilteredSearch();
+
+    // Tags are persisted with the features
+    ret = HFFeatureHubDataDisable();
+    REQUIRE(ret == HSUCCEED);
+    ret = HFFeatureHubDataEnable(configuration);
+    REQUIRE(ret == HSUCCEED);
+    HUInt64 tags = 0;
+    ret = HFFeatureHubGetFaceTags(targetId, &tags);
+    REQUIRE(ret == HSUCCEED);
+    REQUIRE(tags == groupTags(targetId));
+    checkFilteredSearch();
+
+    // A removed feature loses its tags
+    ret = HFFeatureHubFaceRemove(targetId);
+    REQUIRE(ret == HSUCCEED);
+    ret = HFFeatureHubGetFaceTags(targetId, &tags);
+    REQUIRE(ret == HERR_FT_HUB_NOT_FOUND_FEATURE);
+    ret = HFFeatureHubDataDisable();
+    REQUIRE(ret == HSUCCEED);
+
+    delete[] dbPathStr;
+}
@@ -7,7 +7,10 @@
 #include "inspireface/c_api/inspireface.h"
 #include "unit/test_helper/test_help.h"
 #include "inspireface/middleware/thread/resource_pool.h"
+#include <atomic>
+#include <chrono>
 #include <thread>
+#include <vector>
 
 TEST_CASE("test_SessionParallel", "[Session][Parallel]") {
     DRAW_SPLIT_LINE
@@ -153,3 +156,93 @@ TEST_CASE("test_SessionParallel_Memory", "[Session][Parallel][Memory]") {
         TEST_PRINT("[free{}] Current memory usage: {}MB", i + 1, memoryUsage);
     }
 }
+
+TEST_CASE("test_SessionParallel_ConcurrentInference", "[Session][Parallel]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+    if (std::thread::hardware_concurrency() < 2) {
+        TEST_PRINT("Skip the concurrent inference test, it needs at least two cores.");
+        return;
+    }
+    // By default every session loads its own copy of the models, two sessions on the same models run at the same time
+    HInt32 sharing = -1;
+    REQUIRE(HFGetModelSharing(&sharing) == HSUCCEED);
+    REQUIRE(sharing == 0);
+
+    auto image1 = inspirecv::Image::Create(GET_DATA("data/bulk/kun.jpg"));
+    auto image2 = inspirecv::Image::Create(GET_DATA("data/bulk/jntm.jpg"));
+    HFSessionCustomParameter parameter = {0};
+    parameter.enable_recognition = 1;
+    HFSession sessions[2];
+    for (auto &session : sessions) {
+        REQUIRE(HFCreateInspireFaceSession(parameter, HF_DETECT_MODE_ALWAYS_DETECT, 3, -1, -1, &session) == HSUCCEED);
+    }
+
+    const int loop = 20;
+    std::atomic<int> failures{0};
+    auto run = [&](HFSession session) {
+        for (int i = 0; i < loop; ++i) {
+            float similarity = 0.0f;
+            if (!CompareTwoFaces(session, image1, image2, similarity)) {
+                failures++;
+            }
+        }
+    };
+    // Warm up both sessions
+    run(sessions[0]);
+    run(sessions[1]);
+
+    auto start = std::chrono::steady_clock::now();
+    run(sessions[0]);
+    run(sessions[1]);
+    auto serial = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    std::thread first(run, sessions[0]);
+    std::thread second(run, sessions[1]);
+    first.join();
+    second.join();
+    auto concurrent = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    TEST_PRINT("Two sessions, {} comparisons each -> Serial: {:.2f}ms, Concurrent: {:.2f}ms", loop, serial, concurrent);
+
+    CHECK(failures == 0);
+    // The inferences overlap, two sessions taking turns would take as long as running them one after the other
+    CHECK(concurrent < serial * 0.8);
+
+    for (auto session : sessions) {
+        REQUIRE(HFReleaseInspireFaceSession(session) == HSUCCEED);
+    }
+}
+
+TEST_CASE("test_SessionParallel_MemoryBenchmark", "[Session][Parallel][Memory]") {
+#ifdef ISF_ENABLE_BENCHMARK
+    // Without sharing every session loads its own copy of the models, with it each one adds only its inference state
+    HFSessionCustomParameter parameter = {0};
+    parameter.enable_recognition = 1;
+    parameter.enable_liveness = 1;
+    parameter.enable_mask_detect = 1;
+    for (HInt32 sharing : {0, 1}) {
+        REQUIRE(HFSetModelSharing(sharing) == HSUCCEED);
+        size_t baseline = getCurrentMemoryUsage();
+        std::vector<HFSession> sessions;
+        for (int num : {1, 2, 4, 8, 16}) {
+            while ((int)sessions.size() < num) {
+                HFSession session;
+                HResult ret = HFCreateInspireFaceSession(parameter, HF_DETECT_MODE_ALWAYS_DETECT, 3, -1, -1, &session);
+                REQUIRE(ret == HSUCCEED);
+                sessions.push_back(session);
+            }
+            size_t memoryUsage = getCurrentMemoryUsage();
+            TEST_PRINT("<Benchmark> Session memory, model sharing {} -> Sessions: {}, Memory: {}MB, Per Session: {:.2f}MB", sharing, num,
+                       memoryUsage, (static_cast<int64_t>(memoryUsage) - static_cast<int64_t>(baseline)) / (double)num);
+        }
+        for (auto session : sessions) {
+            auto ret = HFReleaseInspireFaceSession(session);
+            REQUIRE(ret == HSUCCEED);
+        }
+    }
+    REQUIRE(HFSetModelSharing(0) == HSUCCEED);
+#else
+    TEST_PRINT("Skip the session memory benchmark test. To run it, you need to turn on the benchmark test.");
+#endif
+}
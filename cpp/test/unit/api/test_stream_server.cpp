@@ -0,0 +1,220 @@
+/**
+ * Created by Jingyu Yan
+ * @date 2024-10-01
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "settings/test_settings.h"
+#include "inspireface/c_api/inspireface.h"
+#include "unit/test_helper/test_help.h"
+#include "unit/test_helper/test_tools.h"
+#include "middleware/costman.h"
+
+namespace {
+
+HFImageData ImageToImageData(const inspirecv::Image& image) {
+    HFImageData imageData = {0};
+    imageData.data = (uint8_t*)image.Data();
+    imageData.height = image.Height();
+    imageData.width = image.Width();
+    imageData.format = HF_STREAM_BGR;
+    imageData.rotation = HF_CAMERA_ROTATION_0;
+    return imageData;
+}
+
+struct DeliveredFrames {
+    std::mutex mutex;
+    std::vector<HInt32> streamIds;
+    std::vector<HUInt64> frameIds;
+    std::vector<HInt32> faceNums;
+};
+
+void CollectFrame(PHFStreamFrameResult result, HPVoid userData) {
+    auto delivered = (DeliveredFrames*)userData;
+    std::lock_guard<std::mutex> lock(delivered->mutex);
+    delivered->streamIds.push_back(result->streamId);
+    delivered->frameIds.push_back(result->frameId);
+    delivered->faceNums.push_back(result->faces.detectedNum);
+}
+
+}  // namespace
+
+TEST_CASE("test_StreamServer", "[stream_server]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+
+    HResult ret;
+    HFSessionCustomParameter parameter = {0};
+    parameter.enable_recognition = 1;
+    parameter.enable_liveness = 1;
+    parameter.enable_mask_detect = 1;
+    HFDetectMode detMode = HF_DETECT_MODE_LIGHT_TRACK;
+
+    auto image = inspirecv::Image::Create(GET_DATA("data/bulk/kun.jpg"));
+    REQUIRE(!image.Empty());
+    auto imageData = ImageToImageData(image);
+
+    SECTION("Each stream gets the results of its own session") {
+        HFStreamServer server;
+        ret = HFCreateInspireFaceStreamServer(parameter, detMode, 3, -1, -1, 2, 4, 4, &server);
+        REQUIRE(ret == HSUCCEED);
+        HFSession session;
+        ret = HFCreateInspireFaceSession(parameter, detMode, 3, -1, -1, &session);
+        REQUIRE(ret == HSUCCEED);
+        HFImageStream imgHandle;
+        ret = CVImageToImageStream(image, imgHandle);
+        REQUIRE(ret == HSUCCEED);
+        HFMultipleFaceData multipleFaceData = {0};
+        ret = HFExecuteFaceTrack(session, imgHandle, &multipleFaceData);
+        REQUIRE(ret == HSUCCEED);
+        REQUIRE(multipleFaceData.detectedNum == 1);
+        ret = HFMultipleFacePipelineProcess(session, imgHandle, &multipleFaceData, parameter);
+        REQUIRE(ret == HSUCCEED);
+        HFRGBLivenessConfidence liveness;
+        ret = HFGetRGBLivenessConfidence(session, &liveness);
+        REQUIRE(ret == HSUCCEED);
+        HFFaceFeature feature;
+        ret = HFFaceFeatureExtract(session, imgHandle, multipleFaceData.tokens[0], &feature);
+        REQUIRE(ret == HSUCCEED);
+
+        const int numStreams = 3;
+        std::vector<HInt32> streams(numStreams);
+        for (auto& stream : streams) {
+            ret = HFStreamServerOpenStream(server, &stream);
+            REQUIRE(ret == HSUCCEED);
+        }
+        // Every stream detects on its first frame, whatever the other streams did
+        for (auto stream : streams) {
+            HUInt64 frameId;
+            ret = HFStreamServerPushFrame(server, stream, &imageData, 1, &frameId);
+            REQUIRE(ret == HSUCCEED);
+            CHECK(frameId == 0);
+        }
+        std::vector<HUInt64> nextFrame(numStreams, 0);
+        for (int i = 0; i < numStreams; i++) {
+            HFStreamFrameResult result;
+            ret = HFStreamServerPollResult(server, 10000, &result);
+            REQUIRE(ret == HSUCCEED);
+            REQUIRE(result.status == HSUCCEED);
+            auto index = std::find(streams.begin(), streams.end(), result.streamId) - streams.begin();
+            REQUIRE(index < numStreams);
+            CHECK(result.frameId == nextFrame[index]++);
+            REQUIRE(result.faces.detectedNum == 1);
+            CHECK(result.faces.rects[0].x == multipleFaceData.rects[0].x);
+            CHECK(result.faces.rects[0].y == multipleFaceData.rects[0].y);
+            CHECK(result.rgbLiveness.confidence[0] == Approx(liveness.confidence[0]).epsilon(1e-4));
+            REQUIRE(result.featureNum == 1);
+            HFloat similarity;
+            ret = HFFaceComparison(result.features[0], feature, &similarity);
+            REQUIRE(ret == HSUCCEED);
+            CHECK(similarity == Approx(1.0f).epsilon(1e-3));
+        }
+
+        // A closed stream takes no more frames
+        ret = HFStreamServerCloseStream(server, streams[0]);
+        REQUIRE(ret == HSUCCEED);
+        ret = HFStreamServerPushFrame(server, streams[0], &imageData, 1, nullptr);
+        CHECK(ret == HERR_INVALID_PARAM);
+        ret = HFStreamServerCloseStream(server, streams[0]);
+        CHECK(ret == HERR_INVALID_PARAM);
+
+        ret = HFReleaseImageStream(imgHandle);
+        REQUIRE(ret == HSUCCEED);
+        ret = HFReleaseInspireFaceSession(session);
+        REQUIRE(ret == HSUCCEED);
+        ret = HFReleaseInspireFaceStreamServer(server);
+        REQUIRE(ret == HSUCCEED);
+    }
+
+    SECTION("Streams are served in turn") {
+        // One worker serving one stream per round, so the rounds are easy to follow
+        HFStreamServer server;
+        ret = HFCreateInspireFaceStreamServer(parameter, detMode, 3, -1, -1, 1, 1, 8, &server);
+        REQUIRE(ret == HSUCCEED);
+        DeliveredFrames delivered;
+        ret = HFStreamServerSetResultCallback(server, CollectFrame, &delivered);
+        REQUIRE(ret == HSUCCEED);
+        HInt32 busy, quiet;
+        ret = HFStreamServerOpenStream(server, &busy);
+        REQUIRE(ret == HSUCCEED);
+        ret = HFStreamServerOpenStream(server, &quiet);
+        REQUIRE(ret == HSUCCEED);
+
+        const int busyFrames = 8;
+        for (int i = 0; i < busyFrames; i++) {
+            ret = HFStreamServerPushFrame(server, busy, &imageData, 1, nullptr);
+            REQUIRE(ret == HSUCCEED);
+        }
+        ret = HFStreamServerPushFrame(server, quiet, &imageData, 1, nullptr);
+        REQUIRE(ret == HSUCCEED);
+        ret = HFStreamServerFlush(server);
+        REQUIRE(ret == HSUCCEED);
+
+        REQUIRE(delivered.streamIds.size() == busyFrames + 1);
+        HUInt64 nextBusyFrame = 0;
+        size_t quietPosition = delivered.streamIds.size();
+        for (size_t i = 0; i < delivered.streamIds.size(); i++) {
+            CHECK(delivered.faceNums[i] == 1);
+            if (delivered.streamIds[i] == busy) {
+                CHECK(delivered.frameIds[i] == nextBusyFrame++);
+            } else {
+                quietPosition = i;
+            }
+        }
+        // The quiet stream does not wait behind every queued frame of the busy one
+        CHECK(quietPosition < busyFrames);
+
+        ret = HFReleaseInspireFaceStreamServer(server);
+        REQUIRE(ret == HSUCCEED);
+    }
+
+    SECTION("Stream server benchmark") {
+#ifdef ISF_ENABLE_BENCHMARK
+        const int numWorkers = std::max(1u, std::thread::hardware_concurrency() / 2);
+        const int framesPerStream = 16;
+        for (int numStreams : {1, 8, 32, 64}) {
+            HFStreamServer server;
+            ret = HFCreateInspireFaceStreamServer(parameter, detMode, 3, -1, -1, numWorkers, 8, 4, &server);
+            REQUIRE(ret == HSUCCEED);
+            std::vector<HInt32> streams(numStreams);
+            for (auto& stream : streams) {
+                ret = HFStreamServerOpenStream(server, &stream);
+                REQUIRE(ret == HSUCCEED);
+            }
+
+            // Poll on a second thread while the cameras push their frames in turn
+            const int total = numStreams * framesPerStream;
+            double totalLatency = 0;
+            std::thread consumer([&]() {
+                for (int i = 0; i < total; i++) {
+                    HFStreamFrameResult result;
+                    if (HFStreamServerPollResult(server, 10000, &result) != HSUCCEED) {
+                        break;
+                    }
+                    totalLatency += result.latencyMs;
+                }
+            });
+            auto timer = inspire::Timer();
+            for (int frame = 0; frame < framesPerStream; frame++) {
+                for (auto stream : streams) {
+                    ret = HFStreamServerPushFrame(server, stream, &imageData, 1, nullptr);
+                    REQUIRE(ret == HSUCCEED);
+                }
+            }
+            consumer.join();
+            auto cost = timer.GetCostTime();
+            TEST_PRINT("<Benchmark> Stream server -> Streams: {}, Workers: {}, Frames: {}, Total Time: {:.5f}ms, FPS: {:.2f}, Average Latency: {:.5f}ms",
+                       numStreams, numWorkers, total, cost, total * 1000.0 / cost, totalLatency / total);
+
+            ret = HFReleaseInspireFaceStreamServer(server);
+            REQUIRE(ret == HSUCCEED);
+        }
+#else
+        TEST_PRINT("Skip the stream server benchmark test. To run it, you need to turn on the benchmark test.");
+#endif
+    }
+}
@@ -0,0 +1,234 @@
+/**
+ * Created by Jingyu Yan
+ * @date 2024-10-01
+ */
+
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "settings/test_settings.h"
+#include "inspireface/c_api/inspireface.h"
+#include "unit/test_helper/test_help.h"
+#include "unit/test_helper/test_tools.h"
+#include "middleware/costman.h"
+
+namespace {
+
+HFImageData ImageToImageData(const inspirecv::Image& image) {
+    HFImageData imageData = {0};
+    imageData.data = (uint8_t*)image.Data();
+    imageData.height = image.Height();
+    imageData.width = image.Width();
+    imageData.format = HF_STREAM_BGR;
+    imageData.rotation = HF_CAMERA_ROTATION_0;
+    return imageData;
+}
+
+struct CollectedResults {
+    std::mutex mutex;
+    std::vector<HUInt64> frameIds;
+    std::vector<HInt32> faceNums;
+    std::vector<HResult> status;
+};
+
+void CollectResult(PHFStreamFrameResult result, HPVoid userData) {
+    auto collected = (CollectedResults*)userData;
+    std::lock_guard<std::mutex> lock(collected->mutex);
+    collected->frameIds.push_back(result->frameId);
+    collected->faceNums.push_back(result->faces.detectedNum);
+    collected->status.push_back(result->status);
+}
+
+}  // namespace
+
+TEST_CASE("test_StreamSession", "[stream_session]") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+
+    HResult ret;
+    HFSessionCustomParameter parameter = {0};
+    parameter.enable_recognition = 1;
+    parameter.enable_liveness = 1;
+    parameter.enable_mask_detect = 1;
+    parameter.enable_face_quality = 1;
+    HFDetectMode detMode = HF_DETECT_MODE_LIGHT_TRACK;
+    HFStreamSession stream;
+    ret = HFCreateInspireFaceStreamSession(parameter, detMode, 3, -1, -1, 4, &stream);
+    REQUIRE(ret == HSUCCEED);
+
+    auto image = inspirecv::Image::Create(GET_DATA("data/bulk/kun.jpg"));
+    REQUIRE(!image.Empty());
+    auto imageData = ImageToImageData(image);
+
+    SECTION("Same results as a synchronous session") {
+        HFSession session;
+        ret = HFCreateInspireFaceSession(parameter, detMode, 3, -1, -1, &session);
+        REQUIRE(ret == HSUCCEED);
+        HFImageStream imgHandle;
+        ret = CVImageToImageStream(image, imgHandle);
+        REQUIRE(ret == HSUCCEED);
+
+        // The first frame detects, the next ones track
+        for (HUInt64 frame = 0; frame < 4; frame++) {
+            HUInt64 frameId;
+            ret = HFStreamSessionPushFrame(stream, &imageData, 1, &frameId);
+            REQUIRE(ret == HSUCCEED);
+            CHECK(frameId == frame);
+            HFStreamFrameResult result;
+            ret = HFStreamSessionPollResult(stream, 10000, &result);
+            REQUIRE(ret == HSUCCEED);
+            REQUIRE(result.status == HSUCCEED);
+            CHECK(result.frameId == frame);
+
+            HFMultipleFaceData multipleFaceData = {0};
+            ret = HFExecuteFaceTrack(session, imgHandle, &multipleFaceData);
+            REQUIRE(ret == HSUCCEED);
+            REQUIRE(multipleFaceData.detectedNum == 1);
+            ret = HFMultipleFacePipelineProcess(session, imgHandle, &multipleFaceData, parameter);
+            REQUIRE(ret == HSUCCEED);
+            HFRGBLivenessConfidence liveness;
+            ret = HFGetRGBLivenessConfidence(session, &liveness);
+            REQUIRE(ret == HSUCCEED);
+            HFFaceMaskConfidence mask;
+            ret = HFGetFaceMaskConfidence(session, &mask);
+            REQUIRE(ret == HSUCCEED);
+            HFFaceFeature feature;
+            ret = HFFaceFeatureExtract(session, imgHandle, multipleFaceData.tokens[0], &feature);
+            REQUIRE(ret == HSUCCEED);
+
+            REQUIRE(result.faces.detectedNum == multipleFaceData.detectedNum);
+            CHECK(result.faces.trackIds[0] == multipleFaceData.trackIds[0]);
+            CHECK(result.faces.rects[0].x == multipleFaceData.rects[0].x);
+            CHECK(result.faces.rects[0].y == multipleFaceData.rects[0].y);
+            CHECK(result.faces.rects[0].width == multipleFaceData.rects[0].width);
+            CHECK(result.faces.rects[0].height == multipleFaceData.rects[0].height);
+            CHECK(result.rgbLiveness.confidence[0] == Approx(liveness.confidence[0]).epsilon(1e-4));
+            CHECK(result.mask.confidence[0] == Approx(mask.confidence[0]).epsilon(1e-4));
+            REQUIRE(result.featureNum == 1);
+            REQUIRE(result.features[0].size == feature.size);
+            HFloat similarity;
+            ret = HFFaceComparison(result.features[0], feature, &similarity);
+            REQUIRE(ret == HSUCCEED);
+            CHECK(similarity == Approx(1.0f).epsilon(1e-3));
+            HFFaceQualityConfidence quality;
+            ret = HFGetFaceQualityConfidence(session, &quality);
+            REQUIRE(ret == HSUCCEED);
+            CHECK(result.quality.confidence[0] == Approx(quality.confidence[0]).epsilon(1e-4));
+            // The token of a stream result works with the token functions
+            HPoint2f streamPoints[5];
+            ret = HFGetFaceFiveKeyPointsFromFaceToken(result.faces.tokens[0], streamPoints, 5);
+            REQUIRE(ret == HSUCCEED);
+            HPoint2f sessionPoints[5];
+            ret = HFGetFaceFiveKeyPointsFromFaceToken(multipleFaceData.tokens[0], sessionPoints, 5);
+            REQUIRE(ret == HSUCCEED);
+            for (int i = 0; i < 5; i++) {
+                CHECK(streamPoints[i].x == Approx(sessionPoints[i].x));
+                CHECK(streamPoints[i].y == Approx(sessionPoints[i].y));
+            }
+        }
+
+        ret = HFReleaseImageStream(imgHandle);
+        REQUIRE(ret == HSUCCEED);
+        ret = HFReleaseInspireFaceSession(session);
+        REQUIRE(ret == HSUCCEED);
+    }
+
+    SECTION("Callback receives the frames in push order") {
+        CollectedResults collected;
+        ret = HFStreamSessionSetResultCallback(stream, CollectResult, &collected);
+        REQUIRE(ret == HSUCCEED);
+        int frames = 12;
+        for (int i = 0; i < frames; i++) {
+            ret = HFStreamSessionPushFrame(stream, &imageData, 1, nullptr);
+            REQUIRE(ret == HSUCCEED);
+        }
+        ret = HFStreamSessionFlush(stream);
+        REQUIRE(ret == HSUCCEED);
+
+        REQUIRE(collected.frameIds.size() == frames);
+        for (int i = 0; i < frames; i++) {
+            CHECK(collected.frameIds[i] == i);
+            CHECK(collected.faceNums[i] == 1);
+            CHECK(collected.status[i] == HSUCCEED);
+        }
+        // Nothing is left for polling
+        HFStreamFrameResult result;
+        ret = HFStreamSessionPollResult(stream, 0, &result);
+        CHECK(ret == HERR_SESS_STREAM_TIMEOUT);
+    }
+
+    SECTION("Stream session benchmark") {
+#ifdef ISF_ENABLE_BENCHMARK
+        // A recorded video, repeated from kun.jpg if the frames are not in the test data
+        std::vector<inspirecv::Image> video;
+        for (const auto& filename : generateFilenames("frame-%04d.jpg", 1, 120)) {
+            auto frame = inspirecv::Image::Create(GET_DATA("data/video_frames/" + filename));
+            if (frame.Empty()) {
+                video.clear();
+                break;
+            }
+            video.push_back(frame);
+        }
+        if (video.empty()) {
+            video.assign(120, image);
+        }
+
+        HFSession session;
+        ret = HFCreateInspireFaceSession(parameter, detMode, 3, -1, -1, &session);
+        REQUIRE(ret == HSUCCEED);
+        auto timer = inspire::Timer();
+        for (const auto& frame : video) {
+            HFImageStream imgHandle;
+            ret = CVImageToImageStream(frame, imgHandle);
+            REQUIRE(ret == HSUCCEED);
+            HFMultipleFaceData multipleFaceData = {0};
+            ret = HFExecuteFaceTrack(session, imgHandle, &multipleFaceData);
+            REQUIRE(ret == HSUCCEED);
+            if (multipleFaceData.detectedNum > 0) {
+                ret = HFMultipleFacePipelineProcess(session, imgHandle, &multipleFaceData, parameter);
+                REQUIRE(ret == HSUCCEED);
+                for (int i = 0; i < multipleFaceData.detectedNum; i++) {
+                    HFFaceFeature feature;
+                    ret = HFFaceFeatureExtract(session, imgHandle, multipleFaceData.tokens[i], &feature);
+                    REQUIRE(ret == HSUCCEED);
+                }
+            }
+            HFReleaseImageStream(imgHandle);
+        }
+        auto syncCost = timer.GetCostTime();
+        ret = HFReleaseInspireFaceSession(session);
+        REQUIRE(ret == HSUCCEED);
+
+        // Poll on a second thread, as an application displaying the results would
+        double totalLatency = 0;
+        std::thread consumer([&]() {
+            for (size_t i = 0; i < video.size(); i++) {
+                HFStreamFrameResult result;
+                if (HFStreamSessionPollResult(stream, 10000, &result) != HSUCCEED) {
+                    break;
+                }
+                totalLatency += result.latencyMs;
+            }
+        });
+        timer = inspire::Timer();
+        for (const auto& frame : video) {
+            auto frameData = ImageToImageData(frame);
+            ret = HFStreamSessionPushFrame(stream, &frameData, 1, nullptr);
+            REQUIRE(ret == HSUCCEED);
+        }
+        consumer.join();
+        auto streamCost = timer.GetCostTime();
+
+        TEST_PRINT("<Benchmark> Synchronous session -> Frames: {}, Total Time: {:.5f}ms, FPS: {:.2f}", video.size(), syncCost,
+                   video.size() * 1000.0 / syncCost);
+        TEST_PRINT("<Benchmark> Stream session -> Frames: {}, Total Time: {:.5f}ms, FPS: {:.2f}, Average Latency: {:.5f}ms", video.size(),
+                   streamCost, video.size() * 1000.0 / streamCost, totalLatency / video.size());
+#else
+        TEST_PRINT("Skip the stream session benchmark test. To run it, you need to turn on the benchmark test.");
+#endif
+    }
+
+    ret = HFReleaseInspireFaceStreamSession(stream);
+    REQUIRE(ret == HSUCCEED);
+}
@@ -1,15 +1,49 @@
 
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <new>
+#include <thread>
 #include "settings/test_settings.h"
 #include "unit/test_helper/help.h"
 #include <inspireface/include/inspireface/feature_hub_db.h>
 #include "middleware/costman.h"
 #include "track_module/face_detect/all.h"
 #include "track_module/face_track_module.h"
+#include "image_process/yuv_kernels.h"
 #include <inspireface/include/inspireface/frame_process.h>
 
 using namespace inspire;
 
+#ifdef ISF_ENABLE_BENCHMARK
+namespace {
+// Number of heap allocations made by the whole program, for the allocation benchmarks
+std::atomic<int64_t> g_allocation_count{0};
+}  // namespace
+
+void *operator new(std::size_t size) {
+    g_allocation_count++;
+    if (void *ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
+#endif
+
 TEST_CASE("test_FaceDetect", "[track_module") {
     DRAW_SPLIT_LINE
     TEST_PRINT_OUTPUT(true);
@@ -29,6 +63,111 @@ TEST_CASE("test_FaceDetect", "[track_module") {
     }
 }
 
+// Builds empty detector outputs (scores, boxes, landmarks of strides 8, 16 and 32) for an input size
+static AnyTensorOutputs MakeDetectOutputs(int input_size) {
+    AnyTensorOutputs outputs(9);
+    const std::vector<int> strides = {8, 16, 32};
+    for (size_t i = 0; i < strides.size(); i++) {
+        size_t anchors = (input_size / strides[i]) * (input_size / strides[i]) * 2;
+        outputs[i].second.assign(anchors, 0.0f);
+        outputs[i + 3].second.assign(anchors * 4, 0.0f);
+        outputs[i + 6].second.assign(anchors * 10, 0.0f);
+    }
+    return outputs;
+}
+
+// Sets one anchor of a stride level to a square box of half side `extent` strides around its cell
+static void PutDetectAnchor(AnyTensorOutputs &outputs, int input_size, int level, int x, int y, float score, float extent) {
+    const int width = input_size / (8 << level);
+    const size_t anchor = (y * width + x) * 2;
+    outputs[level].second[anchor] = score;
+    for (int k = 0; k < 4; k++) {
+        outputs[level + 3].second[anchor * 4 + k] = extent;
+    }
+}
+
+TEST_CASE("test_FaceDetectDecode", "[track_module") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+    auto archive = INSPIREFACE_CONTEXT->getMArchive();
+    InspireModel model;
+    auto ret = archive.LoadModel("face_detect_320", model);
+    REQUIRE(ret == 0);
+    FaceDetectAdapt face_detector(320);
+    face_detector.LoadData(model, model.modelType, false);
+
+    SECTION("Overlapping anchors are merged") {
+        auto outputs = MakeDetectOutputs(320);
+        // A 64 pixel face seen by 3 neighbouring anchors of stride 8
+        PutDetectAnchor(outputs, 320, 0, 10, 10, 0.95f, 4.0f);
+        PutDetectAnchor(outputs, 320, 0, 11, 10, 0.90f, 4.0f);
+        PutDetectAnchor(outputs, 320, 0, 10, 11, 0.85f, 4.0f);
+        // A 32 pixel face of stride 16, far from the first one
+        PutDetectAnchor(outputs, 320, 1, 15, 15, 0.80f, 1.0f);
+        // Below the classification threshold
+        PutDetectAnchor(outputs, 320, 2, 2, 2, 0.10f, 1.0f);
+
+        auto faces = face_detector.Decode(outputs, 0.5f);
+        REQUIRE(faces.size() == 2);
+        // Sorted by area, in the coordinates of the original image
+        CHECK(faces[0].score == Approx(0.95f));
+        CHECK(faces[0].x1 == Approx(96.0f));
+        CHECK(faces[0].y1 == Approx(96.0f));
+        CHECK(faces[0].x2 == Approx(224.0f));
+        CHECK(faces[0].y2 == Approx(224.0f));
+        CHECK(faces[1].score == Approx(0.80f));
+        CHECK(faces[1].x1 == Approx(448.0f));
+        CHECK(faces[1].x2 == Approx(512.0f));
+    }
+
+    SECTION("No candidate") {
+        auto outputs = MakeDetectOutputs(320);
+        auto faces = face_detector.Decode(outputs, 1.0f);
+        REQUIRE(faces.empty());
+    }
+}
+
+TEST_CASE("test_FaceDetectDecodeBenchmark", "[track_module") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+#ifdef ISF_ENABLE_BENCHMARK
+    auto archive = INSPIREFACE_CONTEXT->getMArchive();
+    const std::vector<int32_t> supported_sizes = {160, 320, 640};
+    const std::vector<std::string> scheme_names = {"face_detect_160", "face_detect_320", "face_detect_640"};
+    const int loop = 1000;
+    for (size_t i = 0; i < scheme_names.size(); i++) {
+        InspireModel model;
+        auto ret = archive.LoadModel(scheme_names[i], model);
+        REQUIRE(ret == 0);
+        FaceDetectAdapt face_detector(supported_sizes[i]);
+        face_detector.LoadData(model, model.modelType, false);
+
+        // A crowded scene: every 4th cell of stride 8 holds a face, seen by its neighbouring anchors as well
+        const int size = supported_sizes[i];
+        auto outputs = MakeDetectOutputs(size);
+        const int width = size / 8;
+        for (int y = 0; y < width; y++) {
+            for (int x = 0; x < width; x++) {
+                float score = (x % 4 == 0 && y % 4 == 0) ? 0.9f : ((x % 4 == 1 || y % 4 == 1) ? 0.6f : 0.0f);
+                PutDetectAnchor(outputs, size, 0, x, y, score, 1.5f);
+            }
+        }
+
+        size_t num_faces = 0;
+        auto timer = inspire::Timer();
+        for (int j = 0; j < loop; j++) {
+            num_faces = face_detector.Decode(outputs, 1.0f).size();
+        }
+        auto cost = timer.GetCostTime();
+        REQUIRE(num_faces > 0);
+        TEST_PRINT("<Benchmark> Detect decode + NMS {}x{} ({} faces) -> Loop: {}, Total Time: {:.5f}ms, Average Time: {:.5f}ms", size, size,
+                   num_faces, loop, cost, cost / loop);
+    }
+#else
+    TEST_PRINT("Skip the detect decode benchmark test. To run it, you need to turn on the benchmark test.");
+#endif
+}
+
 TEST_CASE("test_RefineNet", "[track_module") {
     DRAW_SPLIT_LINE
     TEST_PRINT_OUTPUT(true);
@@ -81,6 +220,236 @@ TEST_CASE("test_Quality", "[track_module") {
     REQUIRE(result.lmk_quality.size() == 5);
 }
 
+TEST_CASE("test_TrackModuleBatchForward", "[track_module") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+    auto archive = INSPIREFACE_CONTEXT->getMArchive();
+    inspirecv::Image face = inspirecv::Image::Create(GET_DATA("data/crop/crop.png"));
+    inspirecv::Image no_face = inspirecv::Image::Create(GET_DATA("data/crop/no_face.png"));
+
+    SECTION("Landmark") {
+        InspireModel model;
+        REQUIRE(archive.LoadModel("landmark", model) == 0);
+        FaceLandmarkAdapt face_landmark(112);
+        face_landmark.LoadData(model, model.modelType);
+        // 3 crops are padded to a batch of 4
+        std::vector<inspirecv::Image> crops = {face.Resize(112, 112), no_face.Resize(112, 112), face.Resize(112, 112)};
+        auto batch = face_landmark(crops);
+        REQUIRE(batch.size() == crops.size());
+        for (size_t i = 0; i < crops.size(); i++) {
+            auto single = face_landmark(crops[i]);
+            REQUIRE(batch[i].size() == single.size());
+            for (size_t j = 0; j < single.size(); j++) {
+                CHECK(batch[i][j] == Approx(single[j]).margin(1e-4));
+            }
+        }
+    }
+
+    SECTION("Refine net") {
+        InspireModel model;
+        REQUIRE(archive.LoadModel("refine_net", model) == 0);
+        RNetAdapt rnet;
+        rnet.LoadData(model, model.modelType);
+        std::vector<inspirecv::Image> crops = {face, no_face, face};
+        auto scores = rnet(crops);
+        REQUIRE(scores.size() == crops.size());
+        for (size_t i = 0; i < crops.size(); i++) {
+            CHECK(scores[i] == Approx(rnet(crops[i])).margin(1e-4));
+        }
+        REQUIRE(scores[0] > 0.5f);
+        REQUIRE(scores[1] < 0.5f);
+    }
+
+    SECTION("Pose quality") {
+        InspireModel model;
+        REQUIRE(archive.LoadModel("pose_quality", model) == 0);
+        FacePoseQualityAdapt quality;
+        REQUIRE(quality.LoadData(model, model.modelType) == 0);
+        std::vector<inspirecv::Image> crops = {face.Resize(96, 96), no_face.Resize(96, 96), face.Resize(96, 96)};
+        auto results = quality(crops);
+        REQUIRE(results.size() == crops.size());
+        for (size_t i = 0; i < crops.size(); i++) {
+            auto single = quality(crops[i]);
+            CHECK(results[i].yaw == Approx(single.yaw).margin(1e-3));
+            CHECK(results[i].pitch == Approx(single.pitch).margin(1e-3));
+            REQUIRE(results[i].lmk.size() == 5);
+        }
+    }
+
+    SECTION("Empty batch") {
+        InspireModel model;
+        REQUIRE(archive.LoadModel("landmark", model) == 0);
+        FaceLandmarkAdapt face_landmark(112);
+        face_landmark.LoadData(model, model.modelType);
+        REQUIRE(face_landmark(std::vector<inspirecv::Image>()).empty());
+    }
+}
+
+TEST_CASE("test_TrackModuleBatchForwardBenchmark", "[track_module") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+#ifdef ISF_ENABLE_BENCHMARK
+    auto archive = INSPIREFACE_CONTEXT->getMArchive();
+    InspireModel lmk_model, rnet_model, quality_model;
+    REQUIRE(archive.LoadModel("landmark", lmk_model) == 0);
+    REQUIRE(archive.LoadModel("refine_net", rnet_model) == 0);
+    REQUIRE(archive.LoadModel("pose_quality", quality_model) == 0);
+    FaceLandmarkAdapt face_landmark(112);
+    face_landmark.LoadData(lmk_model, lmk_model.modelType);
+    RNetAdapt rnet;
+    rnet.LoadData(rnet_model, rnet_model.modelType);
+    FacePoseQualityAdapt quality;
+    quality.LoadData(quality_model, quality_model.modelType);
+
+    inspirecv::Image face = inspirecv::Image::Create(GET_DATA("data/crop/crop.png"));
+    auto crop_112 = face.Resize(112, 112);
+    auto crop_96 = face.Resize(96, 96);
+    const int loop = 50;
+    // Network stage of one tracked frame: quality, landmark and refine net for every face
+    for (size_t num_faces : {1, 4, 8, 16, 32}) {
+        std::vector<inspirecv::Image> crops_112(num_faces, crop_112);
+        std::vector<inspirecv::Image> crops_96(num_faces, crop_96);
+
+        auto timer = inspire::Timer();
+        for (int i = 0; i < loop; i++) {
+            for (size_t n = 0; n < num_faces; n++) {
+                quality(crops_96[n]);
+                face_landmark(crops_112[n]);
+                rnet(crops_112[n]);
+            }
+        }
+        auto single_cost = timer.GetCostTimeUpdate() / loop;
+        for (int i = 0; i < loop; i++) {
+            quality(crops_96);
+            face_landmark(crops_112);
+            rnet(crops_112);
+        }
+        auto batch_cost = timer.GetCostTime() / loop;
+        TEST_PRINT("<Benchmark> Track networks per frame, {} faces -> One by one: {:.5f}ms, Batched: {:.5f}ms", num_faces, single_cost,
+                   batch_cost);
+    }
+#else
+    TEST_PRINT("Skip the track batch forward benchmark test. To run it, you need to turn on the benchmark test.");
+#endif
+}
+
+TEST_CASE("test_AnyNetOutputViews", "[track_module") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+    auto archive = INSPIREFACE_CONTEXT->getMArchive();
+    InspireModel model;
+    REQUIRE(archive.LoadModel("landmark", model) == 0);
+    FaceLandmarkAdapt face_landmark(112);
+    face_landmark.LoadData(model, model.modelType);
+    inspirecv::Image face = inspirecv::Image::Create(GET_DATA("data/crop/crop.png")).Resize(112, 112);
+    inspirecv::Image no_face = inspirecv::Image::Create(GET_DATA("data/crop/no_face.png")).Resize(112, 112);
+
+    SECTION("Single image") {
+        AnyTensorOutputs copied;
+        face_landmark.Forward(face, copied);
+        const auto &views = face_landmark.ForwardViews(face);
+        REQUIRE(views.size() == copied.size());
+        for (size_t i = 0; i < views.size(); i++) {
+            CHECK(views[i].Name() == copied[i].first);
+            CHECK(views[i].Batch() == 1);
+            CHECK(views[i].ToVector() == copied[i].second);
+        }
+    }
+
+    SECTION("Batch") {
+        // 40 images take two passes, the rows are gathered
+        for (size_t count : {3, 40}) {
+            std::vector<inspirecv::Image> crops;
+            for (size_t i = 0; i < count; i++) {
+                crops.push_back(i % 2 == 0 ? face : no_face);
+            }
+            AnyTensorOutputs copied;
+            face_landmark.ForwardBatch(crops, copied);
+            const auto &views = face_landmark.ForwardBatchViews(crops);
+            REQUIRE(views.size() == copied.size());
+            REQUIRE(views[0].Batch() == static_cast<int32_t>(count));
+            REQUIRE(views[0].Shape()[0] == static_cast<int32_t>(count));
+            REQUIRE(views[0].Size() == copied[0].second.size());
+            for (size_t i = 0; i < count; i++) {
+                auto row = views[0].Row(i);
+                REQUIRE(row.Size() == 106 * 2);
+                for (size_t j = 0; j < row.Size(); j++) {
+                    CHECK(row[j] == Approx(copied[0].second[i * row.Size() + j]).margin(1e-4));
+                }
+            }
+        }
+        REQUIRE(face_landmark.ForwardBatchViews(std::vector<inspirecv::Image>()).empty());
+    }
+}
+
+TEST_CASE("test_AnyNetOutputViewsBenchmark", "[track_module") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+#ifdef ISF_ENABLE_BENCHMARK
+    auto archive = INSPIREFACE_CONTEXT->getMArchive();
+    InspireModel detect_model, lmk_model, rnet_model, quality_model;
+    REQUIRE(archive.LoadModel("face_detect_160", detect_model) == 0);
+    REQUIRE(archive.LoadModel("landmark", lmk_model) == 0);
+    REQUIRE(archive.LoadModel("refine_net", rnet_model) == 0);
+    REQUIRE(archive.LoadModel("pose_quality", quality_model) == 0);
+    FaceDetectAdapt face_detector(160);
+    face_detector.LoadData(detect_model, detect_model.modelType, false);
+    FaceLandmarkAdapt face_landmark(112);
+    face_landmark.LoadData(lmk_model, lmk_model.modelType);
+    RNetAdapt rnet;
+    rnet.LoadData(rnet_model, rnet_model.modelType);
+    FacePoseQualityAdapt quality;
+    quality.LoadData(quality_model, quality_model.modelType);
+
+    inspirecv::Image face = inspirecv::Image::Create(GET_DATA("data/crop/crop.png"));
+    auto detect_input = face.Resize(160, 160);
+    auto crop_112 = face.Resize(112, 112);
+    auto crop_96 = face.Resize(96, 96);
+    auto crop_24 = face.Resize(24, 24);
+    const int loop = 50;
+    // Network stage of one frame: the detector, then quality, landmark and refine net for every face
+    for (size_t num_faces : {1, 4, 16}) {
+        size_t bytes = 0;
+        for (const auto &view : face_detector.ForwardViews(detect_input)) {
+            bytes += view.Size() * sizeof(float);
+        }
+        const std::vector<std::pair<AnyNetAdapter *, const inspirecv::Image *>> face_nets = {
+          {&quality, &crop_96}, {&face_landmark, &crop_112}, {&rnet, &crop_24}};
+        for (const auto &net : face_nets) {
+            for (const auto &view : net.first->ForwardViews(*net.second)) {
+                bytes += view.Size() * sizeof(float) * num_faces;
+            }
+        }
+
+        auto timer = inspire::Timer();
+        for (int i = 0; i < loop; i++) {
+            AnyTensorOutputs outputs;
+            face_detector.Forward(detect_input, outputs);
+            for (size_t n = 0; n < num_faces; n++) {
+                AnyTensorOutputs quality_outputs, lmk_outputs, rnet_outputs;
+                quality.Forward(crop_96, quality_outputs);
+                face_landmark.Forward(crop_112, lmk_outputs);
+                rnet.Forward(crop_24, rnet_outputs);
+            }
+        }
+        auto copy_cost = timer.GetCostTimeUpdate() / loop;
+        for (int i = 0; i < loop; i++) {
+            face_detector.ForwardViews(detect_input);
+            for (size_t n = 0; n < num_faces; n++) {
+                quality.ForwardViews(crop_96);
+                face_landmark.ForwardViews(crop_112);
+                rnet.ForwardViews(crop_24);
+            }
+        }
+        auto view_cost = timer.GetCostTime() / loop;
+        TEST_PRINT("<Benchmark> Network outputs per frame, {} faces -> {} bytes not copied, Copied: {:.5f}ms, Viewed: {:.5f}ms", num_faces, bytes,
+                   copy_cost, view_cost);
+    }
+#else
+    TEST_PRINT("Skip the network output views benchmark test. To run it, you need to turn on the benchmark test.");
+#endif
+}
+
 TEST_CASE("test_FaceTrackModule", "[track_module") {
     DRAW_SPLIT_LINE
     TEST_PRINT_OUTPUT(true);
@@ -108,4 +477,711 @@ TEST_CASE("test_FaceTrackModule", "[track_module") {
         face_track.UpdateStream(image);
         REQUIRE(face_track.trackingFace.size() == 1);
     }
-}
\ No newline at end of file
+}
+TEST_CASE("test_DetectScheduler", "[track_module") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+    const int max_interval = 10;
+    inspirecv::Image scene(32, 24, 3);
+    std::memset((uint8_t *)scene.Data(), 100, 32 * 24 * 3);
+
+    SECTION("Static scene waits for the max interval") {
+        DetectScheduler scheduler(max_interval);
+        // Nothing to compare the first frame with
+        REQUIRE(scheduler.Schedule(scene, false));
+        for (int frame = 1; frame < max_interval; frame++) {
+            CHECK(!scheduler.Schedule(scene, false));
+            scheduler.ObserveTracks(0, 0.9f);
+        }
+        CHECK(scheduler.Schedule(scene, false));
+        CHECK(scheduler.Schedule(scene, true));
+    }
+
+    SECTION("Scene change triggers detection") {
+        DetectScheduler scheduler(max_interval);
+        REQUIRE(scheduler.Schedule(scene, false));
+        // A face entering a corner of the frame
+        auto changed = inspirecv::Image::Create(32, 24, 3, scene.Data(), true);
+        for (int y = 0; y < 12; y++) {
+            std::memset((uint8_t *)changed.Data() + y * 32 * 3, 220, 16 * 3);
+        }
+        CHECK(!scheduler.Schedule(scene, false));
+        CHECK(scheduler.Schedule(changed, false));
+        CHECK(scheduler.GetLastMotion() > 8.0f);
+        // The changed frame is the new reference
+        CHECK(!scheduler.Schedule(changed, false));
+    }
+
+    SECTION("Weak or lost track triggers detection") {
+        DetectScheduler scheduler(max_interval);
+        REQUIRE(scheduler.Schedule(scene, false));
+        scheduler.ObserveTracks(0, 0.2f);
+        CHECK(scheduler.Schedule(scene, false));
+        scheduler.ObserveTracks(1, 1.0f);
+        CHECK(scheduler.Schedule(scene, false));
+        scheduler.ObserveTracks(0, 0.9f);
+        CHECK(!scheduler.Schedule(scene, false));
+    }
+
+    SECTION("Track that stays weak is detected at the weak interval") {
+        const int weak_interval = 4;
+        DetectScheduler scheduler(max_interval * 10, 8.0f, 0.5f, weak_interval);
+        REQUIRE(scheduler.Schedule(scene, false));
+        std::vector<int> detected;
+        for (int frame = 1; frame <= 20; frame++) {
+            scheduler.ObserveTracks(0, 0.2f);
+            if (scheduler.Schedule(scene, false)) {
+                detected.push_back(frame);
+            }
+        }
+        CHECK(detected == std::vector<int>({1, 5, 9, 13, 17}));
+        // Once the track recovers, the next weak frame is detected right away
+        scheduler.ObserveTracks(0, 0.9f);
+        CHECK(!scheduler.Schedule(scene, false));
+        scheduler.ObserveTracks(0, 0.2f);
+        CHECK(scheduler.Schedule(scene, false));
+        // A lost track is still detected on the next frame
+        scheduler.ObserveTracks(1, 0.2f);
+        CHECK(scheduler.Schedule(scene, false));
+    }
+}
+
+TEST_CASE("test_DetectSchedulerBenchmark", "[track_module") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+#ifdef ISF_ENABLE_BENCHMARK
+    auto archive = INSPIREFACE_CONTEXT->getMArchive();
+    std::vector<std::string> filenames = generateFilenames("frame-%04d.jpg", 1, 288);
+    std::vector<inspirecv::Image> frames;
+    for (auto &filename : filenames) {
+        frames.push_back(inspirecv::Image::Create(GET_DATA("data/video_frames/" + filename)));
+    }
+    // From this frame on a second face is pasted in the top left corner of the recording
+    const int enter_frame = 150;
+    auto person = inspirecv::Image::Create(GET_DATA("data/bulk/kun.jpg"));
+    const int person_width = frames[0].Width() / 3;
+    const int person_height = std::min(frames[0].Height(), person.Height() * person_width / person.Width());
+    person = person.Resize(person_width, person_height);
+    for (size_t i = enter_frame; i < frames.size(); i++) {
+        auto frame = inspirecv::Image::Create(frames[i].Width(), frames[i].Height(), 3, frames[i].Data(), true);
+        for (int y = 0; y < person_height; y++) {
+            std::memcpy((uint8_t *)frame.Data() + y * frame.Width() * 3, person.Data() + y * person_width * 3, person_width * 3);
+        }
+        frames[i] = frame;
+    }
+
+    // Fixed interval of 20 frames against adaptive detection at least every 60 frames
+    for (int max_interval : {0, 60}) {
+        FaceTrackModule face_track(DETECT_MODE_LIGHT_TRACK, 5);
+        REQUIRE(face_track.Configuration(archive) == 0);
+        face_track.SetTrackModeAdaptiveDetect(max_interval);
+        int first_detection = -1;
+        auto timer = inspire::Timer();
+        for (size_t i = 0; i < frames.size(); i++) {
+            auto image = inspirecv::FrameProcess::Create(frames[i].Data(), frames[i].Height(), frames[i].Width(), inspirecv::BGR);
+            face_track.UpdateStream(image);
+            if (first_detection < 0 && (int)i >= enter_frame && face_track.trackingFace.size() > 1) {
+                first_detection = i - enter_frame;
+            }
+        }
+        auto cost = timer.GetCostTime();
+        TEST_PRINT(
+          "<Benchmark> Track detection {} -> Frames: {}, Detector calls per 1000 frames: {:.1f}, Average Time: {:.5f}ms, Time to first "
+          "detection: {} frames",
+          max_interval > 0 ? "adaptive" : "fixed interval", frames.size(), face_track.GetDetectCount() * 1000.0 / frames.size(), cost / frames.size(),
+          first_detection);
+    }
+#else
+    TEST_PRINT("Skip the detect scheduler benchmark test. To run it, you need to turn on the benchmark test.");
+#endif
+}
+
+namespace {
+
+// The landmark smoothing as it was written before LandmarkHistory, the reference of the vectorized one
+void ReferenceSmooth(std::vector<inspirecv::Point2f> &landmarks, std::vector<std::vector<inspirecv::Point2f>> &history, size_t num_points, float h,
+                     size_t n) {
+    std::vector<inspirecv::Point2f> current = landmarks;
+    if (history.size() == n) {
+        for (size_t i = 0; i < num_points; i++) {
+            float sum_d = 1;
+            float max_d = 0;
+            for (size_t j = 0; j < n; j++) {
+                max_d = std::max(max_d, FaceObjectInternal::L2norm(current[i].GetX(), current[i].GetY(), history[j][i].GetX(), history[j][i].GetY()));
+            }
+            for (size_t j = 0; j < n; j++) {
+                float d = std::exp(-max_d * (n - j) * h);
+                sum_d += d;
+                landmarks[i].SetX(landmarks[i].GetX() + d * history[j][i].GetX());
+                landmarks[i].SetY(landmarks[i].GetY() + d * history[j][i].GetY());
+            }
+            landmarks[i].SetX(landmarks[i].GetX() / sum_d);
+            landmarks[i].SetY(landmarks[i].GetY() / sum_d);
+        }
+    }
+    history.emplace_back(landmarks.begin(), landmarks.begin() + num_points);
+    if (history.size() > n) {
+        history.erase(history.begin());
+    }
+}
+
+// Moves the landmarks a little, with a jump every 50 frames
+void JitterLandmarks(std::vector<inspirecv::Point2f> &landmarks, int frame, unsigned int &seed) {
+    for (auto &point : landmarks) {
+        seed = seed * 1103515245u + 12345u;
+        const float jitter = ((seed >> 16) % 1000) / 1000.0f - 0.5f;
+        const float step = frame % 50 == 0 ? 20.0f : 1.0f;
+        point.SetX(point.GetX() + jitter * step);
+        point.SetY(point.GetY() - jitter * step * 0.5f);
+    }
+}
+
+// Pastes a copy of the person resized to the given width into the canvas
+void PastePerson(inspirecv::Image &canvas, const inspirecv::Image &person, int x, int y, int width) {
+    const int height = person.Height() * width / person.Width();
+    auto resized = person.Resize(width, height);
+    for (int row = 0; row < height && y + row < canvas.Height(); row++) {
+        const int columns = std::min(width, canvas.Width() - x);
+        std::memcpy((uint8_t *)canvas.Data() + ((y + row) * canvas.Width() + x) * 3, resized.Data() + row * width * 3, columns * 3);
+    }
+}
+
+// NV21 frame of the even part of a BGR image, with the BT.601 coefficients
+std::vector<uint8_t> BGRToNV21(const inspirecv::Image &image, int &width, int &height) {
+    width = image.Width() & ~1;
+    height = image.Height() & ~1;
+    std::vector<uint8_t> nv21(width * height * 3 / 2);
+    const uint8_t *bgr = image.Data();
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const uint8_t *p = bgr + (y * image.Width() + x) * 3;
+            nv21[y * width + x] = static_cast<uint8_t>(std::min(255.0f, 0.114f * p[0] + 0.587f * p[1] + 0.299f * p[2]));
+            if (y % 2 == 0 && x % 2 == 0) {
+                uint8_t *vu = &nv21[width * height + (y / 2) * width + x];
+                vu[0] = static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, 128.0f - 0.081f * p[0] - 0.419f * p[1] + 0.5f * p[2])));
+                vu[1] = static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, 128.0f + 0.5f * p[0] - 0.331f * p[1] - 0.169f * p[2])));
+            }
+        }
+    }
+    return nv21;
+}
+
+// The YUV to BGR conversion of MNN, pixel by pixel
+void ReferenceYUV420SPToBGR(const uint8_t *frame, int width, int height, bool nv21, uint8_t *bgr) {
+    const uint8_t *uv_plane = frame + width * height;
+    auto clamp = [](int value) { return static_cast<uint8_t>(std::max(0, std::min(255, value))); };
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const uint8_t *uv = uv_plane + (y / 2) * width + (x & ~1);
+            const int u = (nv21 ? uv[1] : uv[0]) - 128;
+            const int v = (nv21 ? uv[0] : uv[1]) - 128;
+            const int luma = frame[y * width + x] << 6;
+            uint8_t *p = bgr + (y * width + x) * 3;
+            p[0] = clamp((luma + 130 * u) >> 6);
+            p[1] = clamp((luma - 25 * u - 37 * v) >> 6);
+            p[2] = clamp((luma + 73 * v) >> 6);
+        }
+    }
+}
+
+// Mean absolute difference of the pixels of two images of the same size
+double MeanAbsDiff(const inspirecv::Image &a, const inspirecv::Image &b) {
+    const size_t size = static_cast<size_t>(a.Width()) * a.Height() * a.Channels();
+    double sum = 0;
+    for (size_t i = 0; i < size; i++) {
+        sum += std::abs(static_cast<int>(a.Data()[i]) - static_cast<int>(b.Data()[i]));
+    }
+    return size > 0 ? sum / size : 0;
+}
+
+// Crops of the tracker, the RNet and the aligned face for each face of a grid spread over the frame
+std::vector<inspirecv::AffineCropRequest> FaceCropRequests(int frame_width, int frame_height, int num_faces, std::vector<inspirecv::Image> &crops) {
+    const int sizes[] = {96, 112, 24, 112};
+    const int per_face = sizeof(sizes) / sizeof(sizes[0]);
+    crops.resize(num_faces * per_face);
+    std::vector<inspirecv::AffineCropRequest> requests;
+    for (int i = 0; i < num_faces; i++) {
+        const float side = 60.0f + (i % 5) * 20.0f;
+        const float x = (i % 5) * (frame_width - side) / 5.0f;
+        const float y = (i / 5) * (frame_height - side) / ((num_faces + 4) / 5);
+        for (int k = 0; k < per_face; k++) {
+            // A slight rotation, as for the aligned faces
+            const float scale = sizes[k] / side;
+            const float c = scale * std::cos(0.1f * k);
+            const float s = scale * std::sin(0.1f * k);
+            inspirecv::AffineCropRequest request;
+            request.affine_matrix = inspirecv::TransformMatrix::Create(c, s, -(c * x + s * y), -s, c, s * x - c * y);
+            request.width_out = sizes[k];
+            request.height_out = sizes[k];
+            request.image_out = &crops[i * per_face + k];
+            requests.push_back(request);
+        }
+    }
+    return requests;
+}
+
+}  // namespace
+
+TEST_CASE("test_TiledDetect", "[track_module") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+    auto archive = INSPIREFACE_CONTEXT->getMArchive();
+    auto person = inspirecv::Image::Create(GET_DATA("data/bulk/kun.jpg"));
+    REQUIRE(!person.Empty());
+    // A small person in a large frame, a few pixels in the preview
+    const int width = 2560;
+    const int height = 1440;
+    inspirecv::Image canvas(width, height, 3);
+    std::memset((uint8_t *)canvas.Data(), 128, width * height * 3);
+    PastePerson(canvas, person, 1500, 800, 200);
+
+    SECTION("Small face is found on the tiles only") {
+        for (int tile_size : {0, 640}) {
+            FaceTrackModule face_track(DETECT_MODE_ALWAYS_DETECT, 5);
+            REQUIRE(face_track.Configuration(archive) == 0);
+            face_track.SetTrackModeTiledDetect(tile_size);
+            auto image = inspirecv::FrameProcess::Create(canvas.Data(), height, width, inspirecv::BGR);
+            face_track.UpdateStream(image);
+            CHECK(face_track.trackingFace.size() == (tile_size > 0 ? 1 : 0));
+        }
+    }
+
+    SECTION("Static tiles are skipped in motion only mode") {
+        FaceTrackModule face_track(DETECT_MODE_LIGHT_TRACK, 5);
+        REQUIRE(face_track.Configuration(archive) == 0);
+        face_track.SetTrackModeTiledDetect(640, true);
+        face_track.SetTrackModeDetectInterval(1);
+        for (int frame = 0; frame < 3; frame++) {
+            auto image = inspirecv::FrameProcess::Create(canvas.Data(), height, width, inspirecv::BGR);
+            face_track.UpdateStream(image);
+            REQUIRE(face_track.trackingFace.size() == 1);
+        }
+    }
+}
+
+TEST_CASE("test_TiledDetectBenchmark", "[track_module") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+#ifdef ISF_ENABLE_BENCHMARK
+    auto archive = INSPIREFACE_CONTEXT->getMArchive();
+    auto person = inspirecv::Image::Create(GET_DATA("data/bulk/kun.jpg"));
+    REQUIRE(!person.Empty());
+    // A 4K frame with a crowd of small people
+    const int width = 3840;
+    const int height = 2160;
+    inspirecv::Image canvas(width, height, 3);
+    std::memset((uint8_t *)canvas.Data(), 128, width * height * 3);
+    const int num_people = 6;
+    for (int i = 0; i < num_people; i++) {
+        PastePerson(canvas, person, 300 + i * 580, 400 + (i % 2) * 900, 160 + (i % 3) * 40);
+    }
+
+    const int loop = 30;
+    struct Mode {
+        const char *name;
+        int tile_size;
+        bool motion_only;
+    };
+    for (auto mode : {Mode{"off", 0, false}, Mode{"tiled", 960, false}, Mode{"tiled motion only", 960, true}}) {
+        FaceTrackModule face_track(DETECT_MODE_LIGHT_TRACK, num_people * 2);
+        REQUIRE(face_track.Configuration(archive) == 0);
+        face_track.SetTrackModeDetectInterval(5);
+        face_track.SetTrackModeTiledDetect(mode.tile_size, mode.motion_only);
+        auto timer = inspire::Timer();
+        for (int i = 0; i < loop; i++) {
+            auto image = inspirecv::FrameProcess::Create(canvas.Data(), height, width, inspirecv::BGR);
+            face_track.UpdateStream(image);
+        }
+        auto cost = timer.GetCostTime();
+        TEST_PRINT("<Benchmark> Tiled detection {} -> Frames: {}, Recall: {}/{}, Detector calls: {}, Average Time: {:.5f}ms", mode.name, loop,
+                   face_track.trackingFace.size(), num_people, face_track.GetDetectCount(), cost / loop);
+    }
+#else
+    TEST_PRINT("Skip the tiled detection benchmark test. To run it, you need to turn on the benchmark test.");
+#endif
+}
+
+TEST_CASE("test_TrackStoreAllocationBenchmark", "[track_module") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+#ifdef ISF_ENABLE_BENCHMARK
+    SECTION("Landmark smoothing") {
+        const int num_landmark = FaceLandmarkAdapt::NUM_OF_LANDMARK + 10;
+        FaceObjectInternal face(0, inspirecv::Rect2i(10, 10, 100, 100), num_landmark);
+        std::vector<inspirecv::Point2f> landmark(num_landmark);
+        const int warmup = 10;
+        const int loop = 1000;
+        int64_t allocations = 0;
+        for (int i = 0; i < warmup + loop; i++) {
+            for (int k = 0; k < num_landmark; k++) {
+                landmark[k] = inspirecv::Point2f(50.0f + k % 10 + (i % 3), 50.0f + k / 10 + (i % 5));
+            }
+            if (i == warmup) {
+                allocations = g_allocation_count;
+            }
+            face.SetLandmark(landmark, true, true, 0.05f, 5, num_landmark * 2);
+        }
+        allocations = g_allocation_count - allocations;
+        TEST_PRINT("<Benchmark> Landmark smoothing -> Frames: {}, Allocations per frame: {:.3f}", loop, allocations / double(loop));
+        // Once the history is full a frame only overwrites the oldest one
+        CHECK(allocations == 0);
+    }
+
+    SECTION("Steady state tracking") {
+        auto archive = INSPIREFACE_CONTEXT->getMArchive();
+        std::vector<std::string> filenames = generateFilenames("frame-%04d.jpg", 1, 100);
+        std::vector<inspirecv::Image> frames;
+        for (auto &filename : filenames) {
+            frames.push_back(inspirecv::Image::Create(GET_DATA("data/video_frames/" + filename)));
+        }
+        FaceTrackModule face_track(DETECT_MODE_LIGHT_TRACK, 5);
+        REQUIRE(face_track.Configuration(archive) == 0);
+        face_track.SetTrackModeDetectInterval(1000);
+        const size_t warmup = 10;
+        int64_t allocations = 0;
+        int64_t tracked_frames = 0;
+        auto timer = inspire::Timer();
+        for (size_t i = 0; i < frames.size(); i++) {
+            auto image = inspirecv::FrameProcess::Create(frames[i].Data(), frames[i].Height(), frames[i].Width(), inspirecv::BGR);
+            const int64_t before = g_allocation_count;
+            face_track.UpdateStream(image);
+            if (i >= warmup && !face_track.trackingFace.empty()) {
+                allocations += g_allocation_count - before;
+                tracked_frames++;
+            }
+        }
+        auto cost = timer.GetCostTime();
+        REQUIRE(tracked_frames > 0);
+        // The networks still allocate, the track store and the crop buffers do not
+        TEST_PRINT("<Benchmark> Steady state tracking -> Frames: {}, Allocations per frame: {:.1f}, Average Time: {:.5f}ms", tracked_frames,
+                   allocations / double(tracked_frames), cost / frames.size());
+    }
+#else
+    TEST_PRINT("Skip the track store allocation benchmark test. To run it, you need to turn on the benchmark test.");
+#endif
+}
+
+TEST_CASE("test_LandmarkSmoothing", "[track_module") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+    const size_t n = 5;
+    // The dense landmarks with the five key points, and a count leaving a tail to the vector loop
+    for (size_t num_points : {size_t(FaceLandmarkAdapt::NUM_OF_LANDMARK + 10), size_t(111)}) {
+        for (float h : {0.05f, 0.5f}) {
+            std::vector<inspirecv::Point2f> base(num_points);
+            for (size_t i = 0; i < num_points; i++) {
+                base[i] = inspirecv::Point2f(200.0f + (i % 11) * 9.0f, 150.0f + (i / 11) * 13.0f);
+            }
+            std::vector<std::vector<inspirecv::Point2f>> reference_history;
+            LandmarkHistory history;
+            history.Reset(n, num_points);
+            unsigned int seed = 7;
+            float max_diff = 0.0f;
+            for (int frame = 0; frame < 500; frame++) {
+                JitterLandmarks(base, frame, seed);
+                auto expected = base;
+                auto smoothed = base;
+                ReferenceSmooth(expected, reference_history, num_points, h, n);
+                history.SmoothAndPush(smoothed, h);
+                for (size_t i = 0; i < num_points; i++) {
+                    max_diff = std::max(max_diff, std::abs(expected[i].GetX() - smoothed[i].GetX()));
+                    max_diff = std::max(max_diff, std::abs(expected[i].GetY() - smoothed[i].GetY()));
+                }
+                base = smoothed;
+            }
+            // Well under a pixel, the order of the sums and the exp approximation differ
+            CHECK(max_diff < 1e-3f);
+        }
+    }
+}
+
+TEST_CASE("test_LandmarkSmoothingBenchmark", "[track_module") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+#ifdef ISF_ENABLE_BENCHMARK
+    const size_t n = 5;
+    const size_t num_points = FaceLandmarkAdapt::NUM_OF_LANDMARK + 10;
+    const int loop = 10000;
+    std::vector<inspirecv::Point2f> base(num_points);
+    for (size_t i = 0; i < num_points; i++) {
+        base[i] = inspirecv::Point2f(200.0f + (i % 11) * 9.0f, 150.0f + (i / 11) * 13.0f);
+    }
+    std::vector<std::vector<inspirecv::Point2f>> frames;
+    unsigned int seed = 7;
+    for (int frame = 0; frame < 64; frame++) {
+        JitterLandmarks(base, frame, seed);
+        frames.push_back(base);
+    }
+
+    std::vector<std::vector<inspirecv::Point2f>> reference_history;
+    auto reference_timer = inspire::Timer();
+    for (int i = 0; i < loop; i++) {
+        auto landmarks = frames[i % frames.size()];
+        ReferenceSmooth(landmarks, reference_history, num_points, 0.05f, n);
+    }
+    auto reference_cost = reference_timer.GetCostTime();
+
+    LandmarkHistory history;
+    history.Reset(n, num_points);
+    auto landmarks = frames[0];
+    auto timer = inspire::Timer();
+    for (int i = 0; i < loop; i++) {
+        landmarks = frames[i % frames.size()];
+        history.SmoothAndPush(landmarks, 0.05f);
+    }
+    auto cost = timer.GetCostTime();
+    TEST_PRINT("<Benchmark> Landmark smoothing per face per frame -> Points: {}, Cached frames: {}, Scalar: {:.5f}us, Vectorized: {:.5f}us", num_points, n,
+               reference_cost * 1000.0 / loop, cost * 1000.0 / loop);
+#else
+    TEST_PRINT("Skip the landmark smoothing benchmark test. To run it, you need to turn on the benchmark test.");
+#endif
+}
+
+TEST_CASE("test_FrameProcessCropBenchmark", "[track_module") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+#ifdef ISF_ENABLE_BENCHMARK
+    auto frame = inspirecv::Image::Create(GET_DATA("data/bulk/kun.jpg"));
+    REQUIRE(!frame.Empty());
+    auto image = inspirecv::FrameProcess::Create(frame.Data(), frame.Height(), frame.Width(), inspirecv::BGR);
+    // 20 faces spread over the frame, each cropped to 112x112 as the tracker does
+    const int num_faces = 20;
+    const int crop_size = 112;
+    std::vector<inspirecv::TransformMatrix> affines;
+    for (int i = 0; i < num_faces; i++) {
+        const float side = 60.0f + (i % 5) * 20.0f;
+        const float x = (i % 5) * (frame.Width() - side) / 5.0f;
+        const float y = (i / 5) * (frame.Height() - side) / 4.0f;
+        const float scale = crop_size / side;
+        affines.push_back(inspirecv::TransformMatrix::Create(scale, 0.0f, -x * scale, 0.0f, scale, -y * scale));
+    }
+    const int warmup = 10;
+    const int loop = 200;
+
+    int64_t allocations = 0;
+    double cost = 0;
+    for (int i = 0; i < warmup + loop; i++) {
+        const int64_t before = g_allocation_count;
+        auto timer = inspire::Timer();
+        for (auto &affine : affines) {
+            auto crop = image.ExecuteImageAffineProcessing(affine, crop_size, crop_size);
+            REQUIRE(!crop.Empty());
+        }
+        if (i >= warmup) {
+            cost += timer.GetCostTime();
+            allocations += g_allocation_count - before;
+        }
+    }
+    TEST_PRINT("<Benchmark> Face crops, new image per crop -> Faces: {}, Allocations per crop: {:.2f}, Average Time per crop: {:.5f}ms", num_faces,
+               allocations / double(loop * num_faces), cost / (loop * num_faces));
+
+    std::vector<inspirecv::Image> crops(num_faces);
+    allocations = 0;
+    cost = 0;
+    for (int i = 0; i < warmup + loop; i++) {
+        const int64_t before = g_allocation_count;
+        auto timer = inspire::Timer();
+        for (int k = 0; k < num_faces; k++) {
+            image.ExecuteImageAffineProcessing(affines[k], crop_size, crop_size, crops[k]);
+        }
+        if (i >= warmup) {
+            cost += timer.GetCostTime();
+            allocations += g_allocation_count - before;
+        }
+    }
+    TEST_PRINT("<Benchmark> Face crops, reused buffers -> Faces: {}, Allocations per crop: {:.2f}, Average Time per crop: {:.5f}ms", num_faces,
+               allocations / double(loop * num_faces), cost / (loop * num_faces));
+    // The cached image processes and the kept buffers leave nothing to allocate
+    CHECK(allocations == 0);
+#else
+    TEST_PRINT("Skip the frame process crop benchmark test. To run it, you need to turn on the benchmark test.");
+#endif
+}
+
+TEST_CASE("test_FrameProcessBatchCrop", "[track_module") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+    auto frame = inspirecv::Image::Create(GET_DATA("data/bulk/kun.jpg"));
+    REQUIRE(!frame.Empty());
+    int nv21_width, nv21_height;
+    auto nv21 = BGRToNV21(frame, nv21_width, nv21_height);
+
+    SECTION("Same crops as one at a time") {
+        std::vector<inspirecv::FrameProcess> processes = {
+          inspirecv::FrameProcess::Create(frame.Data(), frame.Height(), frame.Width(), inspirecv::BGR),
+          inspirecv::FrameProcess::Create(nv21.data(), nv21_height, nv21_width, inspirecv::NV21)};
+        for (auto &process : processes) {
+            std::vector<inspirecv::Image> crops;
+            auto requests = FaceCropRequests(process.GetWidth(), process.GetHeight(), 20, crops);
+            for (int num_threads : {1, 4}) {
+                process.ExecuteImageAffineBatchProcessing(requests, num_threads);
+                for (auto &request : requests) {
+                    auto expected = process.ExecuteImageAffineProcessing(request.affine_matrix, request.width_out, request.height_out);
+                    REQUIRE(request.image_out->Width() == request.width_out);
+                    REQUIRE(request.image_out->Height() == request.height_out);
+                    CHECK(MeanAbsDiff(*request.image_out, expected) < 1.5);
+                }
+            }
+        }
+    }
+
+    SECTION("RGB order and crops outside the frame") {
+        auto process = inspirecv::FrameProcess::Create(frame.Data(), frame.Height(), frame.Width(), inspirecv::BGR);
+        inspirecv::Image bgr, rgb, outside;
+        std::vector<inspirecv::AffineCropRequest> requests(3);
+        for (auto &request : requests) {
+            request.affine_matrix = inspirecv::TransformMatrix::Create(0.5f, 0.0f, -10.0f, 0.0f, 0.5f, -10.0f);
+            request.width_out = 64;
+            request.height_out = 64;
+        }
+        requests[0].image_out = &bgr;
+        requests[1].format = inspirecv::RGB;
+        requests[1].image_out = &rgb;
+        requests[2].affine_matrix = inspirecv::TransformMatrix::Create(1.0f, 0.0f, 100000.0f, 0.0f, 1.0f, 0.0f);
+        requests[2].image_out = &outside;
+        process.ExecuteImageAffineBatchProcessing(requests);
+        for (int i = 0; i < 64 * 64; i++) {
+            CHECK(bgr.Data()[i * 3] == rgb.Data()[i * 3 + 2]);
+            CHECK(bgr.Data()[i * 3 + 2] == rgb.Data()[i * 3]);
+        }
+        for (int i = 0; i < 64 * 64 * 3; i++) {
+            CHECK(outside.Data()[i] == 0);
+        }
+    }
+}
+
+TEST_CASE("test_FrameProcessBatchCropBenchmark", "[track_module") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+#ifdef ISF_ENABLE_BENCHMARK
+    auto frame = inspirecv::Image::Create(GET_DATA("data/bulk/kun.jpg"));
+    REQUIRE(!frame.Empty());
+    int nv21_width, nv21_height;
+    auto nv21 = BGRToNV21(frame, nv21_width, nv21_height);
+    auto process = inspirecv::FrameProcess::Create(nv21.data(), nv21_height, nv21_width, inspirecv::NV21);
+    const int num_faces = 20;
+    const int loop = 100;
+    std::vector<inspirecv::Image> crops;
+    auto requests = FaceCropRequests(nv21_width, nv21_height, num_faces, crops);
+
+    auto timer = inspire::Timer();
+    for (int i = 0; i < loop; i++) {
+        for (auto &request : requests) {
+            process.ExecuteImageAffineProcessing(request.affine_matrix, request.width_out, request.height_out, *request.image_out);
+        }
+    }
+    auto cost = timer.GetCostTime();
+    TEST_PRINT("<Benchmark> NV21 face crops one at a time -> Faces: {}, Crops: {}, Average Time per frame: {:.5f}ms", num_faces, requests.size(),
+               cost / loop);
+
+    const int max_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int num_threads : {1, 2, 4, max_threads}) {
+        if (num_threads > max_threads) {
+            continue;
+        }
+        process.ExecuteImageAffineBatchProcessing(requests, num_threads);
+        timer = inspire::Timer();
+        for (int i = 0; i < loop; i++) {
+            process.ExecuteImageAffineBatchProcessing(requests, num_threads);
+        }
+        cost = timer.GetCostTime();
+        TEST_PRINT("<Benchmark> NV21 face crops in one batch -> Faces: {}, Crops: {}, Threads: {}, Average Time per frame: {:.5f}ms", num_faces,
+                   requests.size(), num_threads, cost / loop);
+    }
+#else
+    TEST_PRINT("Skip the frame process batch crop benchmark test. To run it, you need to turn on the benchmark test.");
+#endif
+}
+
+TEST_CASE("test_YUVKernels", "[track_module") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+    auto frame = inspirecv::Image::Create(GET_DATA("data/bulk/kun.jpg"));
+    REQUIRE(!frame.Empty());
+    int width, height;
+    auto nv21 = BGRToNV21(frame, width, height);
+
+    for (bool is_nv21 : {true, false}) {
+        // The same bytes read as NV12 swap the chroma, which is as good a test frame
+        std::vector<uint8_t> expected(width * height * 3);
+        ReferenceYUV420SPToBGR(nv21.data(), width, height, is_nv21, expected.data());
+
+        SECTION(is_nv21 ? "NV21 rows" : "NV12 rows") {
+            std::vector<uint8_t> converted(width * height * 3);
+            for (int y = 0; y < height; y++) {
+                YUV420SPToBGRRow(nv21.data() + y * width, nv21.data() + width * height + (y / 2) * width, width, is_nv21, converted.data() + y * width * 3);
+            }
+            CHECK(converted == expected);
+        }
+
+        SECTION(is_nv21 ? "NV21 affine sampling" : "NV12 affine sampling") {
+            // Converting then resizing, the frame moved by whole pixels is converted exactly
+            auto reference = inspirecv::Image::Create(width, height, 3, expected.data(), false);
+            auto reference_process = inspirecv::FrameProcess::Create(reference, inspirecv::BGR);
+            auto process = inspirecv::FrameProcess::Create(nv21.data(), height, width, is_nv21 ? inspirecv::NV21 : inspirecv::NV12);
+            const int size = 112;
+            const std::vector<inspirecv::TransformMatrix> affines = {
+              inspirecv::TransformMatrix::Create(1.0f, 0.0f, -30.0f, 0.0f, 1.0f, -41.0f),
+              inspirecv::TransformMatrix::Create(0.6f, 0.1f, -20.0f, -0.1f, 0.6f, -10.0f),
+              inspirecv::TransformMatrix::Create(0.3f, 0.0f, 5.0f, 0.0f, 0.3f, 5.0f)};
+            for (auto affine : affines) {
+                auto crop = process.ExecuteImageAffineProcessing(affine, size, size);
+                auto expected_crop = reference_process.ExecuteImageAffineProcessing(affine, size, size);
+                CHECK(MeanAbsDiff(crop, expected_crop) < 1.5);
+            }
+            auto preview = process.ExecutePreviewImageProcessing(true);
+            auto expected_preview = reference_process.ExecutePreviewImageProcessing(true);
+            REQUIRE(preview.Width() == expected_preview.Width());
+            REQUIRE(preview.Height() == expected_preview.Height());
+            CHECK(MeanAbsDiff(preview, expected_preview) < 1.5);
+        }
+    }
+}
+
+TEST_CASE("test_YUVKernelsBenchmark", "[track_module") {
+    DRAW_SPLIT_LINE
+    TEST_PRINT_OUTPUT(true);
+#ifdef ISF_ENABLE_BENCHMARK
+    auto image = inspirecv::Image::Create(GET_DATA("data/bulk/kun.jpg"));
+    REQUIRE(!image.Empty());
+    const int loop = 20;
+    const std::pair<const char *, std::pair<int, int>> resolutions[] = {{"720p", {1280, 720}}, {"1080p", {1920, 1080}}, {"4K", {3840, 2160}}};
+    for (const auto &resolution : resolutions) {
+        int width, height;
+        auto nv21 = BGRToNV21(image.Resize(resolution.second.first, resolution.second.second), width, height);
+        auto process = inspirecv::FrameProcess::Create(nv21.data(), height, width, inspirecv::NV21);
+        std::vector<uint8_t> bgr(width * height * 3);
+
+        auto timer = inspire::Timer();
+        for (int i = 0; i < loop; i++) {
+            ReferenceYUV420SPToBGR(nv21.data(), width, height, true, bgr.data());
+        }
+        auto scalar_cost = timer.GetCostTime() / loop;
+        timer = inspire::Timer();
+        for (int i = 0; i < loop; i++) {
+            auto full = process.ExecuteImageScaleProcessing(1.0f, false);
+            REQUIRE(!full.Empty());
+        }
+        auto full_cost = timer.GetCostTime() / loop;
+        timer = inspire::Timer();
+        for (int i = 0; i < loop; i++) {
+            auto preview = process.ExecutePreviewImageProcessing(true);
+            REQUIRE(!preview.Empty());
+        }
+        auto preview_cost = timer.GetCostTime() / loop;
+        // A face a quarter of the frame high, scaled down to the landmark input
+        const float scale = 112.0f / (height / 4);
+        auto affine = inspirecv::TransformMatrix::Create(scale, 0.0f, -scale * width / 2, 0.0f, scale, -scale * height / 2);
+        timer = inspire::Timer();
+        for (int i = 0; i < loop; i++) {
+            auto crop = process.ExecuteImageAffineProcessing(affine, 112, 112);
+            REQUIRE(!crop.Empty());
+        }
+        auto crop_cost = timer.GetCostTime() / loop;
+        TEST_PRINT("<Benchmark> NV21 {} -> Scalar conversion: {:.3f}ms, Full frame: {:.3f}ms, Preview: {:.3f}ms, 112 crop: {:.3f}ms", resolution.first,
+                   scalar_cost, full_cost, preview_cost, crop_cost);
+    }
+#else
+    TEST_PRINT("Skip the YUV kernels benchmark test. To run it, you need to turn on the benchmark test.");
+#endif
+}